@@ -0,0 +1,182 @@
+#include "at_parser.h"
+
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+AtReceiveBuffer::AtReceiveBuffer(size_t capacity) : buffer_(capacity) {
+}
+
+char* AtReceiveBuffer::PrepareWrite(size_t length) {
+    if (buffer_.size() - write_ < length) {
+        // Move the unread tail to the front before growing
+        size_t pending = write_ - read_;
+        if (read_ > 0) {
+            memmove(buffer_.data(), buffer_.data() + read_, pending);
+            read_ = 0;
+            write_ = pending;
+        }
+        if (buffer_.size() - write_ < length) {
+            buffer_.resize(write_ + length);
+        }
+    }
+    return buffer_.data() + write_;
+}
+
+void AtReceiveBuffer::CommitWrite(size_t length) {
+    write_ += length;
+}
+
+void AtReceiveBuffer::Consume(size_t length) {
+    read_ += length;
+    scanned_ = scanned_ > length ? scanned_ - length : 0;
+    if (read_ == write_) {
+        read_ = write_ = scanned_ = 0;
+    }
+}
+
+bool AtReceiveBuffer::NextLine(std::string_view& line) {
+    const char* start = buffer_.data() + read_;
+    size_t pending = write_ - read_;
+    // Only scan the bytes that arrived since the last call, long hex URCs come in many chunks
+    const char* search = start + scanned_;
+    const char* newline = (const char*)memchr(search, '\n', pending - scanned_);
+    while (newline != nullptr && (newline == start || newline[-1] != '\r')) {
+        // A bare '\n' is part of the line, keep searching
+        newline = (const char*)memchr(newline + 1, '\n', start + pending - newline - 1);
+    }
+    if (newline == nullptr) {
+        scanned_ = pending;
+        return false;
+    }
+    size_t length = newline - start - 1;
+    line = std::string_view(start, length);
+    Consume(length + 2);
+    return true;
+}
+
+static bool IsInteger(std::string_view item) {
+    size_t i = (!item.empty() && item[0] == '-') ? 1 : 0;
+    if (i == item.size()) {
+        return false;
+    }
+    for (; i < item.size(); i++) {
+        if (item[i] < '0' || item[i] > '9') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns false if the value does not fit in an int
+static bool ToInteger(std::string_view item, int& result) {
+    bool negative = item[0] == '-';
+    long long limit = negative ? -(long long)INT_MIN : INT_MAX;
+    long long value = 0;
+    for (size_t i = negative ? 1 : 0; i < item.size(); i++) {
+        value = value * 10 + (item[i] - '0');
+        if (value > limit) {
+            return false;
+        }
+    }
+    result = (int)(negative ? -value : value);
+    return true;
+}
+
+void ParseAtArguments(std::string_view values, std::vector<AtArgumentValue>& arguments) {
+    arguments.clear();
+    if (values.empty()) {
+        return;
+    }
+
+    size_t pos = 0;
+    while (true) {
+        AtArgumentValue argument;
+        size_t end;
+        if (pos < values.size() && values[pos] == '"') {
+            // A quoted string may contain commas
+            size_t close = values.find('"', pos + 1);
+            if (close == std::string_view::npos) {
+                close = values.size();
+            }
+            argument.string_value = values.substr(pos + 1, close - pos - 1);
+            end = values.find(',', close);
+        } else {
+            end = values.find(',', pos);
+            auto item = values.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos);
+            argument.string_value = item;
+            bool integer = IsInteger(item);
+            if (integer && ToInteger(item, argument.int_value)) {
+                argument.type = AtArgumentValue::Type::Int;
+            } else if ((integer || item.find('.') != std::string_view::npos) && item.size() < 32) {
+                // Integers beyond the int range are kept as Double so that the value is not truncated
+                char number[32];
+                memcpy(number, item.data(), item.size());
+                number[item.size()] = '\0';
+                argument.type = AtArgumentValue::Type::Double;
+                argument.double_value = strtod(number, nullptr);
+            }
+        }
+        arguments.push_back(argument);
+        // Like getline(), a trailing comma does not produce an empty argument
+        if (end == std::string_view::npos || end + 1 == values.size()) {
+            break;
+        }
+        pos = end + 1;
+    }
+}
+
+AtDataFrameResult ParseAtDataFrame(std::string_view pending, AtDataFrame& frame) {
+    static constexpr std::string_view kPrefix = "+MIPURC: \"";
+    if (pending.size() < kPrefix.size()) {
+        return kPrefix.compare(0, pending.size(), pending) == 0 ? AtDataFrameResult::Incomplete : AtDataFrameResult::NotFrame;
+    }
+    if (pending.compare(0, kPrefix.size(), kPrefix) != 0) {
+        return AtDataFrameResult::NotFrame;
+    }
+
+    size_t pos = kPrefix.size();
+    auto quote = pending.find('"', pos);
+    if (quote == std::string_view::npos) {
+        return pending.find('\n', pos) == std::string_view::npos ? AtDataFrameResult::Incomplete : AtDataFrameResult::NotFrame;
+    }
+    frame.type = pending.substr(pos, quote - pos);
+    if (frame.type != "rtcp" && frame.type != "rudp") {
+        return AtDataFrameResult::NotFrame;
+    }
+    pos = quote + 1;
+
+    // ,<id>,<length>,
+    size_t numbers[2];
+    for (auto& number : numbers) {
+        if (pos >= pending.size()) {
+            return AtDataFrameResult::Incomplete;
+        }
+        if (pending[pos] != ',') {
+            return AtDataFrameResult::NotFrame;
+        }
+        pos++;
+        size_t start = pos;
+        number = 0;
+        while (pos < pending.size() && pending[pos] >= '0' && pending[pos] <= '9' && pos - start < 9) {
+            number = number * 10 + (pending[pos] - '0');
+            pos++;
+        }
+        if (pos == pending.size()) {
+            return AtDataFrameResult::Incomplete;
+        }
+        if (pos == start) {
+            return AtDataFrameResult::NotFrame;
+        }
+    }
+    if (pending[pos] != ',') {
+        return AtDataFrameResult::NotFrame;
+    }
+    frame.connection_id = numbers[0];
+    frame.data_length = numbers[1];
+    frame.header_length = pos + 1;
+    if (pending.size() < frame.header_length + frame.data_length + 2) {
+        return AtDataFrameResult::Incomplete;
+    }
+    return AtDataFrameResult::Complete;
+}
@@ -0,0 +1,87 @@
+#include "hex_codec.h"
+
+#include <array>
+#include <bit>
+#include <cstring>
+
+// The encode table and the word-sized stores below lay out bytes in little endian memory order
+static_assert(std::endian::native == std::endian::little, "hex_codec assumes a little endian target");
+
+namespace {
+
+constexpr char kHexDigits[] = "0123456789ABCDEF";
+
+// byte -> two ASCII digits, stored in memory order so a single 16-bit copy writes both
+constexpr std::array<uint16_t, 256> MakeEncodeTable() {
+    std::array<uint16_t, 256> table{};
+    for (int i = 0; i < 256; i++) {
+        // Little endian: low byte is written first
+        table[i] = (uint16_t)((uint8_t)kHexDigits[i >> 4] | ((uint8_t)kHexDigits[i & 0x0F] << 8));
+    }
+    return table;
+}
+
+constexpr std::array<uint8_t, 256> MakeDecodeTable() {
+    std::array<uint8_t, 256> table{};
+    for (int c = '0'; c <= '9'; c++) table[c] = c - '0';
+    for (int c = 'A'; c <= 'F'; c++) table[c] = c - 'A' + 10;
+    for (int c = 'a'; c <= 'f'; c++) table[c] = c - 'a' + 10;
+    return table;
+}
+
+constexpr auto kEncodeTable = MakeEncodeTable();
+constexpr auto kDecodeTable = MakeDecodeTable();
+
+inline uint8_t DecodeByte(const uint8_t* hex) {
+    return (kDecodeTable[hex[0]] << 4) | kDecodeTable[hex[1]];
+}
+
+} // namespace
+
+void HexEncode(char* out, const void* data, size_t length) {
+    auto in = static_cast<const uint8_t*>(data);
+    size_t i = 0;
+    // 4 bytes in, 8 characters out per iteration with two aligned-size stores
+    for (; i + 4 <= length; i += 4) {
+        uint32_t low = kEncodeTable[in[i]] | ((uint32_t)kEncodeTable[in[i + 1]] << 16);
+        uint32_t high = kEncodeTable[in[i + 2]] | ((uint32_t)kEncodeTable[in[i + 3]] << 16);
+        memcpy(out, &low, 4);
+        memcpy(out + 4, &high, 4);
+        out += 8;
+    }
+    for (; i < length; i++) {
+        uint16_t pair = kEncodeTable[in[i]];
+        memcpy(out, &pair, 2);
+        out += 2;
+    }
+}
+
+size_t HexDecode(void* out, const char* hex, size_t length) {
+    auto in = reinterpret_cast<const uint8_t*>(hex);
+    auto dest = static_cast<uint8_t*>(out);
+    size_t count = length / 2;
+    size_t i = 0;
+    // 8 characters in, one 32-bit store out per iteration
+    for (; i + 4 <= count; i += 4) {
+        uint32_t word = DecodeByte(in) | (DecodeByte(in + 2) << 8) | (DecodeByte(in + 4) << 16) | ((uint32_t)DecodeByte(in + 6) << 24);
+        memcpy(dest + i, &word, 4);
+        in += 8;
+    }
+    for (; i < count; i++) {
+        dest[i] = DecodeByte(in);
+        in += 2;
+    }
+    return count;
+}
+
+void HexEncodeAppend(std::string& dest, const void* data, size_t length) {
+    size_t offset = dest.size();
+    dest.resize(offset + length * 2);
+    HexEncode(&dest[offset], data, length);
+}
+
+void HexDecodeAppend(std::string& dest, const char* hex, size_t length) {
+    size_t offset = dest.size();
+    dest.resize(offset + length / 2);
+    HexDecode(&dest[offset], hex, length);
+}
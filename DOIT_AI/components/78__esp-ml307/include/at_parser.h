@@ -0,0 +1,74 @@
+#ifndef _AT_PARSER_H_
+#define _AT_PARSER_H_
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct AtArgumentValue {
+    enum class Type {
+        String,
+        Int,
+        Double
+    };
+    Type type = Type::String;
+    // Points into the receive buffer, only valid inside the response callback
+    std::string_view string_value;
+    int int_value = 0;
+    double double_value = 0;
+};
+
+/*
+ * UART receive buffer for AT responses.
+ * Data is appended at the tail and lines are consumed by advancing a read offset, so no memmove
+ * happens per line; the unread tail is moved to the front only when the buffer runs out of room.
+ * Lines are always contiguous, which lets the parser hand out string_views without copying.
+ */
+class AtReceiveBuffer {
+public:
+    explicit AtReceiveBuffer(size_t capacity = 2048);
+
+    // Returns a pointer with room for at least `length` bytes, call CommitWrite() after filling it
+    char* PrepareWrite(size_t length);
+    void CommitWrite(size_t length);
+
+    // Next complete line without the trailing "\r\n", the view stays valid until the next PrepareWrite()
+    bool NextLine(std::string_view& line);
+
+    std::string_view Peek() const { return std::string_view(buffer_.data() + read_, write_ - read_); }
+    void Consume(size_t length);
+    size_t size() const { return write_ - read_; }
+
+private:
+    std::vector<char> buffer_;
+    size_t read_ = 0;
+    size_t write_ = 0;
+    // Bytes after read_ that are already known not to contain '\n'
+    size_t scanned_ = 0;
+};
+
+/*
+ * Socket data pushed in binary encoding: +MIPURC: "rtcp",<id>,<length>,<raw bytes>\r\n
+ * The payload may contain "\r\n" itself, so the frame is delimited by <length> instead of by lines.
+ */
+struct AtDataFrame {
+    std::string_view type;
+    int connection_id = -1;
+    size_t header_length = 0;
+    size_t data_length = 0;
+};
+
+enum class AtDataFrameResult {
+    NotFrame,       // Not a "rtcp"/"rudp" data URC, parse it as a normal line
+    Incomplete,     // Header or payload not fully received yet
+    Complete        // header_length + data_length + 2 bytes are available
+};
+
+AtDataFrameResult ParseAtDataFrame(std::string_view pending, AtDataFrame& frame);
+
+// Split `"string",int,1.5,raw` into arguments without allocating, `arguments` is reused by the caller.
+// Integers outside the int range are returned as Double, string_value always holds the raw text.
+void ParseAtArguments(std::string_view values, std::vector<AtArgumentValue>& arguments);
+
+#endif // _AT_PARSER_H_
@@ -0,0 +1,22 @@
+#ifndef _HEX_CODEC_H_
+#define _HEX_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * Table driven hex codec shared by the AT modem and the protocols.
+ * Encoding produces upper case digits; decoding accepts both cases and treats invalid digits as 0.
+ * The raw functions write into caller provided buffers and never allocate.
+ */
+
+// Writes exactly length * 2 characters to `out`, no terminating NUL
+void HexEncode(char* out, const void* data, size_t length);
+// Decodes length / 2 bytes into `out` and returns the count, a trailing odd digit is ignored
+size_t HexDecode(void* out, const char* hex, size_t length);
+
+void HexEncodeAppend(std::string& dest, const void* data, size_t length);
+void HexDecodeAppend(std::string& dest, const char* hex, size_t length);
+
+#endif // _HEX_CODEC_H_
@@ -0,0 +1,174 @@
+#ifndef _ML307_AT_MODEM_H_
+#define _ML307_AT_MODEM_H_
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <list>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/event_groups.h>
+#include <driver/gpio.h>
+#include <driver/uart.h>
+#include <esp_timer.h>
+
+#include "at_parser.h"
+
+#define AT_EVENT_DATA_AVAILABLE BIT1
+#define AT_EVENT_NETWORK_READY BIT4
+
+// Socket data is sent and received as raw bytes when the module accepts it, set to 0 to always use hex
+#ifndef ML307_BINARY_DATA_MODE
+#define ML307_BINARY_DATA_MODE 1
+#endif
+
+#define DEFAULT_COMMAND_TIMEOUT 3000
+// Extra time a blocking command waits for its completion callback beyond its own timeout
+#define COMMAND_WAIT_MARGIN_MS 1000
+#define ML307_MAX_PENDING_COMMANDS 16
+#define ML307_MAX_CONNECTIONS 8
+#define DEFAULT_BAUD_RATE 115200
+#define DEFAULT_UART_NUM UART_NUM_1
+
+typedef std::function<void(const std::string& command, const std::vector<AtArgumentValue>& arguments)> CommandResponseCallback;
+// Completion of a queued command, `response` is the last plain line before "OK"
+typedef std::function<void(bool success, const std::string& response)> AtCommandCallback;
+
+class Ml307AtModem {
+public:
+    struct CeregState {
+        int stat = -1;              // <stat>
+        std::string tac;        // <tac>
+        std::string ci;    // <ci>
+        int AcT = -1;        // <AcT>
+        int cause_type = -1;         // <cause_type>
+        int reject_cause = -1;       // <reject_cause>
+
+        std::string ToString() const {
+            std::string json = "{";
+            json += "\"stat\":" + std::to_string(stat);
+            if (!tac.empty()) json += ",\"tac\":\"" + tac + "\"";
+            if (!ci.empty()) json += ",\"ci\":\"" + ci + "\"";
+            if (AcT >= 0) json += ",\"AcT\":" + std::to_string(AcT);
+            if (cause_type >= 0) json += ",\"cause_type\":" + std::to_string(cause_type);
+            if (reject_cause >= 0) json += ",\"reject_cause\":" + std::to_string(reject_cause);
+            json += "}";
+            return json;
+        }
+    };
+
+    Ml307AtModem(int tx_pin = GPIO_NUM_17, int rx_pin = GPIO_NUM_18, size_t rx_buffer_size = 2048);
+    ~Ml307AtModem();
+
+    std::string EncodeHex(std::string_view data);
+    std::string DecodeHex(std::string_view data);
+    void EncodeHexAppend(std::string& dest, const char* data, size_t length);
+    void DecodeHexAppend(std::string& dest, const char* data, size_t length);
+
+    /*
+     * Commands are queued and written back to back: the next one goes out as soon as the previous
+     * "OK"/"ERROR" is parsed, so callers don't pay a task round trip per command.
+     * The async variants return false only if the queue is full, the callback runs on the receive task
+     * (or the timer task on timeout) and must not block.
+     */
+    bool CommandAsync(std::string command, AtCommandCallback callback, int timeout_ms = DEFAULT_COMMAND_TIMEOUT);
+    // "AT+MIPSEND=<id>,<length>", the raw bytes are written after the '>' prompt
+    bool CommandWithDataAsync(std::string command, std::string data, AtCommandCallback callback, int timeout_ms = DEFAULT_COMMAND_TIMEOUT);
+    // Blocking wrappers, wait until the command completes
+    bool Command(const std::string command, int timeout_ms = DEFAULT_COMMAND_TIMEOUT);
+    bool CommandWithData(const std::string& command, const char* data, size_t length, int timeout_ms = DEFAULT_COMMAND_TIMEOUT);
+    // Data URCs of this connection carry raw bytes instead of hex, see AtDataFrame
+    void SetBinaryReceive(int connection_id, bool binary);
+    std::list<CommandResponseCallback>::iterator RegisterCommandResponseCallback(CommandResponseCallback callback);
+    void UnregisterCommandResponseCallback(std::list<CommandResponseCallback>::iterator iterator);
+    // Only receives the MIPOPEN/MIPCLOSE/MIPSEND/MIPSTATE/MIPURC of this connection, plus FIFO_OVERFLOW
+    std::list<CommandResponseCallback>::iterator RegisterConnectionCallback(int connection_id, CommandResponseCallback callback);
+    void UnregisterConnectionCallback(int connection_id, std::list<CommandResponseCallback>::iterator iterator);
+
+    void OnMaterialReady(std::function<void()> callback);
+    void Reset();
+    void ResetConnections();
+    void SetDebug(bool debug);
+    bool SetBaudRate(int new_baud_rate);
+    int WaitForNetworkReady();
+
+    std::string GetImei();
+    std::string GetIccid();
+    std::string GetModuleName();
+    CeregState GetRegistrationState();
+    std::string GetCarrierName();
+    int GetCsq();
+
+    const std::string& ip_address() const { return ip_address_; }
+    bool network_ready() const { return network_ready_; }
+    int pin_ready() const { return pin_ready_; }
+
+private:
+    std::mutex mutex_;
+    std::mutex command_mutex_;
+    bool debug_ = false;
+    bool network_ready_ = false;
+    std::string ip_address_;
+    std::string iccid_;
+    std::string carrier_name_;
+
+    int csq_ = -1;
+    int pin_ready_ = 0;
+
+    AtReceiveBuffer rx_buffer_;
+    size_t rx_buffer_size_;
+    uart_port_t uart_num_;
+    int tx_pin_;
+    int rx_pin_;
+    int baud_rate_;
+    TaskHandle_t event_task_handle_ = nullptr;
+    TaskHandle_t receive_task_handle_ = nullptr;
+    QueueHandle_t event_queue_handle_ = nullptr;
+    EventGroupHandle_t event_group_handle_ = nullptr;
+    // Response of the last blocking Command()
+    std::string response_;
+
+    struct PendingCommand {
+        std::string command;
+        std::string data;
+        bool has_data = false;
+        int timeout_ms = DEFAULT_COMMAND_TIMEOUT;
+        AtCommandCallback callback;
+        std::string response;
+        int64_t deadline_us = 0;
+    };
+    // The front command has been written to the UART, guarded by queue_mutex_ together with UART writes
+    std::mutex queue_mutex_;
+    std::list<PendingCommand> command_queue_;
+    bool waiting_prompt_ = false;
+    esp_timer_handle_t command_timer_ = nullptr;
+    // Reused for every "+XXX: ..." line to avoid allocations while parsing
+    std::string urc_command_;
+    std::vector<AtArgumentValue> urc_arguments_;
+    // Bit n set if connection n receives in binary encoding
+    std::atomic<uint32_t> binary_receive_mask_ = 0;
+
+    CeregState cereg_state_;
+
+    void EventTask();
+    void ReceiveTask();
+    bool ParseResponse();
+    int ParseDataFrame();
+    bool DetectBaudRate();
+    void NotifyCommandResponse(const std::string& command, const std::vector<AtArgumentValue>& arguments);
+    bool EnqueueCommand(PendingCommand&& command);
+    void StartCommand();
+    void CompleteCommand(bool success, bool timeout = false);
+
+    std::list<CommandResponseCallback> on_data_received_;
+    std::list<CommandResponseCallback> connection_callbacks_[ML307_MAX_CONNECTIONS];
+    std::function<void()> on_material_ready_;
+};
+
+
+#endif // _ML307_AT_MODEM_H_
\ No newline at end of file
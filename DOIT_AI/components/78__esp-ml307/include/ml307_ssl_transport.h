@@ -0,0 +1,52 @@
+#ifndef ML307_SSL_TRANSPORT_H
+#define ML307_SSL_TRANSPORT_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/event_groups.h>
+#include "transport.h"
+#include "ml307_at_modem.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+#define ML307_SSL_TRANSPORT_CONNECTED BIT0
+#define ML307_SSL_TRANSPORT_DISCONNECTED BIT1
+#define ML307_SSL_TRANSPORT_ERROR BIT2
+#define ML307_SSL_TRANSPORT_RECEIVE BIT3
+#define ML307_SSL_TRANSPORT_SEND_COMPLETE BIT4
+#define ML307_SSL_TRANSPORT_INITIALIZED BIT5
+
+#define SSL_CONNECT_TIMEOUT_MS 10000
+// 已排队但模组尚未确认发送（+MIPSEND）的最大数据块数
+#define SSL_SEND_WINDOW 4
+
+class Ml307SslTransport : public Transport {
+public:
+    Ml307SslTransport(Ml307AtModem& modem, int tcp_id);
+    ~Ml307SslTransport();
+
+    bool Connect(const char* host, int port) override;
+    void Disconnect() override;
+    int Send(const char* data, size_t length) override;
+    int Receive(char* buffer, size_t bufferSize) override;
+
+private:
+    std::mutex mutex_;
+    Ml307AtModem& modem_;
+    EventGroupHandle_t event_group_handle_;
+    // 收发原始字节，否则为 HEX 编码
+    bool binary_mode_ = false;
+    int tcp_id_ = 0;
+    std::string rx_buffer_;
+    // 连接建立以来排队发送和模组确认的字节数，按总数比较，迟到的确认不会被当作本次发送的确认
+    std::atomic<size_t> queued_bytes_ = 0;
+    std::atomic<size_t> acked_bytes_ = 0;
+    std::list<CommandResponseCallback>::iterator command_callback_it_;
+
+    bool WaitForAcked(size_t bytes, const std::atomic<bool>& failed);
+};
+
+#endif // ML307_SSL_TRANSPORT_H
@@ -0,0 +1,596 @@
+#include "ml307_at_modem.h"
+#include "hex_codec.h"
+#include <esp_log.h>
+#include <esp_err.h>
+#include <cstring>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <future>
+
+static const char* TAG = "Ml307AtModem";
+
+
+Ml307AtModem::Ml307AtModem(int tx_pin, int rx_pin, size_t rx_buffer_size)
+    : rx_buffer_(rx_buffer_size), rx_buffer_size_(rx_buffer_size), uart_num_(DEFAULT_UART_NUM), tx_pin_(tx_pin), rx_pin_(rx_pin), baud_rate_(DEFAULT_BAUD_RATE) {
+    event_group_handle_ = xEventGroupCreate();
+    urc_arguments_.reserve(8);
+
+    esp_timer_create_args_t timer_args = {
+        .callback = [](void* arg) {
+            auto ml307_at_modem = (Ml307AtModem*)arg;
+            ml307_at_modem->CompleteCommand(false, true);
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "modem_command",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &command_timer_));
+
+    uart_config_t uart_config = {};
+    uart_config.baud_rate = baud_rate_;
+    uart_config.data_bits = UART_DATA_8_BITS;
+    uart_config.parity = UART_PARITY_DISABLE;
+    uart_config.stop_bits = UART_STOP_BITS_1;
+    uart_config.source_clk = UART_SCLK_DEFAULT;
+    
+    // With a TX ring buffer the next queued command can be written from the receive task without blocking
+    ESP_ERROR_CHECK(uart_driver_install(uart_num_, rx_buffer_size_ * 2, rx_buffer_size_ * 2, 100, &event_queue_handle_, ESP_INTR_FLAG_IRAM));
+    ESP_ERROR_CHECK(uart_param_config(uart_num_, &uart_config));
+    ESP_ERROR_CHECK(uart_set_pin(uart_num_, tx_pin_, rx_pin_, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
+
+    xTaskCreate([](void* arg) {
+        auto ml307_at_modem = (Ml307AtModem*)arg;
+        ml307_at_modem->EventTask();
+        vTaskDelete(NULL);
+    }, "modem_event", 4096, this, 15, &event_task_handle_);
+
+    xTaskCreate([](void* arg) {
+        auto ml307_at_modem = (Ml307AtModem*)arg;
+        ml307_at_modem->ReceiveTask();
+        vTaskDelete(NULL);
+    }, "modem_receive", 4096 * 2, this, 15, &receive_task_handle_);
+}
+
+Ml307AtModem::~Ml307AtModem() {
+    vTaskDelete(event_task_handle_);
+    vTaskDelete(receive_task_handle_);
+    esp_timer_stop(command_timer_);
+    esp_timer_delete(command_timer_);
+    vEventGroupDelete(event_group_handle_);
+    uart_driver_delete(uart_num_);
+}
+
+bool Ml307AtModem::DetectBaudRate() {
+    // Write and Read AT command to detect the current baud rate
+    std::vector<int> baud_rates = {115200, 921600, 460800, 230400, 57600, 38400, 19200, 9600};
+    while (true) {
+        ESP_LOGI(TAG, "Detecting baud rate...");
+        for (int rate : baud_rates) {
+            uart_set_baudrate(uart_num_, rate);
+            if (Command("AT", 20)) {
+                ESP_LOGI(TAG, "Detected baud rate: %d", rate);
+                baud_rate_ = rate;
+                return true;
+            }
+        }
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+    return false;
+}
+
+bool Ml307AtModem::SetBaudRate(int new_baud_rate) {
+    if (!DetectBaudRate()) {
+        ESP_LOGE(TAG, "Failed to detect baud rate");
+        return false;
+    }
+    if (new_baud_rate == baud_rate_) {
+        return true;
+    }
+    // Set new baud rate
+    if (Command(std::string("AT+IPR=") + std::to_string(new_baud_rate))) {
+        uart_set_baudrate(uart_num_, new_baud_rate);
+        baud_rate_ = new_baud_rate;
+        ESP_LOGI(TAG, "Set baud rate to %d", new_baud_rate);
+        return true;
+    }
+    ESP_LOGI(TAG, "Failed to set baud rate to %d", new_baud_rate);
+    return false;
+}
+
+int Ml307AtModem::WaitForNetworkReady() {
+    ESP_LOGI(TAG, "Waiting for network ready...");
+    Command("AT+CEREG=3", 1000);
+    while (!network_ready_) {
+        if (pin_ready_ == 2) {
+            ESP_LOGE(TAG, "PIN is not ready");
+            return -1;
+        }
+        if (cereg_state_.stat == 3) {
+            ESP_LOGI(TAG, "Registration denied");
+            return -2;
+        }
+        Command("AT+MIPCALL?");
+        xEventGroupWaitBits(event_group_handle_, AT_EVENT_NETWORK_READY, pdTRUE, pdFALSE, pdMS_TO_TICKS(1000));
+    }
+    return 0;
+}
+
+std::string Ml307AtModem::GetImei() {
+    if (Command("AT+CIMI")) {
+        return response_;
+    }
+    return "";
+}
+
+std::string Ml307AtModem::GetIccid() {
+    if (Command("AT+ICCID")) {
+        return iccid_;
+    }
+    return "";
+}
+
+std::string Ml307AtModem::GetModuleName() {
+    if (Command("AT+CGMR")) {
+        return response_;
+    }
+    return "";
+}
+
+std::string Ml307AtModem::GetCarrierName() {
+    if (Command("AT+COPS?")) {
+        return carrier_name_;
+    }
+    return "";
+}
+
+Ml307AtModem::CeregState Ml307AtModem::GetRegistrationState() {
+    if (Command("AT+CEREG?")) {
+        return cereg_state_;
+    }
+    // 返回一个表示未知状态的对象
+    return CeregState{};
+}
+
+int Ml307AtModem::GetCsq() {
+    if (Command("AT+CSQ")) {
+        return csq_;
+    }
+    return -1;
+}
+
+void Ml307AtModem::SetDebug(bool debug) {
+    debug_ = debug;
+}
+
+std::list<CommandResponseCallback>::iterator Ml307AtModem::RegisterCommandResponseCallback(CommandResponseCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_ );
+    return on_data_received_.insert(on_data_received_.end(), callback);
+}
+
+void Ml307AtModem::UnregisterCommandResponseCallback(std::list<CommandResponseCallback>::iterator iterator) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    on_data_received_.erase(iterator);
+}
+
+std::list<CommandResponseCallback>::iterator Ml307AtModem::RegisterConnectionCallback(int connection_id, CommandResponseCallback callback) {
+    assert(connection_id >= 0 && connection_id < ML307_MAX_CONNECTIONS);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& callbacks = connection_callbacks_[connection_id];
+    return callbacks.insert(callbacks.end(), callback);
+}
+
+void Ml307AtModem::UnregisterConnectionCallback(int connection_id, std::list<CommandResponseCallback>::iterator iterator) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    connection_callbacks_[connection_id].erase(iterator);
+}
+
+bool Ml307AtModem::CommandAsync(std::string command, AtCommandCallback callback, int timeout_ms) {
+    PendingCommand pending;
+    pending.command = std::move(command);
+    pending.timeout_ms = timeout_ms;
+    pending.callback = std::move(callback);
+    return EnqueueCommand(std::move(pending));
+}
+
+bool Ml307AtModem::CommandWithDataAsync(std::string command, std::string data, AtCommandCallback callback, int timeout_ms) {
+    PendingCommand pending;
+    pending.command = std::move(command);
+    pending.data = std::move(data);
+    pending.has_data = true;
+    pending.timeout_ms = timeout_ms;
+    pending.callback = std::move(callback);
+    return EnqueueCommand(std::move(pending));
+}
+
+bool Ml307AtModem::EnqueueCommand(PendingCommand&& command) {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    if (command_queue_.size() >= ML307_MAX_PENDING_COMMANDS) {
+        ESP_LOGE(TAG, "command queue full, drop: %.64s", command.command.c_str());
+        return false;
+    }
+    command.command += "\r\n";
+    command_queue_.push_back(std::move(command));
+    if (command_queue_.size() == 1) {
+        StartCommand();
+    }
+    return true;
+}
+
+// Called with queue_mutex_ held
+void Ml307AtModem::StartCommand() {
+    auto& command = command_queue_.front();
+    if (debug_) {
+        ESP_LOGI(TAG, ">> %.*s (%u bytes)", (int)std::min(command.command.size() - 2, (size_t)64), command.command.c_str(),
+            command.command.size() - 2 + command.data.size());
+    }
+    command.deadline_us = esp_timer_get_time() + command.timeout_ms * 1000LL;
+    waiting_prompt_ = command.has_data;
+    int ret = uart_write_bytes(uart_num_, command.command.c_str(), command.command.length());
+    if (ret < 0) {
+        // Left to the timeout, so the queue keeps moving in order
+        ESP_LOGE(TAG, "uart_write_bytes failed: %d", ret);
+    }
+    esp_timer_stop(command_timer_);
+    esp_timer_start_once(command_timer_, command.timeout_ms * 1000LL);
+}
+
+void Ml307AtModem::CompleteCommand(bool success, bool timeout) {
+    PendingCommand command;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (command_queue_.empty()) {
+            return;
+        }
+        // The timer may fire just after the command completed and the next one started
+        if (timeout && esp_timer_get_time() < command_queue_.front().deadline_us) {
+            return;
+        }
+        command = std::move(command_queue_.front());
+        command_queue_.pop_front();
+        waiting_prompt_ = false;
+        esp_timer_stop(command_timer_);
+        if (!command_queue_.empty()) {
+            StartCommand();
+        }
+    }
+
+    if (!success && !timeout) {
+        ESP_LOGE(TAG, "command error: %.*s", (int)command.command.size() - 2, command.command.c_str());
+    } else if (timeout && debug_) {
+        ESP_LOGW(TAG, "command timeout: %.*s", (int)command.command.size() - 2, command.command.c_str());
+    }
+    if (command.callback) {
+        command.callback(success, command.response);
+    }
+}
+
+namespace {
+
+// Shared with the completion callback, which may still run after a blocking caller gave up
+struct CommandResult {
+    std::promise<bool> promise;
+    std::string response;
+};
+
+// The command timer normally completes the command after timeout_ms, this bound only matters
+// if the timer or the receive task is stuck
+bool WaitCommandResult(std::future<bool>& future, int timeout_ms) {
+    if (future.wait_for(std::chrono::milliseconds(timeout_ms + COMMAND_WAIT_MARGIN_MS)) != std::future_status::ready) {
+        ESP_LOGE(TAG, "command not completed in %d ms", timeout_ms + COMMAND_WAIT_MARGIN_MS);
+        return false;
+    }
+    return future.get();
+}
+
+} // namespace
+
+bool Ml307AtModem::Command(const std::string command, int timeout_ms) {
+    if (timeout_ms <= 0) {
+        // Fire and forget
+        CommandAsync(command, nullptr);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(command_mutex_);
+    auto result = std::make_shared<CommandResult>();
+    auto future = result->promise.get_future();
+    if (!CommandAsync(command, [result](bool success, const std::string& response) {
+        result->response = response;
+        result->promise.set_value(success);
+    }, timeout_ms)) {
+        return false;
+    }
+    if (!WaitCommandResult(future, timeout_ms)) {
+        return false;
+    }
+    response_ = result->response;
+    return true;
+}
+
+bool Ml307AtModem::CommandWithData(const std::string& command, const char* data, size_t length, int timeout_ms) {
+    auto result = std::make_shared<CommandResult>();
+    auto future = result->promise.get_future();
+    if (!CommandWithDataAsync(command, std::string(data, length), [result](bool success, const std::string& response) {
+        result->promise.set_value(success);
+    }, timeout_ms)) {
+        return false;
+    }
+    return WaitCommandResult(future, timeout_ms);
+}
+
+void Ml307AtModem::SetBinaryReceive(int connection_id, bool binary) {
+    if (connection_id < 0 || connection_id >= 32) {
+        return;
+    }
+    if (binary) {
+        binary_receive_mask_ |= 1u << connection_id;
+    } else {
+        binary_receive_mask_ &= ~(1u << connection_id);
+    }
+}
+
+void Ml307AtModem::EventTask() {
+    uart_event_t event;
+    while (true) {
+        if (xQueueReceive(event_queue_handle_, &event, portMAX_DELAY) == pdTRUE) {
+            switch (event.type)
+            {
+            case UART_DATA:
+                xEventGroupSetBits(event_group_handle_, AT_EVENT_DATA_AVAILABLE);
+                break;
+            case UART_BREAK:
+                ESP_LOGI(TAG, "break");
+                break;
+            case UART_BUFFER_FULL:
+                ESP_LOGE(TAG, "buffer full");
+                break;
+            case UART_FIFO_OVF:
+                ESP_LOGE(TAG, "FIFO overflow");
+                NotifyCommandResponse("FIFO_OVERFLOW", {});
+                break;
+            default:
+                ESP_LOGE(TAG, "unknown event type: %d", event.type);
+                break;
+            }
+        }
+    }
+}
+
+void Ml307AtModem::ReceiveTask() {
+    while (true) {
+        auto bits = xEventGroupWaitBits(event_group_handle_, AT_EVENT_DATA_AVAILABLE, pdTRUE, pdFALSE, portMAX_DELAY);
+        if (bits & AT_EVENT_DATA_AVAILABLE) {
+            size_t available;
+            uart_get_buffered_data_len(uart_num_, &available);
+            if (available > 0) {
+                char* rx_buffer_ptr = rx_buffer_.PrepareWrite(available);
+                int length = uart_read_bytes(uart_num_, rx_buffer_ptr, available, portMAX_DELAY);
+                rx_buffer_.CommitWrite(length > 0 ? length : 0);
+                while (ParseResponse()) {}
+            }
+        }
+    }
+}
+
+bool Ml307AtModem::ParseResponse() {
+    // The data prompt is not followed by "\r\n"
+    auto pending = rx_buffer_.Peek();
+    if (!pending.empty() && pending[0] == '>') {
+        rx_buffer_.Consume(1);
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (waiting_prompt_ && !command_queue_.empty()) {
+            waiting_prompt_ = false;
+            auto& command = command_queue_.front();
+            int ret = uart_write_bytes(uart_num_, command.data.data(), command.data.size());
+            if (ret < 0) {
+                ESP_LOGE(TAG, "uart_write_bytes failed: %d", ret);
+            }
+        }
+        return true;
+    }
+
+    if (binary_receive_mask_ != 0 && !pending.empty() && pending[0] == '+') {
+        int result = ParseDataFrame();
+        if (result >= 0) {
+            return result > 0;
+        }
+    }
+
+    std::string_view line;
+    if (!rx_buffer_.NextLine(line)) {
+        return false;
+    }
+
+    // Ignore empty lines
+    if (line.empty()) {
+        return true;
+    }
+    if (debug_) {
+        ESP_LOGI(TAG, "<< %.*s (%u bytes)", (int)std::min(line.size(), (size_t)64), line.data(), line.size());
+    }
+
+    // Parse "+CME ERROR: 123,456,789"
+    if (line[0] == '+') {
+        std::string_view values;
+        auto pos = line.find(": ");
+        if (pos == std::string_view::npos) {
+            urc_command_.assign(line.data() + 1, line.size() - 1);
+        } else {
+            urc_command_.assign(line.data() + 1, pos - 1);
+            values = line.substr(pos + 2);
+        }
+
+        // Parse "string", int, int, ... into AtArgumentValue
+        ParseAtArguments(values, urc_arguments_);
+        NotifyCommandResponse(urc_command_, urc_arguments_);
+    } else if (line == "OK") {
+        CompleteCommand(true);
+    } else if (line == "ERROR") {
+        CompleteCommand(false);
+    } else {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (!command_queue_.empty()) {
+            command_queue_.front().response.assign(line.data(), line.size());
+        }
+    }
+    return true;
+}
+
+// Returns 1 if a binary data frame was consumed, 0 if more data is needed and -1 if it is not a binary frame
+int Ml307AtModem::ParseDataFrame() {
+    auto pending = rx_buffer_.Peek();
+    AtDataFrame frame;
+    auto result = ParseAtDataFrame(pending, frame);
+    if (result == AtDataFrameResult::NotFrame) {
+        return -1;
+    }
+    if (frame.connection_id >= 0 && (frame.connection_id >= 32 || !(binary_receive_mask_ & (1u << frame.connection_id)))) {
+        // Hex encoded connection, the payload is a normal line
+        return -1;
+    }
+    if (result == AtDataFrameResult::Incomplete) {
+        return 0;
+    }
+    if (debug_) {
+        ESP_LOGI(TAG, "<< +MIPURC: \"%.*s\",%d,%u,<binary>", (int)frame.type.size(), frame.type.data(),
+            frame.connection_id, frame.data_length);
+    }
+
+    urc_command_.assign("MIPURC");
+    urc_arguments_.resize(4);
+    urc_arguments_[0] = AtArgumentValue{AtArgumentValue::Type::String, frame.type};
+    urc_arguments_[1] = AtArgumentValue{AtArgumentValue::Type::Int, {}, frame.connection_id};
+    urc_arguments_[2] = AtArgumentValue{AtArgumentValue::Type::Int, {}, (int)frame.data_length};
+    urc_arguments_[3] = AtArgumentValue{AtArgumentValue::Type::String, pending.substr(frame.header_length, frame.data_length)};
+    NotifyCommandResponse(urc_command_, urc_arguments_);
+    rx_buffer_.Consume(frame.header_length + frame.data_length + 2);
+    return 1;
+}
+
+void Ml307AtModem::OnMaterialReady(std::function<void()> callback) {
+    on_material_ready_ = callback;
+}
+
+static int GetConnectionId(const std::string& command, const std::vector<AtArgumentValue>& arguments) {
+    if (command.size() < 6 || command.compare(0, 3, "MIP") != 0) {
+        return -1;
+    }
+    size_t index;
+    if (command == "MIPURC") {
+        index = 1;
+    } else if (command == "MIPOPEN" || command == "MIPCLOSE" || command == "MIPSEND" || command == "MIPSTATE") {
+        index = 0;
+    } else {
+        return -1;
+    }
+    if (arguments.size() <= index || arguments[index].type != AtArgumentValue::Type::Int) {
+        return -1;
+    }
+    return arguments[index].int_value;
+}
+
+void Ml307AtModem::NotifyCommandResponse(const std::string& command, const std::vector<AtArgumentValue>& arguments) {
+    if (command == "CME ERROR") {
+        CompleteCommand(false);
+        return;
+    }
+    if (command == "MIPCALL" && arguments.size() >= 3) {
+        if (arguments[1].int_value == 1) {
+            ip_address_ = arguments[2].string_value;
+            network_ready_ = true;
+            xEventGroupSetBits(event_group_handle_, AT_EVENT_NETWORK_READY);
+        }
+    } else if (command == "ICCID" && arguments.size() >= 1) {
+        iccid_ = arguments[0].string_value;
+    } else if (command == "COPS" && arguments.size() >= 4) {
+        carrier_name_ = arguments[2].string_value;
+    } else if (command == "CSQ" && arguments.size() >= 1) {
+        csq_ = arguments[0].int_value;
+    } else if (command == "MATREADY") {
+        network_ready_ = false;
+        if (on_material_ready_) {
+            on_material_ready_();
+        }
+    } else if (command == "CEREG" && arguments.size() >= 1) {
+        cereg_state_ = CeregState{};
+        if (arguments.size() == 1) {
+            cereg_state_.stat = 0;
+        } else if (arguments.size() >= 4) {
+            int state_index = arguments[1].type == AtArgumentValue::Type::Int ? 1 : 0;
+            cereg_state_.stat = arguments[state_index].int_value;
+            cereg_state_.tac = arguments[state_index + 1].string_value;
+            cereg_state_.ci = arguments[state_index + 2].string_value;
+            if (arguments.size() >= 5) {
+                cereg_state_.AcT = arguments[state_index + 3].int_value;
+            }
+            if (arguments.size() >= 6) {
+                cereg_state_.cause_type = arguments[state_index + 4].int_value;
+            }
+            if (arguments.size() >= 7) {
+                cereg_state_.reject_cause = arguments[state_index + 5].int_value;
+            }
+        }
+        if (debug_) {
+            ESP_LOGI(TAG, "CEREG: %s", cereg_state_.ToString().c_str());
+        }
+    } else if (command == "CPIN" && arguments.size() >= 1) {
+        if (arguments[0].string_value == "READY") {
+            pin_ready_ = 1;
+        } else {
+            pin_ready_ = 2;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& callback : on_data_received_) {
+        callback(command, arguments);
+    }
+
+    // Socket URCs only go to the connection they belong to
+    int connection_id = GetConnectionId(command, arguments);
+    if (connection_id >= 0 && connection_id < ML307_MAX_CONNECTIONS) {
+        for (auto& callback : connection_callbacks_[connection_id]) {
+            callback(command, arguments);
+        }
+    } else if (command == "FIFO_OVERFLOW") {
+        for (auto& callbacks : connection_callbacks_) {
+            for (auto& callback : callbacks) {
+                callback(command, arguments);
+            }
+        }
+    }
+}
+
+void Ml307AtModem::EncodeHexAppend(std::string& dest, const char* data, size_t length) {
+    HexEncodeAppend(dest, data, length);
+}
+
+void Ml307AtModem::DecodeHexAppend(std::string& dest, const char* data, size_t length) {
+    HexDecodeAppend(dest, data, length);
+}
+
+std::string Ml307AtModem::EncodeHex(std::string_view data) {
+    std::string encoded;
+    EncodeHexAppend(encoded, data.data(), data.size());
+    return encoded;
+}
+
+std::string Ml307AtModem::DecodeHex(std::string_view data) {
+    std::string decoded;
+    DecodeHexAppend(decoded, data.data(), data.size());
+    return decoded;
+}
+
+void Ml307AtModem::Reset() {
+    Command("AT+MREBOOT=0");
+}
+
+void Ml307AtModem::ResetConnections() {
+    // Reset HTTP instances
+    Command("AT+MHTTPDEL=0");
+    Command("AT+MHTTPDEL=1");
+    Command("AT+MHTTPDEL=2");
+    Command("AT+MHTTPDEL=3");
+}
\ No newline at end of file
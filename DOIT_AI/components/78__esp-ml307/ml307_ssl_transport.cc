@@ -0,0 +1,233 @@
+#include "ml307_ssl_transport.h"
+#include <esp_log.h>
+#include <cstring>
+#include <atomic>
+#include <memory>
+
+static const char *TAG = "Ml307SslTransport";
+
+
+Ml307SslTransport::Ml307SslTransport(Ml307AtModem& modem, int tcp_id) : modem_(modem), tcp_id_(tcp_id) {
+    event_group_handle_ = xEventGroupCreate();
+
+    command_callback_it_ = modem_.RegisterConnectionCallback(tcp_id_, [this](const std::string& command, const std::vector<AtArgumentValue>& arguments) {
+        if (command == "MIPOPEN" && arguments.size() == 2) {
+            if (arguments[0].int_value == tcp_id_) {
+                if (arguments[1].int_value == 0) {
+                    connected_ = true;
+                    xEventGroupClearBits(event_group_handle_, ML307_SSL_TRANSPORT_DISCONNECTED | ML307_SSL_TRANSPORT_ERROR);
+                    xEventGroupSetBits(event_group_handle_, ML307_SSL_TRANSPORT_CONNECTED);
+                } else {
+                    connected_ = false;
+                    xEventGroupSetBits(event_group_handle_, ML307_SSL_TRANSPORT_ERROR);
+                }
+            }
+        } else if (command == "MIPCLOSE" && arguments.size() == 1) {
+            if (arguments[0].int_value == tcp_id_) {
+                connected_ = false;
+                xEventGroupSetBits(event_group_handle_, ML307_SSL_TRANSPORT_DISCONNECTED);
+            }
+        } else if (command == "MIPSEND" && arguments.size() == 2) {
+            if (arguments[0].int_value == tcp_id_) {
+                acked_bytes_ += arguments[1].int_value;
+                xEventGroupSetBits(event_group_handle_, ML307_SSL_TRANSPORT_SEND_COMPLETE);
+            }
+        } else if (command == "MIPURC" && arguments.size() == 4) {
+            if (arguments[1].int_value == tcp_id_) {
+                if (arguments[0].string_value == "rtcp") {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (binary_mode_) {
+                        rx_buffer_.append(arguments[3].string_value);
+                    } else {
+                        modem_.DecodeHexAppend(rx_buffer_, arguments[3].string_value.data(), arguments[3].string_value.size());
+                    }
+                    xEventGroupSetBits(event_group_handle_, ML307_SSL_TRANSPORT_RECEIVE);
+                } else if (arguments[0].string_value == "disconn") {
+                    connected_ = false;
+                    xEventGroupSetBits(event_group_handle_, ML307_SSL_TRANSPORT_DISCONNECTED);
+                } else {
+                    ESP_LOGE(TAG, "Unknown MIPURC command: %.*s", (int)arguments[0].string_value.size(), arguments[0].string_value.data());
+                }
+            }
+        } else if (command == "MIPSTATE" && arguments.size() == 5) {
+            if (arguments[0].int_value == tcp_id_) {
+                if (arguments[4].string_value == "INITIAL") {
+                    connected_ = false;
+                } else {
+                    connected_ = true;
+                }
+                xEventGroupSetBits(event_group_handle_, ML307_SSL_TRANSPORT_INITIALIZED);
+            }
+        } else if (command == "FIFO_OVERFLOW") {
+            xEventGroupSetBits(event_group_handle_, ML307_SSL_TRANSPORT_ERROR);
+            Disconnect();
+        }
+    });
+}
+
+Ml307SslTransport::~Ml307SslTransport() {
+    modem_.UnregisterConnectionCallback(tcp_id_, command_callback_it_);
+}
+
+bool Ml307SslTransport::Connect(const char* host, int port) {
+    char command[64];
+
+    // Clear bits
+    xEventGroupClearBits(event_group_handle_, ML307_SSL_TRANSPORT_CONNECTED | ML307_SSL_TRANSPORT_DISCONNECTED | ML307_SSL_TRANSPORT_ERROR |
+        ML307_SSL_TRANSPORT_SEND_COMPLETE);
+    queued_bytes_ = 0;
+    acked_bytes_ = 0;
+
+    // 检查这个 id 是否已经连接
+    sprintf(command, "AT+MIPSTATE=%d", tcp_id_);
+    modem_.Command(command);
+    auto bits = xEventGroupWaitBits(event_group_handle_, ML307_SSL_TRANSPORT_INITIALIZED, pdTRUE, pdFALSE, pdMS_TO_TICKS(SSL_CONNECT_TIMEOUT_MS));
+    if (!(bits & ML307_SSL_TRANSPORT_INITIALIZED)) {
+        ESP_LOGE(TAG, "Failed to initialize TCP connection");
+        return false;
+    }
+
+    // 断开之前的连接
+    if (connected_) {
+        Disconnect();
+    }
+
+    // 设置 SSL 配置
+    sprintf(command, "AT+MSSLCFG=\"auth\",0,0");
+    if (!modem_.Command(command)) {
+        ESP_LOGE(TAG, "Failed to set SSL configuration");
+        return false;
+    }
+
+    // 只对 443 端口使用 SSL
+    sprintf(command, "AT+MIPCFG=\"ssl\",%d,%d,0", tcp_id_, port == 443 ? 1 : 0);
+    if (!modem_.Command(command)) {
+        ESP_LOGE(TAG, "Failed to set TCP SSL configuration");
+        return false;
+    }
+
+    // 打开 TCP 连接
+    sprintf(command, "AT+MIPOPEN=%d,\"TCP\",\"%s\",%d,,0", tcp_id_, host, port);
+    if (!modem_.Command(command)) {
+        ESP_LOGE(TAG, "Failed to open TCP connection");
+        return false;
+    }
+
+    // 优先使用二进制收发，模组不支持时退回 HEX 编码
+    sprintf(command, "AT+MIPCFG=\"encoding\",%d,0,0", tcp_id_);
+    binary_mode_ = ML307_BINARY_DATA_MODE && modem_.Command(command);
+    modem_.SetBinaryReceive(tcp_id_, binary_mode_);
+    if (!binary_mode_) {
+        sprintf(command, "AT+MIPCFG=\"encoding\",%d,1,1", tcp_id_);
+        if (!modem_.Command(command)) {
+            ESP_LOGE(TAG, "Failed to set HEX encoding");
+            return false;
+        }
+    }
+
+    // 等待连接完成
+    bits = xEventGroupWaitBits(event_group_handle_, ML307_SSL_TRANSPORT_CONNECTED | ML307_SSL_TRANSPORT_ERROR, pdTRUE, pdFALSE, SSL_CONNECT_TIMEOUT_MS / portTICK_PERIOD_MS);
+    if (bits & ML307_SSL_TRANSPORT_ERROR) {
+        ESP_LOGE(TAG, "Failed to connect to %s:%d", host, port);
+        return false;
+    }
+    return true;
+}
+
+void Ml307SslTransport::Disconnect() {
+    if (!connected_) {
+        return;
+    }
+    connected_ = false;
+    xEventGroupSetBits(event_group_handle_, ML307_SSL_TRANSPORT_DISCONNECTED);
+    std::string command = "AT+MIPCLOSE=" + std::to_string(tcp_id_);
+    modem_.Command(command);
+    modem_.SetBinaryReceive(tcp_id_, false);
+}
+
+// 等待模组确认的总字节数达到 bytes，超时、数据块发送失败或连接断开时返回 false
+bool Ml307SslTransport::WaitForAcked(size_t bytes, const std::atomic<bool>& failed) {
+    // 失败的数据块不会有确认，也不会置位事件，所以分段等待并检查 failed；
+    // 回调可能在 Send 返回后才执行，不让它访问本对象
+    const int poll_ms = 100;
+    int idle_ms = 0;
+    while (acked_bytes_ < bytes) {
+        if (!connected_ || failed) {
+            return false;
+        }
+        // 确认先累加再置位，唤醒后重新比较总数，不依赖某一次置位对应哪个数据块
+        auto bits = xEventGroupWaitBits(event_group_handle_, ML307_SSL_TRANSPORT_SEND_COMPLETE, pdTRUE, pdFALSE, pdMS_TO_TICKS(poll_ms));
+        if (bits & ML307_SSL_TRANSPORT_SEND_COMPLETE) {
+            idle_ms = 0;
+        } else if ((idle_ms += poll_ms) >= SSL_CONNECT_TIMEOUT_MS) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int Ml307SslTransport::Send(const char* data, size_t length) {
+    // HEX 编码时每个字节占两个字符
+    const size_t MAX_PACKET_SIZE = binary_mode_ ? 1460 : 1460 / 2;
+    size_t total_sent = 0;
+    // 排队中的数据块发送失败时置位
+    auto failed = std::make_shared<std::atomic<bool>>(false);
+    auto on_complete = [failed](bool success, const std::string& response) {
+        if (!success) {
+            *failed = true;
+        }
+    };
+
+    while (total_sent < length) {
+        size_t chunk_size = std::min(length - total_sent, MAX_PACKET_SIZE);
+        // 数据块连续排队发送，未确认的数据超过 SSL_SEND_WINDOW 块时等待，避免模组缓冲区溢出
+        size_t window = SSL_SEND_WINDOW * MAX_PACKET_SIZE;
+        bool acked = queued_bytes_ + chunk_size <= acked_bytes_ + window || WaitForAcked(queued_bytes_ + chunk_size - window, *failed);
+
+        std::string command = "AT+MIPSEND=" + std::to_string(tcp_id_) + "," + std::to_string(chunk_size);
+        bool queued = false;
+        if (acked && !*failed) {
+            if (binary_mode_) {
+                queued = modem_.CommandWithDataAsync(std::move(command), std::string(data + total_sent, chunk_size), on_complete);
+            } else {
+                // 直接在command字符串上进行十六进制编码
+                command += ",";
+                modem_.EncodeHexAppend(command, data + total_sent, chunk_size);
+                queued = modem_.CommandAsync(std::move(command), on_complete);
+            }
+        }
+        if (!queued) {
+            ESP_LOGE(TAG, "发送数据块失败");
+            connected_ = false;
+            xEventGroupSetBits(event_group_handle_, ML307_SSL_TRANSPORT_DISCONNECTED);
+            return -1;
+        }
+        queued_bytes_ += chunk_size;
+        total_sent += chunk_size;
+    }
+
+    // 返回前等待本次全部数据被确认
+    if (!WaitForAcked(queued_bytes_, *failed) || *failed) {
+        ESP_LOGE(TAG, "未收到发送确认");
+        return -1;
+    }
+    return length;
+}
+
+int Ml307SslTransport::Receive(char* buffer, size_t bufferSize) {
+    while (rx_buffer_.empty()) {
+        auto bits = xEventGroupWaitBits(event_group_handle_, ML307_SSL_TRANSPORT_RECEIVE | ML307_SSL_TRANSPORT_DISCONNECTED, pdTRUE, pdFALSE, portMAX_DELAY);
+        if (bits & ML307_SSL_TRANSPORT_DISCONNECTED) {
+            return 0;
+        }
+        if (!(bits & ML307_SSL_TRANSPORT_RECEIVE)) {
+            ESP_LOGE(TAG, "Failed to receive data");
+            return -1;
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t length = std::min(bufferSize, rx_buffer_.size());
+    memcpy(buffer, rx_buffer_.data(), length);
+    rx_buffer_.erase(0, length);
+    return length;
+}
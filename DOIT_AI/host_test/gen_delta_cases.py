@@ -0,0 +1,78 @@
+#! /usr/bin/env python3
+"""
+生成 test_delta_patch 使用的源镜像、目标镜像和 scripts/gen_delta.py 生成的补丁
+
+用法:
+    gen_delta_cases.py gen_delta.py 输出目录
+输出目录中每组用例有 <name>.old、<name>.new、<name>.patch 三个文件，用例名称写入 cases.txt
+"""
+import os
+import random
+import subprocess
+import sys
+
+IMAGE_SIZE = 48 * 1024
+
+
+def firmware_like(rng, size):
+    """随机代码段中夹杂重复的结构和大段 0，接近固件的样子"""
+    out = bytearray()
+    table = bytes(rng.getrandbits(8) for _ in range(64))
+    while len(out) < size:
+        kind = rng.random()
+        if kind < 0.6:
+            out += bytes(rng.getrandbits(8) for _ in range(rng.randint(16, 256)))
+        elif kind < 0.85:
+            out += table * rng.randint(1, 4)
+        else:
+            out += bytes(rng.randint(16, 512))
+    return bytes(out[:size])
+
+
+def relocate(rng, data, count):
+    """模拟代码移动后地址常量的变化：修改若干处 4 字节的值"""
+    out = bytearray(data)
+    for _ in range(count):
+        pos = rng.randrange(0, len(out) - 4) & ~3
+        value = int.from_bytes(out[pos:pos + 4], "little") + rng.choice((4, 8, 0x100))
+        out[pos:pos + 4] = (value & 0xffffffff).to_bytes(4, "little")
+    return bytes(out)
+
+
+def make_cases(rng):
+    old = firmware_like(rng, IMAGE_SIZE)
+    middle = len(old) // 2
+    inserted = old[:middle] + firmware_like(rng, 777) + old[middle:]
+    return {
+        "same": (old, old),
+        "relocated": (old, relocate(rng, old, 200)),
+        "inserted": (old, relocate(rng, inserted, 50)),
+        "removed": (old, old[:1000] + old[5000:]),
+        "appended": (old, old + firmware_like(rng, 3000)),
+        "unrelated": (old, firmware_like(rng, IMAGE_SIZE - 123)),
+        "empty_target": (old, b""),
+        "empty_source": (b"", firmware_like(rng, 1000)),
+    }
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(__doc__)
+        sys.exit(1)
+    gen_delta, out_dir = sys.argv[1:]
+    os.makedirs(out_dir, exist_ok=True)
+    cases = make_cases(random.Random(2024))
+    for name, (old, new) in cases.items():
+        path = os.path.join(out_dir, name)
+        with open(path + ".old", "wb") as f:
+            f.write(old)
+        with open(path + ".new", "wb") as f:
+            f.write(new)
+        subprocess.run([sys.executable, gen_delta, "diff", path + ".old", path + ".new", path + ".patch"],
+                       check=True, stdout=subprocess.DEVNULL)
+    with open(os.path.join(out_dir, "cases.txt"), "w") as f:
+        f.write("\n".join(cases) + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,210 @@
+#include "simulated_modem.h"
+#include "hex_codec.h"
+
+#include <driver/uart.h>
+
+#include <cstdlib>
+
+SimulatedModem::SimulatedModem() {
+    auto& uart = host_test_uart();
+    std::lock_guard<std::mutex> lock(uart.mutex);
+    uart.on_write = [this](const char* data, size_t length) {
+        OnWrite(data, length);
+    };
+}
+
+SimulatedModem::~SimulatedModem() {
+    auto& uart = host_test_uart();
+    std::lock_guard<std::mutex> lock(uart.mutex);
+    uart.on_write = nullptr;
+}
+
+void SimulatedModem::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    connections_.clear();
+    commands_.clear();
+    line_.clear();
+    pending_data_ = 0;
+    pending_buffer_.clear();
+    held_acks_.clear();
+    hold_send_acks_ = false;
+    fail_sends_ = false;
+    silent_ = false;
+    send_commands_ = 0;
+}
+
+void SimulatedModem::set_binary_supported(bool supported) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    binary_supported_ = supported;
+}
+
+void SimulatedModem::HoldSendAcks(bool hold) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hold_send_acks_ = hold;
+}
+
+void SimulatedModem::ReleaseSendAcks(size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (count-- > 0 && !held_acks_.empty()) {
+        Reply(held_acks_.front());
+        held_acks_.pop_front();
+    }
+}
+
+size_t SimulatedModem::held_send_acks() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return held_acks_.size();
+}
+
+void SimulatedModem::FailSends(bool fail) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fail_sends_ = fail;
+}
+
+void SimulatedModem::SetSilent(bool silent) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    silent_ = silent;
+}
+
+void SimulatedModem::PushData(int id, const std::string& data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& connection = connections_[id];
+    std::string urc = "+MIPURC: \"" + connection.type + "\"," + std::to_string(id) + "," + std::to_string(data.size()) + ",";
+    if (connection.binary) {
+        urc += data;
+    } else {
+        HexEncodeAppend(urc, data.data(), data.size());
+    }
+    Reply(urc + "\r\n");
+}
+
+std::string SimulatedModem::sent_data(int id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return connections_[id].sent;
+}
+
+bool SimulatedModem::binary(int id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return connections_[id].binary;
+}
+
+size_t SimulatedModem::send_commands() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return send_commands_;
+}
+
+std::vector<std::string> SimulatedModem::commands() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return commands_;
+}
+
+void SimulatedModem::Reply(const std::string& text) {
+    host_test_uart_inject(text.data(), text.size());
+}
+
+void SimulatedModem::OnWrite(const char* data, size_t length) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (length > 0) {
+        if (pending_data_ > 0) {
+            size_t count = std::min(pending_data_, length);
+            pending_buffer_.append(data, count);
+            pending_data_ -= count;
+            data += count;
+            length -= count;
+            if (pending_data_ == 0) {
+                CompleteSend(pending_id_, pending_buffer_);
+                pending_buffer_.clear();
+            }
+            continue;
+        }
+        char c = *data++;
+        length--;
+        if (c == '\n' && !line_.empty() && line_.back() == '\r') {
+            line_.pop_back();
+            HandleCommand(line_);
+            line_.clear();
+        } else {
+            line_.push_back(c);
+        }
+    }
+}
+
+// 按逗号切分参数，去掉引号
+static std::vector<std::string> SplitArguments(const std::string& values) {
+    std::vector<std::string> arguments;
+    std::string item;
+    bool quoted = false;
+    for (char c : values) {
+        if (c == '"') {
+            quoted = !quoted;
+        } else if (c == ',' && !quoted) {
+            arguments.push_back(item);
+            item.clear();
+        } else {
+            item.push_back(c);
+        }
+    }
+    arguments.push_back(item);
+    return arguments;
+}
+
+void SimulatedModem::HandleCommand(const std::string& command) {
+    commands_.push_back(command);
+    if (silent_) {
+        return;
+    }
+
+    auto equal = command.find('=');
+    std::string name = command.substr(0, equal);
+    auto arguments = equal == std::string::npos ? std::vector<std::string>() : SplitArguments(command.substr(equal + 1));
+    int id = arguments.empty() ? -1 : atoi(arguments[0].c_str());
+
+    if (name == "AT+MIPSTATE") {
+        Reply("+MIPSTATE: " + arguments[0] + ",\"TCP\",\"\",0,\"INITIAL\"\r\nOK\r\n");
+    } else if (name == "AT+MIPOPEN" && arguments.size() >= 4) {
+        auto& connection = connections_[id];
+        connection = Connection();
+        connection.type = arguments[1] == "UDP" ? "rudp" : "rtcp";
+        Reply("OK\r\n+MIPOPEN: " + arguments[0] + ",0\r\n");
+    } else if (name == "AT+MIPCLOSE") {
+        Reply("OK\r\n+MIPCLOSE: " + arguments[0] + "\r\n");
+    } else if (name == "AT+MIPCFG" && arguments.size() >= 4 && arguments[0] == "encoding") {
+        int connection_id = atoi(arguments[1].c_str());
+        bool binary = arguments[2] == "0";
+        if (binary && !binary_supported_) {
+            Reply("ERROR\r\n");
+            return;
+        }
+        connections_[connection_id].binary = binary;
+        Reply("OK\r\n");
+    } else if (name == "AT+MIPSEND" && arguments.size() >= 2) {
+        send_commands_++;
+        if (fail_sends_) {
+            Reply("ERROR\r\n");
+            return;
+        }
+        size_t size = atoi(arguments[1].c_str());
+        if (arguments.size() >= 3) {
+            std::string decoded;
+            HexDecodeAppend(decoded, arguments[2].data(), arguments[2].size());
+            CompleteSend(id, decoded);
+        } else {
+            pending_id_ = id;
+            pending_data_ = size;
+            Reply(">");
+        }
+    } else {
+        Reply("OK\r\n");
+    }
+}
+
+void SimulatedModem::CompleteSend(int id, const std::string& data) {
+    connections_[id].sent += data;
+    Reply("OK\r\n");
+    auto ack = "+MIPSEND: " + std::to_string(id) + "," + std::to_string(data.size()) + "\r\n";
+    if (hold_send_acks_) {
+        held_acks_.push_back(ack);
+    } else {
+        Reply(ack);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef SIMULATED_MODEM_H
+#define SIMULATED_MODEM_H
+
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * 模拟的 ML307 模组，作为 host_test 中 UART 的对端，实现 Ml307AtModem 用到的 AT 指令子集：
+ *   AT+MIPSTATE / AT+MIPOPEN / AT+MIPCLOSE / AT+MIPCFG="encoding" / AT+MIPSEND（HEX 和 '>' 二进制两种方式）
+ * 其他指令一律回复 OK。收到的数据按连接保存，PushData 按连接的编码方式发出 +MIPURC
+ */
+class SimulatedModem {
+public:
+    SimulatedModem();
+    ~SimulatedModem();
+
+    // 清除连接和统计，保留当前配置
+    void Reset();
+    // 为 false 时拒绝 AT+MIPCFG="encoding",<id>,0,0，模拟只支持 HEX 的固件
+    void set_binary_supported(bool supported);
+    // 暂存 +MIPSEND 确认，ReleaseSendAcks 时再发出，用于模拟网络发送慢于串口
+    void HoldSendAcks(bool hold);
+    void ReleaseSendAcks(size_t count = SIZE_MAX);
+    size_t held_send_acks();
+    // 收到 AT+MIPSEND 时回复 ERROR
+    void FailSends(bool fail);
+    // 不回复任何指令，模拟模组无响应
+    void SetSilent(bool silent);
+
+    void PushData(int id, const std::string& data);
+    std::string sent_data(int id);
+    bool binary(int id);
+    size_t send_commands();
+    std::vector<std::string> commands();
+
+private:
+    struct Connection {
+        std::string type;
+        bool binary = false;
+        std::string sent;
+    };
+
+    std::mutex mutex_;
+    std::map<int, Connection> connections_;
+    std::vector<std::string> commands_;
+    std::string line_;
+    // '>' 之后等待的原始字节数
+    size_t pending_data_ = 0;
+    int pending_id_ = -1;
+    std::string pending_buffer_;
+    bool binary_supported_ = true;
+    bool hold_send_acks_ = false;
+    bool fail_sends_ = false;
+    bool silent_ = false;
+    std::deque<std::string> held_acks_;
+    size_t send_commands_ = 0;
+
+    void OnWrite(const char* data, size_t length);
+    void HandleCommand(const std::string& command);
+    void CompleteSend(int id, const std::string& data);
+    static void Reply(const std::string& text);
+};
+
+#endif // SIMULATED_MODEM_H
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// 主机测试用的 Application，只提供主循环：Schedule 的任务在一个后台线程中依次执行
+class Application {
+public:
+    static Application& GetInstance() {
+        static auto instance = new Application();
+        return *instance;
+    }
+
+    void Schedule(std::function<void()> callback) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!started_) {
+            started_ = true;
+            std::thread([this]() { MainLoop(); }).detach();
+        }
+        tasks_.push_back(std::move(callback));
+        condition_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<std::function<void()>> tasks_;
+    bool started_ = false;
+
+    void MainLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            condition_.wait(lock, [this]() { return !tasks_.empty(); });
+            auto task = std::move(tasks_.front());
+            tasks_.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+};
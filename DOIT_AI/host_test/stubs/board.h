@@ -0,0 +1,27 @@
+#pragma once
+
+// 只提供被测代码用到的接口，返回值由测试设置
+class Board {
+public:
+    static Board& GetInstance() {
+        static Board instance;
+        return instance;
+    }
+
+    bool battery_available = true;
+    int battery_level = 0;
+    bool battery_charging = false;
+    bool battery_discharging = false;
+    int battery_reads = 0;
+
+    bool GetBatteryLevel(int& level, bool& charging, bool& discharging) {
+        battery_reads++;
+        if (!battery_available) {
+            return false;
+        }
+        level = battery_level;
+        charging = battery_charging;
+        discharging = battery_discharging;
+        return true;
+    }
+};
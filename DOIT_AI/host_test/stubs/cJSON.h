@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstring>
+
+// 只实现被测代码用到的查询接口，测试自己构造节点
+#define cJSON_False (1 << 0)
+#define cJSON_True (1 << 1)
+#define cJSON_Number (1 << 3)
+#define cJSON_String (1 << 4)
+
+typedef struct cJSON {
+    struct cJSON* next;
+    struct cJSON* child;
+    int type;
+    char* valuestring;
+    int valueint;
+    double valuedouble;
+    char* string;
+} cJSON;
+
+inline cJSON* cJSON_GetObjectItem(const cJSON* object, const char* name) {
+    if (object == nullptr) {
+        return nullptr;
+    }
+    for (cJSON* item = object->child; item != nullptr; item = item->next) {
+        if (item->string != nullptr && strcmp(item->string, name) == 0) {
+            return item;
+        }
+    }
+    return nullptr;
+}
+
+inline bool cJSON_IsString(const cJSON* item) {
+    return item != nullptr && (item->type & 0xff) == cJSON_String;
+}
+
+inline bool cJSON_IsNumber(const cJSON* item) {
+    return item != nullptr && (item->type & 0xff) == cJSON_Number;
+}
+
+inline bool cJSON_IsTrue(const cJSON* item) {
+    return item != nullptr && (item->type & 0xff) == cJSON_True;
+}
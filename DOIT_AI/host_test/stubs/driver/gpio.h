@@ -0,0 +1,8 @@
+#pragma once
+
+typedef enum {
+    GPIO_NUM_NC = -1,
+    GPIO_NUM_0 = 0,
+    GPIO_NUM_17 = 17,
+    GPIO_NUM_18 = 18,
+} gpio_num_t;
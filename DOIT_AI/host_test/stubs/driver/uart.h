@@ -0,0 +1,134 @@
+#pragma once
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+
+/*
+ * 主机测试用的 UART，只模拟一个端口
+ * 写入的数据交给 host_test_uart().on_write（模拟的对端），对端用 host_test_uart_inject 送回数据
+ */
+typedef int uart_port_t;
+
+#define UART_NUM_1 1
+#define UART_PIN_NO_CHANGE (-1)
+#define ESP_INTR_FLAG_IRAM (1 << 10)
+
+typedef enum { UART_DATA_8_BITS = 3 } uart_word_length_t;
+typedef enum { UART_PARITY_DISABLE = 0 } uart_parity_t;
+typedef enum { UART_STOP_BITS_1 = 1 } uart_stop_bits_t;
+typedef enum { UART_SCLK_DEFAULT = 0 } uart_sclk_t;
+
+typedef struct {
+    int baud_rate;
+    uart_word_length_t data_bits;
+    uart_parity_t parity;
+    uart_stop_bits_t stop_bits;
+    int flow_ctrl;
+    uint8_t rx_flow_ctrl_thresh;
+    uart_sclk_t source_clk;
+} uart_config_t;
+
+typedef enum {
+    UART_DATA,
+    UART_BREAK,
+    UART_BUFFER_FULL,
+    UART_FIFO_OVF,
+    UART_FRAME_ERR,
+    UART_PARITY_ERR,
+    UART_DATA_BREAK,
+    UART_PATTERN_DET,
+    UART_EVENT_MAX,
+} uart_event_type_t;
+
+typedef struct {
+    uart_event_type_t type;
+    size_t size;
+    bool timeout_flag;
+} uart_event_t;
+
+struct host_test_uart_state {
+    std::mutex mutex;
+    std::string rx;
+    QueueHandle_t event_queue = nullptr;
+    std::function<void(const char* data, size_t length)> on_write;
+    size_t tx_bytes = 0;
+    size_t rx_bytes = 0;
+};
+
+inline host_test_uart_state& host_test_uart() {
+    static auto state = new host_test_uart_state();
+    return *state;
+}
+
+// 对端发送的数据，和真实驱动一样产生 UART_DATA 事件
+inline void host_test_uart_inject(const char* data, size_t length) {
+    auto& uart = host_test_uart();
+    {
+        std::lock_guard<std::mutex> lock(uart.mutex);
+        uart.rx.append(data, length);
+        uart.rx_bytes += length;
+    }
+    uart_event_t event = {UART_DATA, length, false};
+    xQueueSend(uart.event_queue, &event, 0);
+}
+
+inline esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size, int tx_buffer_size, int queue_size,
+    QueueHandle_t* queue, int intr_flags) {
+    auto& uart = host_test_uart();
+    uart.event_queue = xQueueCreate(queue_size, sizeof(uart_event_t));
+    *queue = uart.event_queue;
+    return ESP_OK;
+}
+
+inline esp_err_t uart_driver_delete(uart_port_t port) {
+    return ESP_OK;
+}
+
+inline esp_err_t uart_param_config(uart_port_t port, const uart_config_t* config) {
+    return ESP_OK;
+}
+
+inline esp_err_t uart_set_pin(uart_port_t port, int tx, int rx, int rts, int cts) {
+    return ESP_OK;
+}
+
+inline esp_err_t uart_set_baudrate(uart_port_t port, uint32_t baud_rate) {
+    return ESP_OK;
+}
+
+inline int uart_write_bytes(uart_port_t port, const void* data, size_t length) {
+    auto& uart = host_test_uart();
+    std::function<void(const char*, size_t)> on_write;
+    {
+        std::lock_guard<std::mutex> lock(uart.mutex);
+        uart.tx_bytes += length;
+        on_write = uart.on_write;
+    }
+    if (on_write) {
+        on_write(static_cast<const char*>(data), length);
+    }
+    return length;
+}
+
+inline esp_err_t uart_get_buffered_data_len(uart_port_t port, size_t* size) {
+    auto& uart = host_test_uart();
+    std::lock_guard<std::mutex> lock(uart.mutex);
+    *size = uart.rx.size();
+    return ESP_OK;
+}
+
+inline int uart_read_bytes(uart_port_t port, void* buffer, uint32_t length, TickType_t ticks) {
+    auto& uart = host_test_uart();
+    std::lock_guard<std::mutex> lock(uart.mutex);
+    size_t count = std::min<size_t>(length, uart.rx.size());
+    memcpy(buffer, uart.rx.data(), count);
+    uart.rx.erase(0, count);
+    return count;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+/*
+ * 主机测试用的 heap_caps，直接使用系统堆
+ * host_test_spiram_available 为 false 时 MALLOC_CAP_SPIRAM 的分配失败，相当于没有 PSRAM；
+ * host_test_heap_caps_blocks 是尚未释放的块数
+ */
+inline bool host_test_spiram_available = true;
+inline int host_test_heap_caps_blocks = 0;
+
+inline void* heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps) {
+    if ((caps & MALLOC_CAP_SPIRAM) && !host_test_spiram_available) {
+        return nullptr;
+    }
+    void* p = nullptr;
+    if (posix_memalign(&p, alignment < sizeof(void*) ? sizeof(void*) : alignment, size ? size : 1) != 0) {
+        return nullptr;
+    }
+    host_test_heap_caps_blocks++;
+    return p;
+}
+
+inline void heap_caps_free(void* p) {
+    if (p != nullptr) {
+        host_test_heap_caps_blocks--;
+        free(p);
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "esp_err.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+ * 主机测试用的分区，每个分区的内容来自一个文件
+ * host_test_partitions().Add 注册分区，文件比分区短时剩下的部分按擦除后的 0xFF 读出。
+ * esp_partition_mmap 把文件内容读到内存中返回，munmap 时释放
+ */
+typedef enum {
+    ESP_PARTITION_TYPE_APP = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01,
+    ESP_PARTITION_TYPE_ANY = 0xff,
+} esp_partition_type_t;
+
+typedef enum {
+    ESP_PARTITION_SUBTYPE_DATA_SPIFFS = 0x82,
+    ESP_PARTITION_SUBTYPE_ANY = 0xff,
+} esp_partition_subtype_t;
+
+typedef enum {
+    ESP_PARTITION_MMAP_DATA,
+    ESP_PARTITION_MMAP_INST,
+} esp_partition_mmap_memory_t;
+
+typedef uint32_t esp_partition_mmap_handle_t;
+
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+    bool encrypted;
+    bool readonly;
+} esp_partition_t;
+
+struct host_test_partition_state {
+    std::map<std::string, std::pair<esp_partition_t, std::string>> partitions;
+    std::map<esp_partition_mmap_handle_t, std::vector<uint8_t>> mmaps;
+    esp_partition_mmap_handle_t next_handle = 1;
+
+    void Add(const char* label, esp_partition_type_t type, esp_partition_subtype_t subtype, uint32_t size,
+        const std::string& path) {
+        esp_partition_t partition = {};
+        partition.type = type;
+        partition.subtype = subtype;
+        partition.size = size;
+        strncpy(partition.label, label, sizeof(partition.label) - 1);
+        partitions[label] = {partition, path};
+    }
+
+    const std::string* Path(const esp_partition_t* partition) {
+        auto it = partitions.find(partition->label);
+        return it == partitions.end() ? nullptr : &it->second.second;
+    }
+};
+
+inline host_test_partition_state& host_test_partitions() {
+    static auto state = new host_test_partition_state();
+    return *state;
+}
+
+inline const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+    const char* label) {
+    for (auto& [name, entry] : host_test_partitions().partitions) {
+        auto& partition = entry.first;
+        if ((type == ESP_PARTITION_TYPE_ANY || partition.type == type) &&
+            (subtype == ESP_PARTITION_SUBTYPE_ANY || partition.subtype == subtype) &&
+            (label == nullptr || name == label)) {
+            return &partition;
+        }
+    }
+    return nullptr;
+}
+
+inline esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size) {
+    auto path = host_test_partitions().Path(partition);
+    if (path == nullptr || src_offset > partition->size || size > partition->size - src_offset) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(dst, 0xFF, size);
+    auto file = fopen(path->c_str(), "rb");
+    if (file == nullptr) {
+        return ESP_FAIL;
+    }
+    if (fseek(file, src_offset, SEEK_SET) == 0) {
+        fread(dst, 1, size, file);
+    }
+    fclose(file);
+    return ESP_OK;
+}
+
+inline esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+    esp_partition_mmap_memory_t memory, const void** out_ptr, esp_partition_mmap_handle_t* out_handle) {
+    std::vector<uint8_t> data(size);
+    esp_err_t err = esp_partition_read(partition, offset, data.data(), size);
+    if (err != ESP_OK) {
+        return err;
+    }
+    auto& state = host_test_partitions();
+    auto handle = state.next_handle++;
+    auto& mapped = state.mmaps[handle];
+    mapped = std::move(data);
+    *out_ptr = mapped.data();
+    *out_handle = handle;
+    return ESP_OK;
+}
+
+inline void esp_partition_munmap(esp_partition_mmap_handle_t handle) {
+    host_test_partitions().mmaps.erase(handle);
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "esp_err.h"
+
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * 主机测试用的 esp_timer，到期的回调在一个后台线程中依次执行（相当于 ESP_TIMER_TASK）
+ * 测试也可以用 host_test_fire_timer 按名称立即触发
+ */
+typedef struct host_test_timer* esp_timer_handle_t;
+
+typedef enum {
+    ESP_TIMER_TASK,
+    ESP_TIMER_ISR,
+} esp_timer_dispatch_t;
+
+typedef struct {
+    void (*callback)(void* arg);
+    void* arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char* name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+struct host_test_timer {
+    esp_timer_create_args_t args;
+    uint64_t period_us;
+    int64_t deadline_us;
+    bool active;
+};
+
+inline int64_t esp_timer_get_time() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct host_test_timer_service {
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<host_test_timer*> timers;
+    bool started = false;
+
+    void Run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            int64_t now = esp_timer_get_time();
+            int64_t next = INT64_MAX;
+            host_test_timer* due = nullptr;
+            for (auto timer : timers) {
+                if (!timer->active) {
+                    continue;
+                }
+                if (timer->deadline_us <= now) {
+                    due = timer;
+                    break;
+                }
+                next = std::min(next, timer->deadline_us);
+            }
+            if (due != nullptr) {
+                if (due->period_us > 0) {
+                    due->deadline_us = now + due->period_us;
+                } else {
+                    due->active = false;
+                }
+                auto args = due->args;
+                lock.unlock();
+                args.callback(args.arg);
+                lock.lock();
+                continue;
+            }
+            if (next == INT64_MAX) {
+                condition.wait(lock);
+            } else {
+                condition.wait_for(lock, std::chrono::microseconds(next - now));
+            }
+        }
+    }
+};
+
+inline host_test_timer_service& host_test_timers() {
+    static auto service = new host_test_timer_service();
+    return *service;
+}
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* handle) {
+    auto& service = host_test_timers();
+    std::lock_guard<std::mutex> lock(service.mutex);
+    if (!service.started) {
+        service.started = true;
+        std::thread([&service]() { service.Run(); }).detach();
+    }
+    *handle = new host_test_timer{*args, 0, 0, false};
+    service.timers.push_back(*handle);
+    return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us) {
+    auto& service = host_test_timers();
+    std::lock_guard<std::mutex> lock(service.mutex);
+    timer->period_us = period_us;
+    timer->deadline_us = esp_timer_get_time() + timeout_us;
+    timer->active = true;
+    service.condition.notify_all();
+    return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) {
+    return esp_timer_start(timer, period_us, period_us);
+}
+
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    return esp_timer_start(timer, timeout_us, 0);
+}
+
+inline esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    auto& service = host_test_timers();
+    std::lock_guard<std::mutex> lock(service.mutex);
+    timer->active = false;
+    return ESP_OK;
+}
+
+inline esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    auto& service = host_test_timers();
+    std::lock_guard<std::mutex> lock(service.mutex);
+    for (auto it = service.timers.begin(); it != service.timers.end(); ++it) {
+        if (*it == timer) {
+            service.timers.erase(it);
+            break;
+        }
+    }
+    delete timer;
+    return ESP_OK;
+}
+
+inline bool esp_timer_is_active(esp_timer_handle_t timer) {
+    auto& service = host_test_timers();
+    std::lock_guard<std::mutex> lock(service.mutex);
+    return timer->active;
+}
+
+// 在调用线程中立即触发最近创建的同名定时器，返回是否找到
+inline bool host_test_fire_timer(const char* name) {
+    auto& service = host_test_timers();
+    host_test_timer* found = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(service.mutex);
+        for (auto it = service.timers.rbegin(); it != service.timers.rend(); ++it) {
+            if (strcmp((*it)->args.name, name) == 0) {
+                found = *it;
+                break;
+            }
+        }
+    }
+    if (found == nullptr) {
+        return false;
+    }
+    found->args.callback(found->args.arg);
+    return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+struct host_test_queue {
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::vector<uint8_t>> items;
+    size_t item_size;
+    size_t length;
+};
+
+typedef host_test_queue* QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    auto queue = new host_test_queue();
+    queue->item_size = item_size;
+    queue->length = length;
+    return queue;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (queue->items.size() >= queue->length) {
+        return pdFALSE;
+    }
+    auto data = static_cast<const uint8_t*>(item);
+    queue->items.emplace_back(data, data + queue->item_size);
+    queue->condition.notify_one();
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    auto ready = [queue]() { return !queue->items.empty(); };
+    if (ticks == portMAX_DELAY) {
+        queue->condition.wait(lock, ready);
+    } else if (!queue->condition.wait_for(lock, std::chrono::milliseconds(ticks), ready)) {
+        return pdFALSE;
+    }
+    memcpy(item, queue->items.front().data(), queue->item_size);
+    queue->items.pop_front();
+    return pdTRUE;
+}
+
+// 等待中的任务无法唤醒，被测代码在测试中不删除队列
+inline void vQueueDelete(QueueHandle_t queue) {
+}
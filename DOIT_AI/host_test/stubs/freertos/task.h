@@ -0,0 +1,79 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// 每个任务（以及调用 FreeRTOS 接口的测试线程）一个，用于任务通知
+struct host_test_task {
+    std::mutex mutex;
+    std::condition_variable condition;
+    uint32_t notify_value = 0;
+};
+
+typedef host_test_task* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+inline TaskHandle_t& host_test_current_task() {
+    thread_local TaskHandle_t task = nullptr;
+    return task;
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+    auto& task = host_test_current_task();
+    if (task == nullptr) {
+        task = new host_test_task();
+    }
+    return task;
+}
+
+// 任务在分离的线程中运行，vTaskDelete 不会终止其他线程，被测对象在测试进程中不销毁
+inline BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack_size, void* arg,
+    UBaseType_t priority, TaskHandle_t* handle) {
+    auto task = new host_test_task();
+    if (handle != nullptr) {
+        *handle = task;
+    }
+    std::thread([function, arg, task]() {
+        host_test_current_task() = task;
+        function(arg);
+    }).detach();
+    return pdPASS;
+}
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->notify_value++;
+    task->condition.notify_all();
+    return pdPASS;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    auto task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(task->mutex);
+    auto notified = [task]() { return task->notify_value > 0; };
+    if (ticks == portMAX_DELAY) {
+        task->condition.wait(lock, notified);
+    } else {
+        task->condition.wait_for(lock, std::chrono::milliseconds(ticks), notified);
+    }
+    uint32_t value = task->notify_value;
+    if (value > 0) {
+        task->notify_value = clear_on_exit ? 0 : value - 1;
+    }
+    return value;
+}
+
+inline void vTaskDelete(TaskHandle_t task) {
+}
+
+inline void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    return 0;
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "esp_err.h"
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+/*
+ * 主机测试用的 NVS，所有数据保存在内存中
+ * 和真实的 NVS 一样，nvs_set_* 和 nvs_erase_* 立即写入，每个键的写入是完整的，nvs_commit 不做额外的事。
+ * host_test_nvs().power_loss_after 模拟掉电：再写入这么多次之后所有写操作都失败，已经写入的数据保留
+ */
+#define ESP_ERR_NVS_BASE 0x1100
+#define ESP_ERR_NVS_NOT_FOUND (ESP_ERR_NVS_BASE + 0x02)
+#define ESP_ERR_NVS_INVALID_LENGTH (ESP_ERR_NVS_BASE + 0x0c)
+
+typedef uint32_t nvs_handle_t;
+
+typedef enum {
+    NVS_READONLY,
+    NVS_READWRITE,
+} nvs_open_mode_t;
+
+typedef enum {
+    NVS_TYPE_I32 = 0x14,
+    NVS_TYPE_STR = 0x21,
+    NVS_TYPE_ANY = 0xff,
+} nvs_type_t;
+
+struct host_test_nvs_value {
+    nvs_type_t type;
+    std::string string_value;
+    int32_t int_value;
+
+    bool operator==(const host_test_nvs_value& other) const {
+        return type == other.type && string_value == other.string_value && int_value == other.int_value;
+    }
+};
+
+struct host_test_nvs_state {
+    std::recursive_mutex mutex;
+    std::map<std::string, std::map<std::string, host_test_nvs_value>> namespaces;
+    std::map<nvs_handle_t, std::string> handles;
+    nvs_handle_t next_handle = 1;
+    int writes = 0;
+    int commits = 0;
+    // 小于 0 表示不会掉电
+    int power_loss_after = -1;
+    // nvs_commit 开始时调用，测试用来阻塞提交
+    std::function<void(const std::string& ns)> on_commit;
+
+    // 返回 false 表示已经掉电
+    bool Write() {
+        if (power_loss_after == 0) {
+            return false;
+        }
+        if (power_loss_after > 0) {
+            power_loss_after--;
+        }
+        writes++;
+        return true;
+    }
+};
+
+inline host_test_nvs_state& host_test_nvs() {
+    static auto state = new host_test_nvs_state();
+    return *state;
+}
+
+inline esp_err_t nvs_open(const char* name, nvs_open_mode_t mode, nvs_handle_t* handle) {
+    auto& nvs = host_test_nvs();
+    std::lock_guard<std::recursive_mutex> lock(nvs.mutex);
+    if (mode == NVS_READONLY && nvs.namespaces.find(name) == nvs.namespaces.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    nvs.namespaces[name];
+    *handle = nvs.next_handle++;
+    nvs.handles[*handle] = name;
+    return ESP_OK;
+}
+
+inline void nvs_close(nvs_handle_t handle) {
+    auto& nvs = host_test_nvs();
+    std::lock_guard<std::recursive_mutex> lock(nvs.mutex);
+    nvs.handles.erase(handle);
+}
+
+inline std::map<std::string, host_test_nvs_value>& host_test_nvs_namespace(nvs_handle_t handle) {
+    auto& nvs = host_test_nvs();
+    return nvs.namespaces[nvs.handles.at(handle)];
+}
+
+inline esp_err_t nvs_find_key(nvs_handle_t handle, const char* key, nvs_type_t* type) {
+    std::lock_guard<std::recursive_mutex> lock(host_test_nvs().mutex);
+    auto& space = host_test_nvs_namespace(handle);
+    auto it = space.find(key);
+    if (it == space.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *type = it->second.type;
+    return ESP_OK;
+}
+
+inline esp_err_t nvs_get_str(nvs_handle_t handle, const char* key, char* out_value, size_t* length) {
+    std::lock_guard<std::recursive_mutex> lock(host_test_nvs().mutex);
+    auto& space = host_test_nvs_namespace(handle);
+    auto it = space.find(key);
+    if (it == space.end() || it->second.type != NVS_TYPE_STR) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    size_t required = it->second.string_value.size() + 1;
+    if (out_value == nullptr) {
+        *length = required;
+        return ESP_OK;
+    }
+    if (*length < required) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(out_value, it->second.string_value.c_str(), required);
+    *length = required;
+    return ESP_OK;
+}
+
+inline esp_err_t nvs_get_i32(nvs_handle_t handle, const char* key, int32_t* out_value) {
+    std::lock_guard<std::recursive_mutex> lock(host_test_nvs().mutex);
+    auto& space = host_test_nvs_namespace(handle);
+    auto it = space.find(key);
+    if (it == space.end() || it->second.type != NVS_TYPE_I32) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *out_value = it->second.int_value;
+    return ESP_OK;
+}
+
+inline esp_err_t nvs_set_str(nvs_handle_t handle, const char* key, const char* value) {
+    auto& nvs = host_test_nvs();
+    std::lock_guard<std::recursive_mutex> lock(nvs.mutex);
+    if (!nvs.Write()) {
+        return ESP_FAIL;
+    }
+    host_test_nvs_namespace(handle)[key] = {NVS_TYPE_STR, value, 0};
+    return ESP_OK;
+}
+
+inline esp_err_t nvs_set_i32(nvs_handle_t handle, const char* key, int32_t value) {
+    auto& nvs = host_test_nvs();
+    std::lock_guard<std::recursive_mutex> lock(nvs.mutex);
+    if (!nvs.Write()) {
+        return ESP_FAIL;
+    }
+    host_test_nvs_namespace(handle)[key] = {NVS_TYPE_I32, "", value};
+    return ESP_OK;
+}
+
+inline esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key) {
+    auto& nvs = host_test_nvs();
+    std::lock_guard<std::recursive_mutex> lock(nvs.mutex);
+    auto& space = host_test_nvs_namespace(handle);
+    if (space.find(key) == space.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (!nvs.Write()) {
+        return ESP_FAIL;
+    }
+    space.erase(key);
+    return ESP_OK;
+}
+
+// 逐个删除，掉电时可能只删除了一部分
+inline esp_err_t nvs_erase_all(nvs_handle_t handle) {
+    auto& nvs = host_test_nvs();
+    std::lock_guard<std::recursive_mutex> lock(nvs.mutex);
+    auto& space = host_test_nvs_namespace(handle);
+    while (!space.empty()) {
+        if (!nvs.Write()) {
+            return ESP_FAIL;
+        }
+        space.erase(space.begin());
+    }
+    return ESP_OK;
+}
+
+inline esp_err_t nvs_commit(nvs_handle_t handle) {
+    auto& nvs = host_test_nvs();
+    std::function<void(const std::string&)> on_commit;
+    std::string ns;
+    {
+        std::lock_guard<std::recursive_mutex> lock(nvs.mutex);
+        on_commit = nvs.on_commit;
+        ns = nvs.handles.at(handle);
+    }
+    if (on_commit) {
+        on_commit(ns);
+    }
+    std::lock_guard<std::recursive_mutex> lock(nvs.mutex);
+    if (nvs.power_loss_after == 0) {
+        return ESP_FAIL;
+    }
+    nvs.commits++;
+    return ESP_OK;
+}
@@ -0,0 +1,168 @@
+#include "assets.h"
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace {
+
+// 资源包由 scripts/pack_assets.py 打包 main/assets/common 中的音效生成，路径由 CMake 传入
+constexpr uint32_t kPartitionSize = 0x80000;
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kEntrySize = 48;
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    EXPECT_TRUE(file.good()) << "Missing " << path;
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+std::string WriteTempFile(const std::string& name, const std::string& content) {
+    auto path = ::testing::TempDir() + "test_assets_" + name;
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << content;
+    return path;
+}
+
+// 打包前的文件，名称和 main/CMakeLists.txt 中的一样是 sounds/<文件名>
+std::map<std::string, std::string> SourceFiles() {
+    std::map<std::string, std::string> files;
+    for (auto& entry : std::filesystem::directory_iterator(ASSETS_SOURCE_DIR)) {
+        if (entry.path().extension() == ".p3") {
+            files["sounds/" + entry.path().filename().string()] = ReadFile(entry.path().string());
+        }
+    }
+    return files;
+}
+
+// 在资源包的索引中查找文件数据的偏移
+size_t DataOffset(const std::string& pack, const std::string& name) {
+    uint16_t count;
+    memcpy(&count, pack.data() + 6, sizeof(count));
+    for (int i = 0; i < count; i++) {
+        auto entry = pack.data() + kHeaderSize + i * kEntrySize;
+        if (name == entry) {
+            uint32_t offset;
+            memcpy(&offset, entry + 36, sizeof(offset));
+            return offset;
+        }
+    }
+    ADD_FAILURE() << "No " << name << " in pack";
+    return 0;
+}
+
+// Assets 是单例，第一次 GetInstance 时按当时注册的分区映射，
+// 所以每个用例都在子进程中注册分区后再检查，子进程中有 EXPECT 失败时以 1 退出
+template <typename Check>
+void CheckAssets(const std::string& path, uint32_t partition_size, Check check) {
+    EXPECT_EXIT({
+        if (!path.empty()) {
+            host_test_partitions().Add("assets", ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS,
+                partition_size, path);
+        }
+        check(Assets::GetInstance());
+        fflush(stdout);
+        _exit(::testing::Test::HasFailure() ? 1 : 0);
+    }, ::testing::ExitedWithCode(0), "");
+}
+
+} // namespace
+
+TEST(Assets, ReadsEveryFile) {
+    auto files = SourceFiles();
+    ASSERT_FALSE(files.empty());
+    CheckAssets(ASSETS_PACK, kPartitionSize, [&files](Assets& assets) {
+        EXPECT_TRUE(assets.available());
+        for (auto& [name, content] : files) {
+            EXPECT_EQ(assets.Get(name), content) << name;
+            // 第二次取出时不再校验，结果相同
+            EXPECT_EQ(assets.Get(name), content) << name;
+        }
+    });
+}
+
+TEST(Assets, MissingNameReturnsEmpty) {
+    auto files = SourceFiles();
+    ASSERT_FALSE(files.empty());
+    auto first = files.begin()->first;
+    CheckAssets(ASSETS_PACK, kPartitionSize, [&first](Assets& assets) {
+        EXPECT_TRUE(assets.available());
+        EXPECT_TRUE(assets.Get("sounds/missing.p3").empty());
+        EXPECT_TRUE(assets.Get("").empty());
+        // 排在所有文件前后的名称，以及已有文件名称的前缀和加长
+        EXPECT_TRUE(assets.Get("a").empty());
+        EXPECT_TRUE(assets.Get("zzz").empty());
+        EXPECT_TRUE(assets.Get(first.substr(0, first.size() - 1)).empty());
+        EXPECT_TRUE(assets.Get(first + "x").empty());
+        EXPECT_FALSE(assets.Get(first).empty());
+    });
+}
+
+TEST(Assets, FlippedDataByteFailsOnlyThatFile) {
+    auto files = SourceFiles();
+    ASSERT_GE(files.size(), 2u);
+    auto pack = ReadFile(ASSETS_PACK);
+    auto corrupted = files.begin()->first;
+    pack[DataOffset(pack, corrupted) + files[corrupted].size() / 2] ^= 0x01;
+    auto path = WriteTempFile("flipped_data.bin", pack);
+
+    CheckAssets(path, kPartitionSize, [&files, &corrupted](Assets& assets) {
+        // 索引没有损坏，分区可以映射，损坏的文件第一次取出时校验失败，之后一直视为不存在
+        EXPECT_TRUE(assets.available());
+        EXPECT_TRUE(assets.Get(corrupted).empty());
+        EXPECT_TRUE(assets.Get(corrupted).empty());
+        for (auto& [name, content] : files) {
+            if (name != corrupted) {
+                EXPECT_EQ(assets.Get(name), content) << name;
+            }
+        }
+    });
+}
+
+TEST(Assets, FlippedIndexByteRejectsPack) {
+    auto files = SourceFiles();
+    auto pack = ReadFile(ASSETS_PACK);
+    // 第一个文件的名称
+    pack[kHeaderSize] ^= 0x01;
+    auto path = WriteTempFile("flipped_index.bin", pack);
+
+    CheckAssets(path, kPartitionSize, [&files](Assets& assets) {
+        EXPECT_FALSE(assets.available());
+        for (auto& [name, content] : files) {
+            EXPECT_TRUE(assets.Get(name).empty()) << name;
+        }
+    });
+}
+
+TEST(Assets, PackLargerThanPartitionIsRejected) {
+    auto pack = ReadFile(ASSETS_PACK);
+    auto size = (uint32_t)pack.size();
+    CheckAssets(ASSETS_PACK, size - 1, [](Assets& assets) {
+        EXPECT_FALSE(assets.available());
+    });
+}
+
+TEST(Assets, ErasedOrMissingPartition) {
+    auto files = SourceFiles();
+    ASSERT_FALSE(files.empty());
+    auto name = files.begin()->first;
+    // 分区存在但没有烧录资源，读出的都是 0xFF
+    CheckAssets(WriteTempFile("erased.bin", ""), kPartitionSize, [&name](Assets& assets) {
+        EXPECT_FALSE(assets.available());
+        EXPECT_TRUE(assets.Get(name).empty());
+    });
+    // 分区表中没有 assets 分区
+    CheckAssets("", kPartitionSize, [&name](Assets& assets) {
+        EXPECT_FALSE(assets.available());
+        EXPECT_TRUE(assets.Get(name).empty());
+    });
+}
@@ -0,0 +1,167 @@
+#include "at_parser.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<AtArgumentValue> Parse(std::string_view values) {
+    std::vector<AtArgumentValue> arguments;
+    ParseAtArguments(values, arguments);
+    return arguments;
+}
+
+// 按给定的分块大小写入缓冲区，取出全部完整的行
+std::vector<std::string> SplitLines(const std::string& input, size_t chunk_size, AtReceiveBuffer& buffer) {
+    std::vector<std::string> lines;
+    for (size_t pos = 0; pos < input.size(); pos += chunk_size) {
+        size_t length = std::min(chunk_size, input.size() - pos);
+        memcpy(buffer.PrepareWrite(length), input.data() + pos, length);
+        buffer.CommitWrite(length);
+        std::string_view line;
+        while (buffer.NextLine(line)) {
+            lines.emplace_back(line);
+        }
+    }
+    return lines;
+}
+
+// 参照实现：按 "\r\n" 切分，最后不完整的一行留在缓冲区
+std::vector<std::string> ReferenceLines(const std::string& input, std::string& rest) {
+    std::vector<std::string> lines;
+    size_t start = 0;
+    size_t pos;
+    while ((pos = input.find("\r\n", start)) != std::string::npos) {
+        lines.push_back(input.substr(start, pos - start));
+        start = pos + 2;
+    }
+    rest = input.substr(start);
+    return lines;
+}
+
+TEST(AtParserTest, Integers) {
+    auto arguments = Parse("0,-5,2147483647,-2147483648");
+    ASSERT_EQ(arguments.size(), 4u);
+    for (auto& argument : arguments) {
+        EXPECT_EQ(argument.type, AtArgumentValue::Type::Int);
+    }
+    EXPECT_EQ(arguments[0].int_value, 0);
+    EXPECT_EQ(arguments[1].int_value, -5);
+    EXPECT_EQ(arguments[2].int_value, 2147483647);
+    EXPECT_EQ(arguments[3].int_value, INT_MIN);
+}
+
+TEST(AtParserTest, TenDigitIntegers) {
+    auto arguments = Parse("1234567890,-1000000000");
+    ASSERT_EQ(arguments.size(), 2u);
+    EXPECT_EQ(arguments[0].type, AtArgumentValue::Type::Int);
+    EXPECT_EQ(arguments[0].int_value, 1234567890);
+    EXPECT_EQ(arguments[1].type, AtArgumentValue::Type::Int);
+    EXPECT_EQ(arguments[1].int_value, -1000000000);
+}
+
+TEST(AtParserTest, IntegersBeyondIntRangeAreDouble) {
+    auto arguments = Parse("2147483648,-2147483649,460001234567890");
+    ASSERT_EQ(arguments.size(), 3u);
+    EXPECT_EQ(arguments[0].type, AtArgumentValue::Type::Double);
+    EXPECT_EQ(arguments[0].double_value, 2147483648.0);
+    EXPECT_EQ(arguments[1].type, AtArgumentValue::Type::Double);
+    EXPECT_EQ(arguments[1].double_value, -2147483649.0);
+    // IMSI 之类的长数字仍然可以从原始文本读取
+    EXPECT_EQ(arguments[2].type, AtArgumentValue::Type::Double);
+    EXPECT_EQ(arguments[2].string_value, "460001234567890");
+}
+
+TEST(AtParserTest, StringsAndDoubles) {
+    auto arguments = Parse("\"rtcp\",\"a,b\",1.5,-,abc,");
+    ASSERT_EQ(arguments.size(), 5u);
+    EXPECT_EQ(arguments[0].type, AtArgumentValue::Type::String);
+    EXPECT_EQ(arguments[0].string_value, "rtcp");
+    EXPECT_EQ(arguments[1].string_value, "a,b");
+    EXPECT_EQ(arguments[2].type, AtArgumentValue::Type::Double);
+    EXPECT_DOUBLE_EQ(arguments[2].double_value, 1.5);
+    EXPECT_EQ(arguments[3].type, AtArgumentValue::Type::String);
+    EXPECT_EQ(arguments[3].string_value, "-");
+    EXPECT_EQ(arguments[4].type, AtArgumentValue::Type::String);
+    EXPECT_EQ(arguments[4].string_value, "abc");
+}
+
+TEST(AtParserTest, EmptyAndUnterminated) {
+    EXPECT_TRUE(Parse("").empty());
+    auto arguments = Parse("1,,\"open");
+    ASSERT_EQ(arguments.size(), 3u);
+    EXPECT_EQ(arguments[1].string_value, "");
+    EXPECT_EQ(arguments[2].string_value, "open");
+}
+
+TEST(AtParserTest, LinesAcrossChunks) {
+    const std::string input = "OK\r\n+CSQ: 20,99\r\n\r\nbare\nline\r\n+MIPURC: \"rtcp\",1,";
+    for (size_t chunk_size : {1, 3, 7, 64}) {
+        AtReceiveBuffer buffer(8);
+        auto lines = SplitLines(input, chunk_size, buffer);
+        EXPECT_EQ(lines, (std::vector<std::string>{"OK", "+CSQ: 20,99", "", "bare\nline"})) << chunk_size;
+        EXPECT_EQ(buffer.Peek(), "+MIPURC: \"rtcp\",1,");
+    }
+}
+
+TEST(AtParserTest, DataFrame) {
+    AtDataFrame frame;
+    std::string data = "+MIPURC: \"rtcp\",2,4,a\r\nb\r\nOK\r\n";
+    ASSERT_EQ(ParseAtDataFrame(data, frame), AtDataFrameResult::Complete);
+    EXPECT_EQ(frame.type, "rtcp");
+    EXPECT_EQ(frame.connection_id, 2);
+    EXPECT_EQ(frame.data_length, 4u);
+    EXPECT_EQ(data.substr(frame.header_length, frame.data_length), "a\r\nb");
+
+    for (size_t length = 0; length < frame.header_length + frame.data_length + 2; ++length) {
+        EXPECT_EQ(ParseAtDataFrame(std::string_view(data).substr(0, length), frame), AtDataFrameResult::Incomplete) << length;
+    }
+    EXPECT_EQ(ParseAtDataFrame("+MIPURC: \"disconn\",1\r\n", frame), AtDataFrameResult::NotFrame);
+    EXPECT_EQ(ParseAtDataFrame("+MIPURC: \"rudp\",x", frame), AtDataFrameResult::NotFrame);
+    EXPECT_EQ(ParseAtDataFrame("OK\r\n", frame), AtDataFrameResult::NotFrame);
+}
+
+// 随机输入按随机分块写入，行切分结果和参照实现一致，解析不越界（配合 -fsanitize=address 运行）
+TEST(AtParserTest, Fuzz) {
+    std::mt19937 random(20261018);
+    const char alphabet[] = "a1-.,\"\r\n+: ";
+    std::vector<AtArgumentValue> arguments;
+    for (int iteration = 0; iteration < 2000; ++iteration) {
+        std::string input(random() % 256, '\0');
+        for (auto& c : input) {
+            c = random() % 8 == 0 ? (char)random() : alphabet[random() % (sizeof(alphabet) - 1)];
+        }
+
+        AtReceiveBuffer buffer(random() % 64 + 1);
+        std::vector<std::string> lines;
+        for (size_t pos = 0; pos < input.size();) {
+            size_t length = std::min<size_t>(random() % 17 + 1, input.size() - pos);
+            memcpy(buffer.PrepareWrite(length), input.data() + pos, length);
+            buffer.CommitWrite(length);
+            pos += length;
+
+            AtDataFrame frame;
+            if (ParseAtDataFrame(buffer.Peek(), frame) == AtDataFrameResult::Complete) {
+                ASSERT_LE(frame.header_length + frame.data_length + 2, buffer.size());
+            }
+            std::string_view line;
+            while (buffer.NextLine(line)) {
+                lines.emplace_back(line);
+                ParseAtArguments(line, arguments);
+                for (auto& argument : arguments) {
+                    ASSERT_GE(argument.string_value.data(), line.data());
+                    ASSERT_LE(argument.string_value.data() + argument.string_value.size(), line.data() + line.size());
+                }
+            }
+        }
+
+        std::string rest;
+        ASSERT_EQ(lines, ReferenceLines(input, rest));
+        ASSERT_EQ(buffer.Peek(), rest);
+    }
+}
+
+} // namespace
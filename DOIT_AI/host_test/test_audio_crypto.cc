@@ -0,0 +1,209 @@
+// MQTT/UDP 音频包的 AES-CTR 加解密，stubs/mbedtls/aes.h 是纯软件实现
+#include <mbedtls/aes.h>
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::atomic<size_t> g_allocations = 0;
+
+void* operator new(size_t size) {
+    g_allocations++;
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+namespace {
+
+std::vector<uint8_t> FromHex(const char* hex) {
+    std::vector<uint8_t> bytes;
+    for (; hex[0] && hex[1]; hex += 2) {
+        bytes.push_back((uint8_t)std::stoi(std::string(hex, 2), nullptr, 16));
+    }
+    return bytes;
+}
+
+class AudioCryptoTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        mbedtls_aes_init(&aes_ctx_);
+        // 服务器 hello 中的 key 和 nonce 都是 16 字节
+        auto key = FromHex("2b7e151628aed2a6abf7158809cf4f3c");
+        ASSERT_EQ(mbedtls_aes_setkey_enc(&aes_ctx_, key.data(), 128), 0);
+        aes_nonce_ = std::string(16, '\0');
+        aes_nonce_[0] = 0x01;
+        udp_packet_.reserve(1500);
+    }
+
+    void TearDown() override {
+        mbedtls_aes_free(&aes_ctx_);
+    }
+
+    // 改为原地加密之前的 MqttProtocol::SendAudio：nonce 和密文各一个临时 std::string
+    std::string SendWithTemporaries(const std::vector<uint8_t>& payload, uint32_t timestamp) {
+        std::string nonce(aes_nonce_);
+        *(uint16_t*)&nonce[2] = htons(payload.size());
+        *(uint32_t*)&nonce[8] = htonl(timestamp);
+        *(uint32_t*)&nonce[12] = htonl(++local_sequence_);
+
+        std::string encrypted;
+        encrypted.resize(aes_nonce_.size() + payload.size());
+        memcpy(encrypted.data(), nonce.data(), nonce.size());
+
+        size_t nc_off = 0;
+        uint8_t stream_block[16] = {0};
+        mbedtls_aes_crypt_ctr(&aes_ctx_, payload.size(), &nc_off, (uint8_t*)nonce.c_str(), stream_block,
+            payload.data(), (uint8_t*)&encrypted[nonce.size()]);
+        return encrypted;
+    }
+
+    // 现在的 MqttProtocol::SendAudio：头部和 payload 写入预分配的 udp_packet_ 后原地加密
+    const std::string& SendInPlace(const std::vector<uint8_t>& payload, uint32_t timestamp) {
+        const size_t nonce_size = aes_nonce_.size();
+        udp_packet_.resize(nonce_size + payload.size());
+        auto header = (uint8_t*)udp_packet_.data();
+        memcpy(header, aes_nonce_.data(), nonce_size);
+        *(uint16_t*)&header[2] = htons(payload.size());
+        *(uint32_t*)&header[8] = htonl(timestamp);
+        *(uint32_t*)&header[12] = htonl(++local_sequence_);
+        memcpy(header + nonce_size, payload.data(), payload.size());
+
+        uint8_t nonce_counter[16];
+        memcpy(nonce_counter, header, sizeof(nonce_counter));
+        size_t nc_off = 0;
+        uint8_t stream_block[16] = {0};
+        mbedtls_aes_crypt_ctr(&aes_ctx_, payload.size(), &nc_off, nonce_counter, stream_block, header + nonce_size,
+            header + nonce_size);
+        return udp_packet_;
+    }
+
+    // MqttProtocol 的 UDP 接收回调：解密到新的 payload，交给解码队列
+    std::vector<uint8_t> Receive(const std::string& data) {
+        size_t decrypted_size = data.size() - aes_nonce_.size();
+        size_t nc_off = 0;
+        uint8_t stream_block[16] = {0};
+        uint8_t nonce[16];
+        memcpy(nonce, data.data(), sizeof(nonce));
+        std::vector<uint8_t> payload;
+        payload.resize(decrypted_size);
+        mbedtls_aes_crypt_ctr(&aes_ctx_, decrypted_size, &nc_off, nonce, stream_block,
+            (const uint8_t*)data.data() + aes_nonce_.size(), payload.data());
+        return payload;
+    }
+
+    mbedtls_aes_context aes_ctx_;
+    std::string aes_nonce_;
+    std::string udp_packet_;
+    uint32_t local_sequence_ = 0;
+};
+
+} // namespace
+
+// NIST SP 800-38A F.5.1 CTR-AES128.Encrypt
+TEST_F(AudioCryptoTest, MatchesNistVector) {
+    auto counter = FromHex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+    auto plaintext = FromHex("6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+                             "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710");
+    auto expected = FromHex("874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff"
+                            "5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009cee");
+    // 分两次调用，检查 nc_off 和 stream_block 在调用之间保留未用完的密钥流
+    std::vector<uint8_t> output(plaintext.size());
+    size_t nc_off = 0;
+    uint8_t stream_block[16] = {0};
+    ASSERT_EQ(mbedtls_aes_crypt_ctr(&aes_ctx_, 21, &nc_off, counter.data(), stream_block, plaintext.data(),
+        output.data()), 0);
+    EXPECT_EQ(nc_off, 5u);
+    ASSERT_EQ(mbedtls_aes_crypt_ctr(&aes_ctx_, plaintext.size() - 21, &nc_off, counter.data(), stream_block,
+        plaintext.data() + 21, output.data() + 21), 0);
+    EXPECT_EQ(output, expected);
+    EXPECT_EQ(mbedtls_aes_setkey_enc(&aes_ctx_, counter.data(), 192), MBEDTLS_ERR_AES_INVALID_KEY_LENGTH);
+}
+
+TEST_F(AudioCryptoTest, InPlaceMatchesTemporaries) {
+    std::mt19937 random(26);
+    for (size_t size : {0, 1, 15, 16, 17, 120, 1400}) {
+        std::vector<uint8_t> payload(size);
+        for (auto& byte : payload) {
+            byte = random();
+        }
+        local_sequence_ = 100;
+        auto old_packet = SendWithTemporaries(payload, 4800);
+        local_sequence_ = 100;
+        auto& packet = SendInPlace(payload, 4800);
+        EXPECT_EQ(packet, old_packet) << size;
+
+        // 头部保持原始 nonce，接收端用它解密
+        EXPECT_EQ(ntohs(*(uint16_t*)&packet[2]), size);
+        EXPECT_EQ(ntohl(*(uint32_t*)&packet[12]), 101u);
+        EXPECT_EQ(Receive(packet), payload) << size;
+    }
+}
+
+// 60ms 一帧的 Opus 包，比较两种发送方式每个包的耗时和分配次数，以及接收端解密的耗时
+TEST_F(AudioCryptoTest, Benchmark) {
+    constexpr int kPackets = 20000;
+    constexpr size_t kPayloadSize = 120;
+    std::vector<uint8_t> payload(kPayloadSize, 0x5a);
+    using Clock = std::chrono::steady_clock;
+    auto per_packet = [](Clock::duration elapsed) {
+        return std::chrono::duration<double, std::nano>(elapsed).count() / kPackets;
+    };
+
+    size_t sent_bytes = 0;
+    size_t allocations = g_allocations;
+    auto start = Clock::now();
+    for (int i = 0; i < kPackets; i++) {
+        sent_bytes += SendWithTemporaries(payload, i * 960).size();
+    }
+    double old_ns = per_packet(Clock::now() - start);
+    double old_allocations = (double)(g_allocations - allocations) / kPackets;
+
+    SendInPlace(payload, 0);
+    allocations = g_allocations;
+    start = Clock::now();
+    for (int i = 0; i < kPackets; i++) {
+        sent_bytes += SendInPlace(payload, i * 960).size();
+    }
+    double new_ns = per_packet(Clock::now() - start);
+    double new_allocations = (double)(g_allocations - allocations) / kPackets;
+
+    auto packet = SendInPlace(payload, 0);
+    size_t received_bytes = 0;
+    allocations = g_allocations;
+    start = Clock::now();
+    for (int i = 0; i < kPackets; i++) {
+        received_bytes += Receive(packet).size();
+    }
+    double receive_ns = per_packet(Clock::now() - start);
+    double receive_allocations = (double)(g_allocations - allocations) / kPackets;
+
+    printf("send, temporaries %8.1f ns/packet %5.2f allocations/packet (%zu byte payload)\n", old_ns, old_allocations,
+        kPayloadSize);
+    printf("send, in place    %8.1f ns/packet %5.2f allocations/packet\n", new_ns, new_allocations);
+    printf("receive           %8.1f ns/packet %5.2f allocations/packet\n", receive_ns, receive_allocations);
+
+    EXPECT_EQ(sent_bytes, 2u * kPackets * (16 + kPayloadSize));
+    EXPECT_EQ(received_bytes, kPackets * kPayloadSize);
+    EXPECT_EQ(new_allocations, 0.0);
+    EXPECT_EQ(old_allocations, 2.0);
+    // 接收端每个包分配一次 payload，由解码任务释放
+    EXPECT_EQ(receive_allocations, 1.0);
+}
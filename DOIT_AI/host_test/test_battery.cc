@@ -0,0 +1,91 @@
+// Battery 直接定义在 .cc 中，测试把它包含进来
+#include "iot/things/battery.cc"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+namespace {
+
+class BatteryTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        board_ = Board();
+        board_.battery_level = 80;
+        board_.battery_charging = false;
+        battery_ = std::make_unique<iot::Battery>();
+        battery_->OnStateChanged([this]() {
+            notifications_++;
+        });
+    }
+
+    Board& board_ = Board::GetInstance();
+    std::unique_ptr<iot::Battery> battery_;
+    int notifications_ = 0;
+};
+
+TEST_F(BatteryTest, FirstGetterReadsBoard) {
+    EXPECT_EQ(board_.battery_reads, 0);
+    EXPECT_EQ(battery_->GetStateJson(), R"({"name":"Battery","state":{"level":80,"charging":false}})");
+    // 两个 getter 只触发一次读取
+    EXPECT_EQ(board_.battery_reads, 1);
+}
+
+TEST_F(BatteryTest, GettersDoNotReadBoardAfterRefresh) {
+    battery_->GetStateJson();
+    board_.battery_level = 50;
+    EXPECT_EQ(battery_->GetStateJson(), R"({"name":"Battery","state":{"level":80,"charging":false}})");
+    EXPECT_EQ(board_.battery_reads, 1);
+}
+
+TEST_F(BatteryTest, TimerRefreshUpdatesGetters) {
+    battery_->GetStateJson();
+    notifications_ = 0;
+
+    board_.battery_level = 79;
+    board_.battery_charging = true;
+    ASSERT_TRUE(host_test_fire_timer("battery_refresh"));
+    EXPECT_EQ(notifications_, 2);
+
+    std::string delta;
+    ASSERT_TRUE(battery_->GetStateDeltaJson(delta));
+    EXPECT_EQ(delta, R"({"name":"Battery","state":{"level":79,"charging":true}})");
+}
+
+TEST_F(BatteryTest, UnchangedRefreshDoesNotNotify) {
+    battery_->GetStateJson();
+    notifications_ = 0;
+
+    ASSERT_TRUE(host_test_fire_timer("battery_refresh"));
+    EXPECT_EQ(notifications_, 0);
+    std::string delta;
+    EXPECT_FALSE(battery_->GetStateDeltaJson(delta));
+}
+
+TEST_F(BatteryTest, UnavailableBatteryReportsZero) {
+    board_.battery_available = false;
+    EXPECT_EQ(battery_->GetStateJson(), R"({"name":"Battery","state":{"level":0,"charging":false}})");
+}
+
+// 定时器任务刷新的同时主任务读取，读到的电量只能是新旧值之一
+TEST_F(BatteryTest, ConcurrentRefreshAndGetters) {
+    battery_->GetStateJson();
+    battery_->OnStateChanged(nullptr);
+
+    std::atomic<bool> done = false;
+    std::thread refresher([&]() {
+        for (int i = 0; i < 10000; ++i) {
+            board_.battery_level = i % 2 ? 20 : 80;
+            host_test_fire_timer("battery_refresh");
+        }
+        done = true;
+    });
+    while (!done) {
+        auto json = battery_->GetStateJson();
+        EXPECT_TRUE(json.find("\"level\":20") != std::string::npos || json.find("\"level\":80") != std::string::npos) << json;
+    }
+    refresher.join();
+}
+
+} // namespace
@@ -0,0 +1,199 @@
+#include "iot/command_queue.h"
+#include "application.h"
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// 占住主循环，相当于正在执行 SetDeviceState 或播放提示音，Release 后主循环继续
+class MainLoopBlocker {
+public:
+    MainLoopBlocker() {
+        std::promise<void> started;
+        auto future = started.get_future();
+        Application::GetInstance().Schedule([this, &started]() {
+            started.set_value();
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return released_; });
+        });
+        future.wait();
+    }
+
+    ~MainLoopBlocker() {
+        Release();
+        // 等主循环执行完前面的任务，下一个用例从空闲的主循环开始
+        std::promise<void> idle;
+        auto future = idle.get_future();
+        Application::GetInstance().Schedule([&idle]() { idle.set_value(); });
+        future.wait();
+    }
+
+    void Release() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        released_ = true;
+        condition_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool released_ = false;
+};
+
+// 记录命令从 Post 到开始执行的时间
+struct Latency {
+    Clock::time_point posted;
+    std::promise<Clock::duration> executed;
+    std::thread::id thread;
+
+    std::function<void()> Callback() {
+        posted = Clock::now();
+        return [this]() {
+            thread = std::this_thread::get_id();
+            executed.set_value(Clock::now() - posted);
+        };
+    }
+};
+
+double Milliseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+// CommandQueue 是静态单例，进程退出时析构 iot_worker 正在等待的条件变量会一直阻塞，
+// 单例构造后注册的 atexit 在它析构之前执行，直接结束进程
+iot::CommandQueue& Queue() {
+    static auto& queue = []() -> iot::CommandQueue& {
+        auto& queue = iot::CommandQueue::GetInstance();
+        std::atexit([]() {
+            fflush(stdout);
+            _exit(::testing::UnitTest::GetInstance()->Passed() ? 0 : 1);
+        });
+        return queue;
+    }();
+    return queue;
+}
+
+} // namespace
+
+TEST(CommandQueue, InlineRunsOnPostingThread) {
+    MainLoopBlocker blocker;
+    Latency latency;
+    Queue().Post(iot::kThingExecutorInline, 0, latency.Callback());
+    auto future = latency.executed.get_future();
+    // Post 返回前已经执行
+    ASSERT_EQ(future.wait_for(0s), std::future_status::ready);
+    EXPECT_EQ(latency.thread, std::this_thread::get_id());
+}
+
+TEST(CommandQueue, WorkerRunsWhileMainLoopBlocked) {
+    MainLoopBlocker blocker;
+    Latency latency;
+    Queue().Post(iot::kThingExecutorWorker, 0, latency.Callback());
+    auto future = latency.executed.get_future();
+    ASSERT_EQ(future.wait_for(1s), std::future_status::ready);
+    EXPECT_NE(latency.thread, std::this_thread::get_id());
+}
+
+TEST(CommandQueue, MainLoopCommandWaitsForMainLoop) {
+    auto blocker = std::make_unique<MainLoopBlocker>();
+    Latency latency;
+    Queue().Post(iot::kThingExecutorMainLoop, 0, latency.Callback());
+    auto future = latency.executed.get_future();
+    EXPECT_EQ(future.wait_for(100ms), std::future_status::timeout);
+    blocker->Release();
+    ASSERT_EQ(future.wait_for(1s), std::future_status::ready);
+    EXPECT_GE(future.get(), 100ms);
+    blocker.reset();
+}
+
+TEST(CommandQueue, CoalescesWhileMainLoopBlocked) {
+    std::vector<int> executed;
+    {
+        MainLoopBlocker blocker;
+        auto& queue = Queue();
+        // 连续调节音量，只执行最后一次
+        for (int volume = 1; volume <= 10; volume++) {
+            queue.Post(iot::kThingExecutorMainLoop, 0x11, [&executed, volume]() { executed.push_back(volume); });
+        }
+        // key 为 0 的命令不合并，合并的命令保留第一次排队的位置
+        queue.Post(iot::kThingExecutorMainLoop, 0, [&executed]() { executed.push_back(100); });
+        queue.Post(iot::kThingExecutorMainLoop, 0, [&executed]() { executed.push_back(101); });
+        queue.Post(iot::kThingExecutorMainLoop, 0x11, [&executed]() { executed.push_back(11); });
+    }
+    EXPECT_EQ(executed, (std::vector<int>{11, 100, 101}));
+}
+
+// 主循环一直在执行 100ms 的任务时，三种执行方式从收到命令到开始执行的延迟
+TEST(CommandQueue, LatencyUnderBusyMainLoop) {
+    constexpr auto kBusyTask = 100ms;
+    constexpr int kCommands = 20;
+
+    // 用例结束（包括 ASSERT 失败返回）时停止重新排队，等主循环中的任务执行完，之后不再引用这里的变量
+    struct BusyMainLoop {
+        std::atomic<bool> busy = true;
+        std::function<void()> task;
+
+        ~BusyMainLoop() {
+            busy = false;
+            std::promise<void> idle;
+            auto future = idle.get_future();
+            Application::GetInstance().Schedule([&idle]() { idle.set_value(); });
+            future.wait();
+        }
+    } busy_main_loop;
+    busy_main_loop.task = [&busy_main_loop, kBusyTask]() {
+        std::this_thread::sleep_for(kBusyTask);
+        if (busy_main_loop.busy) {
+            Application::GetInstance().Schedule(busy_main_loop.task);
+        }
+    };
+    Application::GetInstance().Schedule(busy_main_loop.task);
+
+    struct Result {
+        const char* name;
+        iot::ThingExecutor executor;
+        std::vector<double> latencies;
+    };
+    std::vector<Result> results = {
+        {"inline", iot::kThingExecutorInline, {}},
+        {"worker", iot::kThingExecutorWorker, {}},
+        {"main_loop", iot::kThingExecutorMainLoop, {}},
+    };
+    for (int i = 0; i < kCommands; i++) {
+        for (auto& result : results) {
+            Latency latency;
+            auto future = latency.executed.get_future();
+            Queue().Post(result.executor, 0, latency.Callback());
+            ASSERT_EQ(future.wait_for(1s), std::future_status::ready) << result.name;
+            result.latencies.push_back(Milliseconds(future.get()));
+        }
+        // 错开命令到达的时间，落在主循环任务的不同位置
+        std::this_thread::sleep_for(std::chrono::milliseconds(7 * i % 50));
+    }
+
+    for (auto& result : results) {
+        std::sort(result.latencies.begin(), result.latencies.end());
+        printf("%-10s p50 %8.3f ms  max %8.3f ms\n", result.name, result.latencies[kCommands / 2],
+            result.latencies.back());
+    }
+    // 不经过主循环的命令不等主循环的任务
+    EXPECT_LT(results[0].latencies.back(), Milliseconds(kBusyTask) / 2);
+    EXPECT_LT(results[1].latencies[kCommands / 2], Milliseconds(kBusyTask) / 2);
+    EXPECT_GT(results[2].latencies[kCommands / 2], results[1].latencies[kCommands / 2]);
+}
@@ -0,0 +1,170 @@
+#include "delta_patch.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// gen_delta_cases.py 用 scripts/gen_delta.py 生成的用例，目录由 CMake 传入
+std::string ReadCaseFile(const std::string& name) {
+    std::ifstream file(std::string(DELTA_PATCH_CASES_DIR) + "/" + name, std::ios::binary);
+    EXPECT_TRUE(file.good()) << "Missing " << name;
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+std::vector<std::string> CaseNames() {
+    std::vector<std::string> names;
+    std::istringstream lines(ReadCaseFile("cases.txt"));
+    for (std::string line; std::getline(lines, line);) {
+        if (!line.empty()) {
+            names.push_back(line);
+        }
+    }
+    return names;
+}
+
+struct PatchResult {
+    bool ok = true;
+    bool done = false;
+    bool header_called = false;
+    DeltaPatchHeader header = {};
+    std::string target;
+};
+
+// 按 chunk_sizes 循环的长度把补丁分段输入
+PatchResult ApplyPatch(const std::string& source, const std::string& patch, const std::vector<size_t>& chunk_sizes) {
+    PatchResult result;
+    auto read_source = [&source](size_t offset, uint8_t* data, size_t length) {
+        if (offset > source.size() || length > source.size() - offset) {
+            return false;
+        }
+        memcpy(data, source.data() + offset, length);
+        return true;
+    };
+    auto on_header = [&result](const DeltaPatchHeader& header) {
+        EXPECT_FALSE(result.header_called);
+        result.header_called = true;
+        result.header = header;
+        return true;
+    };
+    auto write_target = [&result](const uint8_t* data, size_t length) {
+        result.target.append((const char*)data, length);
+        return true;
+    };
+
+    DeltaPatch delta(read_source, on_header, write_target);
+    size_t position = 0;
+    for (size_t i = 0; position < patch.size() && result.ok; i++) {
+        size_t length = std::min(chunk_sizes[i % chunk_sizes.size()], patch.size() - position);
+        result.ok = delta.Feed((const uint8_t*)patch.data() + position, length);
+        position += length;
+    }
+    result.done = delta.done();
+    if (result.done) {
+        EXPECT_EQ(delta.target_written(), result.target.size());
+    }
+    return result;
+}
+
+class DeltaPatchTest : public testing::TestWithParam<std::string> {
+protected:
+    void SetUp() override {
+        source_ = ReadCaseFile(GetParam() + ".old");
+        target_ = ReadCaseFile(GetParam() + ".new");
+        patch_ = ReadCaseFile(GetParam() + ".patch");
+        ASSERT_GE(patch_.size(), (size_t)DELTA_PATCH_HEADER_SIZE);
+    }
+
+    std::string source_;
+    std::string target_;
+    std::string patch_;
+};
+
+TEST_P(DeltaPatchTest, FixedChunkSizes) {
+    // 包括逐字节输入、跨头部边界和大于输出缓存的分段
+    for (size_t chunk_size : {1, 2, 3, 7, 79, 81, 511, 513, 1024, 4096}) {
+        auto result = ApplyPatch(source_, patch_, {chunk_size});
+        ASSERT_TRUE(result.ok) << "chunk " << chunk_size;
+        ASSERT_TRUE(result.done) << "chunk " << chunk_size;
+        ASSERT_TRUE(result.target == target_) << "chunk " << chunk_size;
+    }
+
+    auto result = ApplyPatch(source_, patch_, {patch_.size()});
+    ASSERT_TRUE(result.ok && result.done);
+    EXPECT_TRUE(result.header_called);
+    EXPECT_EQ(result.header.source_size, source_.size());
+    EXPECT_EQ(result.header.target_size, target_.size());
+    EXPECT_TRUE(result.target == target_);
+}
+
+TEST_P(DeltaPatchTest, RandomChunkSizes) {
+    std::mt19937 random(std::hash<std::string>()(GetParam()));
+    for (int round = 0; round < 20; round++) {
+        std::vector<size_t> chunk_sizes(37);
+        for (auto& size : chunk_sizes) {
+            size = 1 + random() % (round < 10 ? 16 : 2000);
+        }
+        auto result = ApplyPatch(source_, patch_, chunk_sizes);
+        ASSERT_TRUE(result.ok && result.done) << "round " << round;
+        ASSERT_TRUE(result.target == target_) << "round " << round;
+    }
+}
+
+TEST_P(DeltaPatchTest, TruncatedPatchIsNotDone) {
+    if (target_.empty()) {
+        GTEST_SKIP() << "Header-only patch";
+    }
+    // 缺少最后一条记录的 seek 时输出可能已经完整，但补丁没有结束
+    for (size_t length : {patch_.size() - 1, patch_.size() / 2, (size_t)DELTA_PATCH_HEADER_SIZE}) {
+        auto result = ApplyPatch(source_, patch_.substr(0, length), {100});
+        EXPECT_TRUE(result.ok) << "length " << length;
+        EXPECT_FALSE(result.done) << "length " << length;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(GenDelta, DeltaPatchTest, testing::ValuesIn(CaseNames()),
+    [](const testing::TestParamInfo<std::string>& info) { return info.param; });
+
+TEST(DeltaPatchErrorTest, BadMagicIsRejected) {
+    auto patch = ReadCaseFile("relocated.patch");
+    patch[0] ^= 1;
+    auto result = ApplyPatch(ReadCaseFile("relocated.old"), patch, {1});
+    EXPECT_FALSE(result.ok);
+    EXPECT_FALSE(result.header_called);
+}
+
+TEST(DeltaPatchErrorTest, HeaderCallbackStopsPatch) {
+    auto patch = ReadCaseFile("relocated.patch");
+    DeltaPatch delta(nullptr, [](const DeltaPatchHeader&) { return false; },
+        [](const uint8_t*, size_t) { return true; });
+    EXPECT_FALSE(delta.Feed((const uint8_t*)patch.data(), patch.size()));
+    EXPECT_FALSE(delta.Feed((const uint8_t*)patch.data(), 1));
+    EXPECT_FALSE(delta.done());
+}
+
+TEST(DeltaPatchErrorTest, ShorterSourceIsRejected) {
+    auto source = ReadCaseFile("relocated.old");
+    auto result = ApplyPatch(source.substr(0, source.size() / 2), ReadCaseFile("relocated.patch"), {4096});
+    EXPECT_FALSE(result.ok);
+    EXPECT_FALSE(result.done);
+}
+
+TEST(DeltaPatchErrorTest, WriterFailureStopsPatch) {
+    auto source = ReadCaseFile("relocated.old");
+    auto patch = ReadCaseFile("relocated.patch");
+    DeltaPatch delta([&source](size_t offset, uint8_t* data, size_t length) {
+            memcpy(data, source.data() + offset, length);
+            return true;
+        }, nullptr, [](const uint8_t*, size_t) { return false; });
+    EXPECT_FALSE(delta.Feed((const uint8_t*)patch.data(), patch.size()));
+    EXPECT_FALSE(delta.done());
+}
+
+} // namespace
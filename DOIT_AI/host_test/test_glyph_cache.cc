@@ -0,0 +1,211 @@
+// GlyphCache 使用 LVGL 自己的 LRU 缓存，缓存只有 CONFIG_GLYPH_CACHE_SIZE_KB（1 KB），放得下 4 个 16x16 的 A8 字形
+#include "display/glyph_cache.h"
+
+#include <esp_heap_caps.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <deque>
+
+namespace {
+
+constexpr uint32_t kWideLetter = 'W';
+constexpr uint32_t kEmojiLetter = 0x1F600;
+const uint8_t kEmojiImage[4] = {};
+
+// 原字体：普通字形 16x16，'W' 是 64x64，表情是图片字形；记录解码次数
+struct FakeFont {
+    lv_font_t font = {};
+    int decodes = 0;
+
+    FakeFont() {
+        font.get_glyph_dsc = GetGlyphDsc;
+        font.get_glyph_bitmap = GetGlyphBitmap;
+        font.line_height = 20;
+        font.base_line = 4;
+    }
+
+    static bool GetGlyphDsc(const lv_font_t* font, lv_font_glyph_dsc_t* dsc, uint32_t letter, uint32_t letter_next) {
+        uint16_t size = letter == kWideLetter ? 64 : 16;
+        dsc->adv_w = size;
+        dsc->box_w = size;
+        dsc->box_h = size;
+        dsc->ofs_x = 0;
+        dsc->ofs_y = 0;
+        dsc->format = letter == kEmojiLetter ? LV_FONT_GLYPH_FORMAT_IMAGE : LV_FONT_GLYPH_FORMAT_A8;
+        dsc->is_placeholder = 0;
+        dsc->gid.index = letter;
+        return true;
+    }
+
+    // 每行填入 letter + 行号，用来检查取出的位图是不是这个字形的
+    static const void* GetGlyphBitmap(lv_font_glyph_dsc_t* dsc, lv_draw_buf_t* draw_buf) {
+        ((FakeFont*)dsc->resolved_font)->decodes++;
+        if (dsc->format == LV_FONT_GLYPH_FORMAT_IMAGE) {
+            return kEmojiImage;
+        }
+        for (uint32_t y = 0; y < dsc->box_h; y++) {
+            memset(draw_buf->data + y * draw_buf->header.stride, (uint8_t)(dsc->gid.index + y), dsc->box_w);
+        }
+        return draw_buf;
+    }
+};
+
+bool IsGlyph(const void* bitmap, uint32_t letter) {
+    auto draw_buf = (const lv_draw_buf_t*)bitmap;
+    for (uint32_t y = 0; y < draw_buf->header.h; y++) {
+        for (uint32_t x = 0; x < draw_buf->header.w; x++) {
+            if (draw_buf->data[y * draw_buf->header.stride + x] != (uint8_t)(letter + y)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+class GlyphCacheTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        lv_init();
+        // 缓存放不下时 LVGL 解码到调用方的缓冲区
+        fallback_buffer_ = lv_draw_buf_create(64, 64, LV_COLOR_FORMAT_A8, 0);
+    }
+
+    // 和 LVGL 绘制一个字符的顺序相同：取描述、取位图，用完后释放
+    const void* Draw(uint32_t letter, lv_font_glyph_dsc_t& dsc) {
+        dsc = {};
+        EXPECT_TRUE(lv_font_get_glyph_dsc(wrapped_, &dsc, letter, 0));
+        return lv_font_get_glyph_bitmap(&dsc, fallback_buffer_);
+    }
+
+    void DrawAndRelease(uint32_t letter) {
+        lv_font_glyph_dsc_t dsc;
+        auto bitmap = Draw(letter, dsc);
+        EXPECT_TRUE(IsGlyph(bitmap, letter)) << letter;
+        lv_font_glyph_release_draw_data(&dsc);
+    }
+
+    uint32_t Misses() {
+        uint32_t lookups, misses;
+        GlyphCache::GetInstance().GetStats(lookups, misses);
+        return misses;
+    }
+
+    uint32_t Lookups() {
+        uint32_t lookups, misses;
+        GlyphCache::GetInstance().GetStats(lookups, misses);
+        return lookups;
+    }
+
+    // 每个用例使用新的原字体，缓存以原字体的地址区分，字体一直保留，地址不会被后面的用例复用
+    static FakeFont& NewFont() {
+        static std::deque<FakeFont> fonts;
+        return fonts.emplace_back();
+    }
+
+    FakeFont& original_ = NewFont();
+    const lv_font_t* wrapped_ = GlyphCache::GetInstance().Wrap(&original_.font);
+    static inline lv_draw_buf_t* fallback_buffer_ = nullptr;
+};
+
+} // namespace
+
+TEST_F(GlyphCacheTest, WrapKeepsMetrics) {
+    EXPECT_EQ(GlyphCache::GetInstance().Wrap(&original_.font), wrapped_);
+    EXPECT_EQ(GlyphCache::GetInstance().Wrap(nullptr), nullptr);
+    EXPECT_NE(wrapped_, &original_.font);
+    EXPECT_EQ(wrapped_->line_height, 20);
+    EXPECT_EQ(wrapped_->base_line, 4);
+    EXPECT_EQ(wrapped_->dsc, &original_.font);
+}
+
+TEST_F(GlyphCacheTest, SecondDrawHitsCache) {
+    uint32_t lookups = Lookups();
+    uint32_t misses = Misses();
+    DrawAndRelease('A');
+    DrawAndRelease('A');
+    EXPECT_EQ(original_.decodes, 1);
+    EXPECT_EQ(Lookups() - lookups, 2u);
+    EXPECT_EQ(Misses() - misses, 1u);
+
+    lv_font_glyph_dsc_t dsc;
+    auto bitmap = Draw('A', dsc);
+    // 命中时返回缓存中的位图，不是调用方的缓冲区，释放时交还缓存
+    EXPECT_NE(bitmap, fallback_buffer_);
+    EXPECT_NE(dsc.entry, nullptr);
+    lv_font_glyph_release_draw_data(&dsc);
+    EXPECT_EQ(dsc.entry, nullptr);
+}
+
+TEST_F(GlyphCacheTest, EvictsLeastRecentlyUsed) {
+    for (uint32_t letter : {'A', 'B', 'C', 'D'}) {
+        DrawAndRelease(letter);
+    }
+    EXPECT_EQ(original_.decodes, 4);
+    // 缓存中只剩这 4 个字形，之前用例的字形都已经淘汰，位图内存已经释放
+    EXPECT_EQ(host_test_heap_caps_blocks, 4);
+
+    DrawAndRelease('A');
+    EXPECT_EQ(original_.decodes, 4);
+    // 淘汰最久没有使用的 B
+    DrawAndRelease('E');
+    EXPECT_EQ(original_.decodes, 5);
+    EXPECT_EQ(host_test_heap_caps_blocks, 4);
+    for (uint32_t letter : {'A', 'C', 'D', 'E'}) {
+        DrawAndRelease(letter);
+    }
+    EXPECT_EQ(original_.decodes, 5);
+    DrawAndRelease('B');
+    EXPECT_EQ(original_.decodes, 6);
+}
+
+TEST_F(GlyphCacheTest, HeldGlyphIsNotEvicted) {
+    lv_font_glyph_dsc_t held;
+    auto bitmap = Draw('A', held);
+    ASSERT_NE(held.entry, nullptr);
+    // 持有 A 时连续绘制其他字形，只在其余 3 个槽位中淘汰
+    for (uint32_t letter = 'B'; letter <= 'J'; letter++) {
+        DrawAndRelease(letter);
+    }
+    EXPECT_TRUE(IsGlyph(bitmap, 'A'));
+    lv_font_glyph_release_draw_data(&held);
+
+    int decodes = original_.decodes;
+    DrawAndRelease('A');
+    EXPECT_EQ(original_.decodes, decodes);
+}
+
+TEST_F(GlyphCacheTest, GlyphLargerThanCacheFallsBack) {
+    uint32_t misses = Misses();
+    for (int i = 0; i < 2; i++) {
+        lv_font_glyph_dsc_t dsc;
+        auto bitmap = Draw(kWideLetter, dsc);
+        // 64x64 放不进 1 KB 的缓存，每次都由原字体解码到调用方的缓冲区
+        EXPECT_EQ(bitmap, fallback_buffer_);
+        EXPECT_EQ(dsc.entry, nullptr);
+        EXPECT_EQ(dsc.resolved_font, &original_.font);
+        EXPECT_TRUE(IsGlyph(bitmap, kWideLetter));
+        lv_font_glyph_release_draw_data(&dsc);
+    }
+    EXPECT_EQ(original_.decodes, 2);
+    EXPECT_EQ(Misses() - misses, 2u);
+}
+
+TEST_F(GlyphCacheTest, ImageGlyphBypassesCache) {
+    uint32_t lookups = Lookups();
+    lv_font_glyph_dsc_t dsc;
+    EXPECT_EQ(Draw(kEmojiLetter, dsc), kEmojiImage);
+    EXPECT_EQ(dsc.resolved_font, &original_.font);
+    EXPECT_EQ(dsc.entry, nullptr);
+    lv_font_glyph_release_draw_data(&dsc);
+    EXPECT_EQ(Lookups(), lookups);
+}
+
+TEST_F(GlyphCacheTest, WithoutSpiramUsesInternalMemory) {
+    host_test_spiram_available = false;
+    DrawAndRelease('A');
+    DrawAndRelease('A');
+    host_test_spiram_available = true;
+    EXPECT_EQ(original_.decodes, 1);
+}
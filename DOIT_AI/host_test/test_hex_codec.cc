@@ -0,0 +1,78 @@
+#include "hex_codec.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+
+namespace {
+
+TEST(HexCodecTest, EncodeKnownValues) {
+    const uint8_t data[] = {0x00, 0x01, 0x7F, 0x80, 0xAB, 0xCD, 0xEF, 0xFF, 0x10};
+    std::string hex;
+    HexEncodeAppend(hex, data, sizeof(data));
+    EXPECT_EQ(hex, "00017F80ABCDEFFF10");
+}
+
+TEST(HexCodecTest, EncodeWritesExactLength) {
+    const uint8_t data[] = {0x12, 0x34, 0x56};
+    char out[8];
+    memset(out, '#', sizeof(out));
+    HexEncode(out, data, sizeof(data));
+    EXPECT_EQ(std::string(out, sizeof(out)), "123456##");
+}
+
+TEST(HexCodecTest, DecodeAcceptsBothCases) {
+    std::string bytes;
+    HexDecodeAppend(bytes, "abCDef0123456789", 16);
+    EXPECT_EQ(bytes, std::string("\xAB\xCD\xEF\x01\x23\x45\x67\x89", 8));
+}
+
+TEST(HexCodecTest, DecodeIgnoresTrailingOddDigit) {
+    uint8_t out[4] = {0};
+    EXPECT_EQ(HexDecode(out, "ABC", 3), 1u);
+    EXPECT_EQ(out[0], 0xAB);
+    EXPECT_EQ(out[1], 0);
+}
+
+TEST(HexCodecTest, DecodeTreatsInvalidDigitsAsZero) {
+    std::string bytes;
+    HexDecodeAppend(bytes, "G1zz", 4);
+    EXPECT_EQ(bytes, std::string("\x01\x00", 2));
+}
+
+TEST(HexCodecTest, AppendKeepsExistingContent) {
+    std::string text = "AT+X=";
+    HexEncodeAppend(text, "\x01\x02", 2);
+    EXPECT_EQ(text, "AT+X=0102");
+    std::string bytes = "p";
+    HexDecodeAppend(bytes, "7172", 4);
+    EXPECT_EQ(bytes, "pqr");
+}
+
+// 各种长度覆盖 4 字节一组的快速路径和逐字节的尾部，起始地址不对齐
+TEST(HexCodecTest, RoundTrip) {
+    std::mt19937 random(36);
+    for (size_t length = 0; length < 70; ++length) {
+        for (size_t offset = 0; offset < 4; ++offset) {
+            std::string data(offset + length, '\0');
+            for (auto& c : data) {
+                c = (char)random();
+            }
+            std::string hex(offset, '-');
+            HexEncodeAppend(hex, data.data() + offset, length);
+            ASSERT_EQ(hex.size(), offset + length * 2);
+            for (size_t i = 0; i < length; ++i) {
+                char expected[3];
+                snprintf(expected, sizeof(expected), "%02X", (uint8_t)data[offset + i]);
+                ASSERT_EQ(hex.substr(offset + i * 2, 2), expected);
+            }
+
+            std::string decoded(offset, '\0');
+            HexDecodeAppend(decoded, hex.data() + offset, length * 2);
+            ASSERT_EQ(decoded.substr(offset), data.substr(offset)) << length << " " << offset;
+        }
+    }
+}
+
+} // namespace
@@ -0,0 +1,345 @@
+#include "json_scanner.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef HOST_TEST_CJSON_HEADER
+#include HOST_TEST_CJSON_HEADER
+#endif
+
+// 统计 JsonScanner 路径上的内存分配次数
+static std::atomic<size_t> g_allocations = 0;
+
+void* operator new(size_t size) {
+    g_allocations++;
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+namespace {
+
+struct Member {
+    std::string key;
+    JsonValueType type;
+    std::string raw;
+};
+
+// 扫描全部成员，格式错误时 error 为 true
+std::vector<Member> Scan(std::string_view json, bool& error) {
+    JsonScanner scanner(json.data(), json.size());
+    std::vector<Member> members;
+    std::string_view key;
+    JsonValue value;
+    while (scanner.Next(key, value)) {
+        members.push_back({std::string(key), value.type, std::string(value.raw)});
+    }
+    error = scanner.error();
+    return members;
+}
+
+bool IsValid(std::string_view json) {
+    bool error;
+    Scan(json, error);
+    return !error;
+}
+
+// 解码第一个成员的字符串值
+std::string FirstString(std::string_view json) {
+    JsonScanner scanner(json.data(), json.size());
+    std::string_view key;
+    JsonValue value;
+    EXPECT_TRUE(scanner.Next(key, value)) << json;
+    EXPECT_EQ(value.type, kJsonValueString) << json;
+    std::string scratch;
+    return std::string(JsonScanner::GetString(value, scratch));
+}
+
+} // namespace
+
+TEST(JsonScanner, Members) {
+    bool error;
+    auto members = Scan(R"( { "s" : "v" , "n":-1.5e+3, "t":true, "f":false, "z":null, "o":{"a":[1,{}]}, "a":[ ] } )",
+        error);
+    EXPECT_FALSE(error);
+    ASSERT_EQ(members.size(), 7u);
+    EXPECT_EQ(members[0].key, "s");
+    EXPECT_EQ(members[0].type, kJsonValueString);
+    EXPECT_EQ(members[0].raw, "v");
+    EXPECT_EQ(members[1].type, kJsonValueNumber);
+    EXPECT_EQ(members[1].raw, "-1.5e+3");
+    EXPECT_EQ(members[2].type, kJsonValueBoolean);
+    EXPECT_EQ(members[2].raw, "true");
+    EXPECT_EQ(members[3].raw, "false");
+    EXPECT_EQ(members[4].type, kJsonValueNull);
+    EXPECT_EQ(members[5].type, kJsonValueObject);
+    EXPECT_EQ(members[5].raw, R"({"a":[1,{}]})");
+    EXPECT_EQ(members[6].type, kJsonValueArray);
+    EXPECT_EQ(members[6].raw, "[ ]");
+
+    EXPECT_TRUE(Scan("{}", error).empty());
+    EXPECT_FALSE(error);
+    EXPECT_FALSE(IsValid("[]"));
+    EXPECT_FALSE(IsValid(""));
+}
+
+TEST(JsonScanner, DuplicateKeysAreReturnedInOrder) {
+    bool error;
+    auto members = Scan(R"({"type":"tts","type":"stt","state":"start"})", error);
+    EXPECT_FALSE(error);
+    ASSERT_EQ(members.size(), 3u);
+    EXPECT_EQ(members[0].raw, "tts");
+    EXPECT_EQ(members[1].raw, "stt");
+}
+
+TEST(JsonScanner, Escapes) {
+    EXPECT_EQ(FirstString(R"({"k":"a\"b\\c\/d\be\ff\ng\rh\ti"})"), "a\"b\\c/d\be\ff\ng\rh\ti");
+
+    // 没有转义字符时直接指向输入，不复制
+    std::string json = R"({"k":"plain"})";
+    JsonScanner scanner(json.data(), json.size());
+    std::string_view key;
+    JsonValue value;
+    ASSERT_TRUE(scanner.Next(key, value));
+    EXPECT_FALSE(value.escaped);
+    std::string scratch;
+    EXPECT_EQ(JsonScanner::GetString(value, scratch).data(), json.data() + 6);
+
+    EXPECT_FALSE(IsValid(R"({"k":"\x"})"));
+    EXPECT_FALSE(IsValid(R"({"k":"\'"})"));
+    EXPECT_FALSE(IsValid(std::string("{\"k\":\"\\\0\"}", 9)));
+}
+
+TEST(JsonScanner, UnicodeEscapes) {
+    EXPECT_EQ(FirstString(R"({"k":"\u4f60\u597d"})"), "你好");
+    EXPECT_EQ(FirstString(R"({"k":"\u0041\u00e9"})"), "Aé");
+    // 代理对解码为一个 4 字节的 UTF-8 字符
+    EXPECT_EQ(FirstString(R"({"k":"\ud83d\ude00!"})"), "😀!");
+    EXPECT_EQ(FirstString(R"({"k":"\uD83D\uDE09"})"), "😉");
+
+    // 单独的高位或低位代理项、高位后面不是低位、十六进制不完整，和 cJSON 一样按格式错误处理
+    EXPECT_FALSE(IsValid(R"({"k":"\ud83d"})"));
+    EXPECT_FALSE(IsValid(R"({"k":"\ud83dx"})"));
+    EXPECT_FALSE(IsValid(R"({"k":"\ud83dA"})"));
+    EXPECT_FALSE(IsValid(R"({"k":"\ude00"})"));
+    EXPECT_FALSE(IsValid(R"({"k":"\u12"})"));
+    EXPECT_FALSE(IsValid(R"({"k":"\u12g4"})"));
+}
+
+TEST(JsonScanner, TrailingBackslash) {
+    EXPECT_FALSE(IsValid(R"({"k":"abc\)"));
+    EXPECT_FALSE(IsValid(R"({"k":"abc\\)"));
+    EXPECT_FALSE(IsValid(R"({"k":"abc\u)"));
+    EXPECT_FALSE(IsValid(R"({"k":"\ud83d\)"));
+    // 反斜杠出现在缓冲区末尾、后面的内存中才有引号时也不能越界读取
+    std::string buffer = R"({"k":"abc\"})";
+    JsonScanner scanner(buffer.data(), buffer.find('\\') + 1);
+    std::string_view key;
+    JsonValue value;
+    EXPECT_FALSE(scanner.Next(key, value));
+    EXPECT_TRUE(scanner.error());
+}
+
+TEST(JsonScanner, NestedValues) {
+    EXPECT_TRUE(IsValid(R"({"a":{"b":[1,"]",{"c":"}"}],"d":{}}})"));
+    EXPECT_TRUE(IsValid(R"({"a":[[[]],[{}],{"b":[true,false,null]}]})"));
+
+    // 括号种类不配对
+    EXPECT_FALSE(IsValid(R"({"a":[}})"));
+    EXPECT_FALSE(IsValid(R"({"a":{]})"));
+    EXPECT_FALSE(IsValid(R"({"a":[{]}]})"));
+    EXPECT_FALSE(IsValid(R"({"a":[1})"));
+    // 嵌套值内部的格式错误
+    EXPECT_FALSE(IsValid(R"({"a":[1,]})"));
+    EXPECT_FALSE(IsValid(R"({"a":[,1]})"));
+    EXPECT_FALSE(IsValid(R"({"a":[1 2]})"));
+    EXPECT_FALSE(IsValid(R"({"a":{"b"}})"));
+    EXPECT_FALSE(IsValid(R"({"a":{"b":1,}})"));
+    EXPECT_FALSE(IsValid(R"({"a":{1:2}})"));
+    EXPECT_FALSE(IsValid(R"({"a":[nope]})"));
+    EXPECT_FALSE(IsValid(R"({"a":["\q"]})"));
+
+    // 最多 64 层
+    EXPECT_TRUE(IsValid("{\"a\":" + std::string(64, '[') + std::string(64, ']') + "}"));
+    EXPECT_FALSE(IsValid("{\"a\":" + std::string(65, '[') + std::string(65, ']') + "}"));
+}
+
+TEST(JsonScanner, Literals) {
+    EXPECT_FALSE(IsValid(R"({"type":"tts","x":nope})"));
+    EXPECT_FALSE(IsValid(R"({"x":tru})"));
+    EXPECT_FALSE(IsValid(R"({"x":truex})"));
+    EXPECT_FALSE(IsValid(R"({"x":nul})"));
+    EXPECT_FALSE(IsValid(R"({"x":False})"));
+    EXPECT_TRUE(IsValid(R"({"x":true,"y":false,"z":null})"));
+}
+
+TEST(JsonScanner, Numbers) {
+    for (auto number : {"0", "-0", "10", "-12.5", "1e9", "1E-9", "0.5e+10"}) {
+        EXPECT_TRUE(IsValid(std::string(R"({"n":)") + number + "}")) << number;
+    }
+    for (auto number : {"-", "01", "1.", ".5", "1e", "1e+", "+1", "--1", "1.2.3", "0x10"}) {
+        EXPECT_FALSE(IsValid(std::string(R"({"n":)") + number + "}")) << number;
+    }
+}
+
+TEST(JsonScanner, EveryTruncationIsAnError) {
+    std::string json = R"({"type":"tts","state":"sentence_start","text":"\u4f60\ud83d\ude00\"","x":[{"a":null}],"n":-1.5})";
+    ASSERT_TRUE(IsValid(json));
+    for (size_t length = 0; length < json.size(); length++) {
+        // 复制到刚好大小的缓冲区，越界读取时 ASan 能发现
+        std::vector<char> buffer(json.begin(), json.begin() + length);
+        bool error;
+        Scan(std::string_view(buffer.data(), buffer.size()), error);
+        EXPECT_TRUE(error) << length;
+    }
+}
+
+namespace {
+
+// 和 Protocol::DispatchIncomingMessage 一样取出 type/state/text/emotion，重复的键取第一个
+struct Fields {
+    bool ok = false;
+    std::string type, state, text, emotion;
+
+    bool operator==(const Fields& other) const {
+        return ok == other.ok && type == other.type && state == other.state && text == other.text &&
+            emotion == other.emotion;
+    }
+};
+
+void ScanFields(std::string_view message, Fields& fields, std::string& scratch) {
+    JsonScanner scanner(message.data(), message.size());
+    std::string_view key;
+    JsonValue value;
+    JsonValue type, state, text, emotion;
+    while (scanner.Next(key, value)) {
+        if (value.type != kJsonValueString) {
+            continue;
+        }
+        if (key == "type" && type.type == kJsonValueInvalid) type = value;
+        else if (key == "state" && state.type == kJsonValueInvalid) state = value;
+        else if (key == "text" && text.type == kJsonValueInvalid) text = value;
+        else if (key == "emotion" && emotion.type == kJsonValueInvalid) emotion = value;
+    }
+    fields.ok = !scanner.error();
+    fields.type = JsonScanner::GetString(type, scratch);
+    fields.state = JsonScanner::GetString(state, scratch);
+    fields.text = JsonScanner::GetString(text, scratch);
+    fields.emotion = JsonScanner::GetString(emotion, scratch);
+}
+
+#ifdef HOST_TEST_CJSON_HEADER
+std::atomic<size_t> g_cjson_allocations = 0;
+
+void ParseFields(std::string_view message, Fields& fields) {
+    auto root = cJSON_ParseWithLength(message.data(), message.size());
+    fields.ok = root != nullptr;
+    auto get = [root](const char* name) {
+        auto item = cJSON_GetObjectItem(root, name);
+        return cJSON_IsString(item) ? item->valuestring : "";
+    };
+    fields.type = get("type");
+    fields.state = get("state");
+    fields.text = get("text");
+    fields.emotion = get("emotion");
+    cJSON_Delete(root);
+}
+#endif
+
+std::vector<std::string> LoadMessages() {
+    std::ifstream file(JSON_SCANNER_MESSAGES);
+    EXPECT_TRUE(file.good()) << "Missing " << JSON_SCANNER_MESSAGES;
+    std::vector<std::string> messages;
+    for (std::string line; std::getline(file, line);) {
+        if (!line.empty()) {
+            messages.push_back(line);
+        }
+    }
+    return messages;
+}
+
+// 每条消息的平均耗时（纳秒）和 counter 增加的次数；fields 重复使用，预热后不再扩容
+struct Measurement {
+    double nanoseconds;
+    double allocations;
+};
+
+template <typename Parse>
+Measurement Measure(const std::vector<std::string>& messages, const std::atomic<size_t>& counter, Parse parse) {
+    constexpr int kRounds = 2000;
+    Fields fields;
+    for (auto& message : messages) {
+        parse(message, fields);
+    }
+    size_t allocations = counter;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; round++) {
+        for (auto& message : messages) {
+            parse(message, fields);
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double count = (double)kRounds * messages.size();
+    return {std::chrono::duration<double, std::nano>(elapsed).count() / count, (counter - allocations) / count};
+}
+
+} // namespace
+
+// data/server_messages.jsonl 是按服务器下发的格式（docs/websocket.md）整理的一次对话，一行一条消息
+TEST(JsonScannerBenchmark, ServerMessages) {
+    auto messages = LoadMessages();
+    ASSERT_FALSE(messages.empty());
+
+    std::string scratch;
+    for (auto& message : messages) {
+        Fields fields;
+        ScanFields(message, fields, scratch);
+        EXPECT_TRUE(fields.ok) << message;
+    }
+    auto scan = Measure(messages, g_allocations, [&scratch](const std::string& message, Fields& fields) {
+        ScanFields(message, fields, scratch);
+    });
+    printf("JsonScanner %8.0f ns/message %6.2f allocations/message (%zu messages)\n", scan.nanoseconds,
+        scan.allocations, messages.size());
+    EXPECT_EQ(scan.allocations, 0.0);
+
+#ifdef HOST_TEST_CJSON_HEADER
+    cJSON_Hooks hooks = {};
+    hooks.malloc_fn = [](size_t size) {
+        g_cjson_allocations++;
+        return malloc(size);
+    };
+    hooks.free_fn = free;
+    cJSON_InitHooks(&hooks);
+    // 两种方式取出的字段相同
+    for (auto& message : messages) {
+        Fields scanned, parsed;
+        ScanFields(message, scanned, scratch);
+        ParseFields(message, parsed);
+        EXPECT_EQ(scanned, parsed) << message;
+    }
+    auto parse = Measure(messages, g_cjson_allocations, ParseFields);
+    printf("cJSON       %8.0f ns/message %6.2f allocations/message\n", parse.nanoseconds, parse.allocations);
+    cJSON_InitHooks(nullptr);
+    // 耗时和编译选项、机器负载有关，只打印不检查
+    EXPECT_LT(scan.allocations, parse.allocations);
+#else
+    printf("cJSON not found, set IDF_PATH to compare with ESP-IDF's cJSON\n");
+#endif
+}
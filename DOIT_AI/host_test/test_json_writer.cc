@@ -0,0 +1,218 @@
+#include "json_writer.h"
+#include "json_scanner.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+// 统计消息拼接过程中的内存分配次数
+static std::atomic<size_t> g_allocations = 0;
+
+void* operator new(size_t size) {
+    g_allocations++;
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+namespace {
+
+std::string Escape(std::string_view text) {
+    std::string buffer;
+    JsonWriter writer(buffer);
+    writer.AppendEscaped(text);
+    return buffer;
+}
+
+// 写成 {"k":"..."} 后用 JsonScanner 读回
+std::string RoundTrip(std::string_view text) {
+    std::string buffer;
+    JsonWriter writer(buffer);
+    writer.BeginObject().Field("k", text).EndObject();
+    JsonScanner scanner(buffer.data(), buffer.size());
+    std::string_view key;
+    JsonValue value;
+    EXPECT_TRUE(scanner.Next(key, value)) << buffer;
+    EXPECT_FALSE(scanner.Next(key, value));
+    EXPECT_FALSE(scanner.error()) << buffer;
+    std::string scratch;
+    return std::string(JsonScanner::GetString(value, scratch));
+}
+
+} // namespace
+
+TEST(JsonWriter, EscapesQuotesAndBackslashes) {
+    EXPECT_EQ(Escape(R"(say "hi")"), R"(say \"hi\")");
+    EXPECT_EQ(Escape(R"(C:\path\)"), R"(C:\\path\\)");
+    EXPECT_EQ(Escape(R"(\")"), R"(\\\")");
+    // 斜杠不需要转义
+    EXPECT_EQ(Escape("a/b"), "a/b");
+}
+
+TEST(JsonWriter, EscapesControlCharacters) {
+    EXPECT_EQ(Escape("\b\f\n\r\t"), R"(\b\f\n\r\t)");
+    EXPECT_EQ(Escape(std::string("a\0b", 3)), R"(a\u0000b)");
+    EXPECT_EQ(Escape("\x01\x1f"), R"(\u0001\u001f)");
+    // 0x7f 在 JSON 中不需要转义
+    EXPECT_EQ(Escape("\x7f"), "\x7f");
+    for (int c = 0; c < 0x20; c++) {
+        std::string text(1, (char)c);
+        EXPECT_EQ(RoundTrip(text), text) << c;
+    }
+}
+
+TEST(JsonWriter, NonAsciiWakeWordsPassThrough) {
+    for (std::string wake_word : {"你好小智", "小爱同学", "Hé Jarvis", "こんにちは", "😀 hi"}) {
+        EXPECT_EQ(Escape(wake_word), wake_word);
+        EXPECT_EQ(RoundTrip(wake_word), wake_word);
+    }
+    // 混合中文、引号和换行
+    std::string wake_word = "你好\"小智\"\n";
+    EXPECT_EQ(Escape(wake_word), R"(你好\"小智\"\n)");
+    EXPECT_EQ(RoundTrip(wake_word), wake_word);
+}
+
+TEST(JsonWriter, AllBytesRoundTrip) {
+    std::string text;
+    for (int c = 1; c < 0x80; c++) {
+        text.push_back((char)c);
+    }
+    EXPECT_EQ(RoundTrip(text), text);
+}
+
+TEST(JsonWriter, Structure) {
+    std::string buffer;
+    JsonWriter writer(buffer);
+    writer.BeginObject()
+        .Field("type", "listen")
+        .Key("n").Number(-9007199254740993)
+        .Key("ok").Bool(true)
+        .Key("off").Bool(false)
+        .Key("list").BeginArray().Number(1).String("a\"").BeginObject().EndObject().BeginArray().EndArray().EndArray()
+        .Key("raw").Raw(R"({"x":1})")
+        .Key("k\"ey").String("")
+        .EndObject();
+    EXPECT_EQ(buffer,
+        R"({"type":"listen","n":-9007199254740993,"ok":true,"off":false,"list":[1,"a\"",{},[]],"raw":{"x":1},"k\"ey":""})");
+}
+
+TEST(JsonWriter, ReusesBuffer) {
+    std::string buffer;
+    buffer.reserve(256);
+    {
+        JsonWriter writer(buffer);
+        writer.BeginObject().Field("a", std::string(100, 'x')).EndObject();
+    }
+    auto data = buffer.data();
+    JsonWriter writer(buffer);
+    EXPECT_TRUE(buffer.empty());
+    writer.BeginObject().Field("b", "y").EndObject();
+    EXPECT_EQ(buffer, R"({"b":"y"})");
+    EXPECT_EQ(buffer.data(), data);
+}
+
+namespace {
+
+// 和 Protocol 中相同的消息模板
+constexpr std::string_view kSessionIdPrefix = "{\"session_id\":\"";
+constexpr std::string_view kWakeWordInfix = "\",\"type\":\"listen\",\"state\":\"detect\",\"text\":\"";
+constexpr std::string_view kStringEndSuffix = "\"}";
+constexpr std::string_view kStartListeningAutoSuffix = "\",\"type\":\"listen\",\"state\":\"start\",\"mode\":\"auto\"}";
+constexpr std::string_view kAbortWakeWordSuffix = "\",\"type\":\"abort\",\"reason\":\"wake_word_detected\"}";
+constexpr std::string_view kIotStatesInfix = "\",\"type\":\"iot\",\"update\":true,\"states\":";
+
+const std::string kSessionId = "8f3c2a1e-5b7d-4c9a-a0e2-3d6f1b9c7e45";
+const std::string kWakeWord = "你好小智";
+const std::string kStates = R"([{"name":"Speaker","state":{"volume":70}},{"name":"Lamp","state":{"power":true}}])";
+
+// 改为 JsonWriter 之前 Protocol 拼接消息的做法
+void BuildWithConcatenation(std::string& message) {
+    message = "{\"session_id\":\"" + kSessionId +
+        "\",\"type\":\"listen\",\"state\":\"detect\",\"text\":\"" + kWakeWord + "\"}";
+    message = "{\"session_id\":\"" + kSessionId + "\"";
+    message += ",\"type\":\"listen\",\"state\":\"start\"";
+    message += ",\"mode\":\"auto\"";
+    message += "}";
+    message = "{\"session_id\":\"" + kSessionId + "\",\"type\":\"abort\"";
+    message += ",\"reason\":\"wake_word_detected\"";
+    message += "}";
+    message = "{\"session_id\":\"" + kSessionId + "\",\"type\":\"iot\",\"update\":true,\"states\":" + kStates + "}";
+}
+
+// 现在的做法：预先序列化的模板写入复用的缓冲区
+void BuildWithWriter(std::string& buffer) {
+    {
+        JsonWriter writer(buffer);
+        writer.Append(kSessionIdPrefix).AppendEscaped(kSessionId);
+        writer.Append(kWakeWordInfix).AppendEscaped(kWakeWord).Append(kStringEndSuffix);
+    }
+    {
+        JsonWriter writer(buffer);
+        writer.Append(kSessionIdPrefix).AppendEscaped(kSessionId).Append(kStartListeningAutoSuffix);
+    }
+    {
+        JsonWriter writer(buffer);
+        writer.Append(kSessionIdPrefix).AppendEscaped(kSessionId).Append(kAbortWakeWordSuffix);
+    }
+    {
+        JsonWriter writer(buffer);
+        writer.Append(kSessionIdPrefix).AppendEscaped(kSessionId);
+        writer.Append(kIotStatesInfix).Append(kStates).Append("}");
+    }
+}
+
+struct Measurement {
+    double nanoseconds;
+    double allocations;
+};
+
+// 每次调用生成 4 条消息，返回每条消息的平均值
+template <typename Build>
+Measurement Measure(std::string& buffer, Build build) {
+    constexpr int kRounds = 20000;
+    constexpr int kMessages = 4;
+    build(buffer);
+    size_t allocations = g_allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; round++) {
+        build(buffer);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double count = (double)kRounds * kMessages;
+    return {std::chrono::duration<double, std::nano>(elapsed).count() / count, (g_allocations - allocations) / count};
+}
+
+} // namespace
+
+// wake word、listen start、abort 和 iot states 四种消息，比较字符串拼接和 JsonWriter 的耗时与分配次数
+TEST(JsonWriterBenchmark, ControlMessages) {
+    std::string concatenated, written;
+    BuildWithConcatenation(concatenated);
+    BuildWithWriter(written);
+    EXPECT_EQ(written, concatenated);
+
+    std::string message;
+    auto old_way = Measure(message, BuildWithConcatenation);
+    // Protocol 构造时为 message_buffer_ 预留 PROTOCOL_MESSAGE_BUFFER_SIZE
+    std::string buffer;
+    buffer.reserve(512);
+    auto new_way = Measure(buffer, BuildWithWriter);
+
+    printf("std::string + %8.1f ns/message %6.2f allocations/message\n", old_way.nanoseconds, old_way.allocations);
+    printf("JsonWriter    %8.1f ns/message %6.2f allocations/message\n", new_way.nanoseconds, new_way.allocations);
+    EXPECT_EQ(new_way.allocations, 0.0);
+    EXPECT_GT(old_way.allocations, 1.0);
+}
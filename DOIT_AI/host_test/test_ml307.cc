@@ -0,0 +1,243 @@
+#include "ml307_at_modem.h"
+#include "ml307_ssl_transport.h"
+#include "ml307_udp.h"
+#include "simulated_modem.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <random>
+#include <thread>
+
+namespace {
+
+// 模组的任务在测试进程中一直运行，所有测试共用一个实例
+Ml307AtModem& GetModem() {
+    static auto modem = new Ml307AtModem();
+    return *modem;
+}
+
+SimulatedModem& GetPeer() {
+    static auto peer = new SimulatedModem();
+    return *peer;
+}
+
+std::string RandomData(size_t size, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::string data(size, '\0');
+    for (auto& c : data) {
+        c = (char)random();
+    }
+    // 二进制数据中出现的行结束符和 URC 前缀不能打断帧
+    if (size > 16) {
+        data.replace(3, 6, "\r\nOK\r\n");
+        data.replace(10, 6, "+CME: ");
+    }
+    return data;
+}
+
+// 以 921600 波特率（每字节 10 位）传输这么多串口字节时的有效吞吐，单位 KB/s
+double EffectiveThroughput(size_t payload_bytes, size_t wire_bytes) {
+    double seconds = wire_bytes * 10.0 / 921600;
+    return payload_bytes / 1024.0 / seconds;
+}
+
+class Ml307Test : public ::testing::TestWithParam<bool> {
+protected:
+    void SetUp() override {
+        GetModem();
+        GetPeer().Reset();
+        GetPeer().set_binary_supported(GetParam());
+    }
+
+    bool binary() const { return GetParam(); }
+
+    std::pair<size_t, size_t> WireBytes() {
+        auto& uart = host_test_uart();
+        std::lock_guard<std::mutex> lock(uart.mutex);
+        return {uart.tx_bytes, uart.rx_bytes};
+    }
+};
+
+TEST_P(Ml307Test, SslTransportRoundTrip) {
+    Ml307SslTransport transport(GetModem(), 0);
+    ASSERT_TRUE(transport.Connect("example.com", 443));
+    EXPECT_EQ(GetPeer().binary(0), binary());
+
+    auto data = RandomData(5000, 1);
+    ASSERT_EQ(transport.Send(data.data(), data.size()), (int)data.size());
+    EXPECT_EQ(GetPeer().sent_data(0), data);
+    // 二进制每块 1460 字节，HEX 每块 730 字节
+    EXPECT_EQ(GetPeer().send_commands(), binary() ? 4u : 7u);
+
+    auto reply = RandomData(3000, 2);
+    GetPeer().PushData(0, reply.substr(0, 1000));
+    GetPeer().PushData(0, reply.substr(1000));
+    std::string received;
+    char buffer[512];
+    while (received.size() < reply.size()) {
+        int length = transport.Receive(buffer, sizeof(buffer));
+        ASSERT_GT(length, 0);
+        received.append(buffer, length);
+    }
+    EXPECT_EQ(received, reply);
+    transport.Disconnect();
+}
+
+TEST_P(Ml307Test, UdpRoundTrip) {
+    Ml307Udp udp(GetModem(), 1);
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<std::string> messages;
+    udp.OnMessage([&](const std::string& data) {
+        std::lock_guard<std::mutex> lock(mutex);
+        messages.push_back(data);
+        condition.notify_all();
+    });
+    ASSERT_TRUE(udp.Connect("example.com", 8888));
+    EXPECT_EQ(GetPeer().binary(1), binary());
+
+    // 一次排队的包数不超过 ML307_MAX_PENDING_COMMANDS
+    std::string expected;
+    for (int i = 0; i < ML307_MAX_PENDING_COMMANDS / 2; ++i) {
+        auto packet = RandomData(100 + i * 30, 10 + i);
+        ASSERT_EQ(udp.Send(packet), (int)packet.size());
+        expected += packet;
+    }
+    // 发送是异步的，等待队列清空
+    for (int i = 0; i < 100 && GetPeer().sent_data(1).size() < expected.size(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(GetPeer().sent_data(1), expected);
+
+    for (int i = 0; i < 5; ++i) {
+        GetPeer().PushData(1, RandomData(200 + i, 100 + i));
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(condition.wait_for(lock, std::chrono::seconds(2), [&]() { return messages.size() == 5; }));
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(messages[i], RandomData(200 + i, 100 + i));
+    }
+    lock.unlock();
+    udp.Disconnect();
+}
+
+// 串口上每个有效字节实际传输的字节数，以及按 921600 波特率折算的吞吐
+TEST_P(Ml307Test, Throughput) {
+    Ml307SslTransport transport(GetModem(), 2);
+    ASSERT_TRUE(transport.Connect("example.com", 443));
+
+    auto data = RandomData(64 * 1024, 3);
+    auto before = WireBytes();
+    ASSERT_EQ(transport.Send(data.data(), data.size()), (int)data.size());
+    auto after_send = WireBytes();
+    for (size_t offset = 0; offset < data.size(); offset += 1024) {
+        GetPeer().PushData(2, data.substr(offset, 1024));
+    }
+    std::vector<char> buffer(data.size());
+    size_t received = 0;
+    while (received < data.size()) {
+        int length = transport.Receive(buffer.data() + received, buffer.size() - received);
+        ASSERT_GT(length, 0);
+        received += length;
+    }
+    auto after_receive = WireBytes();
+    transport.Disconnect();
+
+    size_t tx = after_send.first - before.first;
+    size_t rx = after_receive.second - after_send.second;
+    double tx_ratio = (double)tx / data.size();
+    double rx_ratio = (double)rx / data.size();
+    printf("%s: send %.3f UART bytes/byte (%.1f KB/s at 921600), receive %.3f UART bytes/byte (%.1f KB/s)\n",
+        binary() ? "binary" : "hex", tx_ratio, EffectiveThroughput(data.size(), tx),
+        rx_ratio, EffectiveThroughput(data.size(), rx));
+    if (binary()) {
+        EXPECT_LT(tx_ratio, 1.05);
+        EXPECT_LT(rx_ratio, 1.05);
+    } else {
+        EXPECT_GT(tx_ratio, 2.0);
+        EXPECT_GT(rx_ratio, 2.0);
+    }
+}
+
+// 模组确认（+MIPSEND）比 OK 晚到，Send 要等到本次每个数据块都确认后才返回
+TEST_P(Ml307Test, SendWaitsForEveryAck) {
+    Ml307SslTransport transport(GetModem(), 3);
+    ASSERT_TRUE(transport.Connect("example.com", 443));
+    GetPeer().HoldSendAcks(true);
+
+    auto WaitHeld = [](size_t count) {
+        for (int i = 0; i < 200 && GetPeer().held_send_acks() != count; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return GetPeer().held_send_acks();
+    };
+
+    size_t chunk_size = binary() ? 1460 : 730;
+    auto data = RandomData(chunk_size * 5, 4);
+    std::atomic<int> result = 0;
+    std::atomic<bool> done = false;
+    std::thread sender([&]() {
+        result = transport.Send(data.data(), data.size());
+        done = true;
+    });
+
+    // 最多 SSL_SEND_WINDOW 块等待确认
+    EXPECT_EQ(WaitHeld(SSL_SEND_WINDOW), (size_t)SSL_SEND_WINDOW);
+    GetPeer().ReleaseSendAcks(1);
+    EXPECT_EQ(WaitHeld(SSL_SEND_WINDOW), (size_t)SSL_SEND_WINDOW);
+    GetPeer().ReleaseSendAcks(SSL_SEND_WINDOW - 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_FALSE(done) << "Send returned with the last chunk unacknowledged";
+
+    GetPeer().ReleaseSendAcks();
+    sender.join();
+    EXPECT_EQ(result, (int)data.size());
+    EXPECT_EQ(GetPeer().sent_data(3), data);
+
+    // 上一次的确认已经全部消耗，下一次发送同样要等自己的确认
+    done = false;
+    sender = std::thread([&]() {
+        result = transport.Send(data.data(), chunk_size);
+        done = true;
+    });
+    EXPECT_EQ(WaitHeld(1), 1u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_FALSE(done);
+    GetPeer().ReleaseSendAcks();
+    sender.join();
+    EXPECT_EQ(result, (int)chunk_size);
+    transport.Disconnect();
+}
+
+TEST_P(Ml307Test, SendFailsWhenModemRejects) {
+    Ml307SslTransport transport(GetModem(), 4);
+    ASSERT_TRUE(transport.Connect("example.com", 443));
+    GetPeer().FailSends(true);
+
+    auto data = RandomData(10000, 5);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(transport.Send(data.data(), data.size()), -1);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+    EXPECT_FALSE(transport.connected());
+}
+
+// 模组不回复时阻塞的 Command 在超时后返回
+TEST_P(Ml307Test, CommandTimesOut) {
+    GetPeer().SetSilent(true);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(GetModem().Command("AT+CSQ", 100));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(elapsed, std::chrono::milliseconds(100));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(100 + COMMAND_WAIT_MARGIN_MS + 500));
+    GetPeer().SetSilent(false);
+    EXPECT_TRUE(GetModem().Command("AT"));
+}
+
+INSTANTIATE_TEST_SUITE_P(Encoding, Ml307Test, ::testing::Bool(), [](const auto& info) {
+    return info.param ? "Binary" : "Hex";
+});
+
+} // namespace
@@ -0,0 +1,307 @@
+#include "receive_stats.h"
+#include "reorder_buffer.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kFrameMs = 60;
+
+// 按 60ms 一帧的时间戳输入，到达时间等于时间戳加 transit_ms
+bool Receive(ReceiveStats& stats, uint32_t sequence, int64_t transit_ms = 100) {
+    uint32_t timestamp = 1000 + sequence * kFrameMs;
+    return stats.OnPacket(sequence, timestamp, timestamp + transit_ms);
+}
+
+struct Output {
+    std::vector<uint32_t> sequences;
+
+    auto Collector() {
+        return [this](uint32_t&& sequence) {
+            sequences.push_back(sequence);
+        };
+    }
+};
+
+} // namespace
+
+TEST(ReceiveStats, InOrder) {
+    ReceiveStats stats;
+    for (uint32_t s = 1; s <= 10; s++) {
+        EXPECT_TRUE(Receive(stats, s));
+    }
+    EXPECT_EQ(stats.received(), 10u);
+    EXPECT_EQ(stats.expected(), 10u);
+    EXPECT_EQ(stats.lost(), 0u);
+    EXPECT_EQ(stats.loss_rate(), 0.0f);
+    EXPECT_TRUE(stats.TakeMissingSequences().empty());
+}
+
+TEST(ReceiveStats, Loss) {
+    ReceiveStats stats;
+    EXPECT_TRUE(Receive(stats, 1));
+    EXPECT_TRUE(Receive(stats, 2));
+    EXPECT_TRUE(Receive(stats, 5));
+    EXPECT_EQ(stats.expected(), 5u);
+    EXPECT_EQ(stats.lost(), 2u);
+    EXPECT_FLOAT_EQ(stats.loss_rate(), 0.4f);
+    EXPECT_EQ(stats.TakeMissingSequences(), (std::vector<uint32_t>{3, 4}));
+    // 只返回新发现的缺失序号
+    EXPECT_TRUE(stats.TakeMissingSequences().empty());
+    EXPECT_TRUE(Receive(stats, 7));
+    EXPECT_EQ(stats.TakeMissingSequences(), (std::vector<uint32_t>{6}));
+}
+
+TEST(ReceiveStats, LongGapKeepsRecentMissing) {
+    ReceiveStats stats;
+    EXPECT_TRUE(Receive(stats, 1));
+    EXPECT_TRUE(Receive(stats, 100));
+    EXPECT_EQ(stats.lost(), 98u);
+    auto missing = stats.TakeMissingSequences();
+    ASSERT_EQ(missing.size(), (size_t)RECEIVE_STATS_MAX_MISSING);
+    EXPECT_EQ(missing.front(), 100u - RECEIVE_STATS_MAX_MISSING);
+    EXPECT_EQ(missing.back(), 99u);
+}
+
+TEST(ReceiveStats, ReorderWithinWindowIsPlayable) {
+    ReceiveStats stats(4);
+    EXPECT_TRUE(Receive(stats, 1));
+    EXPECT_TRUE(Receive(stats, 2));
+    EXPECT_TRUE(Receive(stats, 4));
+    EXPECT_TRUE(Receive(stats, 5));
+    EXPECT_TRUE(Receive(stats, 3));
+    EXPECT_EQ(stats.reordered(), 1u);
+    EXPECT_EQ(stats.late(), 0u);
+    EXPECT_EQ(stats.lost(), 0u);
+    // 已经补上的序号不再出现在 NACK 中
+    EXPECT_TRUE(stats.TakeMissingSequences().empty());
+}
+
+TEST(ReceiveStats, ReorderBeyondWindowIsLate) {
+    ReceiveStats stats(2);
+    EXPECT_TRUE(Receive(stats, 1));
+    EXPECT_TRUE(Receive(stats, 3));
+    EXPECT_TRUE(Receive(stats, 4));
+    // 最新的是 4，2 已经比它旧 2 个，乱序缓冲已经跳过
+    EXPECT_FALSE(Receive(stats, 2));
+    EXPECT_EQ(stats.reordered(), 1u);
+    EXPECT_EQ(stats.late(), 1u);
+    EXPECT_EQ(stats.received(), 4u);
+    EXPECT_EQ(stats.lost(), 0u);
+}
+
+TEST(ReceiveStats, WithoutWindowEveryReorderIsLate) {
+    ReceiveStats stats;
+    EXPECT_TRUE(Receive(stats, 1));
+    EXPECT_TRUE(Receive(stats, 3));
+    EXPECT_FALSE(Receive(stats, 2));
+    EXPECT_EQ(stats.late(), 1u);
+}
+
+TEST(ReceiveStats, Duplicates) {
+    ReceiveStats stats(4);
+    EXPECT_TRUE(Receive(stats, 1));
+    EXPECT_TRUE(Receive(stats, 3));
+    EXPECT_FALSE(Receive(stats, 3));
+    EXPECT_FALSE(Receive(stats, 1));
+    EXPECT_TRUE(Receive(stats, 2));
+    // 补上缺口的包重传了两次
+    EXPECT_FALSE(Receive(stats, 2));
+    EXPECT_EQ(stats.duplicated(), 3u);
+    EXPECT_EQ(stats.received(), 3u);
+    EXPECT_EQ(stats.lost(), 0u);
+}
+
+TEST(ReceiveStats, Wraparound) {
+    ReceiveStats stats(4);
+    EXPECT_TRUE(Receive(stats, 0xFFFFFFFE));
+    EXPECT_TRUE(Receive(stats, 0xFFFFFFFF));
+    EXPECT_TRUE(Receive(stats, 2));
+    EXPECT_EQ(stats.expected(), 5u);
+    EXPECT_EQ(stats.lost(), 2u);
+    EXPECT_EQ(stats.TakeMissingSequences(), (std::vector<uint32_t>{0, 1}));
+    EXPECT_TRUE(Receive(stats, 0));
+    EXPECT_TRUE(Receive(stats, 1));
+    EXPECT_FALSE(Receive(stats, 0xFFFFFFFF));
+    EXPECT_EQ(stats.lost(), 0u);
+    EXPECT_EQ(stats.duplicated(), 1u);
+}
+
+TEST(ReceiveStats, Jitter) {
+    ReceiveStats stats;
+    for (uint32_t s = 0; s < 100; s++) {
+        Receive(stats, s, 100);
+    }
+    EXPECT_EQ(stats.jitter(), 0u);
+
+    // 传输时间在 100ms 和 120ms 之间交替，|D| 一直是 20，J 收敛到 20
+    stats.Reset();
+    for (uint32_t s = 0; s < 200; s++) {
+        Receive(stats, s, s % 2 == 0 ? 100 : 120);
+    }
+    EXPECT_GE(stats.jitter(), 19u);
+    EXPECT_LE(stats.jitter(), 20u);
+
+    // 没有时间戳的包不参与抖动计算
+    stats.Reset();
+    stats.OnPacket(0, 0, 0);
+    stats.OnPacket(1, 0, 500);
+    EXPECT_EQ(stats.jitter(), 0u);
+    EXPECT_EQ(stats.received(), 2u);
+}
+
+TEST(ReceiveStats, ResetAndJson) {
+    ReceiveStats stats(4);
+    Receive(stats, 10);
+    Receive(stats, 12);
+    Receive(stats, 11);
+    Receive(stats, 11);
+    EXPECT_EQ(stats.GetJson(),
+        "{\"received\":3,\"expected\":3,\"lost\":0,\"reordered\":1,\"late\":0,\"duplicated\":1,\"jitter\":0}");
+    stats.Reset();
+    EXPECT_EQ(stats.received(), 0u);
+    EXPECT_EQ(stats.expected(), 0u);
+    // 重置后从新的序号开始计算
+    EXPECT_TRUE(Receive(stats, 500));
+    EXPECT_EQ(stats.expected(), 1u);
+}
+
+TEST(ReorderBuffer, InOrderPassesThrough) {
+    ReorderBuffer<uint32_t> buffer(4);
+    Output output;
+    for (uint32_t s = 5; s < 10; s++) {
+        EXPECT_TRUE(buffer.Push(s, uint32_t(s), output.Collector()));
+        EXPECT_TRUE(buffer.empty());
+    }
+    EXPECT_EQ(output.sequences, (std::vector<uint32_t>{5, 6, 7, 8, 9}));
+}
+
+TEST(ReorderBuffer, GapFilledWithinWindow) {
+    ReorderBuffer<uint32_t> buffer(4);
+    Output output;
+    for (uint32_t s : {1, 2, 4, 5}) {
+        EXPECT_TRUE(buffer.Push(s, uint32_t(s), output.Collector()));
+    }
+    EXPECT_EQ(output.sequences, (std::vector<uint32_t>{1, 2}));
+    EXPECT_FALSE(buffer.empty());
+    EXPECT_TRUE(buffer.Push(3, 3, output.Collector()));
+    EXPECT_EQ(output.sequences, (std::vector<uint32_t>{1, 2, 3, 4, 5}));
+    EXPECT_TRUE(buffer.empty());
+}
+
+TEST(ReorderBuffer, GapSkippedAfterWindow) {
+    ReorderBuffer<uint32_t> buffer(2);
+    Output output;
+    for (uint32_t s : {1, 3, 4}) {
+        EXPECT_TRUE(buffer.Push(s, uint32_t(s), output.Collector()));
+    }
+    EXPECT_EQ(output.sequences, (std::vector<uint32_t>{1, 3, 4}));
+    EXPECT_FALSE(buffer.Push(2, 2, output.Collector()));
+    EXPECT_FALSE(buffer.Push(4, 4, output.Collector()));
+}
+
+TEST(ReorderBuffer, WithoutWindowNeverWaits) {
+    ReorderBuffer<uint32_t> buffer(0);
+    Output output;
+    for (uint32_t s : {1, 3, 2, 6}) {
+        buffer.Push(s, uint32_t(s), output.Collector());
+        EXPECT_TRUE(buffer.empty());
+    }
+    EXPECT_EQ(output.sequences, (std::vector<uint32_t>{1, 3, 6}));
+}
+
+TEST(ReorderBuffer, FlushReleasesHeldPackets) {
+    ReorderBuffer<uint32_t> buffer(4);
+    Output output;
+    buffer.Push(1, 1, output.Collector());
+    buffer.Push(3, 3, output.Collector());
+    buffer.Push(5, 5, output.Collector());
+    EXPECT_EQ(output.sequences, (std::vector<uint32_t>{1}));
+    buffer.Flush(output.Collector());
+    EXPECT_EQ(output.sequences, (std::vector<uint32_t>{1, 3, 5}));
+    EXPECT_TRUE(buffer.empty());
+    // 交出后缺口中的包再到达时丢弃
+    EXPECT_FALSE(buffer.Push(2, 2, output.Collector()));
+    EXPECT_TRUE(buffer.Push(6, 6, output.Collector()));
+}
+
+TEST(ReorderBuffer, FarJumpKeepsWindowOnly) {
+    ReorderBuffer<uint32_t> buffer(4);
+    Output output;
+    buffer.Push(1, 1, output.Collector());
+    buffer.Push(3, 3, output.Collector());
+    buffer.Push(1000000, 1000000, output.Collector());
+    EXPECT_EQ(output.sequences, (std::vector<uint32_t>{1, 3}));
+    // 比最新的包旧不到 4 个的序号仍然等待
+    EXPECT_TRUE(buffer.Push(999998, 999998, output.Collector()));
+    EXPECT_TRUE(buffer.Push(999997, 999997, output.Collector()));
+    EXPECT_FALSE(buffer.Push(999996, 999996, output.Collector()));
+    buffer.Flush(output.Collector());
+    EXPECT_EQ(output.sequences, (std::vector<uint32_t>{1, 3, 999997, 999998, 1000000}));
+}
+
+TEST(ReorderBuffer, Wraparound) {
+    ReorderBuffer<uint32_t> buffer(4);
+    Output output;
+    for (uint32_t s : {0xFFFFFFFEu, 1u, 0xFFFFFFFFu, 0u}) {
+        EXPECT_TRUE(buffer.Push(s, uint32_t(s), output.Collector()));
+    }
+    EXPECT_EQ(output.sequences, (std::vector<uint32_t>{0xFFFFFFFE, 0xFFFFFFFF, 0, 1}));
+}
+
+TEST(ReorderBuffer, ResetStartsFromNextPacket) {
+    ReorderBuffer<uint32_t> buffer(4);
+    Output output;
+    buffer.Push(10, 10, output.Collector());
+    buffer.Push(12, 12, output.Collector());
+    buffer.Reset();
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_TRUE(buffer.Push(3, 3, output.Collector()));
+    EXPECT_EQ(output.sequences, (std::vector<uint32_t>{10, 3}));
+}
+
+// 和 MqttProtocol 一样，ReceiveStats 接受的包放入乱序缓冲：
+// 丢包、乱序、重复和回绕混在一起时，交出的序号严格递增，ReceiveStats 接受的包都能交出
+TEST(ReorderBuffer, WithReceiveStats) {
+    for (uint32_t window : {0u, 1u, 4u, 8u}) {
+        std::mt19937 random(window);
+        uint32_t first = 0xFFFFFF00;
+        std::vector<uint32_t> arrivals;
+        for (uint32_t i = 0; i < 2000; i++) {
+            if (random() % 20 != 0) {
+                arrivals.push_back(first + i);
+            }
+            if (random() % 30 == 0 && !arrivals.empty()) {
+                arrivals.push_back(arrivals[random() % arrivals.size()]);
+            }
+        }
+        // 每个包最多向后错位 6 个位置
+        for (size_t i = 0; i + 1 < arrivals.size(); i++) {
+            if (random() % 5 == 0) {
+                std::swap(arrivals[i], arrivals[std::min(arrivals.size() - 1, i + 1 + random() % 6)]);
+            }
+        }
+
+        ReceiveStats stats(window);
+        ReorderBuffer<uint32_t> buffer(window);
+        Output output;
+        uint32_t accepted = 0;
+        for (auto sequence : arrivals) {
+            if (stats.OnPacket(sequence, 0, 0)) {
+                accepted++;
+                EXPECT_TRUE(buffer.Push(sequence, uint32_t(sequence), output.Collector()))
+                    << "window " << window << " sequence " << sequence;
+            }
+        }
+        buffer.Flush(output.Collector());
+        ASSERT_EQ(output.sequences.size(), accepted) << "window " << window;
+        for (size_t i = 1; i < output.sequences.size(); i++) {
+            EXPECT_GT((int32_t)(output.sequences[i] - output.sequences[i - 1]), 0) << "window " << window;
+        }
+        EXPECT_EQ(stats.received() - stats.late(), accepted);
+    }
+}
@@ -0,0 +1,253 @@
+#include "settings.h"
+
+#include <esp_timer.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+
+namespace {
+
+// 缓存是进程内的单例，每个测试使用自己的命名空间
+class SettingsTest : public testing::Test {
+protected:
+    void TearDown() override {
+        auto& nvs = host_test_nvs();
+        std::lock_guard<std::recursive_mutex> lock(nvs.mutex);
+        nvs.power_loss_after = -1;
+        nvs.on_commit = nullptr;
+    }
+
+    static const host_test_nvs_value* Stored(const std::string& ns, const std::string& key) {
+        auto& nvs = host_test_nvs();
+        std::lock_guard<std::recursive_mutex> lock(nvs.mutex);
+        auto& space = nvs.namespaces[ns];
+        auto it = space.find(key);
+        return it == space.end() ? nullptr : &it->second;
+    }
+
+    static std::string StoredString(const std::string& ns, const std::string& key) {
+        auto value = Stored(ns, key);
+        return value != nullptr && value->type == NVS_TYPE_STR ? value->string_value : "<none>";
+    }
+
+    static int Writes() {
+        std::lock_guard<std::recursive_mutex> lock(host_test_nvs().mutex);
+        return host_test_nvs().writes;
+    }
+
+    static int Commits() {
+        std::lock_guard<std::recursive_mutex> lock(host_test_nvs().mutex);
+        return host_test_nvs().commits;
+    }
+};
+
+// 在 ns 的提交开始时阻塞，直到 Release
+class CommitBlocker {
+public:
+    explicit CommitBlocker(const std::string& ns) {
+        auto entered = std::make_shared<std::promise<void>>();
+        auto blocked = std::make_shared<std::atomic<bool>>(false);
+        entered_ = entered->get_future();
+        auto released = released_.get_future().share();
+        std::lock_guard<std::recursive_mutex> lock(host_test_nvs().mutex);
+        // nvs_commit 调用的是回调的副本，只阻塞第一次提交
+        host_test_nvs().on_commit = [ns, entered, blocked, released](const std::string& commit_ns) {
+            if (commit_ns == ns && !blocked->exchange(true)) {
+                entered->set_value();
+                released.wait();
+            }
+        };
+    }
+
+    bool WaitEntered() { return entered_.wait_for(std::chrono::seconds(5)) == std::future_status::ready; }
+    void Release() { released_.set_value(); }
+
+private:
+    std::future<void> entered_;
+    std::promise<void> released_;
+};
+
+TEST_F(SettingsTest, FlushWritesChangesInOneCommit) {
+    {
+        nvs_handle_t handle;
+        ASSERT_EQ(nvs_open("t_flush", NVS_READWRITE, &handle), ESP_OK);
+        nvs_set_i32(handle, "old", 7);
+        nvs_close(handle);
+    }
+    Settings settings("t_flush", true);
+    EXPECT_EQ(settings.GetInt("old"), 7);
+    settings.SetString("name", "xiaozhi");
+    settings.SetInt("volume", 70);
+    settings.EraseKey("old");
+    EXPECT_EQ(settings.GetInt("old", -1), -1);
+    EXPECT_EQ(Stored("t_flush", "name"), nullptr);
+
+    int commits = Commits();
+    Settings::Flush();
+    EXPECT_EQ(Commits(), commits + 1);
+    EXPECT_EQ(StoredString("t_flush", "name"), "xiaozhi");
+    ASSERT_NE(Stored("t_flush", "volume"), nullptr);
+    EXPECT_EQ(Stored("t_flush", "volume")->int_value, 70);
+    EXPECT_EQ(Stored("t_flush", "old"), nullptr);
+
+    Settings reader("t_flush");
+    EXPECT_EQ(reader.GetString("name"), "xiaozhi");
+    EXPECT_EQ(reader.GetInt("volume"), 70);
+}
+
+TEST_F(SettingsTest, UnchangedValuesAreNotWritten) {
+    Settings settings("t_unchanged", true);
+    settings.SetInt("volume", 50);
+    Settings::Flush();
+
+    int writes = Writes();
+    int commits = Commits();
+    settings.SetInt("volume", 50);
+    Settings::Flush();
+    EXPECT_EQ(Writes(), writes);
+    EXPECT_EQ(Commits(), commits);
+}
+
+TEST_F(SettingsTest, ReadOnlyInstanceDoesNotWrite) {
+    Settings settings("t_read_only");
+    settings.SetInt("volume", 50);
+    settings.EraseAll();
+    Settings::Flush();
+    EXPECT_EQ(Stored("t_read_only", "volume"), nullptr);
+    EXPECT_EQ(settings.GetInt("volume", -1), -1);
+}
+
+// 延迟提交在 settings_commit 任务中执行，提交期间 esp_timer 任务和其它调用者都不会被阻塞
+TEST_F(SettingsTest, DelayedCommitRunsOutsideTimerTask) {
+    Settings settings("t_delayed", true);
+    settings.SetString("a", "1");
+    CommitBlocker blocker("t_delayed");
+
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(host_test_fire_timer("settings_commit"));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(100));
+    ASSERT_TRUE(blocker.WaitEntered());
+
+    auto access = std::async(std::launch::async, [&settings]() {
+        settings.SetString("b", "2");
+        return settings.GetString("a") + settings.GetString("b");
+    });
+    ASSERT_EQ(access.wait_for(std::chrono::seconds(2)), std::future_status::ready) << "Cache locked during commit";
+    EXPECT_EQ(access.get(), "12");
+
+    blocker.Release();
+    for (int i = 0; i < 200 && Stored("t_delayed", "a") == nullptr; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(StoredString("t_delayed", "a"), "1");
+    Settings::Flush();
+    EXPECT_EQ(StoredString("t_delayed", "b"), "2");
+}
+
+// 提交期间再次修改的值在下一次提交时写入
+TEST_F(SettingsTest, ChangeDuringCommitIsNotLost) {
+    Settings settings("t_concurrent", true);
+    settings.SetString("key", "first");
+    CommitBlocker blocker("t_concurrent");
+    std::thread flusher([]() { Settings::Flush(); });
+    ASSERT_TRUE(blocker.WaitEntered());
+
+    settings.SetString("key", "second");
+    blocker.Release();
+    flusher.join();
+    EXPECT_EQ(StoredString("t_concurrent", "key"), "first");
+    EXPECT_EQ(settings.GetString("key"), "second");
+
+    Settings::Flush();
+    EXPECT_EQ(StoredString("t_concurrent", "key"), "second");
+}
+
+// 每个可能的掉电位置：每个键要么是旧值要么是新值，恢复供电后再次提交得到完整的新值
+TEST_F(SettingsTest, PowerLossDuringCommitLeavesWholeValues) {
+    const int key_count = 5;
+    for (int power_loss_after = 0; power_loss_after <= key_count; power_loss_after++) {
+        std::string ns = "t_power_" + std::to_string(power_loss_after);
+        Settings settings(ns, true);
+        for (int i = 0; i < key_count; i++) {
+            settings.SetString("k" + std::to_string(i), "old" + std::to_string(i));
+        }
+        Settings::Flush();
+
+        for (int i = 0; i < key_count; i++) {
+            settings.SetString("k" + std::to_string(i), "new" + std::to_string(i));
+        }
+        host_test_nvs().power_loss_after = power_loss_after;
+        Settings::Flush();
+        host_test_nvs().power_loss_after = -1;
+
+        int new_count = 0;
+        for (int i = 0; i < key_count; i++) {
+            auto stored = StoredString(ns, "k" + std::to_string(i));
+            if (stored == "new" + std::to_string(i)) {
+                new_count++;
+            } else {
+                EXPECT_EQ(stored, "old" + std::to_string(i)) << ns;
+            }
+            EXPECT_EQ(settings.GetString("k" + std::to_string(i)), "new" + std::to_string(i)) << ns;
+        }
+        EXPECT_EQ(new_count, power_loss_after) << ns;
+
+        Settings::Flush();
+        for (int i = 0; i < key_count; i++) {
+            EXPECT_EQ(StoredString(ns, "k" + std::to_string(i)), "new" + std::to_string(i)) << ns;
+        }
+    }
+}
+
+// EraseAll 逐个删除，掉电后缓存中仍然视为已清空，恢复后只剩新写入的键
+TEST_F(SettingsTest, PowerLossDuringEraseAll) {
+    for (int power_loss_after = 0; power_loss_after <= 4; power_loss_after++) {
+        std::string ns = "t_erase_" + std::to_string(power_loss_after);
+        Settings settings(ns, true);
+        settings.SetInt("a", 1);
+        settings.SetInt("b", 2);
+        settings.SetInt("c", 3);
+        Settings::Flush();
+
+        settings.EraseAll();
+        settings.SetInt("d", 4);
+        host_test_nvs().power_loss_after = power_loss_after;
+        Settings::Flush();
+        host_test_nvs().power_loss_after = -1;
+
+        int remaining = (Stored(ns, "a") != nullptr) + (Stored(ns, "b") != nullptr) + (Stored(ns, "c") != nullptr);
+        EXPECT_EQ(remaining, 3 - std::min(power_loss_after, 3)) << ns;
+        EXPECT_EQ(Stored(ns, "d") != nullptr, power_loss_after == 4) << ns;
+        EXPECT_EQ(settings.GetInt("a", -1), -1) << ns;
+        EXPECT_EQ(settings.GetInt("d"), 4) << ns;
+
+        Settings::Flush();
+        auto& nvs = host_test_nvs();
+        std::lock_guard<std::recursive_mutex> lock(nvs.mutex);
+        EXPECT_EQ(nvs.namespaces[ns].size(), 1u) << ns;
+        EXPECT_EQ(nvs.namespaces[ns]["d"].int_value, 4) << ns;
+    }
+}
+
+TEST_F(SettingsTest, LongStringsAreNotKeptInCache) {
+    Settings settings("t_long", true);
+    std::string long_value(300, 'x');
+    settings.SetString("long", long_value);
+    settings.SetString("short", "cached");
+    EXPECT_EQ(settings.GetString("long"), long_value);
+    Settings::Flush();
+
+    // 直接修改 NVS，只有没有缓存的键能读到新值
+    nvs_handle_t handle;
+    ASSERT_EQ(nvs_open("t_long", NVS_READWRITE, &handle), ESP_OK);
+    nvs_set_str(handle, "long", "reloaded");
+    nvs_set_str(handle, "short", "changed");
+    nvs_close(handle);
+    EXPECT_EQ(settings.GetString("long"), "reloaded");
+    EXPECT_EQ(settings.GetString("short"), "cached");
+}
+
+} // namespace
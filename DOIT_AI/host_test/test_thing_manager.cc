@@ -0,0 +1,177 @@
+#include "iot/thing_manager.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int kThingCount = 50;
+constexpr int kMethodCount = 4;
+
+// 每个方法记录调用次数和最后一次收到的参数
+class CountingThing : public iot::Thing {
+public:
+    explicit CountingThing(int id) : Thing("Thing" + std::to_string(id), "") {
+        executor_ = iot::kThingExecutorInline;
+        for (int i = 0; i < kMethodCount; i++) {
+            iot::ParameterList parameters({iot::Parameter("value", "", iot::kValueTypeNumber)});
+            methods_.AddMethod("Method" + std::to_string(i), "", parameters,
+                [this, i](const iot::ParameterList& parameters) {
+                    calls[i]++;
+                    last_value = parameters["value"].number();
+                });
+        }
+    }
+
+    int calls[kMethodCount] = {};
+    int last_value = -1;
+};
+
+// 50 个设备注册到 ThingManager 单例，所有用例共用
+std::vector<std::unique_ptr<CountingThing>>& Things() {
+    static auto things = []() {
+        std::vector<std::unique_ptr<CountingThing>> things;
+        for (int i = 0; i < kThingCount; i++) {
+            things.push_back(std::make_unique<CountingThing>(i));
+            iot::ThingManager::GetInstance().AddThing(things.back().get());
+        }
+        return things;
+    }();
+    return things;
+}
+
+// 用 stubs/cJSON.h 的节点拼出服务端下发的 {"name":...,"method":...,"parameters":{"value":...}}
+class Command {
+public:
+    Command(std::string name, std::string method, int value) : name_(std::move(name)), method_(std::move(method)) {
+        value_node_ = {.type = cJSON_Number, .valueint = value, .valuedouble = (double)value, .string = (char*)"value"};
+        parameters_node_ = {.child = &value_node_, .string = (char*)"parameters"};
+        method_node_ = {.next = &parameters_node_, .type = cJSON_String, .valuestring = method_.data(),
+            .string = (char*)"method"};
+        name_node_ = {.next = &method_node_, .type = cJSON_String, .valuestring = name_.data(), .string = (char*)"name"};
+        root_ = {.child = &name_node_};
+    }
+    Command(const Command&) = delete;
+    Command& operator=(const Command&) = delete;
+
+    const cJSON* json() const { return &root_; }
+    const std::string& name() const { return name_; }
+
+private:
+    std::string name_;
+    std::string method_;
+    cJSON root_ = {};
+    cJSON name_node_ = {};
+    cJSON method_node_ = {};
+    cJSON parameters_node_ = {};
+    cJSON value_node_ = {};
+};
+
+// 改为哈希索引之前 FindThing 的做法：逐个比较名称
+iot::Thing* LinearFindThing(const std::string& name) {
+    for (auto& thing : Things()) {
+        if (thing->name() == name) {
+            return thing.get();
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+TEST(ThingManager, FindThing) {
+    auto& manager = iot::ThingManager::GetInstance();
+    for (auto& thing : Things()) {
+        EXPECT_EQ(manager.FindThing(thing->name().c_str()), thing.get());
+    }
+    EXPECT_EQ(manager.FindThing("Thing50"), nullptr);
+    EXPECT_EQ(manager.FindThing(""), nullptr);
+}
+
+TEST(ThingManager, InvokeRoutesToThingAndMethod) {
+    auto& manager = iot::ThingManager::GetInstance();
+    auto& thing = Things()[37];
+    int calls = thing->calls[2];
+    Command command("Thing37", "Method2", 42);
+    manager.Invoke(command.json());
+    EXPECT_EQ(thing->calls[2], calls + 1);
+    EXPECT_EQ(thing->last_value, 42);
+
+    // 未知的设备和方法只打印日志
+    Command unknown_thing("Thing99", "Method2", 1);
+    manager.Invoke(unknown_thing.json());
+    Command unknown_method("Thing37", "Method9", 1);
+    manager.Invoke(unknown_method.json());
+    EXPECT_EQ(thing->calls[2], calls + 1);
+}
+
+// 50 个设备的注册表上执行上千条命令，比较按名称哈希查找和逐个比较名称的耗时
+TEST(ThingManagerBenchmark, CommandsAgainstFiftyThings) {
+    constexpr int kCommands = 5000;
+    constexpr int kRounds = 20;
+    auto& manager = iot::ThingManager::GetInstance();
+    auto& things = Things();
+
+    std::mt19937 random(2024);
+    std::deque<Command> commands;
+    std::vector<int> expected_calls(kThingCount * kMethodCount);
+    for (int i = 0; i < kCommands; i++) {
+        int thing = random() % kThingCount;
+        int method = random() % kMethodCount;
+        commands.emplace_back("Thing" + std::to_string(thing), "Method" + std::to_string(method), i);
+        expected_calls[thing * kMethodCount + method] += kRounds;
+    }
+    std::vector<int> base_calls;
+    for (auto& thing : things) {
+        base_calls.insert(base_calls.end(), thing->calls, thing->calls + kMethodCount);
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto per_command = [](Clock::duration elapsed) {
+        return std::chrono::duration<double, std::nano>(elapsed).count() / ((double)kCommands * kRounds);
+    };
+
+    auto start = Clock::now();
+    for (int round = 0; round < kRounds; round++) {
+        for (auto& command : commands) {
+            manager.Invoke(command.json());
+        }
+    }
+    double invoke_ns = per_command(Clock::now() - start);
+
+    // 只比较查找设备这一步
+    size_t found = 0;
+    start = Clock::now();
+    for (int round = 0; round < kRounds; round++) {
+        for (auto& command : commands) {
+            found += manager.FindThing(command.name().c_str()) != nullptr;
+        }
+    }
+    double indexed_ns = per_command(Clock::now() - start);
+    start = Clock::now();
+    for (int round = 0; round < kRounds; round++) {
+        for (auto& command : commands) {
+            found += LinearFindThing(command.name()) != nullptr;
+        }
+    }
+    double linear_ns = per_command(Clock::now() - start);
+
+    printf("Invoke          %8.1f ns/command (%d commands x %d rounds, %d things)\n", invoke_ns, kCommands, kRounds,
+        kThingCount);
+    printf("FindThing       %8.1f ns/lookup\n", indexed_ns);
+    printf("linear lookup   %8.1f ns/lookup\n", linear_ns);
+
+    EXPECT_EQ(found, 2u * kCommands * kRounds);
+    for (int i = 0; i < kThingCount; i++) {
+        for (int method = 0; method < kMethodCount; method++) {
+            EXPECT_EQ(things[i]->calls[method] - base_calls[i * kMethodCount + method],
+                expected_calls[i * kMethodCount + method]) << things[i]->name() << ".Method" << method;
+        }
+    }
+}
@@ -9,6 +9,7 @@
 #include "font_awesome_symbols.h" // 引入字体图标头文件，提供 UI 图标符号
 #include "iot/thing_manager.h" // 引入 IoT 设备管理器头文件，管理物联网设备
 #include "assets/lang_config.h" // 引入多语言配置头文件，提供多语言字符串
+#include "boot_sequence.h" // 引入启动阶段依赖图，启动时并行初始化
 
 #if CONFIG_USE_AUDIO_PROCESSOR
 #include "afe_audio_processor.h" // 如果启用音频处理器，包含 AfeAudioProcessor 头文件
@@ -36,6 +37,8 @@
 #define CONFIG_AUDIO_LOOP_TASK_STACK_SIZE   (4096*2) // 定义音频循环任务栈大小，默认 8KB
 #endif
 
+#define BOOT_MODELS_TASK_STACK_SIZE   (4096*2) // 启动时加载模型的任务栈大小，加载完成后释放
+
 static const char* const STATE_STRINGS[] = { // 定义设备状态字符串数组，便于日志和 UI 显示
     "unknown",
     "starting",
@@ -76,6 +79,29 @@ Application::Application() { // Application 构造函数，初始化应用各模
     };
     esp_timer_create(&clock_timer_args, &clock_timer_handle_); // 创建定时器，引用自 esp_timer.h
     esp_timer_start_periodic(clock_timer_handle_, 1000000); // 启动定时器，周期 1 秒
+
+#if CONFIG_IOT_STATE_PUSH_INTERVAL > 0
+    esp_timer_create_args_t iot_state_timer_args = {
+        .callback = [](void* arg) { // 定时器到期，在主循环中上报合并后的增量状态
+            Application* app = (Application*)arg;
+            app->Schedule([app]() {
+                if (app->protocol_ && app->protocol_->IsAudioChannelOpened() && app->device_state_ != kDeviceStateListening) {
+                    app->UpdateIotStates(); // 聆听状态下进入时已经上报过
+                }
+            });
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "iot_state_timer",
+        .skip_unhandled_events = true
+    };
+    esp_timer_create(&iot_state_timer_args, &iot_state_timer_handle_); // 创建单次定时器，用于合并上报
+    iot::ThingManager::GetInstance().OnStateChanged([this]() {
+        if (!esp_timer_is_active(iot_state_timer_handle_)) { // 间隔内的多次变化只上报一次
+            esp_timer_start_once(iot_state_timer_handle_, CONFIG_IOT_STATE_PUSH_INTERVAL * 1000);
+        }
+    });
+#endif
 }
 
 Application::~Application() { // 析构函数，释放资源
@@ -83,6 +109,12 @@ Application::~Application() { // 析构函数，释放资源
         esp_timer_stop(clock_timer_handle_); // 停止定时器
         esp_timer_delete(clock_timer_handle_); // 删除定时器
     }
+#if CONFIG_IOT_STATE_PUSH_INTERVAL > 0
+    if (iot_state_timer_handle_ != nullptr) {
+        esp_timer_stop(iot_state_timer_handle_); // 停止定时器
+        esp_timer_delete(iot_state_timer_handle_); // 删除定时器
+    }
+#endif
     if (background_task_ != nullptr) {
         delete background_task_; // 释放后台任务对象
     }
@@ -124,45 +156,7 @@ void Application::CheckNewVersion() { // 检查新固件版本，涉及 OTA 升
         retry_delay = 10; // 重置重试延迟时间
 
         if (ota_.HasNewVersion()) { // 检查到有新版本，引用自 ota_ 成员
-            Alert(Lang::Strings::OTA_UPGRADE, Lang::Strings::UPGRADING, "happy", Lang::Sounds::P3_UPGRADE); // 弹出升级提示
-
-            vTaskDelay(pdMS_TO_TICKS(3000)); // 延迟3秒
-
-            SetDeviceState(kDeviceStateUpgrading); // 设置设备状态为"升级中"
-            
-            display->SetIcon(FONT_AWESOME_DOWNLOAD); // 显示下载图标，引用自 font_awesome_symbols.h
-            std::string message = std::string(Lang::Strings::NEW_VERSION) + ota_.GetFirmwareVersion(); // 拼接新版本信息
-            display->SetChatMessage("system", message.c_str()); // 显示新版本信息
-
-            auto& board = Board::GetInstance(); // 获取 Board 单例
-            board.SetPowerSaveMode(false); // 关闭省电模式
-#if CONFIG_USE_WAKE_WORD_DETECT
-            wake_word_detect_.StopDetection(); // 停止唤醒词检测，引用自本类成员
-#endif
-            // 预先关闭音频输出，避免升级过程有音频操作
-            auto codec = board.GetAudioCodec(); // 获取音频编解码器对象
-            codec->EnableInput(false); // 关闭音频输入
-            codec->EnableOutput(false); // 关闭音频输出
-            {
-                std::lock_guard<std::mutex> lock(mutex_); // 加锁，保护音频解码队列
-                audio_decode_queue_.clear(); // 清空音频解码队列
-            }
-            background_task_->WaitForCompletion(); // 等待后台任务完成
-            delete background_task_; // 删除后台任务对象
-            background_task_ = nullptr; // 指针置空
-            vTaskDelay(pdMS_TO_TICKS(1000)); // 延迟1秒
-
-            ota_.StartUpgrade([display](int progress, size_t speed) { // 启动 OTA 升级，传入进度回调
-                char buffer[64];
-                snprintf(buffer, sizeof(buffer), "%d%% %zuKB/s", progress, speed / 1024); // 格式化进度信息
-                display->SetChatMessage("system", buffer); // 显示进度信息
-            });
-
-            // If upgrade success, the device will reboot and never reach here
-            display->SetStatus(Lang::Strings::UPGRADE_FAILED); // 升级失败，显示失败状态
-            ESP_LOGI(TAG, "Firmware upgrade failed..."); // 输出日志
-            vTaskDelay(pdMS_TO_TICKS(3000)); // 延迟3秒
-            Reboot(); // 重启设备，引用自本类方法
+            UpgradeFirmware(); // 升级固件，成功后重启
             return; // 退出函数
         }
 
@@ -199,6 +193,102 @@ void Application::CheckNewVersion() { // 检查新固件版本，涉及 OTA 升
     }
 }
 
+// 升级固件，成功后设备重启，失败也会重启
+void Application::UpgradeFirmware() {
+    auto display = Board::GetInstance().GetDisplay(); // 获取显示屏对象
+    Alert(Lang::Strings::OTA_UPGRADE, Lang::Strings::UPGRADING, "happy", Lang::Sounds::P3_UPGRADE); // 弹出升级提示
+
+    vTaskDelay(pdMS_TO_TICKS(3000)); // 延迟3秒
+
+    SetDeviceState(kDeviceStateUpgrading); // 设置设备状态为"升级中"
+    
+    display->SetIcon(FONT_AWESOME_DOWNLOAD); // 显示下载图标，引用自 font_awesome_symbols.h
+    std::string message = std::string(Lang::Strings::NEW_VERSION) + ota_.GetFirmwareVersion(); // 拼接新版本信息
+    display->SetChatMessage("system", message.c_str()); // 显示新版本信息
+
+    auto& board = Board::GetInstance(); // 获取 Board 单例
+    board.SetPowerSaveMode(false); // 关闭省电模式
+#if CONFIG_USE_WAKE_WORD_DETECT
+    wake_word_detect_.StopDetection(); // 停止唤醒词检测，引用自本类成员
+#endif
+    // 预先关闭音频输出，避免升级过程有音频操作
+    auto codec = board.GetAudioCodec(); // 获取音频编解码器对象
+    codec->EnableInput(false); // 关闭音频输入
+    codec->EnableOutput(false); // 关闭音频输出
+    {
+        std::lock_guard<std::mutex> lock(mutex_); // 加锁，保护音频解码队列
+        audio_decode_queue_.clear(); // 清空音频解码队列
+    }
+    background_task_->WaitForCompletion(); // 等待后台任务完成
+    delete background_task_; // 删除后台任务对象
+    background_task_ = nullptr; // 指针置空
+    vTaskDelay(pdMS_TO_TICKS(1000)); // 延迟1秒
+
+    ota_.StartUpgrade([display](int progress, size_t speed, uint32_t write_stall_ms) { // 启动 OTA 升级，传入进度回调
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%d%% %zuKB/s", progress, speed / 1024); // 格式化进度信息
+        display->SetChatMessage("system", buffer); // 显示进度信息
+    });
+
+    // If upgrade success, the device will reboot and never reach here
+    display->SetStatus(Lang::Strings::UPGRADE_FAILED); // 升级失败，显示失败状态
+    ESP_LOGI(TAG, "Firmware upgrade failed..."); // 输出日志
+    vTaskDelay(pdMS_TO_TICKS(3000)); // 延迟3秒
+    Reboot(); // 重启设备，引用自本类方法
+}
+
+// 后台检查新版本，启动时使用了缓存的配置，不阻塞设备使用
+void Application::CheckNewVersionInBackground() {
+    const int MAX_RETRY = 10; // 最大重试次数
+    int retry_delay = 10; // 初始重试延迟为10秒
+    for (int retry_count = 1; !ota_.CheckVersion(); retry_count++) {
+        if (retry_count >= MAX_RETRY) {
+            ESP_LOGE(TAG, "Too many retries, exit background version check");
+            return;
+        }
+        ESP_LOGW(TAG, "Background version check failed, retry in %d seconds (%d/%d)", retry_delay, retry_count, MAX_RETRY);
+        vTaskDelay(pdMS_TO_TICKS(retry_delay * 1000));
+        retry_delay *= 2; // 每次重试后延迟时间翻倍
+    }
+
+    if (ota_.HasActivationCode() || ota_.HasActivationChallenge()) {
+        // 服务器要求重新激活，缓存已经清除，空闲时重启进入正常的激活流程
+        ESP_LOGW(TAG, "Activation required, reboot when idle");
+        while (device_state_ != kDeviceStateIdle) {
+            vTaskDelay(pdMS_TO_TICKS(1000));
+        }
+        Schedule([this]() {
+            Reboot();
+        });
+        return;
+    }
+
+    if (ota_.HasNewVersion()) {
+        bool forced = ota_.IsUpgradeForced();
+        ESP_LOGI(TAG, "New version %s available%s", ota_.GetFirmwareVersion().c_str(), forced ? " (forced)" : "");
+        // 普通升级等到空闲时进行，强制升级立即打断对话
+        while (!forced && device_state_ != kDeviceStateIdle) {
+            vTaskDelay(pdMS_TO_TICKS(1000));
+        }
+        Schedule([this, forced]() {
+            if (!forced && device_state_ != kDeviceStateIdle) {
+                // 对话又开始了，下次启动时不使用缓存，在启动阶段升级
+                ota_.ClearCachedConfig();
+                return;
+            }
+            if (protocol_ && protocol_->IsAudioChannelOpened()) {
+                protocol_->CloseAudioChannel(); // 关闭音频通道
+            }
+            audio_processor_->Stop(); // 停止音频处理器
+            UpgradeFirmware(); // 升级固件，成功后重启
+        });
+        return;
+    }
+
+    // No new version, mark the current version as valid
+    ota_.MarkCurrentVersionValid(); // 标记当前版本为有效
+}
+
 // 显示激活码函数
 void Application::ShowActivationCode() {
     auto& message = ota_.GetActivationMessage(); // 获取激活提示信息，引用自 ota_ 成员
@@ -313,6 +403,7 @@ void Application::PlaySound(const std::string_view& sound) {
         // 将音频包加入解码队列
         std::lock_guard<std::mutex> lock(mutex_); // 加锁
         audio_decode_queue_.emplace_back(std::move(packet)); // 入队
+        audio_enqueued_packets_++;
     }
 }
 
@@ -401,15 +492,9 @@ void Application::StopListening() {
     });
 }
 
-// 应用程序启动函数
-void Application::Start() {
+// 初始化音频编解码器并启动音频循环任务
+void Application::InitializeAudioCodec() {
     auto& board = Board::GetInstance(); // 获取 Board 单例
-    SetDeviceState(kDeviceStateStarting); // 设置设备状态为启动中
-
-    /* 初始化显示 */
-    auto display = board.GetDisplay(); // 获取显示屏对象
-
-    /* 初始化音频编解码器 */
     auto codec = board.GetAudioCodec(); // 获取音频编解码器对象
 #ifdef CONFIG_USE_AUDIO_CODEC_DECODE_OPUS
 #else
@@ -453,12 +538,13 @@ void Application::Start() {
         vTaskDelete(NULL);
     }, "audio_loop", CONFIG_AUDIO_LOOP_TASK_STACK_SIZE, this, 8, &audio_loop_task_handle_); // 创建任务
 #endif
+}
 
-    /* 启动网络 */
-    board.StartNetwork(); // 启动网络，引用自 Board
-
-    // 检查新版本
-    CheckNewVersion(); // 检查 OTA 升级
+// 根据 OTA 配置创建协议，设置回调并启动
+bool Application::StartProtocol() {
+    auto& board = Board::GetInstance(); // 获取 Board 单例
+    auto display = board.GetDisplay(); // 获取显示屏对象
+    auto codec = board.GetAudioCodec(); // 获取音频编解码器对象
 
     // 初始化协议
     display->SetStatus(Lang::Strings::LOADING_PROTOCOL); // 显示"加载协议"
@@ -498,6 +584,7 @@ void Application::Start() {
         std::lock_guard<std::mutex> lock(mutex_); // 加锁
         if (audio_decode_queue_.size() < max_packets_in_queue) {
             audio_decode_queue_.emplace_back(std::move(packet)); // 入队
+            audio_enqueued_packets_++;
         }
     });
 
@@ -510,7 +597,13 @@ void Application::Start() {
         }
         SetDecodeSampleRate(protocol_->server_sample_rate(), protocol_->server_frame_duration()); // 设置解码采样率
         auto& thing_manager = iot::ThingManager::GetInstance(); // 获取物联网管理器
+#if CONFIG_IOT_DESCRIPTORS_BATCHED
+        // 描述一次性发送，服务端确认过相同哈希时只发送哈希
+        protocol_->SendIotDescriptors(thing_manager.GetDescriptorsJson(), thing_manager.GetDescriptorsHash(),
+            thing_manager.IsDescriptorsAcknowledged());
+#else
         protocol_->SendIotDescriptors(thing_manager.GetDescriptorsJson()); // 发送 IoT 描述符
+#endif
         std::string states;
         if (thing_manager.GetStatesJson(states, false)) {
             protocol_->SendIotStates(states); // 发送 IoT 状态
@@ -527,23 +620,23 @@ void Application::Start() {
         });
     });
 
-    // 处理接收到的JSON消息
-    protocol_->OnIncomingJson([this, display](const cJSON* root) {
-        // 解析JSON数据
-        auto type = cJSON_GetObjectItem(root, "type"); // 获取 type 字段
-        if (strcmp(type->valuestring, "tts") == 0) { // TTS 消息
-            // 处理TTS（文本转语音）消息
-            auto state = cJSON_GetObjectItem(root, "state"); // 获取 state 字段
-            if (strcmp(state->valuestring, "start") == 0) {
+    // 处理高频的 tts/stt/llm 消息（免 DOM 快速路径，字段只在回调期间有效）
+    protocol_->OnIncomingMessage([this, display](const IncomingMessage& message) {
+        switch (message.kind) {
+            case kIncomingMessageTtsStart:
                 Schedule([this]() {
                     aborted_ = false; // 标记未中止
                     if (device_state_ == kDeviceStateIdle || device_state_ == kDeviceStateListening) {
                         SetDeviceState(kDeviceStateSpeaking); // 切换为说话状态
                     }
                 });
-            } else if (strcmp(state->valuestring, "stop") == 0) {
+                break;
+            case kIncomingMessageTtsStop:
                 Schedule([this]() {
                     background_task_->WaitForCompletion(); // 等待后台任务完成
+#if CONFIG_CHAT_MESSAGE_TYPING_INTERVAL_MS > 0
+                    ShowPlayingSentences(true); // 语音结束，剩下的句子直接显示
+#endif
                     if (device_state_ == kDeviceStateSpeaking) {
                         if (listening_mode_ == kListeningModeManualStop) {
                             SetDeviceState(kDeviceStateIdle); // 手动停止，切换为空闲
@@ -552,34 +645,65 @@ void Application::Start() {
                         }
                     }
                 });
-            } else if (strcmp(state->valuestring, "sentence_start") == 0) {
-                auto text = cJSON_GetObjectItem(root, "text"); // 获取文本内容
-                if (text != NULL) {
-                    ESP_LOGI(TAG, "<< %s", text->valuestring); // 输出日志
-                    Schedule([this, display, message = std::string(text->valuestring)]() {
-                        display->SetChatMessage("assistant", message.c_str()); // 显示助手消息
+                break;
+            case kIncomingMessageTtsSentenceStart:
+                if (!message.text.empty()) {
+                    ESP_LOGI(TAG, "<< %.*s", (int)message.text.size(), message.text.data()); // 输出日志
+#if CONFIG_CHAT_MESSAGE_TYPING_INTERVAL_MS > 0
+                    {
+                        // 句子的音频在这条消息之后到达，等第一个包开始播放时再显示
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        pending_sentences_.push_back({audio_enqueued_packets_, std::string(message.text)});
+                    }
+#else
+                    Schedule([this, display, text = std::string(message.text)]() {
+                        display->SetChatMessage("assistant", text.c_str()); // 显示助手消息
                     });
+#endif
                 }
-            }
-        } else if (strcmp(type->valuestring, "stt") == 0) { // STT 消息
-            // 处理STT（语音转文本）消息
-            auto text = cJSON_GetObjectItem(root, "text"); // 获取文本内容
-            if (text != NULL) {
-                ESP_LOGI(TAG, ">> %s", text->valuestring); // 输出日志
-                Schedule([this, display, message = std::string(text->valuestring)]() {
-                    display->SetChatMessage("user", message.c_str()); // 显示用户消息
-                });
-            }
-        } else if (strcmp(type->valuestring, "llm") == 0) { // LLM 消息
-            // 处理LLM（语言模型）消息
-            auto emotion = cJSON_GetObjectItem(root, "emotion"); // 获取情感字段
-            if (emotion != NULL) {
-                Schedule([this, display, emotion_str = std::string(emotion->valuestring)]() {
-                    display->SetEmotion(emotion_str.c_str()); // 设置表情
+                break;
+            case kIncomingMessageStt:
+                if (!message.text.empty()) {
+                    ESP_LOGI(TAG, ">> %.*s", (int)message.text.size(), message.text.data()); // 输出日志
+                    Schedule([this, display, text = std::string(message.text)]() {
+                        display->SetChatMessage("user", text.c_str()); // 显示用户消息
+                    });
+                }
+                break;
+            case kIncomingMessageLlm:
+                if (!message.emotion.empty()) {
+                    Schedule([this, display, emotion = std::string(message.emotion)]() {
+                        display->SetEmotion(emotion.c_str()); // 设置表情
+                    });
+                }
+                break;
+            default:
+                break;
+        }
+    });
+
+    // 处理其他 JSON 消息
+    protocol_->OnIncomingJson([this, display](const cJSON* root) {
+        // 解析JSON数据
+        auto type = cJSON_GetObjectItem(root, "type"); // 获取 type 字段
+        if (!cJSON_IsString(type)) {
+            return;
+        }
+        if (strcmp(type->valuestring, "iot") == 0) { // IoT 消息
+            // 处理IoT（物联网）消息
+#if CONFIG_IOT_DESCRIPTORS_BATCHED
+            // 服务端确认描述哈希，不一致（例如服务端缓存丢失）时重新发送完整描述
+            // ThingManager 的描述缓存和确认状态只在主任务中访问，确认也放到主任务中处理
+            auto descriptors_hash = cJSON_GetObjectItem(root, "descriptors_hash");
+            if (cJSON_IsString(descriptors_hash)) {
+                Schedule([this, hash = std::string(descriptors_hash->valuestring)]() {
+                    auto& thing_manager = iot::ThingManager::GetInstance();
+                    if (!thing_manager.AcknowledgeDescriptors(hash)) {
+                        protocol_->SendIotDescriptors(thing_manager.GetDescriptorsJson(), thing_manager.GetDescriptorsHash(), false);
+                    }
                 });
             }
-        } else if (strcmp(type->valuestring, "iot") == 0) { // IoT 消息
-            // 处理IoT（物联网）消息
+#endif
             auto commands = cJSON_GetObjectItem(root, "commands"); // 获取命令数组
             if (commands != NULL) {
                 auto& thing_manager = iot::ThingManager::GetInstance(); // 获取物联网管理器
@@ -615,7 +739,12 @@ void Application::Start() {
     });
 
     // 启动协议
-    bool protocol_started = protocol_->Start(); // 启动协议
+    return protocol_->Start(); // 启动协议
+}
+
+// 初始化音频处理器和唤醒词检测，加载模型较慢，在启动时与网络并行
+void Application::InitializeAudioProcessing() {
+    auto codec = Board::GetInstance().GetAudioCodec(); // 获取音频编解码器对象
 
     // 初始化音频处理器
     audio_processor_->Initialize(codec); // 初始化音频处理器
@@ -658,6 +787,11 @@ void Application::Start() {
     wake_word_detect_.Initialize(codec); // 初始化唤醒词检测器
     wake_word_detect_.OnWakeWordDetected([this](const std::string& wake_word) {
         Schedule([this, &wake_word]() {
+            static bool first_wake_word = true;
+            if (first_wake_word) {
+                first_wake_word = false;
+                ESP_LOGI(TAG, "First wake word at %lld ms", esp_timer_get_time() / 1000);
+            }
             if (device_state_ == kDeviceStateIdle) {
                 SetDeviceState(kDeviceStateConnecting); // 切换为连接中
                 wake_word_detect_.EncodeWakeWordData(); // 编码唤醒词数据
@@ -682,12 +816,61 @@ void Application::Start() {
             }
         });
     });
+#endif
+}
+
+// 应用程序启动函数
+void Application::Start() {
+    auto& board = Board::GetInstance(); // 获取 Board 单例
+    SetDeviceState(kDeviceStateStarting); // 设置设备状态为启动中
+    auto display = board.GetDisplay(); // 获取显示屏对象
+
+    // 按依赖关系启动：语音模型加载较慢，与连接网络、检查版本、启动协议并行进行
+    BootSequence boot;
+    int audio = boot.AddStage("audio", {}, [this]() {
+        InitializeAudioCodec(); // 初始化音频编解码器
+    });
+    int models = boot.AddStage("models", {audio}, [this]() {
+        InitializeAudioProcessing(); // 加载音频处理和唤醒词模型
+    }, BOOT_MODELS_TASK_STACK_SIZE);
+    int network = boot.AddStage("network", {}, [&board]() {
+        board.StartNetwork(); // 启动网络，引用自 Board
+    });
+    bool cached_config = false;
+    // 升级会擦写 Flash 并占用大量内存，要等模型加载完成
+    int ota = boot.AddStage("ota", {network, audio, models}, [this, &cached_config]() {
+        // 有上次成功检查时缓存的配置就直接启动，版本检查放到后台，服务器慢或者不可用时不阻塞启动
+        cached_config = ota_.LoadCachedConfig();
+        if (cached_config) {
+            xEventGroupSetBits(event_group_, CHECK_NEW_VERSION_DONE_EVENT);
+        } else {
+            CheckNewVersion(); // 检查 OTA 升级，提示音需要先初始化解码器
+        }
+    });
+    bool protocol_started = false;
+    boot.AddStage("protocol", {ota}, [this, &protocol_started]() {
+        protocol_started = StartProtocol(); // 根据 OTA 配置创建并启动协议
+    });
+    boot.Run(); // 等待所有阶段完成并打印启动时间线
+
+#if CONFIG_USE_WAKE_WORD_DETECT
     wake_word_detect_.StartDetection(); // 启动唤醒词检测
+    ESP_LOGI(TAG, "Wake word detection ready at %lld ms", esp_timer_get_time() / 1000);
 #endif
 
     // 等待版本检查完成
     xEventGroupWaitBits(event_group_, CHECK_NEW_VERSION_DONE_EVENT, pdTRUE, pdFALSE, portMAX_DELAY); // 等待事件位
     SetDeviceState(kDeviceStateIdle); // 切换为空闲
+    ESP_LOGI(TAG, "Boot to idle: %lld ms (%s config)", esp_timer_get_time() / 1000, cached_config ? "cached" : "server");
+
+    if (cached_config) {
+        xTaskCreate([](void* arg) {
+            Application* app = (Application*)arg;
+            app->CheckNewVersionInBackground(); // 后台检查新版本
+            app->check_new_version_task_handle_ = nullptr;
+            vTaskDelete(NULL);
+        }, "check_version", 4096 * 2, this, 2, &check_new_version_task_handle_);
+    }
 
     if (protocol_started) {
         // 显示版本信息
@@ -778,11 +961,46 @@ void Application::AudioLoop() {
     }
 }
 
+#if CONFIG_CHAT_MESSAGE_TYPING_INTERVAL_MS > 0
+// 显示第一个音频包已经出队的句子，all 为 true 时显示所有等待的句子
+// 显示在主循环中进行：句子在锁内取出，同时加入主循环的任务队列，显示顺序与取出顺序一致
+void Application::ShowPlayingSentences(bool all) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::list<PendingSentence> sentences;
+        uint32_t played_packets = audio_enqueued_packets_ - audio_decode_queue_.size();
+        while (!pending_sentences_.empty()) {
+            auto& sentence = pending_sentences_.front();
+            // 队列已经播放完时，还没收到音频的句子也直接显示
+            int32_t distance = played_packets - sentence.first_packet;
+            if (!all && distance <= 0 && !(distance == 0 && audio_decode_queue_.empty())) {
+                break;
+            }
+            sentences.splice(sentences.end(), pending_sentences_, pending_sentences_.begin());
+        }
+        if (sentences.empty()) {
+            return;
+        }
+        main_tasks_.push_back([sentences = std::move(sentences)]() {
+            auto display = Board::GetInstance().GetDisplay();
+            for (auto& sentence : sentences) {
+                // 下一句开始时上一句会立即显示完整
+                display->TypeChatMessage("assistant", sentence.text.c_str());
+            }
+        });
+    }
+    xEventGroupSetBits(event_group_, SCHEDULE_EVENT);
+}
+#endif
+
 // 处理音频输出
 void Application::OnAudioOutput() {
     if (busy_decoding_audio_) {
         return;
     }
+#if CONFIG_CHAT_MESSAGE_TYPING_INTERVAL_MS > 0
+    ShowPlayingSentences(false);
+#endif
 
     auto now = std::chrono::steady_clock::now();
     auto codec = Board::GetInstance().GetAudioCodec();
@@ -1000,10 +1218,11 @@ void Application::SetDeviceState(DeviceState state) {
             // 空闲状态
             display->SetStatus(Lang::Strings::STANDBY); // 设置待机状态
             display->SetEmotion("neutral"); // 设置中性表情
-            audio_processor_->Stop(); // 停止音频处理器
+            // 先打开唤醒词再停止音频处理器，共用的音频前端不会因为没有输出而清空缓冲
 #if CONFIG_USE_WAKE_WORD_DETECT
             wake_word_detect_.StartDetection(); // 启动唤醒词检测
 #endif
+            audio_processor_->Stop(); // 停止音频处理器
             break;
         case kDeviceStateConnecting:
             // 连接状态
@@ -1031,10 +1250,10 @@ void Application::SetDeviceState(DeviceState state) {
 #else
                 opus_encoder_->ResetState(); // 重置Opus编码器状态
 #endif
+                audio_processor_->Start(); // 启动音频处理器
 #if CONFIG_USE_WAKE_WORD_DETECT
                 wake_word_detect_.StopDetection(); // 停止唤醒词检测
 #endif
-                audio_processor_->Start(); // 启动音频处理器
             }
             break;
         case kDeviceStateSpeaking:
@@ -1042,10 +1261,10 @@ void Application::SetDeviceState(DeviceState state) {
             display->SetStatus(Lang::Strings::SPEAKING); // 设置说话状态
 
             if (listening_mode_ != kListeningModeRealtime) {
-                audio_processor_->Stop();
 #if CONFIG_USE_WAKE_WORD_DETECT
                 wake_word_detect_.StartDetection();
 #endif
+                audio_processor_->Stop();
             }
             ResetDecoder();
             break;
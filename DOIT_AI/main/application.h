@@ -105,6 +105,9 @@ private:
     std::unique_ptr<Protocol> protocol_;  // 协议处理器
     EventGroupHandle_t event_group_ = nullptr;  // 事件组句柄
     esp_timer_handle_t clock_timer_handle_ = nullptr;  // 时钟定时器句柄
+#if CONFIG_IOT_STATE_PUSH_INTERVAL > 0
+    esp_timer_handle_t iot_state_timer_handle_ = nullptr;  // IoT 状态合并上报定时器句柄
+#endif
     volatile DeviceState device_state_ = kDeviceStateUnknown;  // 设备状态
     ListeningMode listening_mode_ = kListeningModeAutoStop;  // 监听模式
 #if CONFIG_USE_DEVICE_AEC || CONFIG_USE_SERVER_AEC
@@ -124,6 +127,15 @@ private:
     std::chrono::steady_clock::time_point last_output_time_;  // 上次输出时间
     std::atomic<uint32_t> last_output_timestamp_ = 0;  // 上次输出时间戳
     std::list<AudioStreamPacket> audio_decode_queue_;  // 音频解码队列
+    uint32_t audio_enqueued_packets_ = 0;  // 进入解码队列的音频包总数，减去队列长度就是已经播放的包数
+#if CONFIG_CHAT_MESSAGE_TYPING_INTERVAL_MS > 0
+    // 等待语音开始播放的句子，first_packet 是句子第一个音频包的序号
+    struct PendingSentence {
+        uint32_t first_packet;
+        std::string text;
+    };
+    std::list<PendingSentence> pending_sentences_;
+#endif
     std::condition_variable audio_decode_cv_;  // 音频解码条件变量
 
     // Opus 编解码器相关成员
@@ -150,10 +162,18 @@ private:
     void ResetDecoder();  // 重置解码器
     void SetDecodeSampleRate(int sample_rate, int frame_duration);  // 设置解码采样率
     void CheckNewVersion();  // 检查新版本
+    void CheckNewVersionInBackground();  // 使用缓存配置启动后在后台检查新版本
+    void UpgradeFirmware();  // 升级固件
+    void InitializeAudioCodec();  // 初始化音频编解码器
+    void InitializeAudioProcessing();  // 初始化音频处理器和唤醒词检测
+    bool StartProtocol();  // 创建并启动协议
     void ShowActivationCode();  // 显示激活码
     void OnClockTimer();  // 时钟定时器回调
     void SetListeningMode(ListeningMode mode);  // 设置监听模式
     void AudioLoop();  // 音频循环处理
+#if CONFIG_CHAT_MESSAGE_TYPING_INTERVAL_MS > 0
+    void ShowPlayingSentences(bool all);  // 在主循环中显示已经开始播放的句子
+#endif
 };
 
 #endif // _APPLICATION_H_
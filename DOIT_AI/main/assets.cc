@@ -0,0 +1,122 @@
+#include "assets.h"
+
+#include <esp_log.h>
+#include <esp_rom_crc.h>
+
+#include <algorithm>
+#include <cstring>
+
+#define TAG "Assets"
+
+#define ASSETS_PARTITION "assets"
+#define ASSETS_MAGIC "XZAS"
+#define ASSETS_VERSION 1
+#define ASSETS_DATA_ALIGN 16
+
+namespace {
+
+struct Header {
+    char magic[4];
+    uint16_t version;
+    uint16_t count;
+    uint32_t total_size;
+    uint32_t index_crc;
+};
+
+static_assert(sizeof(Header) == 16, "Assets header layout mismatch");
+
+} // namespace
+
+Assets::Assets() {
+    if (!Map()) {
+        ESP_LOGW(TAG, "No assets, flash them with idf.py assets-flash");
+    }
+}
+
+Assets::~Assets() {
+    if (data_ != nullptr) {
+        esp_partition_munmap(mmap_handle_);
+    }
+}
+
+bool Assets::Map() {
+    static_assert(sizeof(Entry) == 48, "Assets entry layout mismatch");
+    auto partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, ASSETS_PARTITION);
+    if (partition == nullptr) {
+        ESP_LOGE(TAG, "Partition %s not found", ASSETS_PARTITION);
+        return false;
+    }
+
+    // 先只读头部，确认资源包的长度后只映射用到的部分
+    Header header;
+    esp_err_t err = esp_partition_read(partition, 0, &header, sizeof(header));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read partition %s: %s", ASSETS_PARTITION, esp_err_to_name(err));
+        return false;
+    }
+    if (memcmp(header.magic, ASSETS_MAGIC, sizeof(header.magic)) != 0 || header.version != ASSETS_VERSION ||
+        header.total_size > partition->size || sizeof(Header) + header.count * sizeof(Entry) > header.total_size) {
+        ESP_LOGE(TAG, "Invalid assets header in partition %s", ASSETS_PARTITION);
+        return false;
+    }
+
+    const void* data = nullptr;
+    err = esp_partition_mmap(partition, 0, header.total_size, ESP_PARTITION_MMAP_DATA, &data, &mmap_handle_);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to map partition %s: %s", ASSETS_PARTITION, esp_err_to_name(err));
+        return false;
+    }
+
+    auto index = (const Entry*)((const uint8_t*)data + sizeof(Header));
+    if (esp_rom_crc32_le(0, (const uint8_t*)index, header.count * sizeof(Entry)) != header.index_crc) {
+        ESP_LOGE(TAG, "Assets index checksum mismatch");
+        esp_partition_munmap(mmap_handle_);
+        return false;
+    }
+    for (int i = 0; i < header.count; i++) {
+        auto& entry = index[i];
+        if (entry.name[sizeof(entry.name) - 1] != '\0' || entry.offset % ASSETS_DATA_ALIGN != 0 ||
+            entry.offset > header.total_size || entry.size > header.total_size - entry.offset ||
+            (i > 0 && strcmp(index[i - 1].name, entry.name) >= 0)) {
+            ESP_LOGE(TAG, "Invalid assets index entry %d", i);
+            esp_partition_munmap(mmap_handle_);
+            return false;
+        }
+    }
+
+    data_ = (const uint8_t*)data;
+    index_ = index;
+    count_ = header.count;
+    check_states_ = std::make_unique<std::atomic<uint8_t>[]>(count_);
+    ESP_LOGI(TAG, "Mapped %u assets, %lu bytes", count_, header.total_size);
+    return true;
+}
+
+std::string_view Assets::Get(std::string_view name) {
+    if (index_ == nullptr) {
+        return {};
+    }
+
+    auto end = index_ + count_;
+    auto it = std::lower_bound(index_, end, name, [](const Entry& entry, std::string_view name) {
+        return std::string_view(entry.name) < name;
+    });
+    if (it == end || std::string_view(it->name) != name) {
+        ESP_LOGW(TAG, "Asset %.*s not found", (int)name.size(), name.data());
+        return {};
+    }
+
+    auto data = (const char*)data_ + it->offset;
+    auto& state = check_states_[it - index_];
+    if (state == kCheckPending) {
+        bool passed = esp_rom_crc32_le(0, (const uint8_t*)data, it->size) == it->crc;
+        state = passed ? kCheckPassed : kCheckFailed;
+        if (!passed) {
+            ESP_LOGE(TAG, "Asset %s checksum mismatch", it->name);
+        }
+    }
+    if (state != kCheckPassed) {
+        return {};
+    }
+    return std::string_view(data, it->size);
+}
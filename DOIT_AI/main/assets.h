@@ -0,0 +1,61 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <esp_partition.h>
+
+#include <atomic>
+#include <memory>
+#include <string_view>
+
+/*
+ * assets 分区中的资源包，由 scripts/pack_assets.py 生成，可以和固件分开烧录、更新
+ * 资源包格式（小端）：
+ *   头部   16 字节：magic "XZAS"，uint16 版本，uint16 文件数量，uint32 资源包总长度，uint32 索引的 CRC32
+ *   索引   每个文件 48 字节：char 名称[36]（以 0 结尾），uint32 偏移，uint32 长度，uint32 数据的 CRC32，
+ *          按名称排序
+ *   数据   每个文件按 16 字节对齐
+ * 第一次调用 GetInstance 时打开分区，音效放在资源包中时由 Lang::Sounds 的 inline 变量在全局构造阶段调用。
+ * 构造时先读取并校验头部，只映射头部中的资源包总长度，再校验索引。Get 返回的数据直接指向 flash，不占内存。
+ * 每个文件第一次被取出时校验一次 CRC32，校验失败的文件视为不存在
+ */
+class Assets {
+public:
+    static Assets& GetInstance() {
+        static Assets instance;
+        return instance;
+    }
+    Assets(const Assets&) = delete;
+    Assets& operator=(const Assets&) = delete;
+
+    // 文件不存在或校验失败时返回空
+    std::string_view Get(std::string_view name);
+    bool available() const { return index_ != nullptr; }
+
+private:
+    struct Entry {
+        char name[36];
+        uint32_t offset;
+        uint32_t size;
+        uint32_t crc;
+    };
+
+    enum CheckState : uint8_t {
+        kCheckPending,
+        kCheckPassed,
+        kCheckFailed,
+    };
+
+    Assets();
+    ~Assets();
+
+    const uint8_t* data_ = nullptr;
+    const Entry* index_ = nullptr;
+    uint16_t count_ = 0;
+    esp_partition_mmap_handle_t mmap_handle_ = 0;
+    // 多个任务同时校验同一个文件时结果相同，不需要加锁
+    std::unique_ptr<std::atomic<uint8_t>[]> check_states_;
+
+    bool Map();
+};
+
+#endif // ASSETS_H
@@ -1,17 +1,13 @@
 #ifndef AFE_AUDIO_PROCESSOR_H
 #define AFE_AUDIO_PROCESSOR_H
 
-#include <esp_afe_sr_models.h>
-#include <freertos/FreeRTOS.h>
-#include <freertos/task.h>
-#include <freertos/event_groups.h>
-
 #include <string>
 #include <vector>
 #include <functional>
 
 #include "audio_processor.h"
 #include "audio_codec.h"
+#include "audio_front_end.h"
 
 class AfeAudioProcessor : public AudioProcessor {
 public:
@@ -28,15 +24,12 @@ public:
     size_t GetFeedSize() override;
 
 private:
-    EventGroupHandle_t event_group_ = nullptr;
-    esp_afe_sr_iface_t* afe_iface_ = nullptr;
-    esp_afe_sr_data_t* afe_data_ = nullptr;
     std::function<void(std::vector<int16_t>&& data)> output_callback_;
     std::function<void(bool speaking)> vad_state_change_callback_;
     AudioCodec* codec_ = nullptr;
     bool is_speaking_ = false;
 
-    void AudioProcessorTask();
+    void OnFetchResult(const afe_fetch_result_t* result);
 };
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include "audio_front_end.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <model_path.h>
+
+#include <string>
+
+static const char* TAG = "AudioFrontEnd";
+
+AudioFrontEnd::AudioFrontEnd() {
+    event_group_ = xEventGroupCreate();
+}
+
+AudioFrontEnd::~AudioFrontEnd() {
+    for (int i = 0; i < instance_count_; i++) {
+        instances_[i].iface->destroy(instances_[i].data);
+    }
+    vEventGroupDelete(event_group_);
+}
+
+void AudioFrontEnd::Initialize(AudioCodec* codec) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (instance_count_ > 0) {
+        return;
+    }
+    codec_ = codec;
+
+    models_ = esp_srmodel_init("model");
+    for (int i = 0; i < models_->num; i++) {
+        ESP_LOGI(TAG, "Model %d: %s", i, models_->model_name[i]);
+    }
+#if CONFIG_USE_WAKE_WORD_DETECT
+    wakenet_model_ = esp_srmodel_filter(models_, ESP_WN_PREFIX, NULL);
+#endif
+
+    int ref_num = codec_->input_reference() ? 1 : 0;
+    int mic_num = codec_->input_channels() - ref_num;
+    std::string input_format;
+    for (int i = 0; i < mic_num; i++) {
+        input_format.push_back('M');
+    }
+    for (int i = 0; i < ref_num; i++) {
+        input_format.push_back('R');
+    }
+
+    auto sr_config = [this, &input_format]() {
+        afe_config_t* afe_config = afe_config_init(input_format.c_str(), models_, AFE_TYPE_SR, AFE_MODE_HIGH_PERF);
+        afe_config->aec_init = codec_->input_reference();
+        afe_config->aec_mode = AEC_MODE_SR_HIGH_PERF;
+        afe_config->wakenet_init = wakenet_model_ != nullptr;
+        afe_config->wakenet_model_name = wakenet_model_;
+        return afe_config;
+    };
+
+#if CONFIG_USE_AUDIO_PROCESSOR
+    // 单麦克风时 SR 类型没有多通道处理，唤醒词可以共用通话的 VC 实例；没有唤醒词模型时也只需要一个实例
+    bool shared = mic_num <= 1 || wakenet_model_ == nullptr;
+    afe_config_t* afe_config = afe_config_init(input_format.c_str(), models_, AFE_TYPE_VC, AFE_MODE_HIGH_PERF);
+    afe_config->ns_init = true;
+    afe_config->ns_model_name = esp_srmodel_filter(models_, ESP_NSNET_PREFIX, NULL);
+    afe_config->afe_ns_mode = AFE_NS_MODE_NET;
+#ifdef CONFIG_USE_DEVICE_AEC
+    afe_config->aec_init = true;
+    afe_config->aec_mode = AEC_MODE_VOIP_HIGH_PERF;
+    afe_config->vad_init = false;
+#else
+    // 没有设备端 AEC 时只给共用实例中的唤醒词使用，通话时关闭
+    afe_config->aec_init = shared && codec_->input_reference() && wakenet_model_ != nullptr;
+    afe_config->aec_mode = AEC_MODE_SR_HIGH_PERF;
+    afe_config->vad_init = true;
+    afe_config->vad_mode = VAD_MODE_0;
+    afe_config->vad_min_noise_ms = 100;
+#endif
+    afe_config->agc_init = false;
+    afe_config->wakenet_init = shared && wakenet_model_ != nullptr;
+    afe_config->wakenet_model_name = wakenet_model_;
+    CreateInstance(afe_config, shared ? (kOutputWakeWord | kOutputVoice) : kOutputVoice);
+    if (!shared) {
+        CreateInstance(sr_config(), kOutputWakeWord);
+    }
+#else
+    CreateInstance(sr_config(), kOutputWakeWord | kOutputVoice);
+#endif
+    ApplyOutputs(xEventGroupGetBits(event_group_));
+}
+
+bool AudioFrontEnd::CreateInstance(afe_config_t* afe_config, EventBits_t outputs) {
+    afe_config->afe_perferred_core = 1;
+    afe_config->afe_perferred_priority = 1;
+    afe_config->memory_alloc_mode = AFE_MEMORY_ALLOC_MORE_PSRAM;
+
+    size_t free_sram = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    size_t free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    auto& instance = instances_[instance_count_];
+    instance.iface = esp_afe_handle_from_config(afe_config);
+    instance.data = instance.iface->create_from_config(afe_config);
+    if (instance.data == nullptr) {
+        ESP_LOGE(TAG, "Failed to create AFE instance");
+        return false;
+    }
+    instance.outputs = outputs;
+    instance_count_++;
+    ESP_LOGI(TAG, "AFE instance for%s%s uses %zu bytes SRAM, %zu bytes PSRAM",
+        (outputs & kOutputWakeWord) ? " wake word" : "", (outputs & kOutputVoice) ? " voice" : "",
+        free_sram - heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+        free_psram - heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+
+    struct TaskArgs {
+        AudioFrontEnd* front_end;
+        Instance* instance;
+    };
+    xTaskCreate([](void* arg) {
+        auto args = (TaskArgs*)arg;
+        auto front_end = args->front_end;
+        auto instance = args->instance;
+        delete args;
+        front_end->FetchTask(instance);
+        vTaskDelete(NULL);
+    }, "audio_front_end", 4096, new TaskArgs{this, &instance}, 3, nullptr);
+    return true;
+}
+
+AudioFrontEnd::Instance* AudioFrontEnd::FindInstance(Output output) {
+    for (int i = 0; i < instance_count_; i++) {
+        if (instances_[i].outputs & output) {
+            return &instances_[i];
+        }
+    }
+    return nullptr;
+}
+
+void AudioFrontEnd::Feed(Output output, const std::vector<int16_t>& data) {
+    auto instance = FindInstance(output);
+    if (instance == nullptr) {
+        return;
+    }
+    instance->iface->feed(instance->data, data.data());
+}
+
+size_t AudioFrontEnd::GetFeedSize(Output output) {
+    auto instance = FindInstance(output);
+    if (instance == nullptr) {
+        return 0;
+    }
+    return instance->iface->get_feed_chunksize(instance->data) * codec_->input_channels();
+}
+
+void AudioFrontEnd::SetOutputCallback(Output output, OutputCallback callback) {
+    if (output == kOutputWakeWord) {
+        wake_word_callback_ = callback;
+    } else {
+        voice_callback_ = callback;
+    }
+}
+
+void AudioFrontEnd::EnableOutput(Output output, bool enable) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    EventBits_t bits = xEventGroupGetBits(event_group_);
+    EventBits_t new_bits = enable ? (bits | output) : (bits & ~output);
+    if (new_bits == bits) {
+        return;
+    }
+    if (enable) {
+        if (output == kOutputVoice) {
+            voice_enabled_time_ = esp_timer_get_time();
+        }
+        xEventGroupSetBits(event_group_, output);
+    } else {
+        xEventGroupClearBits(event_group_, output);
+    }
+
+    if (instance_count_ == 0) {
+        return;
+    }
+    ApplyOutputs(new_bits);
+    auto instance = FindInstance(output);
+    if (!enable && instance != nullptr && (new_bits & instance->outputs) == 0) {
+        instance->iface->reset_buffer(instance->data);
+    }
+}
+
+bool AudioFrontEnd::IsOutputEnabled(Output output) {
+    return xEventGroupGetBits(event_group_) & output;
+}
+
+// 共用的实例只运行当前输出需要的算法，切换时不重建实例；单独的实例一直运行全部算法
+void AudioFrontEnd::ApplyOutputs(EventBits_t bits) {
+    auto instance = FindInstance(kOutputWakeWord);
+    if (instance == nullptr || instance != FindInstance(kOutputVoice)) {
+        return;
+    }
+    auto afe_iface = instance->iface;
+    auto afe_data = instance->data;
+    bool wake_word = bits & kOutputWakeWord;
+    if (wakenet_model_ != nullptr) {
+        if (wake_word) {
+            afe_iface->enable_wakenet(afe_data);
+        } else {
+            afe_iface->disable_wakenet(afe_data);
+        }
+    }
+#if CONFIG_USE_AUDIO_PROCESSOR
+    // 唤醒词只需要线性处理，神经网络降噪只在通话时运行
+    if (bits & kOutputVoice) {
+        afe_iface->enable_ns(afe_data);
+    } else {
+        afe_iface->disable_ns(afe_data);
+    }
+#ifndef CONFIG_USE_DEVICE_AEC
+    if (codec_->input_reference() && wakenet_model_ != nullptr) {
+        if (wake_word) {
+            afe_iface->enable_aec(afe_data);
+        } else {
+            afe_iface->disable_aec(afe_data);
+        }
+    }
+#endif
+#endif
+}
+
+void AudioFrontEnd::FetchTask(Instance* instance) {
+    auto fetch_size = instance->iface->get_fetch_chunksize(instance->data);
+    auto feed_size = instance->iface->get_feed_chunksize(instance->data);
+    ESP_LOGI(TAG, "Audio front end task started, feed size: %d fetch size: %d",
+        feed_size, fetch_size);
+
+    while (true) {
+        xEventGroupWaitBits(event_group_, instance->outputs, pdFALSE, pdFALSE, portMAX_DELAY);
+
+        auto res = instance->iface->fetch_with_delay(instance->data, portMAX_DELAY);
+        if (res == nullptr || res->ret_value == ESP_FAIL) {
+            if (res != nullptr) {
+                ESP_LOGI(TAG, "Error code: %d", res->ret_value);
+            }
+            continue;
+        }
+
+        EventBits_t bits = xEventGroupGetBits(event_group_) & instance->outputs;
+        if ((bits & kOutputVoice) && voice_callback_) {
+            int64_t enabled_time = voice_enabled_time_;
+            if (enabled_time != 0) {
+                voice_enabled_time_ = 0;
+                ESP_LOGI(TAG, "First voice frame %lld ms after switching", (esp_timer_get_time() - enabled_time) / 1000);
+            }
+            voice_callback_(res);
+        }
+        // 唤醒词回调可能关闭输出，放在最后
+        if ((bits & kOutputWakeWord) && wake_word_callback_) {
+            wake_word_callback_(res);
+        }
+    }
+}
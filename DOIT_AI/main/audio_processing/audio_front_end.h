@@ -0,0 +1,83 @@
+#ifndef AUDIO_FRONT_END_H
+#define AUDIO_FRONT_END_H
+
+#include <esp_afe_sr_models.h>
+#include <esp_nsn_models.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/event_groups.h>
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "audio_codec.h"
+
+/*
+ * 唤醒词检测和通话降噪共用的音频前端，模型只加载一次
+ * 单麦克风时只创建一个 VC 类型的 AFE 实例，同时打开 WakeNet，AEC/NS/VAD 前端共用。一个 fetch 任务按当前打开的
+ * 输出分发结果，唤醒词和通话之间切换只是打开、关闭输出（以及 AFE 内部的 WakeNet），不重新送数据也不清空缓冲。
+ * 多麦克风时唤醒词需要 SR 类型的多通道处理（BSS），VC 类型只输出降噪后的单通道，因此唤醒词和通话各用一个实例，
+ * 各自只在输出打开时送数据。
+ * 实例的所有输出都关闭时清空缓冲，避免下次打开时读到过期的音频。切换时应先打开新的输出再关闭旧的输出。
+ */
+class AudioFrontEnd {
+public:
+    enum Output {
+        kOutputWakeWord = 0x01,
+        kOutputVoice = 0x02,
+    };
+
+    typedef std::function<void(const afe_fetch_result_t* result)> OutputCallback;
+
+    static AudioFrontEnd& GetInstance() {
+        static AudioFrontEnd instance;
+        return instance;
+    }
+    AudioFrontEnd(const AudioFrontEnd&) = delete;
+    AudioFrontEnd& operator=(const AudioFrontEnd&) = delete;
+
+    // 可以重复调用，只有第一次会加载模型和创建 AFE
+    void Initialize(AudioCodec* codec);
+    // 送给处理 output 的实例
+    void Feed(Output output, const std::vector<int16_t>& data);
+    size_t GetFeedSize(Output output);
+    // 回调在 fetch 任务中调用，需要在打开对应输出之前设置
+    void SetOutputCallback(Output output, OutputCallback callback);
+    void EnableOutput(Output output, bool enable);
+    bool IsOutputEnabled(Output output);
+
+    srmodel_list_t* models() const { return models_; }
+    const char* wakenet_model() const { return wakenet_model_; }
+
+private:
+    struct Instance {
+        esp_afe_sr_iface_t* iface = nullptr;
+        esp_afe_sr_data_t* data = nullptr;
+        // 这个实例处理的输出
+        EventBits_t outputs = 0;
+    };
+
+    AudioFrontEnd();
+    ~AudioFrontEnd();
+
+    std::mutex mutex_;
+    EventGroupHandle_t event_group_ = nullptr;
+    AudioCodec* codec_ = nullptr;
+    srmodel_list_t* models_ = nullptr;
+    char* wakenet_model_ = nullptr;
+    Instance instances_[2];
+    int instance_count_ = 0;
+    OutputCallback wake_word_callback_;
+    OutputCallback voice_callback_;
+    // 打开通话输出的时间，用于统计切换后第一帧的延迟
+    std::atomic<int64_t> voice_enabled_time_ = 0;
+
+    Instance* FindInstance(Output output);
+    bool CreateInstance(afe_config_t* afe_config, EventBits_t outputs);
+    void ApplyOutputs(EventBits_t bits);
+    void FetchTask(Instance* instance);
+};
+
+#endif // AUDIO_FRONT_END_H
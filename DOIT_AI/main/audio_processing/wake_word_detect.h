@@ -3,10 +3,6 @@
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <freertos/event_groups.h>
-
-#include <esp_afe_sr_models.h>
-#include <esp_nsn_models.h>
 
 #include <list>
 #include <string>
@@ -16,6 +12,7 @@
 #include <condition_variable>
 
 #include "audio_codec.h"
+#include "audio_front_end.h"
 
 class WakeWordDetect {
 public:
@@ -34,11 +31,7 @@ public:
     const std::string& GetLastDetectedWakeWord() const { return last_detected_wake_word_; }
 
 private:
-    esp_afe_sr_iface_t* afe_iface_ = nullptr;
-    esp_afe_sr_data_t* afe_data_ = nullptr;
-    char* wakenet_model_ = NULL;
     std::vector<std::string> wake_words_;
-    EventGroupHandle_t event_group_;
     std::function<void(const std::string& wake_word)> wake_word_detected_callback_;
     AudioCodec* codec_ = nullptr;
     std::string last_detected_wake_word_;
@@ -52,7 +45,7 @@ private:
     std::condition_variable wake_word_cv_;
 
     void StoreWakeWordData(uint16_t* data, size_t size);
-    void AudioDetectionTask();
+    void OnFetchResult(const afe_fetch_result_t* result);
 };
 
 #endif
@@ -17,6 +17,8 @@ Board::Board() {
     if (uuid_.empty()) {
         uuid_ = GenerateUuid();
         settings.SetString("uuid", uuid_);
+        // 设备标识随后就会上报给服务器，立即保存
+        Settings::Flush();
     }
     ESP_LOGI(TAG, "UUID=%s SKU=%s", uuid_.c_str(), BOARD_NAME);
 }
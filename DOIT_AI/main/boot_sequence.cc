@@ -0,0 +1,117 @@
+#include "boot_sequence.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+
+#include <algorithm>
+#include <string>
+
+#define TAG "BootSequence"
+
+// 时间线每行的宽度
+#define TIMELINE_WIDTH 40
+
+BootSequence::BootSequence() {
+    event_group_ = xEventGroupCreate();
+}
+
+BootSequence::~BootSequence() {
+    vEventGroupDelete(event_group_);
+}
+
+int BootSequence::AddStage(const char* name, std::initializer_list<int> depends, std::function<void()> function,
+    uint32_t stack_size) {
+    int index = stages_.size();
+    if (index >= BOOT_SEQUENCE_MAX_STAGES) {
+        ESP_LOGE(TAG, "Too many stages, %s runs without dependencies", name);
+        function();
+        return -1;
+    }
+
+    EventBits_t bits = 0;
+    for (int depend : depends) {
+        if (depend >= 0) {
+            bits |= BIT(depend);
+        }
+    }
+    stages_.push_back({name, bits, std::move(function), stack_size});
+    return index;
+}
+
+void BootSequence::RunStage(int index) {
+    auto& stage = stages_[index];
+    if (stage.depends != 0) {
+        xEventGroupWaitBits(event_group_, stage.depends, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+    stage.start_time = esp_timer_get_time();
+    stage.function();
+    stage.end_time = esp_timer_get_time();
+    ESP_LOGI(TAG, "Stage %s done in %lld ms", stage.name, (stage.end_time - stage.start_time) / 1000);
+    xEventGroupSetBits(event_group_, BIT(index));
+}
+
+void BootSequence::Run() {
+    struct TaskArgs {
+        BootSequence* sequence;
+        int index;
+        TaskHandle_t caller;
+    };
+
+    int task_count = 0;
+    for (int i = 0; i < (int)stages_.size(); i++) {
+        if (stages_[i].stack_size == 0) {
+            continue;
+        }
+        auto args = new TaskArgs{this, i, xTaskGetCurrentTaskHandle()};
+        auto ret = xTaskCreate([](void* arg) {
+            auto args = (TaskArgs*)arg;
+            auto caller = args->caller;
+            args->sequence->RunStage(args->index);
+            delete args;
+            // xEventGroupSetBits 唤醒等待者之后还会访问事件组，返回后才通知调用者
+            xTaskNotifyGive(caller);
+            vTaskDelete(NULL);
+        }, stages_[i].name, stages_[i].stack_size, args, uxTaskPriorityGet(NULL), nullptr);
+        if (ret != pdPASS) {
+            // 内存不足时退回到调用者任务中执行
+            ESP_LOGW(TAG, "Failed to create task for stage %s", stages_[i].name);
+            delete args;
+            stages_[i].stack_size = 0;
+        } else {
+            task_count++;
+        }
+    }
+
+    for (int i = 0; i < (int)stages_.size(); i++) {
+        if (stages_[i].stack_size == 0) {
+            RunStage(i);
+        }
+    }
+    for (int i = 0; i < task_count; i++) {
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+    }
+    PrintTimeline();
+}
+
+void BootSequence::PrintTimeline() {
+    int64_t end_time = 0;
+    for (auto& stage : stages_) {
+        end_time = std::max(end_time, stage.end_time);
+    }
+    if (end_time <= 0) {
+        return;
+    }
+
+    // 时间从上电开始计算，每列代表 end_time / TIMELINE_WIDTH
+    ESP_LOGI(TAG, "Boot timeline (ms since power on):");
+    for (auto& stage : stages_) {
+        std::string bar(TIMELINE_WIDTH, ' ');
+        int begin = stage.start_time * TIMELINE_WIDTH / end_time;
+        int end = std::max<int>(stage.end_time * TIMELINE_WIDTH / end_time, begin + 1);
+        std::fill(bar.begin() + begin, bar.begin() + std::min(end, TIMELINE_WIDTH), '#');
+        ESP_LOGI(TAG, "  %-10s |%s| %6lld - %6lld (%lld)", stage.name, bar.c_str(), stage.start_time / 1000,
+            stage.end_time / 1000, (stage.end_time - stage.start_time) / 1000);
+    }
+    ESP_LOGI(TAG, "Ready at %lld ms", end_time / 1000);
+}
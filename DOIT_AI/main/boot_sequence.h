@@ -0,0 +1,48 @@
+#ifndef BOOT_SEQUENCE_H
+#define BOOT_SEQUENCE_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+// 事件组可用的位数
+#define BOOT_SEQUENCE_MAX_STAGES 24
+
+/*
+ * 启动阶段的依赖图
+ * 每个阶段在依赖的阶段全部完成后开始。stack_size 为 0 的阶段按添加顺序在调用 Run 的任务中执行，
+ * 其它阶段各自创建一个任务并发执行，结束后任务退出。Run 等待所有阶段完成后打印启动时间线。
+ * 在调用者任务中执行的阶段只能依赖先添加的阶段。
+ * 阶段任务设置完事件位后用任务通知告知 Run，Run 返回时不再有任务访问事件组，可以安全析构。
+ */
+class BootSequence {
+public:
+    BootSequence();
+    ~BootSequence();
+
+    // 返回阶段编号，用于声明其它阶段的依赖
+    int AddStage(const char* name, std::initializer_list<int> depends, std::function<void()> function,
+        uint32_t stack_size = 0);
+    void Run();
+
+private:
+    struct Stage {
+        const char* name;
+        EventBits_t depends;
+        std::function<void()> function;
+        uint32_t stack_size;
+        int64_t start_time = 0;
+        int64_t end_time = 0;
+    };
+
+    EventGroupHandle_t event_group_;
+    std::vector<Stage> stages_;
+
+    void RunStage(int index);
+    void PrintTimeline();
+};
+
+#endif // BOOT_SEQUENCE_H
@@ -0,0 +1,213 @@
+#include "delta_patch.h"
+
+#include <esp_log.h>
+
+#include <algorithm>
+#include <cstring>
+
+#define TAG "DeltaPatch"
+
+DeltaPatch::DeltaPatch(SourceReader read_source, HeaderCallback on_header, TargetWriter write_target) :
+    read_source_(read_source), on_header_(on_header), write_target_(write_target) {
+}
+
+bool DeltaPatch::Fail(const char* reason) {
+    ESP_LOGE(TAG, "Invalid patch at target offset %zu: %s", target_written_, reason);
+    state_ = kError;
+    return false;
+}
+
+static uint32_t ReadLe32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool DeltaPatch::ParseHeader() {
+    if (memcmp(header_buffer_, DELTA_PATCH_MAGIC, 8) != 0) {
+        return Fail("bad magic");
+    }
+    header_.source_size = ReadLe32(header_buffer_ + 8);
+    header_.target_size = ReadLe32(header_buffer_ + 12);
+    memcpy(header_.source_sha256, header_buffer_ + 16, 32);
+    memcpy(header_.target_sha256, header_buffer_ + 48, 32);
+    if (on_header_ && !on_header_(header_)) {
+        state_ = kError;
+        return false;
+    }
+    state_ = header_.target_size == 0 ? kDone : kDiffLength;
+    return true;
+}
+
+// 返回 true 表示 varint_ 已经读完
+bool DeltaPatch::ReadVarint(uint8_t byte) {
+    varint_ |= (uint64_t)(byte & 0x7f) << varint_shift_;
+    varint_shift_ += 7;
+    return (byte & 0x80) == 0 || varint_shift_ >= 64;
+}
+
+bool DeltaPatch::ReadSource(uint8_t& value) {
+    if (source_position_ >= header_.source_size) {
+        return Fail("source out of range");
+    }
+    if (source_position_ < cache_offset_ || source_position_ >= cache_offset_ + cache_length_) {
+        cache_offset_ = source_position_;
+        cache_length_ = std::min(sizeof(source_cache_), (size_t)header_.source_size - source_position_);
+        if (!read_source_(cache_offset_, source_cache_, cache_length_)) {
+            cache_length_ = 0;
+            return Fail("failed to read source");
+        }
+    }
+    value = source_cache_[source_position_ - cache_offset_];
+    source_position_++;
+    return true;
+}
+
+bool DeltaPatch::Emit(uint8_t value) {
+    output_[output_length_++] = value;
+    target_written_++;
+    if (output_length_ == sizeof(output_)) {
+        return Flush();
+    }
+    return true;
+}
+
+bool DeltaPatch::Flush() {
+    if (output_length_ == 0) {
+        return true;
+    }
+    if (!write_target_(output_, output_length_)) {
+        state_ = kError;
+        return false;
+    }
+    output_length_ = 0;
+    return true;
+}
+
+bool DeltaPatch::CopySource(size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        uint8_t value;
+        if (!ReadSource(value) || !Emit(value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void DeltaPatch::EndDiff() {
+    state_ = extra_remaining_ > 0 ? kExtra : kSeek;
+}
+
+bool DeltaPatch::EndRecord() {
+    int64_t seek = (int64_t)(varint_ >> 1) ^ -(int64_t)(varint_ & 1);
+    int64_t position = (int64_t)source_position_ + seek;
+    if (position < 0 || position > (int64_t)header_.source_size) {
+        return Fail("seek out of range");
+    }
+    source_position_ = position;
+    if (target_written_ == header_.target_size) {
+        if (!Flush()) {
+            return false;
+        }
+        state_ = kDone;
+    } else {
+        state_ = kDiffLength;
+    }
+    return true;
+}
+
+bool DeltaPatch::Feed(const uint8_t* data, size_t length) {
+    const uint8_t* end = data + length;
+    while (data < end) {
+        switch (state_) {
+            case kHeader: {
+                size_t n = std::min((size_t)(end - data), sizeof(header_buffer_) - header_received_);
+                memcpy(header_buffer_ + header_received_, data, n);
+                header_received_ += n;
+                data += n;
+                if (header_received_ == sizeof(header_buffer_) && !ParseHeader()) {
+                    return false;
+                }
+                break;
+            }
+            case kDiffLength:
+            case kExtraLength:
+            case kZeroRun:
+            case kLiteralLength:
+            case kSeek:
+                if (!ReadVarint(*data++)) {
+                    break;
+                }
+                if (state_ == kDiffLength) {
+                    diff_remaining_ = varint_;
+                    state_ = kExtraLength;
+                } else if (state_ == kExtraLength) {
+                    extra_remaining_ = varint_;
+                    if (diff_remaining_ + extra_remaining_ > header_.target_size - target_written_) {
+                        return Fail("record exceeds target size");
+                    }
+                    if (diff_remaining_ > 0) {
+                        state_ = kZeroRun;
+                    } else {
+                        EndDiff();
+                    }
+                } else if (state_ == kZeroRun) {
+                    if (varint_ > diff_remaining_) {
+                        return Fail("zero run exceeds diff length");
+                    }
+                    diff_remaining_ -= varint_;
+                    if (!CopySource(varint_)) {
+                        return false;
+                    }
+                    if (diff_remaining_ == 0) {
+                        EndDiff();
+                    } else {
+                        state_ = kLiteralLength;
+                    }
+                } else if (state_ == kLiteralLength) {
+                    if (varint_ == 0 || varint_ > diff_remaining_) {
+                        return Fail("bad literal length");
+                    }
+                    literal_remaining_ = varint_;
+                    state_ = kLiteral;
+                } else if (!EndRecord()) {
+                    return false;
+                }
+                varint_ = 0;
+                varint_shift_ = 0;
+                break;
+            case kLiteral: {
+                uint8_t value;
+                if (!ReadSource(value) || !Emit(value + *data++)) {
+                    return false;
+                }
+                diff_remaining_--;
+                if (--literal_remaining_ == 0) {
+                    if (diff_remaining_ == 0) {
+                        EndDiff();
+                    } else {
+                        state_ = kZeroRun;
+                    }
+                }
+                break;
+            }
+            case kExtra: {
+                size_t n = std::min((size_t)(end - data), extra_remaining_);
+                for (size_t i = 0; i < n; i++) {
+                    if (!Emit(data[i])) {
+                        return false;
+                    }
+                }
+                data += n;
+                extra_remaining_ -= n;
+                if (extra_remaining_ == 0) {
+                    state_ = kSeek;
+                }
+                break;
+            }
+            case kDone:
+                return Fail("trailing data");
+            case kError:
+                return false;
+        }
+    }
+    return true;
+}
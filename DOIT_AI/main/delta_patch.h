@@ -0,0 +1,95 @@
+#ifndef DELTA_PATCH_H
+#define DELTA_PATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#define DELTA_PATCH_MAGIC "XZDELTA1"
+#define DELTA_PATCH_HEADER_SIZE 80
+
+struct DeltaPatchHeader {
+    uint32_t source_size;
+    uint32_t target_size;
+    uint8_t source_sha256[32];
+    uint8_t target_sha256[32];
+};
+
+/*
+ * 差分补丁的流式解码器，补丁由 scripts/gen_delta.py 生成，格式：
+ *   头部：magic "XZDELTA1"，source_size、target_size（小端 u32），源镜像和目标镜像的 SHA-256
+ *   之后是若干条记录，直到输出 target_size 字节：
+ *     diff_len、extra_len（varint），seek（zigzag varint）
+ *     diff 数据：若干组 zero_run、literal_len（varint）和 literal_len 个字节，合计 diff_len 字节，
+ *       zero_run 部分原样复制源字节，literal 部分输出 源字节 + literal；zero_run 用完 diff_len 时省略 literal_len
+ *     extra 数据：extra_len 个字节原样输出
+ *     每条记录结束后源位置再移动 seek
+ * 补丁可以按任意大小分段输入，内存占用固定：一块源数据缓存和一块输出缓存
+ */
+class DeltaPatch {
+public:
+    // 从源镜像 offset 处读取 length 字节
+    typedef std::function<bool(size_t offset, uint8_t* data, size_t length)> SourceReader;
+    // 头部解析完成后调用一次，返回 false 终止
+    typedef std::function<bool(const DeltaPatchHeader& header)> HeaderCallback;
+    typedef std::function<bool(const uint8_t* data, size_t length)> TargetWriter;
+
+    DeltaPatch(SourceReader read_source, HeaderCallback on_header, TargetWriter write_target);
+
+    // 返回 false 表示补丁格式错误或者回调失败，之后的输入都会被拒绝
+    bool Feed(const uint8_t* data, size_t length);
+
+    bool done() const { return state_ == kDone; }
+    size_t target_written() const { return target_written_; }
+
+private:
+    enum State {
+        kHeader,
+        kDiffLength,
+        kExtraLength,
+        kSeek,
+        kZeroRun,
+        kLiteralLength,
+        kLiteral,
+        kExtra,
+        kDone,
+        kError
+    };
+
+    SourceReader read_source_;
+    HeaderCallback on_header_;
+    TargetWriter write_target_;
+
+    State state_ = kHeader;
+    uint8_t header_buffer_[DELTA_PATCH_HEADER_SIZE];
+    size_t header_received_ = 0;
+    DeltaPatchHeader header_ = {};
+
+    uint64_t varint_ = 0;
+    int varint_shift_ = 0;
+    size_t diff_remaining_ = 0;
+    size_t extra_remaining_ = 0;
+    size_t literal_remaining_ = 0;
+
+    size_t source_position_ = 0;
+    // 已经输出（包括还在输出缓存中）的字节数
+    size_t target_written_ = 0;
+
+    uint8_t source_cache_[1024];
+    size_t cache_offset_ = 0;
+    size_t cache_length_ = 0;
+    uint8_t output_[512];
+    size_t output_length_ = 0;
+
+    bool Fail(const char* reason);
+    bool ParseHeader();
+    bool ReadVarint(uint8_t byte);
+    bool ReadSource(uint8_t& value);
+    bool Emit(uint8_t value);
+    bool Flush();
+    bool CopySource(size_t length);
+    void EndDiff();
+    bool EndRecord();
+};
+
+#endif // DELTA_PATCH_H
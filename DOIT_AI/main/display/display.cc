@@ -24,8 +24,8 @@ Display::Display() {
         .callback = [](void *arg) {
             Display *display = static_cast<Display*>(arg);
             DisplayLockGuard lock(display);
-            lv_obj_add_flag(display->notification_label_, LV_OBJ_FLAG_HIDDEN);
-            lv_obj_clear_flag(display->status_label_, LV_OBJ_FLAG_HIDDEN);
+            SetHidden(display->notification_label_, true);
+            SetHidden(display->status_label_, false);
         },
         .arg = this,
         .dispatch_method = ESP_TIMER_TASK,
@@ -48,6 +48,19 @@ Display::Display() {
     ESP_ERROR_CHECK(esp_timer_create(&update_display_timer_args, &update_timer_));
     ESP_ERROR_CHECK(esp_timer_start_periodic(update_timer_, 1000000));
 
+    // Typing timer
+    esp_timer_create_args_t typing_timer_args = {
+        .callback = [](void *arg) {
+            Display *display = static_cast<Display*>(arg);
+            display->OnTypingTimer();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "typing_timer",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&typing_timer_args, &typing_timer_));
+
     // Create a power management lock
     auto ret = esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, "display_update", &pm_lock_);
     if (ret == ESP_ERR_NOT_SUPPORTED) {
@@ -66,6 +79,10 @@ Display::~Display() {
         esp_timer_stop(update_timer_);
         esp_timer_delete(update_timer_);
     }
+    if (typing_timer_ != nullptr) {
+        esp_timer_stop(typing_timer_);
+        esp_timer_delete(typing_timer_);
+    }
 
     if (network_label_ != nullptr) {
         lv_obj_del(network_label_);
@@ -88,9 +105,9 @@ void Display::SetStatus(const char* status) {
     if (status_label_ == nullptr) {
         return;
     }
-    lv_label_set_text(status_label_, status);
-    lv_obj_clear_flag(status_label_, LV_OBJ_FLAG_HIDDEN);
-    lv_obj_add_flag(notification_label_, LV_OBJ_FLAG_HIDDEN);
+    SetLabelText(status_label_, status);
+    SetHidden(status_label_, false);
+    SetHidden(notification_label_, true);
 }
 
 void Display::ShowNotification(const std::string &notification, int duration_ms) {
@@ -102,9 +119,9 @@ void Display::ShowNotification(const char* notification, int duration_ms) {
     if (notification_label_ == nullptr) {
         return;
     }
-    lv_label_set_text(notification_label_, notification);
-    lv_obj_clear_flag(notification_label_, LV_OBJ_FLAG_HIDDEN);
-    lv_obj_add_flag(status_label_, LV_OBJ_FLAG_HIDDEN);
+    SetLabelText(notification_label_, notification);
+    SetHidden(notification_label_, false);
+    SetHidden(status_label_, true);
 
     esp_timer_stop(notification_timer_);
     ESP_ERROR_CHECK(esp_timer_start_once(notification_timer_, duration_ms * 1000));
@@ -113,31 +130,18 @@ void Display::ShowNotification(const char* notification, int duration_ms) {
 void Display::Update() {
     auto& board = Board::GetInstance();
     auto codec = board.GetAudioCodec();
-
-    {
-        DisplayLockGuard lock(this);
-        if (mute_label_ == nullptr) {
-            return;
-        }
-
-        // 如果静音状态改变，则更新图标
-        if (codec->output_volume() == 0 && !muted_) {
-            muted_ = true;
-            lv_label_set_text(mute_label_, FONT_AWESOME_VOLUME_MUTE);
-        } else if (codec->output_volume() > 0 && muted_) {
-            muted_ = false;
-            lv_label_set_text(mute_label_, "");
-        }
+    if (mute_label_ == nullptr) {
+        return;
     }
 
     esp_pm_lock_acquire(pm_lock_);
-    // 更新电池图标
+    // 先在锁外读取电池和网络状态，再一次性更新界面，所有变化在同一帧中重绘
     int battery_level;
     bool charging, discharging;
-    const char* icon = nullptr;
+    const char* battery_icon = nullptr;
     if (board.GetBatteryLevel(battery_level, charging, discharging)) {
         if (charging) {
-            icon = FONT_AWESOME_BATTERY_CHARGING;
+            battery_icon = FONT_AWESOME_BATTERY_CHARGING;
         } else {
             const char* levels[] = {
                 FONT_AWESOME_BATTERY_EMPTY, // 0-19%
@@ -147,31 +151,12 @@ void Display::Update() {
                 FONT_AWESOME_BATTERY_FULL, // 80-99%
                 FONT_AWESOME_BATTERY_FULL, // 100%
             };
-            icon = levels[battery_level / 20];
-        }
-        DisplayLockGuard lock(this);
-        if (battery_label_ != nullptr && battery_icon_ != icon) {
-            battery_icon_ = icon;
-            lv_label_set_text(battery_label_, battery_icon_);
-        }
-
-        if (low_battery_popup_ != nullptr) {
-            if (strcmp(icon, FONT_AWESOME_BATTERY_EMPTY) == 0 && discharging) {
-                if (lv_obj_has_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN)) { // 如果低电量提示框隐藏，则显示
-                    lv_obj_clear_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
-                    auto& app = Application::GetInstance();
-                    app.PlaySound(Lang::Sounds::P3_LOW_BATTERY);
-                }
-            } else {
-                // Hide the low battery popup when the battery is not empty
-                if (!lv_obj_has_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN)) { // 如果低电量提示框显示，则隐藏
-                    lv_obj_add_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
-                }
-            }
+            battery_icon = levels[battery_level / 20];
         }
     }
 
     // 升级固件时，不读取 4G 网络状态，避免占用 UART 资源
+    const char* network_icon = nullptr;
     auto device_state = Application::GetInstance().GetDeviceState();
     static const std::vector<DeviceState> allowed_states = {
         kDeviceStateIdle,
@@ -181,10 +166,42 @@ void Display::Update() {
         kDeviceStateActivating,
     };
     if (std::find(allowed_states.begin(), allowed_states.end(), device_state) != allowed_states.end()) {
-        icon = board.GetNetworkStateIcon();
-        if (network_label_ != nullptr && icon != nullptr && network_icon_ != icon) {
-            DisplayLockGuard lock(this);
-            network_icon_ = icon;
+        network_icon = board.GetNetworkStateIcon();
+    }
+
+    {
+        DisplayLockGuard lock(this);
+        // 如果静音状态改变，则更新图标
+        if (codec->output_volume() == 0 && !muted_) {
+            muted_ = true;
+            lv_label_set_text(mute_label_, FONT_AWESOME_VOLUME_MUTE);
+        } else if (codec->output_volume() > 0 && muted_) {
+            muted_ = false;
+            lv_label_set_text(mute_label_, "");
+        }
+
+        if (battery_icon != nullptr) {
+            if (battery_label_ != nullptr && battery_icon_ != battery_icon) {
+                battery_icon_ = battery_icon;
+                lv_label_set_text(battery_label_, battery_icon_);
+            }
+
+            if (low_battery_popup_ != nullptr) {
+                if (strcmp(battery_icon, FONT_AWESOME_BATTERY_EMPTY) == 0 && discharging) {
+                    if (lv_obj_has_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN)) { // 如果低电量提示框隐藏，则显示
+                        lv_obj_clear_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
+                        auto& app = Application::GetInstance();
+                        app.PlaySound(Lang::Sounds::P3_LOW_BATTERY);
+                    }
+                } else {
+                    // Hide the low battery popup when the battery is not empty
+                    SetHidden(low_battery_popup_, true);
+                }
+            }
+        }
+
+        if (network_label_ != nullptr && network_icon != nullptr && network_icon_ != network_icon) {
+            network_icon_ = network_icon;
             lv_label_set_text(network_label_, network_icon_);
         }
     }
@@ -235,9 +252,9 @@ void Display::SetEmotion(const char* emotion) {
 
     // 如果找到匹配的表情就显示对应图标，否则显示默认的neutral表情
     if (it != emotions.end()) {
-        lv_label_set_text(emotion_label_, it->icon);
+        SetLabelText(emotion_label_, it->icon);
     } else {
-        lv_label_set_text(emotion_label_, FONT_AWESOME_EMOJI_NEUTRAL);
+        SetLabelText(emotion_label_, FONT_AWESOME_EMOJI_NEUTRAL);
     }
 }
 
@@ -246,15 +263,103 @@ void Display::SetIcon(const char* icon) {
     if (emotion_label_ == nullptr) {
         return;
     }
-    lv_label_set_text(emotion_label_, icon);
+    SetLabelText(emotion_label_, icon);
 }
 
 void Display::SetChatMessage(const char* role, const char* content) {
     DisplayLockGuard lock(this);
+    FinishTyping();
     if (chat_message_label_ == nullptr) {
         return;
     }
-    lv_label_set_text(chat_message_label_, content);
+    SetLabelText(chat_message_label_, content);
+}
+
+// 只把新的文字插入到标签末尾，不重新设置整段文字
+void Display::AppendChatMessage(const char* role, const char* content) {
+    DisplayLockGuard lock(this);
+    if (chat_message_label_ == nullptr || content[0] == '\0') {
+        return;
+    }
+    lv_label_ins_text(chat_message_label_, LV_LABEL_POS_LAST, content);
+}
+
+// UTF-8 字符的字节数，逐字显示时不能把一个汉字拆开
+static size_t Utf8CharLength(const std::string& text, size_t pos) {
+    size_t length = 1;
+    while (pos + length < text.size() && (text[pos + length] & 0xC0) == 0x80) {
+        length++;
+    }
+    return length;
+}
+
+void Display::TypeChatMessage(const char* role, const char* content) {
+#if CONFIG_CHAT_MESSAGE_TYPING_INTERVAL_MS > 0
+    DisplayLockGuard lock(this);
+    std::string text = content;
+    if (text.empty()) {
+        SetChatMessage(role, content);
+        return;
+    }
+    size_t length = Utf8CharLength(text, 0);
+    SetChatMessage(role, text.substr(0, length).c_str());
+    if (length < text.size()) {
+        typing_role_ = role;
+        typing_text_ = std::move(text);
+        typing_length_ = length;
+        esp_timer_stop(typing_timer_);
+        ESP_ERROR_CHECK(esp_timer_start_periodic(typing_timer_, CONFIG_CHAT_MESSAGE_TYPING_INTERVAL_MS * 1000));
+    }
+#else
+    SetChatMessage(role, content);
+#endif
+}
+
+void Display::OnTypingTimer() {
+    DisplayLockGuard lock(this);
+    if (typing_length_ >= typing_text_.size()) {
+        esp_timer_stop(typing_timer_);
+        return;
+    }
+    size_t length = Utf8CharLength(typing_text_, typing_length_);
+    auto next = typing_text_.substr(typing_length_, length);
+    typing_length_ += length;
+    AppendChatMessage(typing_role_.c_str(), next.c_str());
+    if (typing_length_ >= typing_text_.size()) {
+        esp_timer_stop(typing_timer_);
+        typing_text_.clear();
+        typing_length_ = 0;
+    }
+}
+
+void Display::FinishTyping() {
+    if (typing_length_ >= typing_text_.size()) {
+        return;
+    }
+    esp_timer_stop(typing_timer_);
+    auto rest = typing_text_.substr(typing_length_);
+    typing_text_.clear();
+    typing_length_ = 0;
+    AppendChatMessage(typing_role_.c_str(), rest.c_str());
+}
+
+void Display::SetLabelText(lv_obj_t* label, const char* text) {
+    const char* current = lv_label_get_text(label);
+    if (current != nullptr && strcmp(current, text) == 0) {
+        return;
+    }
+    lv_label_set_text(label, text);
+}
+
+void Display::SetHidden(lv_obj_t* object, bool hidden) {
+    if (lv_obj_has_flag(object, LV_OBJ_FLAG_HIDDEN) == hidden) {
+        return;
+    }
+    if (hidden) {
+        lv_obj_add_flag(object, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_clear_flag(object, LV_OBJ_FLAG_HIDDEN);
+    }
 }
 
 void Display::SetTheme(const std::string& theme_name) {
@@ -24,6 +24,10 @@ public:
     virtual void ShowNotification(const std::string &notification, int duration_ms = 3000);
     virtual void SetEmotion(const char* emotion);
     virtual void SetChatMessage(const char* role, const char* content);
+    // 在最后一条消息后面追加文字，最后一条不是这个角色的消息时等同于 SetChatMessage
+    virtual void AppendChatMessage(const char* role, const char* content);
+    // 按 CONFIG_CHAT_MESSAGE_TYPING_INTERVAL_MS 逐字显示一条消息
+    void TypeChatMessage(const char* role, const char* content);
     virtual void SetIcon(const char* icon);
     virtual void SetTheme(const std::string& theme_name);
     virtual std::string GetTheme() { return current_theme_name_; }
@@ -55,12 +59,26 @@ protected:
 
     esp_timer_handle_t notification_timer_ = nullptr;
     esp_timer_handle_t update_timer_ = nullptr;
+    esp_timer_handle_t typing_timer_ = nullptr;
+
+    // 正在逐字显示的消息，typing_length_ 是已经显示的字节数
+    std::string typing_role_;
+    std::string typing_text_;
+    size_t typing_length_ = 0;
 
     friend class DisplayLockGuard;
     virtual bool Lock(int timeout_ms = 0) = 0;
     virtual void Unlock() = 0;
 
     virtual void Update();
+
+    // 立即显示完正在逐字显示的消息，SetChatMessage 开始时调用，避免文字追加到新的消息上
+    void FinishTyping();
+    void OnTypingTimer();
+
+    // 内容或状态没有变化时不调用 LVGL，避免重绘没有变化的区域
+    static void SetLabelText(lv_obj_t* label, const char* text);
+    static void SetHidden(lv_obj_t* object, bool hidden);
 };
 
 
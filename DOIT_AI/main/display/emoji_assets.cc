@@ -0,0 +1,151 @@
+#include "emoji_assets.h"
+#include "assets.h"
+
+#include <esp_log.h>
+
+#include <algorithm>
+#include <cstring>
+
+#define TAG "EmojiAssets"
+
+#define EMOJI_ASSETS_NAME "emoji.bin"
+#define EMOJI_ASSETS_MAGIC "XZEM"
+#define EMOJI_ASSETS_VERSION 1
+// 图片缓存保留当前和上一个表情，来回切换时不用重新解压
+#define EMOJI_CACHE_IMAGES 2
+
+namespace {
+
+struct PackHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t count;
+};
+
+struct PackEntry {
+    uint32_t unicode;
+    uint16_t size;
+    uint8_t cf;
+    uint8_t reserved;
+    uint16_t w;
+    uint16_t h;
+    uint16_t stride;
+    uint16_t reserved_2;
+    uint32_t offset;
+    uint32_t data_size;
+};
+
+static_assert(sizeof(PackHeader) == 8 && sizeof(PackEntry) == 24, "Emoji pack layout mismatch");
+
+// lv_image_compressed_t 在数据开头的 12 字节
+struct CompressedHeader {
+    uint32_t method;
+    uint32_t compressed_size;
+    uint32_t decompressed_size;
+};
+
+} // namespace
+
+bool EmojiAssets::Load() {
+    auto pack = Assets::GetInstance().Get(EMOJI_ASSETS_NAME);
+    if (pack.size() < sizeof(PackHeader)) {
+        ESP_LOGE(TAG, "No %s in assets", EMOJI_ASSETS_NAME);
+        return false;
+    }
+    data_ = (const uint8_t*)pack.data();
+    size_ = pack.size();
+
+    PackHeader header;
+    memcpy(&header, data_, sizeof(header));
+    if (memcmp(header.magic, EMOJI_ASSETS_MAGIC, sizeof(header.magic)) != 0 || header.version != EMOJI_ASSETS_VERSION ||
+        sizeof(PackHeader) + header.count * sizeof(PackEntry) > size_) {
+        ESP_LOGE(TAG, "Invalid %s in assets", EMOJI_ASSETS_NAME);
+        data_ = nullptr;
+        return false;
+    }
+
+    for (int i = 0; i < header.count; i++) {
+        PackEntry entry;
+        memcpy(&entry, data_ + sizeof(PackHeader) + i * sizeof(PackEntry), sizeof(entry));
+        if (entry.offset > size_ || entry.data_size > size_ - entry.offset || entry.data_size < sizeof(CompressedHeader)) {
+            ESP_LOGW(TAG, "Invalid emoji U+%lX size %u", entry.unicode, entry.size);
+            continue;
+        }
+
+        EmojiImage emoji = {};
+        emoji.unicode = entry.unicode;
+        emoji.image.header.magic = LV_IMAGE_HEADER_MAGIC;
+        emoji.image.header.cf = entry.cf;
+        emoji.image.header.flags = LV_IMAGE_FLAGS_COMPRESSED;
+        emoji.image.header.w = entry.w;
+        emoji.image.header.h = entry.h;
+        emoji.image.header.stride = entry.stride;
+        emoji.image.data_size = entry.data_size;
+        emoji.image.data = data_ + entry.offset;
+        images_[entry.size].push_back(emoji);
+    }
+    ESP_LOGI(TAG, "Loaded %u emoji images from %s", header.count, EMOJI_ASSETS_NAME);
+    return true;
+}
+
+const lv_font_t* EmojiAssets::GetFont(int size) {
+    auto it = fonts_.find(size);
+    if (it != fonts_.end()) {
+        return it->second;
+    }
+    if (!load_attempted_) {
+        load_attempted_ = true;
+        Load();
+    }
+
+    auto images = images_.find(size);
+    if (images == images_.end()) {
+        ESP_LOGW(TAG, "No %dpx emoji in %s", size, EMOJI_ASSETS_NAME);
+        fonts_[size] = nullptr;
+        return nullptr;
+    }
+
+    // 图片表在创建字体之后不再修改，字体直接引用其中的 lv_image_dsc_t
+    auto font = lv_imgfont_create(size, GetImage, &images->second);
+    if (font == nullptr) {
+        ESP_LOGE(TAG, "Failed to create %dpx emoji font", size);
+        return nullptr;
+    }
+    font->base_line = 0;
+    font->fallback = nullptr;
+    fonts_[size] = font;
+
+    // 图片缓存按解压后的大小计算，默认不缓存，每次重绘都要重新解压
+    uint32_t image_size = 0;
+    for (auto& emoji : images->second) {
+        CompressedHeader compressed;
+        memcpy(&compressed, emoji.image.data, sizeof(compressed));
+        image_size = std::max(image_size, compressed.decompressed_size);
+    }
+    cache_size_ += EMOJI_CACHE_IMAGES * image_size;
+    lv_image_cache_resize(cache_size_, false);
+    ESP_LOGI(TAG, "Created %dpx emoji font with %zu images, image cache %lu bytes",
+        size, images->second.size(), cache_size_);
+    return font;
+}
+
+const void* EmojiAssets::GetImage(const lv_font_t* font, uint32_t unicode, uint32_t unicode_next,
+    int32_t* offset_y, void* user_data) {
+    auto images = static_cast<const std::vector<EmojiImage>*>(user_data);
+    for (auto& emoji : *images) {
+        if (emoji.unicode == unicode) {
+            return &emoji.image;
+        }
+    }
+    return nullptr;
+}
+
+// 链接时用 --wrap 替换 xiaozhi-fonts 组件中的同名函数，板子代码不用修改，
+// 编译进固件的表情图片没有被引用，不会被链接
+extern "C" const lv_font_t* __wrap_font_emoji_32_init(void) {
+    return EmojiAssets::GetInstance().GetFont(32);
+}
+
+extern "C" const lv_font_t* __wrap_font_emoji_64_init(void) {
+    return EmojiAssets::GetInstance().GetFont(64);
+}
@@ -0,0 +1,51 @@
+#ifndef EMOJI_ASSETS_H
+#define EMOJI_ASSETS_H
+
+#include <lvgl.h>
+
+#include <map>
+#include <vector>
+
+/*
+ * 资源包中的表情图片 emoji.bin，由 scripts/pack_emoji.py 打包
+ * 文件内容（小端）：
+ *   头部   magic "XZEM"，uint16 版本，uint16 图片数量
+ *   索引   每张图片 24 字节：uint32 unicode，uint16 尺寸，uint8 cf，uint8 保留，uint16 w/h/stride，
+ *          uint16 保留，uint32 数据偏移（相对文件开头），uint32 数据长度
+ *   数据   4 字节对齐，lv_image_compressed_t 的 12 字节头部加 LZ4 数据
+ * 图片数据直接指向映射的 flash 交给 LVGL，显示时才解压，解压结果放在 LVGL 的图片缓存中，
+ * 缓存只保留 EMOJI_CACHE_IMAGES 张，没有显示过的表情不占内存
+ */
+class EmojiAssets {
+public:
+    static EmojiAssets& GetInstance() {
+        static EmojiAssets instance;
+        return instance;
+    }
+    EmojiAssets(const EmojiAssets&) = delete;
+    EmojiAssets& operator=(const EmojiAssets&) = delete;
+
+    // 返回对应尺寸的表情字体，资源包中没有这个尺寸的图片时返回空
+    const lv_font_t* GetFont(int size);
+
+private:
+    struct EmojiImage {
+        uint32_t unicode;
+        lv_image_dsc_t image;
+    };
+
+    EmojiAssets() = default;
+
+    bool load_attempted_ = false;
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    std::map<int, std::vector<EmojiImage>> images_;
+    std::map<int, lv_font_t*> fonts_;
+    uint32_t cache_size_ = LV_CACHE_DEF_SIZE;
+
+    bool Load();
+    static const void* GetImage(const lv_font_t* font, uint32_t unicode, uint32_t unicode_next,
+        int32_t* offset_y, void* user_data);
+};
+
+#endif // EMOJI_ASSETS_H
@@ -0,0 +1,143 @@
+#include "glyph_cache.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <src/misc/cache/lv_cache_private.h>
+
+#define TAG "GlyphCache"
+
+namespace {
+
+// lv_cache_class_lru_rb_size 要求数据以 lv_cache_slot_size_t 开头
+struct GlyphEntry {
+    lv_cache_slot_size_t slot;
+    const lv_font_t* font;
+    uint32_t gid;
+    uint16_t box_w;
+    uint16_t box_h;
+    lv_draw_buf_t draw_buf;
+};
+
+lv_cache_compare_res_t CompareGlyph(const GlyphEntry* lhs, const GlyphEntry* rhs) {
+    if (lhs->font != rhs->font) {
+        return lhs->font > rhs->font ? 1 : -1;
+    }
+    if (lhs->gid != rhs->gid) {
+        return lhs->gid > rhs->gid ? 1 : -1;
+    }
+    if (lhs->box_w != rhs->box_w) {
+        return lhs->box_w > rhs->box_w ? 1 : -1;
+    }
+    return 0;
+}
+
+// 从原字体解码一次位图保存到缓存
+bool CreateGlyph(GlyphEntry* entry, void* user_data) {
+    auto dsc = (lv_font_glyph_dsc_t*)user_data;
+    uint32_t stride = lv_draw_buf_width_to_stride(entry->box_w, LV_COLOR_FORMAT_A8);
+    uint32_t size = stride * entry->box_h;
+    void* buffer = heap_caps_aligned_alloc(LV_DRAW_BUF_ALIGN, size, MALLOC_CAP_SPIRAM);
+    if (buffer == nullptr) {
+        buffer = heap_caps_aligned_alloc(LV_DRAW_BUF_ALIGN, size, MALLOC_CAP_8BIT);
+    }
+    if (buffer == nullptr) {
+        return false;
+    }
+    lv_draw_buf_init(&entry->draw_buf, entry->box_w, entry->box_h, LV_COLOR_FORMAT_A8, stride, buffer, size);
+
+    lv_font_glyph_dsc_t font_dsc = *dsc;
+    font_dsc.resolved_font = entry->font;
+    // 原字体返回了自己的缓冲区时无法缓存
+    if (entry->font->get_glyph_bitmap(&font_dsc, &entry->draw_buf) != &entry->draw_buf) {
+        heap_caps_free(buffer);
+        return false;
+    }
+    return true;
+}
+
+void FreeGlyph(GlyphEntry* entry, void* user_data) {
+    heap_caps_free(entry->draw_buf.unaligned_data);
+}
+
+} // namespace
+
+const lv_font_t* GlyphCache::Wrap(const lv_font_t* font) {
+    if (font == nullptr) {
+        return nullptr;
+    }
+    auto it = fonts_.find(font);
+    if (it != fonts_.end()) {
+        return it->second.get();
+    }
+
+    // 副本保留原字体的行高、基线、字距和 fallback，dsc 指向原字体
+    auto wrapped = std::make_unique<lv_font_t>(*font);
+    wrapped->get_glyph_dsc = GetGlyphDsc;
+    wrapped->get_glyph_bitmap = GetGlyphBitmap;
+    wrapped->release_glyph = ReleaseGlyph;
+    wrapped->dsc = font;
+    return (fonts_[font] = std::move(wrapped)).get();
+}
+
+void GlyphCache::GetStats(uint32_t& lookups, uint32_t& misses) const {
+    lookups = lookups_;
+    misses = misses_;
+}
+
+bool GlyphCache::GetGlyphDsc(const lv_font_t* font, lv_font_glyph_dsc_t* dsc, uint32_t letter, uint32_t letter_next) {
+    auto original = (const lv_font_t*)font->dsc;
+    return original->get_glyph_dsc(original, dsc, letter, letter_next);
+}
+
+const void* GlyphCache::GetGlyphBitmap(lv_font_glyph_dsc_t* dsc, lv_draw_buf_t* draw_buf) {
+    auto& self = GetInstance();
+    auto original = (const lv_font_t*)dsc->resolved_font->dsc;
+    dsc->entry = nullptr;
+
+    // 图片字形由图片缓存处理，直接交给原字体，释放时也由原字体处理
+    if (dsc->format <= LV_FONT_GLYPH_FORMAT_NONE || dsc->format >= LV_FONT_GLYPH_FORMAT_IMAGE) {
+        dsc->resolved_font = original;
+        return original->get_glyph_bitmap(dsc, draw_buf);
+    }
+
+    if (self.cache_ == nullptr) {
+        lv_cache_ops_t ops = {
+            .compare_cb = (lv_cache_compare_cb_t)CompareGlyph,
+            .create_cb = (lv_cache_create_cb_t)CreateGlyph,
+            .free_cb = (lv_cache_free_cb_t)FreeGlyph,
+        };
+        self.cache_ = lv_cache_create(&lv_cache_class_lru_rb_size, sizeof(GlyphEntry),
+            CONFIG_GLYPH_CACHE_SIZE_KB * 1024, ops);
+        lv_cache_set_name(self.cache_, "GLYPH");
+        ESP_LOGI(TAG, "Glyph cache created, %d KB", CONFIG_GLYPH_CACHE_SIZE_KB);
+    }
+
+    GlyphEntry key = {};
+    key.slot.size = lv_draw_buf_width_to_stride(dsc->box_w, LV_COLOR_FORMAT_A8) * dsc->box_h;
+    key.font = original;
+    key.gid = dsc->gid.index;
+    key.box_w = dsc->box_w;
+    key.box_h = dsc->box_h;
+
+    self.lookups_++;
+    auto entry = lv_cache_acquire(self.cache_, &key, nullptr);
+    if (entry == nullptr) {
+        self.misses_++;
+        entry = lv_cache_acquire_or_create(self.cache_, &key, dsc);
+    }
+    if (entry == nullptr) {
+        // 缓存放不下或者内存不足，退回到原字体解码
+        dsc->resolved_font = original;
+        return original->get_glyph_bitmap(dsc, draw_buf);
+    }
+    dsc->entry = entry;
+    auto glyph = (GlyphEntry*)lv_cache_entry_get_data(entry);
+    return &glyph->draw_buf;
+}
+
+void GlyphCache::ReleaseGlyph(const lv_font_t* font, lv_font_glyph_dsc_t* dsc) {
+    if (dsc->entry != nullptr) {
+        lv_cache_release(GetInstance().cache_, dsc->entry, nullptr);
+        dsc->entry = nullptr;
+    }
+}
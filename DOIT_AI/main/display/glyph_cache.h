@@ -0,0 +1,43 @@
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <lvgl.h>
+
+#include <map>
+#include <memory>
+
+/*
+ * 字形位图缓存
+ * Wrap 返回原字体的副本，度量和字形描述仍由原字体提供，字形位图第一次绘制时从 flash 解码，
+ * 之后从 LVGL 的 LRU 缓存中取出。缓存按字节计算，大小由 CONFIG_GLYPH_CACHE_SIZE_KB 决定，
+ * 有 PSRAM 时位图放在 PSRAM。表情等图片字形不经过缓存。
+ * 和其他 LVGL 调用一样，只能在持有显示锁时使用
+ */
+class GlyphCache {
+public:
+    static GlyphCache& GetInstance() {
+        static GlyphCache instance;
+        return instance;
+    }
+    GlyphCache(const GlyphCache&) = delete;
+    GlyphCache& operator=(const GlyphCache&) = delete;
+
+    // 同一个字体多次调用返回同一个副本，font 为空时返回空
+    const lv_font_t* Wrap(const lv_font_t* font);
+    // 取出位图的次数和其中需要解码的次数
+    void GetStats(uint32_t& lookups, uint32_t& misses) const;
+
+private:
+    GlyphCache() = default;
+
+    lv_cache_t* cache_ = nullptr;
+    std::map<const lv_font_t*, std::unique_ptr<lv_font_t>> fonts_;
+    uint32_t lookups_ = 0;
+    uint32_t misses_ = 0;
+
+    static bool GetGlyphDsc(const lv_font_t* font, lv_font_glyph_dsc_t* dsc, uint32_t letter, uint32_t letter_next);
+    static const void* GetGlyphBitmap(lv_font_glyph_dsc_t* dsc, lv_draw_buf_t* draw_buf);
+    static void ReleaseGlyph(const lv_font_t* font, lv_font_glyph_dsc_t* dsc);
+};
+
+#endif // GLYPH_CACHE_H
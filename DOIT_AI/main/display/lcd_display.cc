@@ -7,7 +7,10 @@
 #include <esp_lvgl_port.h>
 #include "assets/lang_config.h"
 #include <cstring>
+#include <algorithm>
+#include <esp_heap_caps.h>
 #include "settings.h"
+#include "glyph_cache.h"
 
 #include "board.h"
 
@@ -112,8 +115,9 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         .io_handle = panel_io_,
         .panel_handle = panel_,
         .control_handle = nullptr,
-        .buffer_size = static_cast<uint32_t>(width_ * 20),
-        .double_buffer = false,
+        // 局部刷新，两块 10 行的 DMA 缓冲区（与原来一块 20 行占用相同），LVGL 渲染一块时另一块在 SPI 上传输
+        .buffer_size = static_cast<uint32_t>(width_ * 10),
+        .double_buffer = true,
         .trans_size = 0,
         .hres = static_cast<uint32_t>(width_),
         .vres = static_cast<uint32_t>(height_),
@@ -143,6 +147,9 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
     if (offset_x != 0 || offset_y != 0) {
         lv_display_set_offset(display_, offset_x, offset_y);
     }
+#if CONFIG_DISPLAY_REFRESH_STATS_INTERVAL > 0
+    InitializeRefreshStats();
+#endif
 
     // Update the theme
     if (current_theme_name_ == "dark") {
@@ -191,10 +198,11 @@ RgbLcdDisplay::RgbLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
             .mirror_x = mirror_x,
             .mirror_y = mirror_y,
         },
+        // 直接使用面板的两块帧缓冲，LVGL 只重绘变化的区域并同步到另一块缓冲，不需要整屏刷新
         .flags = {
             .buff_dma = 1,
             .swap_bytes = 0,
-            .full_refresh = 1,
+            .full_refresh = 0,
             .direct_mode = 1,
         },
     };
@@ -215,6 +223,9 @@ RgbLcdDisplay::RgbLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
     if (offset_x != 0 || offset_y != 0) {
         lv_display_set_offset(display_, offset_x, offset_y);
     }
+#if CONFIG_DISPLAY_REFRESH_STATS_INTERVAL > 0
+    InitializeRefreshStats();
+#endif
 
     // Update the theme
     if (current_theme_name_ == "dark") {
@@ -226,6 +237,15 @@ RgbLcdDisplay::RgbLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
     SetupUI();
 }
 
+LcdDisplay::LcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handle_t panel, DisplayFonts fonts)
+    : panel_io_(panel_io), panel_(panel), fonts_(fonts) {
+#if CONFIG_GLYPH_CACHE_SIZE_KB > 0
+    // 表情是图片字体，由 LVGL 的图片缓存处理
+    fonts_.text_font = GlyphCache::GetInstance().Wrap(fonts_.text_font);
+    fonts_.icon_font = GlyphCache::GetInstance().Wrap(fonts_.icon_font);
+#endif
+}
+
 LcdDisplay::~LcdDisplay() {
     // 然后再清理 LVGL 对象
     if (content_ != nullptr) {
@@ -252,6 +272,48 @@ LcdDisplay::~LcdDisplay() {
     }
 }
 
+#if CONFIG_DISPLAY_REFRESH_STATS_INTERVAL > 0
+// 事件在持有 LVGL 锁的刷新任务中触发，统计值在 Update 中加锁读取
+void LcdDisplay::InitializeRefreshStats() {
+    lv_display_add_event_cb(display_, [](lv_event_t* e) {
+        auto display = static_cast<LcdDisplay*>(lv_event_get_user_data(e));
+        display->refresh_frames_++;
+    }, LV_EVENT_RENDER_READY, this);
+    lv_display_add_event_cb(display_, [](lv_event_t* e) {
+        auto display = static_cast<LcdDisplay*>(lv_event_get_user_data(e));
+        auto area = static_cast<lv_area_t*>(lv_event_get_param(e));
+        display->refresh_bytes_ += lv_area_get_size(area) *
+            lv_color_format_get_size(lv_display_get_color_format(display->display_));
+    }, LV_EVENT_FLUSH_START, this);
+    refresh_stats_time_ = esp_timer_get_time();
+}
+
+void LcdDisplay::Update() {
+    Display::Update();
+
+    DisplayLockGuard lock(this);
+    int64_t now = esp_timer_get_time();
+    int64_t elapsed_ms = (now - refresh_stats_time_) / 1000;
+    if (elapsed_ms < CONFIG_DISPLAY_REFRESH_STATS_INTERVAL * 1000) {
+        return;
+    }
+    if (refresh_frames_ > 0) {
+        ESP_LOGI(TAG, "Refresh: %.1f fps, %llu KB/s", refresh_frames_ * 1000.0f / elapsed_ms,
+            refresh_bytes_ / elapsed_ms * 1000 / 1024);
+    }
+#if CONFIG_GLYPH_CACHE_SIZE_KB > 0
+    uint32_t lookups, misses;
+    GlyphCache::GetInstance().GetStats(lookups, misses);
+    if (lookups > 0) {
+        ESP_LOGI(TAG, "Glyph cache: %lu lookups, %.1f%% hit", lookups, (lookups - misses) * 100.0f / lookups);
+    }
+#endif
+    refresh_frames_ = 0;
+    refresh_bytes_ = 0;
+    refresh_stats_time_ = now;
+}
+#endif
+
 bool LcdDisplay::Lock(int timeout_ms) {
     return lvgl_port_lock(timeout_ms);
 }
@@ -371,188 +433,256 @@ void LcdDisplay::SetupUI() {
     lv_obj_add_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
 }
 
-#define  MAX_MESSAGES 20
+// 最多保留的聊天记录条数
+#define CHAT_HISTORY_SIZE 50
+// 复用的消息行数，需要比一屏能显示的消息多，超出的记录滚动到边缘时再绑定
+#define CHAT_ROW_POOL_SIZE 12
+
+void LcdDisplay::CreateChatRow(ChatRow& row) {
+    row.container = lv_obj_create(content_);
+    lv_obj_set_width(row.container, LV_HOR_RES);
+    lv_obj_set_height(row.container, LV_SIZE_CONTENT);
+    lv_obj_set_style_bg_opa(row.container, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(row.container, 0, 0);
+    lv_obj_set_style_pad_all(row.container, 0, 0);
+    lv_obj_set_scrollbar_mode(row.container, LV_SCROLLBAR_MODE_OFF);
+    lv_obj_add_flag(row.container, LV_OBJ_FLAG_HIDDEN);
+
+    row.bubble = lv_obj_create(row.container);
+    lv_obj_set_style_radius(row.bubble, 8, 0);
+    lv_obj_set_scrollbar_mode(row.bubble, LV_SCROLLBAR_MODE_OFF);
+    lv_obj_set_style_border_width(row.bubble, 1, 0);
+    lv_obj_set_style_pad_all(row.bubble, 8, 0);
+    lv_obj_set_size(row.bubble, LV_SIZE_CONTENT, LV_SIZE_CONTENT);
+
+    row.label = lv_label_create(row.bubble);
+    lv_label_set_text(row.label, "");
+    lv_label_set_long_mode(row.label, LV_LABEL_LONG_WRAP);
+    lv_obj_set_style_text_font(row.label, fonts_.text_font, 0);
+    row.role = -1;
+}
+
+// 按当前主题设置气泡和文字颜色，role 变化或切换主题后调用
+void LcdDisplay::StyleChatRow(ChatRow& row) {
+    if (row.role == kChatRoleUser) {
+        lv_obj_set_style_bg_color(row.bubble, current_theme.user_bubble, 0);
+    } else if (row.role == kChatRoleAssistant) {
+        lv_obj_set_style_bg_color(row.bubble, current_theme.assistant_bubble, 0);
+    } else {
+        lv_obj_set_style_bg_color(row.bubble, current_theme.system_bubble, 0);
+    }
+    lv_obj_set_style_border_color(row.bubble, current_theme.border, 0);
+    lv_obj_set_style_text_color(row.label,
+        row.role == kChatRoleSystem ? current_theme.system_text : current_theme.text, 0);
+}
+
+void LcdDisplay::BindChatRow(ChatRow& row, const ChatRecord& record) {
+    if (row.role != record.role) {
+        row.role = record.role;
+        StyleChatRow(row);
+        if (record.role == kChatRoleUser) {
+            lv_obj_align(row.bubble, LV_ALIGN_RIGHT_MID, -25, 0);
+        } else if (record.role == kChatRoleAssistant) {
+            lv_obj_align(row.bubble, LV_ALIGN_LEFT_MID, 0, 0);
+        } else {
+            lv_obj_align(row.bubble, LV_ALIGN_CENTER, 0, 0);
+        }
+    }
+    lv_coord_t max_width = LV_HOR_RES * 85 / 100 - 16;  // 屏幕宽度的85%
+    lv_coord_t width = std::clamp<lv_coord_t>(record.text_width, 20, max_width);
+    if (lv_obj_get_width(row.label) != width) {
+        lv_obj_set_width(row.label, width);
+    }
+    SetLabelText(row.label, record.text.get());
+    SetHidden(row.container, false);
+}
+
+size_t LcdDisplay::BoundChatRowCount() const {
+    return std::min(chat_rows_.size(), chat_records_.size() - chat_window_start_);
+}
+
+// 从 start 开始重新绑定所有行，多余的行隐藏
+void LcdDisplay::BindChatWindow(size_t start) {
+    chat_window_start_ = start;
+    size_t bound = BoundChatRowCount();
+    for (size_t i = 0; i < chat_rows_.size(); i++) {
+        if (i < bound) {
+            BindChatRow(chat_rows_[i], chat_records_[start + i]);
+        } else {
+            SetHidden(chat_rows_[i].container, true);
+        }
+    }
+}
+
+// 滚动到顶部或底部时，把另一端完全看不到的一行移过来绑定相邻的记录
+void LcdDisplay::OnChatScrollEnd() {
+    size_t bound = BoundChatRowCount();
+    if (bound < chat_rows_.size()) {
+        return;
+    }
+    int32_t pad_row = lv_obj_get_style_pad_row(content_, 0);
+    int32_t scroll_y = lv_obj_get_scroll_y(content_);
+    int32_t top_height = lv_obj_get_height(chat_rows_.front().container) + pad_row;
+    int32_t bottom_height = lv_obj_get_height(chat_rows_.back().container) + pad_row;
+    if (lv_obj_get_scroll_top(content_) <= 0 && chat_window_start_ > 0 &&
+        lv_obj_get_scroll_bottom(content_) >= bottom_height) {
+        ChatRow row = chat_rows_.back();
+        chat_rows_.pop_back();
+        chat_rows_.insert(chat_rows_.begin(), row);
+        lv_obj_move_to_index(row.container, 0);
+        chat_window_start_--;
+        BindChatRow(chat_rows_.front(), chat_records_[chat_window_start_]);
+        lv_obj_update_layout(content_);
+        // 保持原来的消息在屏幕上的位置不变
+        lv_obj_scroll_to_y(content_, scroll_y + lv_obj_get_height(row.container) + pad_row, LV_ANIM_OFF);
+    } else if (lv_obj_get_scroll_bottom(content_) <= 0 && chat_window_start_ + bound < chat_records_.size() &&
+        lv_obj_get_scroll_top(content_) >= top_height) {
+        ChatRow row = chat_rows_.front();
+        chat_rows_.erase(chat_rows_.begin());
+        chat_rows_.push_back(row);
+        lv_obj_move_to_index(row.container, -1);
+        chat_window_start_++;
+        BindChatRow(chat_rows_.back(), chat_records_[chat_window_start_ + bound - 1]);
+        lv_obj_update_layout(content_);
+        lv_obj_scroll_to_y(content_, scroll_y - top_height, LV_ANIM_OFF);
+    }
+}
+
+bool LcdDisplay::ParseChatRole(const char* role, ChatRole& chat_role) {
+    if (strcmp(role, "user") == 0) {
+        chat_role = kChatRoleUser;
+    } else if (strcmp(role, "assistant") == 0) {
+        chat_role = kChatRoleAssistant;
+    } else if (strcmp(role, "system") == 0) {
+        chat_role = kChatRoleSystem;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 void LcdDisplay::SetChatMessage(const char* role, const char* content) {
     DisplayLockGuard lock(this);
+    FinishTyping();
     if (content_ == nullptr) {
         return;
     }
     
     //避免出现空的消息框
     if(strlen(content) == 0) return;
-    
-    // 检查消息数量是否超过限制
-    uint32_t child_count = lv_obj_get_child_cnt(content_);
-    if (child_count >= MAX_MESSAGES) {
-        // 删除最早的消息（第一个子对象）
-        lv_obj_t* first_child = lv_obj_get_child(content_, 0);
-        lv_obj_t* last_child = lv_obj_get_child(content_, child_count - 1);
-        if (first_child != nullptr) {
-            lv_obj_del(first_child);
-        }
-        // Scroll to the last message immediately
-        if (last_child != nullptr) {
-            lv_obj_scroll_to_view_recursive(last_child, LV_ANIM_OFF);
-        }
+
+    ChatRole chat_role;
+    if (!ParseChatRole(role, chat_role)) {
+        return;
     }
-    
-    // 折叠系统消息（如果是系统消息，检查最后一个消息是否也是系统消息）
-    if (strcmp(role, "system") == 0 && child_count > 0) {
-        // 获取最后一个消息容器
-        lv_obj_t* last_container = lv_obj_get_child(content_, child_count - 1);
-        if (last_container != nullptr && lv_obj_get_child_cnt(last_container) > 0) {
-            // 获取容器内的气泡
-            lv_obj_t* last_bubble = lv_obj_get_child(last_container, 0);
-            if (last_bubble != nullptr) {
-                // 检查气泡类型是否为系统消息
-                void* bubble_type_ptr = lv_obj_get_user_data(last_bubble);
-                if (bubble_type_ptr != nullptr && strcmp((const char*)bubble_type_ptr, "system") == 0) {
-                    // 如果最后一个消息也是系统消息，则删除它
-                    lv_obj_del(last_container);
-                }
-            }
+
+    if (chat_rows_.empty()) {
+        chat_rows_.resize(CHAT_ROW_POOL_SIZE);
+        for (auto& row : chat_rows_) {
+            CreateChatRow(row);
         }
+        lv_obj_add_event_cb(content_, [](lv_event_t* e) {
+            auto display = static_cast<LcdDisplay*>(lv_event_get_user_data(e));
+            display->OnChatScrollEnd();
+        }, LV_EVENT_SCROLL_END, this);
     }
-    
-    // Create a message bubble
-    lv_obj_t* msg_bubble = lv_obj_create(content_);
-    lv_obj_set_style_radius(msg_bubble, 8, 0);
-    lv_obj_set_scrollbar_mode(msg_bubble, LV_SCROLLBAR_MODE_OFF);
-    lv_obj_set_style_border_width(msg_bubble, 1, 0);
-    lv_obj_set_style_border_color(msg_bubble, current_theme.border, 0);
-    lv_obj_set_style_pad_all(msg_bubble, 8, 0);
-
-    // Create the message text
-    lv_obj_t* msg_text = lv_label_create(msg_bubble);
-    lv_label_set_text(msg_text, content);
-    
-    // 计算文本实际宽度
-    lv_coord_t text_width = lv_txt_get_width(content, strlen(content), fonts_.text_font, 0);
 
-    // 计算气泡宽度
-    lv_coord_t max_width = LV_HOR_RES * 85 / 100 - 16;  // 屏幕宽度的85%
-    lv_coord_t min_width = 20;  
-    lv_coord_t bubble_width;
-    
-    // 确保文本宽度不小于最小宽度
-    if (text_width < min_width) {
-        text_width = min_width;
+    // 文字复制到 PSRAM，气泡宽度在这里测量一次，复用行时直接使用
+    size_t length = strlen(content);
+    char* text = (char*)heap_caps_malloc_prefer(length + 1, 2, MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT);
+    if (text == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate chat message");
+        return;
     }
-
-    // 如果文本宽度小于最大宽度，使用文本宽度
-    if (text_width < max_width) {
-        bubble_width = text_width; 
+    memcpy(text, content, length + 1);
+    ChatRecord record = {chat_role, {text, heap_caps_free}, lv_txt_get_width(content, length, fonts_.text_font, 0)};
+
+    size_t bound = BoundChatRowCount();
+    bool at_tail = chat_window_start_ + bound == chat_records_.size();
+
+    // 折叠系统消息（如果是系统消息，并且最后一个消息也是系统消息，则替换它）
+    if (chat_role == kChatRoleSystem && !chat_records_.empty() && chat_records_.back().role == kChatRoleSystem) {
+        chat_records_.back() = std::move(record);
+        if (at_tail) {
+            BindChatRow(chat_rows_[bound - 1], chat_records_.back());
+        } else {
+            BindChatWindow(chat_records_.size() - std::min(chat_rows_.size(), chat_records_.size()));
+        }
     } else {
-        bubble_width = max_width;
+        chat_records_.push_back(std::move(record));
+        if (chat_records_.size() > CHAT_HISTORY_SIZE) {
+            chat_records_.pop_front();
+            if (chat_window_start_ > 0) {
+                chat_window_start_--;
+            } else {
+                at_tail = false;
+            }
+        }
+
+        if (at_tail && bound == chat_rows_.size()) {
+            // 把最上面的一行移到最下面复用，其他行不需要重新布局文字
+            ChatRow row = chat_rows_.front();
+            chat_rows_.erase(chat_rows_.begin());
+            chat_rows_.push_back(row);
+            lv_obj_move_to_index(row.container, -1);
+            chat_window_start_++;
+            BindChatRow(chat_rows_.back(), chat_records_.back());
+        } else if (at_tail) {
+            BindChatRow(chat_rows_[bound], chat_records_.back());
+        } else {
+            // 正在查看较早的记录，回到最新的消息
+            BindChatWindow(chat_records_.size() - std::min(chat_rows_.size(), chat_records_.size()));
+        }
     }
-    
-    // 设置消息文本的宽度
-    lv_obj_set_width(msg_text, bubble_width);  // 减去padding
-    lv_label_set_long_mode(msg_text, LV_LABEL_LONG_WRAP);
-    lv_obj_set_style_text_font(msg_text, fonts_.text_font, 0);
 
-    // 设置气泡宽度
-    lv_obj_set_width(msg_bubble, bubble_width);
-    lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
+    // 不使用滚动动画，动画的每一帧都要重绘整个聊天区域
+    auto& last_row = chat_rows_[BoundChatRowCount() - 1];
+    lv_obj_scroll_to_view_recursive(last_row.container, LV_ANIM_OFF);
 
-    // Set alignment and style based on message role
-    if (strcmp(role, "user") == 0) {
-        // User messages are right-aligned with green background
-        lv_obj_set_style_bg_color(msg_bubble, current_theme.user_bubble, 0);
-        // Set text color for contrast
-        lv_obj_set_style_text_color(msg_text, current_theme.text, 0);
-        
-        // 设置自定义属性标记气泡类型
-        lv_obj_set_user_data(msg_bubble, (void*)"user");
-        
-        // Set appropriate width for content
-        lv_obj_set_width(msg_bubble, LV_SIZE_CONTENT);
-        lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
-        
-        // Don't grow
-        lv_obj_set_style_flex_grow(msg_bubble, 0, 0);
-    } else if (strcmp(role, "assistant") == 0) {
-        // Assistant messages are left-aligned with white background
-        lv_obj_set_style_bg_color(msg_bubble, current_theme.assistant_bubble, 0);
-        // Set text color for contrast
-        lv_obj_set_style_text_color(msg_text, current_theme.text, 0);
-        
-        // 设置自定义属性标记气泡类型
-        lv_obj_set_user_data(msg_bubble, (void*)"assistant");
-        
-        // Set appropriate width for content
-        lv_obj_set_width(msg_bubble, LV_SIZE_CONTENT);
-        lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
-        
-        // Don't grow
-        lv_obj_set_style_flex_grow(msg_bubble, 0, 0);
-    } else if (strcmp(role, "system") == 0) {
-        // System messages are center-aligned with light gray background
-        lv_obj_set_style_bg_color(msg_bubble, current_theme.system_bubble, 0);
-        // Set text color for contrast
-        lv_obj_set_style_text_color(msg_text, current_theme.system_text, 0);
-        
-        // 设置自定义属性标记气泡类型
-        lv_obj_set_user_data(msg_bubble, (void*)"system");
-        
-        // Set appropriate width for content
-        lv_obj_set_width(msg_bubble, LV_SIZE_CONTENT);
-        lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
-        
-        // Don't grow
-        lv_obj_set_style_flex_grow(msg_bubble, 0, 0);
+    // Store reference to the latest message label
+    chat_message_label_ = last_row.label;
+}
+
+// 逐字显示时追加到最后一条记录，只测量新增文字的宽度，标签只插入新的文字
+void LcdDisplay::AppendChatMessage(const char* role, const char* content) {
+    DisplayLockGuard lock(this);
+    if (content_ == nullptr || content[0] == '\0') {
+        return;
     }
-    
-    // Create a full-width container for user messages to ensure right alignment
-    if (strcmp(role, "user") == 0) {
-        // Create a full-width container
-        lv_obj_t* container = lv_obj_create(content_);
-        lv_obj_set_width(container, LV_HOR_RES);
-        lv_obj_set_height(container, LV_SIZE_CONTENT);
-        
-        // Make container transparent and borderless
-        lv_obj_set_style_bg_opa(container, LV_OPA_TRANSP, 0);
-        lv_obj_set_style_border_width(container, 0, 0);
-        lv_obj_set_style_pad_all(container, 0, 0);
-        
-        // Move the message bubble into this container
-        lv_obj_set_parent(msg_bubble, container);
-        
-        // Right align the bubble in the container
-        lv_obj_align(msg_bubble, LV_ALIGN_RIGHT_MID, -25, 0);
-        
-        // Auto-scroll to this container
-        lv_obj_scroll_to_view_recursive(container, LV_ANIM_ON);
-    } else if (strcmp(role, "system") == 0) {
-        // 为系统消息创建全宽容器以确保居中对齐
-        lv_obj_t* container = lv_obj_create(content_);
-        lv_obj_set_width(container, LV_HOR_RES);
-        lv_obj_set_height(container, LV_SIZE_CONTENT);
-        
-        // 使容器透明且无边框
-        lv_obj_set_style_bg_opa(container, LV_OPA_TRANSP, 0);
-        lv_obj_set_style_border_width(container, 0, 0);
-        lv_obj_set_style_pad_all(container, 0, 0);
-        
-        // 将消息气泡移入此容器
-        lv_obj_set_parent(msg_bubble, container);
-        
-        // 将气泡居中对齐在容器中
-        lv_obj_align(msg_bubble, LV_ALIGN_CENTER, 0, 0);
-        
-        // 自动滚动底部
-        lv_obj_scroll_to_view_recursive(container, LV_ANIM_ON);
-    } else {
-        // For assistant messages
-        // Left align assistant messages
-        lv_obj_align(msg_bubble, LV_ALIGN_LEFT_MID, 0, 0);
 
-        // Auto-scroll to the message bubble
-        lv_obj_scroll_to_view_recursive(msg_bubble, LV_ANIM_ON);
+    ChatRole chat_role;
+    if (!ParseChatRole(role, chat_role) || chat_records_.empty() || chat_records_.back().role != chat_role) {
+        SetChatMessage(role, content);
+        return;
     }
-    
-    // Store reference to the latest message label
-    chat_message_label_ = msg_text;
+
+    auto& record = chat_records_.back();
+    size_t old_length = strlen(record.text.get());
+    size_t length = strlen(content);
+    char* text = (char*)heap_caps_realloc_prefer(record.text.get(), old_length + length + 1, 2,
+        MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT);
+    if (text == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate chat message");
+        return;
+    }
+    record.text.release();
+    record.text.reset(text);
+    memcpy(text + old_length, content, length + 1);
+    record.text_width += lv_txt_get_width(content, length, fonts_.text_font, 0);
+
+    // 正在查看较早的记录时，最后一条没有绑定到行上
+    size_t bound = BoundChatRowCount();
+    if (chat_window_start_ + bound != chat_records_.size()) {
+        return;
+    }
+    auto& row = chat_rows_[bound - 1];
+    lv_coord_t max_width = LV_HOR_RES * 85 / 100 - 16;  // 屏幕宽度的85%
+    lv_coord_t width = std::clamp<lv_coord_t>(record.text_width, 20, max_width);
+    if (lv_obj_get_width(row.label) != width) {
+        lv_obj_set_width(row.label, width);
+    }
+    lv_label_ins_text(row.label, LV_LABEL_POS_LAST, content);
+    lv_obj_scroll_to_view_recursive(row.container, LV_ANIM_OFF);
 }
 #else
 void LcdDisplay::SetupUI() {
@@ -695,12 +825,19 @@ void LcdDisplay::SetEmotion(const char* emotion) {
         return;
     }
 
+    // 没有表情字体时（例如 assets 分区中没有表情图片）显示 Font Awesome 图标
+    if (fonts_.emoji_font == nullptr) {
+        SetEmotionFont(&font_awesome_30_4);
+        Display::SetEmotion(emotion);
+        return;
+    }
+
     // 如果找到匹配的表情就显示对应图标，否则显示默认的neutral表情
-    lv_obj_set_style_text_font(emotion_label_, fonts_.emoji_font, 0);
+    SetEmotionFont(fonts_.emoji_font);
     if (it != emotions.end()) {
-        lv_label_set_text(emotion_label_, it->icon);
+        SetLabelText(emotion_label_, it->icon);
     } else {
-        lv_label_set_text(emotion_label_, "😶");
+        SetLabelText(emotion_label_, "😶");
     }
 }
 
@@ -709,8 +846,15 @@ void LcdDisplay::SetIcon(const char* icon) {
     if (emotion_label_ == nullptr) {
         return;
     }
-    lv_obj_set_style_text_font(emotion_label_, &font_awesome_30_4, 0);
-    lv_label_set_text(emotion_label_, icon);
+    SetEmotionFont(&font_awesome_30_4);
+    SetLabelText(emotion_label_, icon);
+}
+
+// 设置相同的字体也会刷新样式并重新布局
+void LcdDisplay::SetEmotionFont(const lv_font_t* font) {
+    if (lv_obj_get_style_text_font(emotion_label_, LV_PART_MAIN) != font) {
+        lv_obj_set_style_text_font(emotion_label_, font, 0);
+    }
 }
 
 void LcdDisplay::SetTheme(const std::string& theme_name) {
@@ -772,117 +916,9 @@ void LcdDisplay::SetTheme(const std::string& theme_name) {
         
         // If we have the chat message style, update all message bubbles
 #if CONFIG_USE_WECHAT_MESSAGE_STYLE
-        // Iterate through all children of content (message containers or bubbles)
-        uint32_t child_count = lv_obj_get_child_cnt(content_);
-        for (uint32_t i = 0; i < child_count; i++) {
-            lv_obj_t* obj = lv_obj_get_child(content_, i);
-            if (obj == nullptr) continue;
-            
-            lv_obj_t* bubble = nullptr;
-            
-            // 检查这个对象是容器还是气泡
-            // 如果是容器（用户或系统消息），则获取其子对象作为气泡
-            // 如果是气泡（助手消息），则直接使用
-            if (lv_obj_get_child_cnt(obj) > 0) {
-                // 可能是容器，检查它是否为用户或系统消息容器
-                // 用户和系统消息容器是透明的
-                lv_opa_t bg_opa = lv_obj_get_style_bg_opa(obj, 0);
-                if (bg_opa == LV_OPA_TRANSP) {
-                    // 这是用户或系统消息的容器
-                    bubble = lv_obj_get_child(obj, 0);
-                } else {
-                    // 这可能是助手消息的气泡自身
-                    bubble = obj;
-                }
-            } else {
-                // 没有子元素，可能是其他UI元素，跳过
-                continue;
-            }
-            
-            if (bubble == nullptr) continue;
-            
-            // 使用保存的用户数据来识别气泡类型
-            void* bubble_type_ptr = lv_obj_get_user_data(bubble);
-            if (bubble_type_ptr != nullptr) {
-                const char* bubble_type = static_cast<const char*>(bubble_type_ptr);
-                
-                // 根据气泡类型应用正确的颜色
-                if (strcmp(bubble_type, "user") == 0) {
-                    lv_obj_set_style_bg_color(bubble, current_theme.user_bubble, 0);
-                } else if (strcmp(bubble_type, "assistant") == 0) {
-                    lv_obj_set_style_bg_color(bubble, current_theme.assistant_bubble, 0); 
-                } else if (strcmp(bubble_type, "system") == 0) {
-                    lv_obj_set_style_bg_color(bubble, current_theme.system_bubble, 0);
-                }
-                
-                // Update border color
-                lv_obj_set_style_border_color(bubble, current_theme.border, 0);
-                
-                // Update text color for the message
-                if (lv_obj_get_child_cnt(bubble) > 0) {
-                    lv_obj_t* text = lv_obj_get_child(bubble, 0);
-                    if (text != nullptr) {
-                        // 根据气泡类型设置文本颜色
-                        if (strcmp(bubble_type, "system") == 0) {
-                            lv_obj_set_style_text_color(text, current_theme.system_text, 0);
-                        } else {
-                            lv_obj_set_style_text_color(text, current_theme.text, 0);
-                        }
-                    }
-                }
-            } else {
-                // 如果没有标记，回退到之前的逻辑（颜色比较）
-                // ...保留原有的回退逻辑...
-                lv_color_t bg_color = lv_obj_get_style_bg_color(bubble, 0);
-            
-                // 改进bubble类型检测逻辑，不仅使用颜色比较
-                bool is_user_bubble = false;
-                bool is_assistant_bubble = false;
-                bool is_system_bubble = false;
-            
-                // 检查用户bubble
-                if (lv_color_eq(bg_color, DARK_USER_BUBBLE_COLOR) || 
-                    lv_color_eq(bg_color, LIGHT_USER_BUBBLE_COLOR) ||
-                    lv_color_eq(bg_color, current_theme.user_bubble)) {
-                    is_user_bubble = true;
-                }
-                // 检查系统bubble
-                else if (lv_color_eq(bg_color, DARK_SYSTEM_BUBBLE_COLOR) || 
-                         lv_color_eq(bg_color, LIGHT_SYSTEM_BUBBLE_COLOR) ||
-                         lv_color_eq(bg_color, current_theme.system_bubble)) {
-                    is_system_bubble = true;
-                }
-                // 剩余的都当作助手bubble处理
-                else {
-                    is_assistant_bubble = true;
-                }
-            
-                // 根据bubble类型应用正确的颜色
-                if (is_user_bubble) {
-                    lv_obj_set_style_bg_color(bubble, current_theme.user_bubble, 0);
-                } else if (is_assistant_bubble) {
-                    lv_obj_set_style_bg_color(bubble, current_theme.assistant_bubble, 0);
-                } else if (is_system_bubble) {
-                    lv_obj_set_style_bg_color(bubble, current_theme.system_bubble, 0);
-                }
-                
-                // Update border color
-                lv_obj_set_style_border_color(bubble, current_theme.border, 0);
-                
-                // Update text color for the message
-                if (lv_obj_get_child_cnt(bubble) > 0) {
-                    lv_obj_t* text = lv_obj_get_child(bubble, 0);
-                    if (text != nullptr) {
-                        // 回退到颜色检测逻辑
-                        if (lv_color_eq(bg_color, current_theme.system_bubble) ||
-                            lv_color_eq(bg_color, DARK_SYSTEM_BUBBLE_COLOR) || 
-                            lv_color_eq(bg_color, LIGHT_SYSTEM_BUBBLE_COLOR)) {
-                            lv_obj_set_style_text_color(text, current_theme.system_text, 0);
-                        } else {
-                            lv_obj_set_style_text_color(text, current_theme.text, 0);
-                        }
-                    }
-                }
+        for (auto& row : chat_rows_) {
+            if (row.role >= 0) {
+                StyleChatRow(row);
             }
         }
 #else
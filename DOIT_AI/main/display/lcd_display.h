@@ -8,6 +8,9 @@
 #include <font_emoji.h>
 
 #include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
 
 class LcdDisplay : public Display {
 protected:
@@ -22,14 +25,61 @@ protected:
 
     DisplayFonts fonts_;
 
+#if CONFIG_DISPLAY_REFRESH_STATS_INTERVAL > 0
+    // 刷新统计：渲染的帧数和送到屏幕的字节数
+    uint32_t refresh_frames_ = 0;
+    uint64_t refresh_bytes_ = 0;
+    int64_t refresh_stats_time_ = 0;
+
+    void InitializeRefreshStats();
+    virtual void Update() override;
+#endif
+
+#if CONFIG_USE_WECHAT_MESSAGE_STYLE
+    enum ChatRole {
+        kChatRoleUser,
+        kChatRoleAssistant,
+        kChatRoleSystem,
+    };
+
+    // 一条聊天记录，文字优先保存在 PSRAM，文字宽度只在收到或追加文字时测量新增的部分
+    struct ChatRecord {
+        ChatRole role;
+        std::unique_ptr<char, void (*)(void*)> text;
+        lv_coord_t text_width;
+    };
+
+    // 复用的一行消息：全宽透明容器 + 气泡 + 文字
+    struct ChatRow {
+        lv_obj_t* container = nullptr;
+        lv_obj_t* bubble = nullptr;
+        lv_obj_t* label = nullptr;
+        int role = -1;
+    };
+
+    std::deque<ChatRecord> chat_records_;
+    // 按显示顺序排列，和 content_ 的子对象顺序一致
+    std::vector<ChatRow> chat_rows_;
+    // 第一行显示的记录在 chat_records_ 中的位置
+    size_t chat_window_start_ = 0;
+
+    static bool ParseChatRole(const char* role, ChatRole& chat_role);
+    void CreateChatRow(ChatRow& row);
+    void BindChatRow(ChatRow& row, const ChatRecord& record);
+    void StyleChatRow(ChatRow& row);
+    void BindChatWindow(size_t start);
+    size_t BoundChatRowCount() const;
+    void OnChatScrollEnd();
+#endif
+
     void SetupUI();
+    void SetEmotionFont(const lv_font_t* font);
     virtual bool Lock(int timeout_ms = 0) override;
     virtual void Unlock() override;
 
 protected:
     // 添加protected构造函数
-    LcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handle_t panel, DisplayFonts fonts)
-        : panel_io_(panel_io), panel_(panel), fonts_(fonts) {}
+    LcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handle_t panel, DisplayFonts fonts);
     
 public:
     ~LcdDisplay();
@@ -37,6 +87,7 @@ public:
     virtual void SetIcon(const char* icon) override;
 #if CONFIG_USE_WECHAT_MESSAGE_STYLE
     virtual void SetChatMessage(const char* role, const char* content) override; 
+    virtual void AppendChatMessage(const char* role, const char* content) override;
 #endif  
 
     // Add theme switching function
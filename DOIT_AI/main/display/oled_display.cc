@@ -1,6 +1,7 @@
 #include "oled_display.h"
 #include "font_awesome_symbols.h"
 #include "assets/lang_config.h"
+#include "glyph_cache.h"
 
 #include <string>
 #include <algorithm>
@@ -16,6 +17,10 @@ LV_FONT_DECLARE(font_awesome_30_1);
 OledDisplay::OledDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handle_t panel,
     int width, int height, bool mirror_x, bool mirror_y, DisplayFonts fonts)
     : panel_io_(panel_io), panel_(panel), fonts_(fonts) {
+#if CONFIG_GLYPH_CACHE_SIZE_KB > 0
+    fonts_.text_font = GlyphCache::GetInstance().Wrap(fonts_.text_font);
+    fonts_.icon_font = GlyphCache::GetInstance().Wrap(fonts_.icon_font);
+#endif
     width_ = width;
     height_ = height;
 
@@ -96,6 +101,7 @@ void OledDisplay::Unlock() {
 
 void OledDisplay::SetChatMessage(const char* role, const char* content) {
     DisplayLockGuard lock(this);
+    FinishTyping();
     if (chat_message_label_ == nullptr) {
         return;
     }
@@ -105,17 +111,27 @@ void OledDisplay::SetChatMessage(const char* role, const char* content) {
     std::replace(content_str.begin(), content_str.end(), '\n', ' ');
 
     if (content_right_ == nullptr) {
-        lv_label_set_text(chat_message_label_, content_str.c_str());
+        SetLabelText(chat_message_label_, content_str.c_str());
     } else {
         if (content == nullptr || content[0] == '\0') {
-            lv_obj_add_flag(content_right_, LV_OBJ_FLAG_HIDDEN);
+            SetHidden(content_right_, true);
         } else {
-            lv_label_set_text(chat_message_label_, content_str.c_str());
-            lv_obj_clear_flag(content_right_, LV_OBJ_FLAG_HIDDEN);
+            SetLabelText(chat_message_label_, content_str.c_str());
+            SetHidden(content_right_, false);
         }
     }
 }
 
+void OledDisplay::AppendChatMessage(const char* role, const char* content) {
+    DisplayLockGuard lock(this);
+    if (chat_message_label_ == nullptr || content[0] == '\0') {
+        return;
+    }
+    std::string content_str = content;
+    std::replace(content_str.begin(), content_str.end(), '\n', ' ');
+    lv_label_ins_text(chat_message_label_, LV_LABEL_POS_LAST, content_str.c_str());
+}
+
 void OledDisplay::SetupUI_128x64() {
     DisplayLockGuard lock(this);
 
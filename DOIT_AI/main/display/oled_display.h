@@ -32,6 +32,7 @@ public:
     ~OledDisplay();
 
     virtual void SetChatMessage(const char* role, const char* content) override;
+    virtual void AppendChatMessage(const char* role, const char* content) override;
 };
 
 #endif // OLED_DISPLAY_H
@@ -0,0 +1,17 @@
+#ifndef HASH_NAME_H
+#define HASH_NAME_H
+
+#include <cstdint>
+#include <string_view>
+
+// FNV-1a，在编译期计算消息类型、Thing、属性和方法名称的哈希，运行时用 switch 或哈希表代替字符串比较
+constexpr uint32_t HashName(std::string_view name) {
+    uint32_t hash = 2166136261u;
+    for (char c : name) {
+        hash ^= (uint8_t)c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+#endif // HASH_NAME_H
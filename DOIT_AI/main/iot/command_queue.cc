@@ -0,0 +1,100 @@
+#include "command_queue.h"
+#include "application.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#define TAG "CommandQueue"
+
+#define IOT_WORKER_PRIORITY 1
+
+namespace iot {
+
+void CommandQueue::Enqueue(std::list<Command>& commands, uint32_t key, std::function<void()>&& callback) {
+    int64_t now = esp_timer_get_time();
+    if (key != 0) {
+        for (auto& command : commands) {
+            if (command.key == key) {
+                // 保留原来的排队位置和时间，只替换为最新的参数
+                ESP_LOGD(TAG, "Coalesced command 0x%08lx", (unsigned long)key);
+                command.callback = std::move(callback);
+                return;
+            }
+        }
+    }
+    commands.push_back({key, now, std::move(callback)});
+}
+
+void CommandQueue::Execute(std::list<Command>& commands) {
+    for (auto& command : commands) {
+        int64_t start = esp_timer_get_time();
+        command.callback();
+        ESP_LOGD(TAG, "Command 0x%08lx: queued %lld us, executed %lld us", (unsigned long)command.key,
+            (long long)(start - command.post_time), (long long)(esp_timer_get_time() - start));
+    }
+}
+
+void CommandQueue::Post(ThingExecutor executor, uint32_t key, std::function<void()> callback) {
+    if (executor == kThingExecutorInline) {
+        callback();
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (executor == kThingExecutorWorker) {
+        if (worker_task_handle_ == nullptr) {
+            xTaskCreate([](void* arg) {
+                auto queue = static_cast<CommandQueue*>(arg);
+                queue->WorkerLoop();
+            }, "iot_worker", CONFIG_IOT_WORKER_TASK_STACK_SIZE, this, IOT_WORKER_PRIORITY, &worker_task_handle_);
+        }
+        Enqueue(worker_commands_, key, std::move(callback));
+        condition_variable_.notify_all();
+        return;
+    }
+
+    Enqueue(main_loop_commands_, key, std::move(callback));
+    // 主循环中只保留一个待执行的任务，执行时取走当时队列里的全部命令
+    if (!main_loop_scheduled_) {
+        main_loop_scheduled_ = true;
+        Application::GetInstance().Schedule([this]() {
+            RunMainLoopCommands();
+        });
+    }
+}
+
+void CommandQueue::RunMainLoopCommands() {
+    std::list<Command> commands;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        commands = std::move(main_loop_commands_);
+        main_loop_commands_.clear();
+        main_loop_scheduled_ = false;
+    }
+    Execute(commands);
+}
+
+void CommandQueue::WorkerLoop() {
+    ESP_LOGI(TAG, "iot_worker started");
+    UBaseType_t min_free_stack = CONFIG_IOT_WORKER_TASK_STACK_SIZE;
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_variable_.wait(lock, [this]() { return !worker_commands_.empty(); });
+
+        std::list<Command> commands = std::move(worker_commands_);
+        worker_commands_.clear();
+        lock.unlock();
+
+        Execute(commands);
+
+        // 记录栈剩余量的最小值，用于确认 CONFIG_IOT_WORKER_TASK_STACK_SIZE 是否合适
+        UBaseType_t free_stack = uxTaskGetStackHighWaterMark(nullptr);
+        if (free_stack < min_free_stack) {
+            min_free_stack = free_stack;
+            ESP_LOGI(TAG, "iot_worker stack high water mark: %u of %u bytes free", free_stack,
+                CONFIG_IOT_WORKER_TASK_STACK_SIZE);
+        }
+    }
+}
+
+} // namespace iot
@@ -0,0 +1,63 @@
+#ifndef IOT_COMMAND_QUEUE_H
+#define IOT_COMMAND_QUEUE_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <condition_variable>
+
+namespace iot {
+
+// 设备方法在哪里执行
+enum ThingExecutor {
+    kThingExecutorMainLoop,  // 主循环，可能排在 SetDeviceState、播放提示音之后
+    kThingExecutorInline,    // 收到命令的协议线程中直接执行，只适合很快且线程安全的操作
+    kThingExecutorWorker     // 独立的低优先级 IoT 任务
+};
+
+/*
+ * IoT 命令队列
+ * 同一个 key 的命令在尚未执行时会被后来的命令替换，连续调节音量、亮度时只执行最后一次
+ */
+class CommandQueue {
+public:
+    static CommandQueue& GetInstance() {
+        static CommandQueue instance;
+        return instance;
+    }
+    CommandQueue(const CommandQueue&) = delete;
+    CommandQueue& operator=(const CommandQueue&) = delete;
+
+    // key 为 0 表示不合并
+    void Post(ThingExecutor executor, uint32_t key, std::function<void()> callback);
+
+private:
+    CommandQueue() = default;
+    ~CommandQueue() = default;
+
+    struct Command {
+        uint32_t key;
+        int64_t post_time;
+        std::function<void()> callback;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable condition_variable_;
+    std::list<Command> main_loop_commands_;
+    std::list<Command> worker_commands_;
+    bool main_loop_scheduled_ = false;
+    TaskHandle_t worker_task_handle_ = nullptr;
+
+    static void Enqueue(std::list<Command>& commands, uint32_t key, std::function<void()>&& callback);
+    static void Execute(std::list<Command>& commands);
+    void RunMainLoopCommands();
+    void WorkerLoop();
+};
+
+} // namespace iot
+
+#endif // IOT_COMMAND_QUEUE_H
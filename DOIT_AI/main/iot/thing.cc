@@ -1,5 +1,5 @@
 #include "thing.h"
-#include "application.h"
+#include "thing_schema.h"
 
 #include <esp_log.h>
 
@@ -36,42 +36,162 @@ std::string Thing::GetDescriptorJson() {
     return json_str;
 }
 
+size_t Thing::GetPropertyCount() {
+    return properties_.size();
+}
+
+const char* Thing::GetPropertyName(size_t index) {
+    return properties_.at(index).name().c_str();
+}
+
+bool Thing::IsPropertyObservable(size_t index) {
+    return properties_.at(index).observable();
+}
+
+std::string Thing::GetPropertyValueJson(size_t index) {
+    return properties_.at(index).GetStateJson();
+}
+
 std::string Thing::GetStateJson() {
+    size_t count = GetPropertyCount();
+    changed_properties_.store(0);
+    last_values_.resize(count);
+
     std::string json_str = "{";
     json_str += "\"name\":\"" + name_ + "\",";
-    json_str += "\"state\":" + properties_.GetStateJson();
-    json_str += "}";
+    json_str += "\"state\":{";
+    for (size_t i = 0; i < count; ++i) {
+        last_values_[i] = GetPropertyValueJson(i);
+        if (i > 0) {
+            json_str += ",";
+        }
+        json_str += "\"";
+        json_str += GetPropertyName(i);
+        json_str += "\":" + last_values_[i];
+    }
+    json_str += "}}";
     return json_str;
 }
 
+bool Thing::GetStateDeltaJson(std::string& json) {
+    size_t count = GetPropertyCount();
+    if (last_values_.size() != count) {
+        json = GetStateJson();
+        return true;
+    }
+
+    uint32_t changed = changed_properties_.exchange(0);
+    std::string state;
+    for (size_t i = 0; i < count; ++i) {
+        // 没有通知变化的可观察属性不调用 getter
+        if (i < 32 && IsPropertyObservable(i) && !(changed & (1u << i))) {
+            continue;
+        }
+        auto value = GetPropertyValueJson(i);
+        if (value == last_values_[i]) {
+            continue;
+        }
+        if (!state.empty()) {
+            state += ",";
+        }
+        state += "\"";
+        state += GetPropertyName(i);
+        state += "\":" + value;
+        last_values_[i] = std::move(value);
+    }
+    if (state.empty()) {
+        return false;
+    }
+    json = "{\"name\":\"" + name_ + "\",\"state\":{" + state + "}}";
+    return true;
+}
+
+void Thing::NotifyPropertyChanged(size_t index) {
+    if (index < 32) {
+        changed_properties_.fetch_or(1u << index);
+    }
+    if (on_state_changed_) {
+        on_state_changed_();
+    }
+}
+
+void Thing::NotifyPropertyChanged(const std::string& name) {
+    size_t count = GetPropertyCount();
+    for (size_t i = 0; i < count; ++i) {
+        if (name == GetPropertyName(i)) {
+            NotifyPropertyChanged(i);
+            return;
+        }
+    }
+    ESP_LOGW(TAG, "Property not found: %s", name.c_str());
+}
+
 void Thing::Invoke(const cJSON* command) {
     auto method_name = cJSON_GetObjectItem(command, "method");
     auto input_params = cJSON_GetObjectItem(command, "parameters");
+    if (!cJSON_IsString(method_name)) {
+        ESP_LOGE(TAG, "Invalid command for %s", name_.c_str());
+        return;
+    }
 
-    try {
-        auto& method = methods_[method_name->valuestring];
-        for (auto& param : method.parameters()) {
-            auto input_param = cJSON_GetObjectItem(input_params, param.name().c_str());
-            if (param.required() && input_param == nullptr) {
-                throw std::runtime_error("Parameter " + param.name() + " is required");
-            }
-            if (param.type() == kValueTypeNumber) {
-                param.set_number(input_param->valueint);
-            } else if (param.type() == kValueTypeString) {
-                param.set_string(input_param->valuestring);
-            } else if (param.type() == kValueTypeBoolean) {
-                param.set_boolean(input_param->valueint == 1);
-            }
-        }
-
-        Application::GetInstance().Schedule([&method]() {
-            method.Invoke();
-        });
-    } catch (const std::runtime_error& e) {
+    auto method = methods_.Find(method_name->valuestring);
+    if (method == nullptr) {
         ESP_LOGE(TAG, "Method not found: %s", method_name->valuestring);
         return;
     }
+
+    // 每次调用填充一份参数副本，避免连续的命令在执行前互相覆盖参数
+    ParameterList parameters = method->parameters();
+    for (auto& param : parameters) {
+        auto input_param = cJSON_GetObjectItem(input_params, param.name().c_str());
+        if (input_param == nullptr) {
+            if (param.required()) {
+                ESP_LOGE(TAG, "Method %s: parameter %s is required", method_name->valuestring, param.name().c_str());
+                return;
+            }
+            continue;
+        }
+        if (param.type() == kValueTypeNumber) {
+            param.set_number(input_param->valueint);
+        } else if (param.type() == kValueTypeString) {
+            param.set_string(cJSON_IsString(input_param) ? input_param->valuestring : "");
+        } else if (param.type() == kValueTypeBoolean) {
+            param.set_boolean(cJSON_IsTrue(input_param) || input_param->valueint == 1);
+        }
+    }
+
+    uint32_t key = method->coalesce() ? GetCommandKey(method->hash()) : 0;
+    CommandQueue::GetInstance().Post(executor_, key, [method, parameters = std::move(parameters)]() {
+        method->Invoke(parameters);
+    });
 }
 
+void InvokeStaticMethod(const char* method_name, const cJSON* input_params, const ParameterSchema* parameters,
+    size_t parameter_count, ThingExecutor executor, uint32_t key, std::function<void(const ParameterList&)> callback) {
+    // 每次调用都构造独立的参数表，回调按值持有
+    ParameterList parameter_list;
+    for (size_t i = 0; i < parameter_count; ++i) {
+        auto& schema = parameters[i];
+        Parameter param(schema.name, "", schema.type, schema.required);
+        auto input_param = cJSON_GetObjectItem(input_params, schema.name);
+        if (input_param == nullptr) {
+            if (schema.required) {
+                ESP_LOGE(TAG, "Method %s: parameter %s is required", method_name, schema.name);
+                return;
+            }
+        } else if (schema.type == kValueTypeNumber) {
+            param.set_number(input_param->valueint);
+        } else if (schema.type == kValueTypeString) {
+            param.set_string(cJSON_IsString(input_param) ? input_param->valuestring : "");
+        } else if (schema.type == kValueTypeBoolean) {
+            param.set_boolean(cJSON_IsTrue(input_param) || input_param->valueint == 1);
+        }
+        parameter_list.AddParameter(param);
+    }
+
+    CommandQueue::GetInstance().Post(executor, key, [callback, parameter_list = std::move(parameter_list)]() {
+        callback(parameter_list);
+    });
+}
 
 } // namespace iot
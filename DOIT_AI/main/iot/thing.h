@@ -6,8 +6,12 @@
 #include <functional>
 #include <vector>
 #include <stdexcept>
+#include <atomic>
 #include <cJSON.h>
 
+#include "hash_name.h"
+#include "command_queue.h"
+
 namespace iot {
 
 enum ValueType {
@@ -19,23 +23,29 @@ enum ValueType {
 class Property {
 private:
     std::string name_;
+    uint32_t hash_;
     std::string description_;
     ValueType type_;
+    bool observable_ = false;
     std::function<bool()> boolean_getter_;
     std::function<int()> number_getter_;
     std::function<std::string()> string_getter_;
 
 public:
     Property(const std::string& name, const std::string& description, std::function<bool()> getter) :
-        name_(name), description_(description), type_(kValueTypeBoolean), boolean_getter_(getter) {}
+        name_(name), hash_(HashName(name)), description_(description), type_(kValueTypeBoolean), boolean_getter_(getter) {}
     Property(const std::string& name, const std::string& description, std::function<int()> getter) :
-        name_(name), description_(description), type_(kValueTypeNumber), number_getter_(getter) {}
+        name_(name), hash_(HashName(name)), description_(description), type_(kValueTypeNumber), number_getter_(getter) {}
     Property(const std::string& name, const std::string& description, std::function<std::string()> getter) :
-        name_(name), description_(description), type_(kValueTypeString), string_getter_(getter) {}
+        name_(name), hash_(HashName(name)), description_(description), type_(kValueTypeString), string_getter_(getter) {}
 
     const std::string& name() const { return name_; }
+    uint32_t hash() const { return hash_; }
     const std::string& description() const { return description_; }
     ValueType type() const { return type_; }
+    // 可观察属性只在设备调用 NotifyPropertyChanged 后才重新读取
+    bool observable() const { return observable_; }
+    void set_observable(bool observable) { observable_ = observable; }
 
     bool boolean() const { return boolean_getter_(); }
     int number() const { return number_getter_(); }
@@ -85,13 +95,37 @@ public:
         properties_.push_back(Property(name, description, getter));
     }
 
-    const Property& operator[](const std::string& name) const {
-        for (auto& property : properties_) {
-            if (property.name() == name) {
-                return property;
+    int IndexOf(const std::string& name) const {
+        uint32_t hash = HashName(name);
+        for (size_t i = 0; i < properties_.size(); ++i) {
+            if (properties_[i].hash() == hash && properties_[i].name() == name) {
+                return i;
             }
         }
-        throw std::runtime_error("Property not found: " + name);
+        return -1;
+    }
+
+    const Property* Find(const std::string& name) const {
+        int index = IndexOf(name);
+        return index < 0 ? nullptr : &properties_[index];
+    }
+
+    void SetObservable(const std::string& name, bool observable = true) {
+        int index = IndexOf(name);
+        if (index >= 0) {
+            properties_[index].set_observable(observable);
+        }
+    }
+
+    size_t size() const { return properties_.size(); }
+    Property& at(size_t index) { return properties_[index]; }
+
+    const Property& operator[](const std::string& name) const {
+        auto property = Find(name);
+        if (property == nullptr) {
+            throw std::runtime_error("Property not found: " + name);
+        }
+        return *property;
     }
 
     std::string GetDescriptorJson() {
@@ -122,18 +156,20 @@ public:
 class Parameter {
 private:
     std::string name_;
+    uint32_t hash_;
     std::string description_;
     ValueType type_;
     bool required_;
-    bool boolean_;
-    int number_;
+    bool boolean_ = false;
+    int number_ = 0;
     std::string string_;
 
 public:
     Parameter(const std::string& name, const std::string& description, ValueType type, bool required = true) :
-        name_(name), description_(description), type_(type), required_(required) {}
+        name_(name), hash_(HashName(name)), description_(description), type_(type), required_(required) {}
 
     const std::string& name() const { return name_; }
+    uint32_t hash() const { return hash_; }
     const std::string& description() const { return description_; }
     ValueType type() const { return type_; }
     bool required() const { return required_; }
@@ -172,18 +208,29 @@ public:
         parameters_.push_back(parameter);
     }
 
-    const Parameter& operator[](const std::string& name) const {
+    const Parameter* Find(const std::string& name) const {
+        uint32_t hash = HashName(name);
         for (auto& parameter : parameters_) {
-            if (parameter.name() == name) {
-                return parameter;
+            if (parameter.hash() == hash && parameter.name() == name) {
+                return &parameter;
             }
         }
-        throw std::runtime_error("Parameter not found: " + name);
+        return nullptr;
+    }
+
+    const Parameter& operator[](const std::string& name) const {
+        auto parameter = Find(name);
+        if (parameter == nullptr) {
+            throw std::runtime_error("Parameter not found: " + name);
+        }
+        return *parameter;
     }
 
     // iterator
     auto begin() { return parameters_.begin(); }
     auto end() { return parameters_.end(); }
+    auto begin() const { return parameters_.begin(); }
+    auto end() const { return parameters_.end(); }
 
     std::string GetDescriptorJson() {
         std::string json_str = "{";
@@ -201,17 +248,24 @@ public:
 class Method {
 private:
     std::string name_;
+    uint32_t hash_;
     std::string description_;
     ParameterList parameters_;
     std::function<void(const ParameterList&)> callback_;
+    bool coalesce_ = false;
 
 public:
     Method(const std::string& name, const std::string& description, const ParameterList& parameters, std::function<void(const ParameterList&)> callback) :
-        name_(name), description_(description), parameters_(parameters), callback_(callback) {}
+        name_(name), hash_(HashName(name)), description_(description), parameters_(parameters), callback_(callback) {}
 
     const std::string& name() const { return name_; }
+    uint32_t hash() const { return hash_; }
     const std::string& description() const { return description_; }
     ParameterList& parameters() { return parameters_; }
+    const ParameterList& parameters() const { return parameters_; }
+    // 整体覆盖状态的方法（如设置音量），连续调用时只需要执行最后一次
+    bool coalesce() const { return coalesce_; }
+    void set_coalesce(bool coalesce) { coalesce_ = coalesce; }
 
     std::string GetDescriptorJson() {
         std::string json_str = "{";
@@ -224,6 +278,11 @@ public:
     void Invoke() {
         callback_(parameters_);
     }
+
+    // 使用调用方填好的参数副本，连续的命令之间互不影响
+    void Invoke(const ParameterList& parameters) const {
+        callback_(parameters);
+    }
 };
 
 class MethodList {
@@ -238,13 +297,22 @@ public:
         methods_.push_back(Method(name, description, parameters, callback));
     }
 
-    Method& operator[](const std::string& name) {
+    Method* Find(const char* name) {
+        uint32_t hash = HashName(name);
         for (auto& method : methods_) {
-            if (method.name() == name) {
-                return method;
+            if (method.hash() == hash && method.name() == name) {
+                return &method;
             }
         }
-        throw std::runtime_error("Method not found: " + name);
+        return nullptr;
+    }
+
+    Method& operator[](const std::string& name) {
+        auto method = Find(name.c_str());
+        if (method == nullptr) {
+            throw std::runtime_error("Method not found: " + name);
+        }
+        return *method;
     }
 
     std::string GetDescriptorJson() {
@@ -263,23 +331,51 @@ public:
 class Thing {
 public:
     Thing(const std::string& name, const std::string& description) :
-        name_(name), description_(description) {}
+        name_(name), hash_(HashName(name)), description_(description) {}
     virtual ~Thing() = default;
 
     virtual std::string GetDescriptorJson();
+    // 完整状态，同时作为之后增量比较的基准
     virtual std::string GetStateJson();
+    // 只包含值发生变化的属性，没有变化时返回 false
+    virtual bool GetStateDeltaJson(std::string& json);
     virtual void Invoke(const cJSON* command);
 
+    // 可观察属性的值变化时由设备调用，可以在任意任务中调用
+    void NotifyPropertyChanged(const std::string& name);
+    void OnStateChanged(std::function<void()> callback) { on_state_changed_ = callback; }
+
     const std::string& name() const { return name_; }
+    uint32_t hash() const { return hash_; }
     const std::string& description() const { return description_; }
+    ThingExecutor executor() const { return executor_; }
 
 protected:
     PropertyList properties_;
     MethodList methods_;
+    // 方法的执行位置，默认在主循环中执行
+    ThingExecutor executor_ = kThingExecutorMainLoop;
+
+    // 可合并命令的 key，同一设备的同一方法相同
+    uint32_t GetCommandKey(uint32_t method_hash) const { return (hash_ * 31u + method_hash) | 1u; }
+
+    void NotifyPropertyChanged(size_t index);
+
+    // 属性访问接口，默认基于 properties_，StaticThing 基于编译期的 Schema
+    virtual size_t GetPropertyCount();
+    virtual const char* GetPropertyName(size_t index);
+    virtual bool IsPropertyObservable(size_t index);
+    virtual std::string GetPropertyValueJson(size_t index);
 
 private:
     std::string name_;
+    uint32_t hash_;
     std::string description_;
+    // 上一次发送的属性值，用于生成属性级别的增量
+    std::vector<std::string> last_values_;
+    // 每个可观察属性一位，最多 32 个，超出的属性按轮询处理
+    std::atomic<uint32_t> changed_properties_ = 0;
+    std::function<void()> on_state_changed_;
 };
 
 
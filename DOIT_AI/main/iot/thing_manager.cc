@@ -1,6 +1,9 @@
 #include "thing_manager.h"
+#include "settings.h"
+#include "hash_name.h"
 
 #include <esp_log.h>
+#include <mbedtls/sha256.h>
 
 #define TAG "ThingManager"
 
@@ -8,39 +11,96 @@ namespace iot {
 
 void ThingManager::AddThing(Thing* thing) {
     things_.push_back(thing);
+    thing_index_.emplace(thing->hash(), thing);
+    thing->OnStateChanged([this]() {
+        if (on_state_changed_) {
+            on_state_changed_();
+        }
+    });
+    descriptors_json_.clear();
+    descriptors_hash_.clear();
 }
 
-std::string ThingManager::GetDescriptorsJson() {
-    std::string json_str = "[";
+const std::string& ThingManager::GetDescriptorsJson() {
+    if (!descriptors_json_.empty()) {
+        return descriptors_json_;
+    }
+
+    descriptors_json_ = "[";
     for (auto& thing : things_) {
-        json_str += thing->GetDescriptorJson() + ",";
+        descriptors_json_ += thing->GetDescriptorJson() + ",";
     }
-    if (json_str.back() == ',') {
-        json_str.pop_back();
+    if (descriptors_json_.back() == ',') {
+        descriptors_json_.pop_back();
     }
-    json_str += "]";
-    return json_str;
+    descriptors_json_ += "]";
+    return descriptors_json_;
 }
 
-bool ThingManager::GetStatesJson(std::string& json, bool delta) {
-    if (!delta) {
-        last_states_.clear();
+const std::string& ThingManager::GetDescriptorsHash() {
+    if (!descriptors_hash_.empty()) {
+        return descriptors_hash_;
+    }
+
+    auto& json = GetDescriptorsJson();
+    uint8_t digest[32];
+    mbedtls_sha256((const unsigned char*)json.data(), json.size(), digest, 0);
+    // 取前 8 字节足以识别描述是否变化
+    static const char hex_chars[] = "0123456789abcdef";
+    for (int i = 0; i < 8; i++) {
+        descriptors_hash_.push_back(hex_chars[digest[i] >> 4]);
+        descriptors_hash_.push_back(hex_chars[digest[i] & 0x0f]);
+    }
+    return descriptors_hash_;
+}
+
+bool ThingManager::IsDescriptorsAcknowledged() {
+    if (!acknowledged_hash_loaded_) {
+        Settings settings("iot", false);
+        acknowledged_hash_ = settings.GetString("desc_hash");
+        acknowledged_hash_loaded_ = true;
+    }
+    return acknowledged_hash_ == GetDescriptorsHash();
+}
+
+bool ThingManager::AcknowledgeDescriptors(const std::string& hash) {
+    if (hash != GetDescriptorsHash()) {
+        ESP_LOGW(TAG, "Descriptors hash mismatch, server: %s, local: %s", hash.c_str(), descriptors_hash_.c_str());
+        if (!acknowledged_hash_.empty()) {
+            Settings settings("iot", true);
+            settings.EraseKey("desc_hash");
+            acknowledged_hash_.clear();
+        }
+        acknowledged_hash_loaded_ = true;
+        return false;
+    }
+    if (acknowledged_hash_ != hash) {
+        Settings settings("iot", true);
+        settings.SetString("desc_hash", hash);
+        acknowledged_hash_ = hash;
     }
+    acknowledged_hash_loaded_ = true;
+    return true;
+}
+
+void ThingManager::OnStateChanged(std::function<void()> callback) {
+    on_state_changed_ = callback;
+}
+
+bool ThingManager::GetStatesJson(std::string& json, bool delta) {
     bool changed = false;
     json = "[";
-    // 枚举thing，获取每个thing的state，如果发生变化，则更新，保存到last_states_
-    // 如果delta为true，则只返回变化的部分
+    // 完整状态会刷新每个 thing 的属性基准，增量只包含之后变化的属性
+    std::string state;
     for (auto& thing : things_) {
-        std::string state = thing->GetStateJson();
         if (delta) {
-            // 如果delta为true，则只返回变化的部分
-            auto it = last_states_.find(thing->name());
-            if (it != last_states_.end() && it->second == state) {
+            if (!thing->GetStateDeltaJson(state)) {
                 continue;
             }
-            changed = true;
-            last_states_[thing->name()] = state;
+        } else {
+            state = thing->GetStateJson();
         }
+        changed = true;
         json += state + ",";
     }
     if (json.back() == ',') {
@@ -50,14 +110,31 @@ bool ThingManager::GetStatesJson(std::string& json, bool delta) {
     return changed;
 }
 
-void ThingManager::Invoke(const cJSON* command) {
-    auto name = cJSON_GetObjectItem(command, "name");
+Thing* ThingManager::FindThing(const char* name) {
+    auto it = thing_index_.find(HashName(name));
+    if (it != thing_index_.end() && it->second->name() == name) {
+        return it->second;
+    }
     for (auto& thing : things_) {
-        if (thing->name() == name->valuestring) {
-            thing->Invoke(command);
-            return;
+        if (thing->name() == name) {
+            return thing;
         }
     }
+    return nullptr;
+}
+
+void ThingManager::Invoke(const cJSON* command) {
+    auto name = cJSON_GetObjectItem(command, "name");
+    if (!cJSON_IsString(name)) {
+        ESP_LOGE(TAG, "Invalid command, name is missing");
+        return;
+    }
+    auto thing = FindThing(name->valuestring);
+    if (thing == nullptr) {
+        ESP_LOGE(TAG, "Thing not found: %s", name->valuestring);
+        return;
+    }
+    thing->Invoke(command);
 }
 
 } // namespace iot
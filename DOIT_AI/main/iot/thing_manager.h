@@ -10,6 +10,7 @@
 #include <memory>
 #include <functional>
 #include <map>
+#include <unordered_map>
 
 namespace iot {
 
@@ -24,16 +25,32 @@ public:
 
     void AddThing(Thing* thing);
 
-    std::string GetDescriptorsJson();
+    const std::string& GetDescriptorsJson();
+    const std::string& GetDescriptorsHash();
+    bool IsDescriptorsAcknowledged();
+    // 服务端确认已缓存的描述哈希，与当前不一致时返回 false
+    // 描述相关的接口都不加锁，只能在主任务中调用
+    bool AcknowledgeDescriptors(const std::string& hash);
+    // delta 为 true 时只包含变化的属性，没有变化时返回 false
     bool GetStatesJson(std::string& json, bool delta = false);
+    // 任意可观察属性变化时回调，可能在其他任务中调用
+    void OnStateChanged(std::function<void()> callback);
     void Invoke(const cJSON* command);
+    Thing* FindThing(const char* name);
 
 private:
     ThingManager() = default;
     ~ThingManager() = default;
 
     std::vector<Thing*> things_;
-    std::map<std::string, std::string> last_states_;
+    // 名称哈希到 Thing 的索引，哈希冲突时退回线性查找
+    std::unordered_map<uint32_t, Thing*> thing_index_;
+    std::function<void()> on_state_changed_;
+    // Thing 注册完成后描述不会再变化，只需要生成一次
+    std::string descriptors_json_;
+    std::string descriptors_hash_;
+    std::string acknowledged_hash_;
+    bool acknowledged_hash_loaded_ = false;
 };
 
 
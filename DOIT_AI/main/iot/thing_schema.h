@@ -0,0 +1,274 @@
+#ifndef THING_SCHEMA_H
+#define THING_SCHEMA_H
+
+#include "thing.h"
+#include "hash_name.h"
+
+#include <esp_log.h>
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+/*
+ * 编译期声明的 Thing
+ *
+ * 属性、方法、参数以 constexpr 表的形式描述，名称和描述只是指向 flash 的字符串常量，
+ * 属性的 getter 和方法的回调是普通函数指针。描述 JSON 在编译期生成，作为 char 数组放在 .rodata 中，
+ * 运行时不再构造 PropertyList / MethodList，也不需要每次打开音频通道时重新拼接描述。
+ *
+ * 用法见 iot/things/speaker.cc
+ */
+
+namespace iot {
+
+struct ParameterSchema {
+    const char* name;
+    const char* description;
+    ValueType type;
+    bool required;
+
+    constexpr ParameterSchema(const char* name, const char* description, ValueType type, bool required = true) :
+        name(name), description(description), type(type), required(required) {}
+};
+
+template <typename T>
+struct PropertySchema {
+    const char* name;
+    const char* description;
+    ValueType type;
+    bool (*boolean_getter)(T&) = nullptr;
+    int (*number_getter)(T&) = nullptr;
+    std::string (*string_getter)(T&) = nullptr;
+    // 可观察属性只在设备调用 NotifyPropertyChanged 后才重新读取
+    bool observable = false;
+
+    constexpr PropertySchema(const char* name, const char* description, bool (*getter)(T&), bool observable = false) :
+        name(name), description(description), type(kValueTypeBoolean), boolean_getter(getter), observable(observable) {}
+    constexpr PropertySchema(const char* name, const char* description, int (*getter)(T&), bool observable = false) :
+        name(name), description(description), type(kValueTypeNumber), number_getter(getter), observable(observable) {}
+    constexpr PropertySchema(const char* name, const char* description, std::string (*getter)(T&), bool observable = false) :
+        name(name), description(description), type(kValueTypeString), string_getter(getter), observable(observable) {}
+};
+
+template <typename T>
+struct MethodSchema {
+    const char* name;
+    uint32_t hash;
+    const char* description;
+    const ParameterSchema* parameters = nullptr;
+    size_t parameter_count = 0;
+    void (*callback)(T&, const ParameterList&);
+    // 连续调用时只执行最后一次，见 Method::coalesce()
+    bool coalesce = false;
+
+    constexpr MethodSchema(const char* name, const char* description, void (*callback)(T&, const ParameterList&),
+        bool coalesce = false) :
+        name(name), hash(HashName(name)), description(description), callback(callback), coalesce(coalesce) {}
+    template <size_t N>
+    constexpr MethodSchema(const char* name, const char* description, const ParameterSchema (&parameters)[N],
+        void (*callback)(T&, const ParameterList&), bool coalesce = false) :
+        name(name), hash(HashName(name)), description(description), parameters(parameters), parameter_count(N),
+        callback(callback), coalesce(coalesce) {}
+};
+
+template <typename T>
+struct ThingSchema {
+    const char* name;
+    const char* description;
+    const PropertySchema<T>* properties = nullptr;
+    size_t property_count = 0;
+    const MethodSchema<T>* methods = nullptr;
+    size_t method_count = 0;
+
+    template <size_t N>
+    constexpr ThingSchema(const char* name, const char* description, const PropertySchema<T> (&properties)[N]) :
+        name(name), description(description), properties(properties), property_count(N) {}
+    template <size_t N>
+    constexpr ThingSchema(const char* name, const char* description, const MethodSchema<T> (&methods)[N]) :
+        name(name), description(description), methods(methods), method_count(N) {}
+    template <size_t N, size_t M>
+    constexpr ThingSchema(const char* name, const char* description, const PropertySchema<T> (&properties)[N],
+        const MethodSchema<T> (&methods)[M]) :
+        name(name), description(description), properties(properties), property_count(N), methods(methods), method_count(M) {}
+};
+
+// 描述 JSON 的生成器，out 为 nullptr 时只计算长度，格式与 Thing::GetDescriptorJson() 一致
+class DescriptorWriter {
+public:
+    constexpr explicit DescriptorWriter(char* out) : out_(out) {}
+
+    constexpr size_t length() const { return length_; }
+
+    template <typename T>
+    constexpr DescriptorWriter& Write(const ThingSchema<T>& schema) {
+        Append("{\"name\":");
+        Quoted(schema.name);
+        Append(",\"description\":");
+        Quoted(schema.description);
+        Append(",\"properties\":{");
+        for (size_t i = 0; i < schema.property_count; ++i) {
+            auto& property = schema.properties[i];
+            Member(i, property.name, property.description);
+            Type(property.type);
+            Append("}");
+        }
+        Append("},\"methods\":{");
+        for (size_t i = 0; i < schema.method_count; ++i) {
+            auto& method = schema.methods[i];
+            Member(i, method.name, method.description);
+            Append(",\"parameters\":{");
+            for (size_t j = 0; j < method.parameter_count; ++j) {
+                auto& parameter = method.parameters[j];
+                Member(j, parameter.name, parameter.description);
+                Type(parameter.type);
+                Append("}");
+            }
+            Append("}}");
+        }
+        Append("}}");
+        return *this;
+    }
+
+private:
+    char* out_;
+    size_t length_ = 0;
+
+    constexpr void Put(char c) {
+        if (out_ != nullptr) {
+            out_[length_] = c;
+        }
+        length_++;
+    }
+
+    constexpr void Append(const char* text) {
+        while (*text) {
+            Put(*text++);
+        }
+    }
+
+    constexpr void Quoted(const char* text) {
+        constexpr char hex_chars[] = "0123456789abcdef";
+        Put('"');
+        for (; *text; ++text) {
+            unsigned char c = *text;
+            if (c == '"' || c == '\\') {
+                Put('\\');
+                Put(c);
+            } else if (c < 0x20) {
+                Append("\\u00");
+                Put(hex_chars[c >> 4]);
+                Put(hex_chars[c & 0x0f]);
+            } else {
+                Put(c);
+            }
+        }
+        Put('"');
+    }
+
+    // "name":{"description":"..."
+    constexpr void Member(size_t index, const char* name, const char* description) {
+        if (index > 0) {
+            Put(',');
+        }
+        Quoted(name);
+        Append(":{\"description\":");
+        Quoted(description);
+    }
+
+    constexpr void Type(ValueType type) {
+        if (type == kValueTypeBoolean) {
+            Append(",\"type\":\"boolean\"");
+        } else if (type == kValueTypeNumber) {
+            Append(",\"type\":\"number\"");
+        } else {
+            Append(",\"type\":\"string\"");
+        }
+    }
+};
+
+// 每个 Schema 实例化一次，kJson 是以 '\0' 结尾的常量字符数组
+template <typename T, const ThingSchema<T>& Schema>
+struct ThingDescriptor {
+    static constexpr size_t kLength = DescriptorWriter(nullptr).Write(Schema).length();
+    static constexpr std::array<char, kLength + 1> kJson = [] {
+        std::array<char, kLength + 1> json{};
+        DescriptorWriter(json.data()).Write(Schema);
+        return json;
+    }();
+};
+
+// 按参数表从命令中取出参数，校验通过后交给 executor 执行回调
+void InvokeStaticMethod(const char* method_name, const cJSON* input_params, const ParameterSchema* parameters,
+    size_t parameter_count, ThingExecutor executor, uint32_t key, std::function<void(const ParameterList&)> callback);
+
+/*
+ * 由 ThingSchema 驱动的 Thing，实例只保存 Schema 和描述 JSON 的指针
+ * 子类在 Schema 定义之后再定义构造函数：
+ *     Speaker::Speaker() : StaticThing(kSchema, ThingDescriptor<Speaker, kSchema>::kJson.data()) {}
+ */
+template <typename T>
+class StaticThing : public Thing {
+public:
+    StaticThing(const ThingSchema<T>& schema, const char* descriptor_json) :
+        Thing(schema.name, schema.description), schema_(schema), descriptor_json_(descriptor_json) {}
+
+    std::string GetDescriptorJson() override {
+        return descriptor_json_;
+    }
+
+    void Invoke(const cJSON* command) override {
+        auto method_name = cJSON_GetObjectItem(command, "method");
+        if (!cJSON_IsString(method_name)) {
+            return;
+        }
+        uint32_t hash = HashName(method_name->valuestring);
+        for (size_t i = 0; i < schema_.method_count; ++i) {
+            auto& method = schema_.methods[i];
+            if (method.hash == hash && strcmp(method.name, method_name->valuestring) == 0) {
+                auto callback = method.callback;
+                auto& self = static_cast<T&>(*this);
+                InvokeStaticMethod(method.name, cJSON_GetObjectItem(command, "parameters"), method.parameters,
+                    method.parameter_count, executor_, method.coalesce ? GetCommandKey(method.hash) : 0,
+                    [callback, &self](const ParameterList& parameters) {
+                        callback(self, parameters);
+                    });
+                return;
+            }
+        }
+        ESP_LOGE("Thing", "Method not found: %s", method_name->valuestring);
+    }
+
+protected:
+    size_t GetPropertyCount() override {
+        return schema_.property_count;
+    }
+
+    const char* GetPropertyName(size_t index) override {
+        return schema_.properties[index].name;
+    }
+
+    bool IsPropertyObservable(size_t index) override {
+        return schema_.properties[index].observable;
+    }
+
+    std::string GetPropertyValueJson(size_t index) override {
+        auto& property = schema_.properties[index];
+        auto& self = static_cast<T&>(*this);
+        if (property.type == kValueTypeBoolean) {
+            return property.boolean_getter(self) ? "true" : "false";
+        } else if (property.type == kValueTypeNumber) {
+            return std::to_string(property.number_getter(self));
+        }
+        return "\"" + property.string_getter(self) + "\"";
+    }
+
+private:
+    const ThingSchema<T>& schema_;
+    const char* descriptor_json_;
+};
+
+} // namespace iot
+
+#endif // THING_SCHEMA_H
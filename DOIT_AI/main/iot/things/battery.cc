@@ -1,35 +1,91 @@
-#include "iot/thing.h"
+#include "iot/thing_schema.h"
 #include "board.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
+
+#include <atomic>
 
 #define TAG "Battery"
 
+// 电量在定时器中刷新，状态上报时不再读取电量计
+#define BATTERY_REFRESH_INTERVAL_MS 30000
+
 namespace iot {
 
 // 这里仅定义 Battery 的属性和方法，不包含具体的实现
-class Battery : public Thing {
+class Battery : public StaticThing<Battery> {
 private:
-    int level_ = 0;
-    bool charging_ = false;
-    bool discharging_ = false;
+    // 定时器任务写入，主任务中的 getter 读取
+    std::atomic<int> level_ = 0;
+    std::atomic<bool> charging_ = false;
+    std::atomic<bool> discharging_ = false;
+    std::atomic<bool> refreshed_ = false;
+    esp_timer_handle_t refresh_timer_ = nullptr;
 
-public:
-    Battery() : Thing("Battery", "电池管理") {
-        // 定义设备的属性
-        properties_.AddNumberProperty("level", "当前电量百分比", [this]() -> int {
-            auto& board = Board::GetInstance();
-            if (board.GetBatteryLevel(level_, charging_, discharging_)) {
-                return level_;
-            }
-            return 0;
-        });
-        properties_.AddBooleanProperty("charging", "是否充电中", [this]() -> int {
-            return charging_;
-        });
+    // 构造时 Board 可能还没有初始化完成，第一次读取推迟到上报状态或定时器触发时
+    void Refresh() {
+        int level = 0;
+        bool charging = false, discharging = false;
+        if (!Board::GetInstance().GetBatteryLevel(level, charging, discharging)) {
+            level = 0;
+        }
+        bool first = !refreshed_;
+        discharging_ = discharging;
+        bool level_changed = level_.exchange(level) != level;
+        bool charging_changed = charging_.exchange(charging) != charging;
+        // 先写入数值再标记已刷新，getter 看到 refreshed_ 时一定能读到有效的电量
+        refreshed_ = true;
+        if (level_changed || first) {
+            NotifyPropertyChanged("level");
+        }
+        if (charging_changed || first) {
+            NotifyPropertyChanged("charging");
+        }
     }
+
+    void EnsureRefreshed() {
+        if (!refreshed_) {
+            Refresh();
+        }
+    }
+
+public:
+    Battery();
+
+    static const PropertySchema<Battery> kProperties[];
+    static const ThingSchema<Battery> kSchema;
+};
+
+// 定义设备的属性
+constexpr PropertySchema<Battery> Battery::kProperties[] = {
+    {"level", "当前电量百分比", [](Battery& battery) -> int {
+        battery.EnsureRefreshed();
+        return battery.level_;
+    }, true},
+    {"charging", "是否充电中", [](Battery& battery) -> bool {
+        battery.EnsureRefreshed();
+        return battery.charging_;
+    }, true},
 };
 
+constexpr ThingSchema<Battery> Battery::kSchema = {"Battery", "电池管理", kProperties};
+
+Battery::Battery() : StaticThing(kSchema, ThingDescriptor<Battery, kSchema>::kJson.data()) {
+    esp_timer_create_args_t timer_args = {
+        .callback = [](void* arg) {
+            auto battery = static_cast<Battery*>(arg);
+            battery->Refresh();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "battery_refresh",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &refresh_timer_));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(refresh_timer_, BATTERY_REFRESH_INTERVAL_MS * 1000));
+}
+
 } // namespace iot
 
-DECLARE_THING(Battery);
\ No newline at end of file
+DECLARE_THING(Battery);
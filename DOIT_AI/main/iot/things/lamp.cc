@@ -1,23 +1,26 @@
-#include "iot/thing.h"
+#include "iot/thing_schema.h"
 #include "board.h"
 #include "audio_codec.h"
 
 #include <driver/gpio.h>
 #include <esp_log.h>
 
+#include <atomic>
+
 #define TAG "Lamp"
 
 namespace iot {
 
 // 这里仅定义 Lamp 的属性和方法，不包含具体的实现
-class Lamp : public Thing {
+class Lamp : public StaticThing<Lamp> {
 private:
 #ifdef CONFIG_IDF_TARGET_ESP32
     gpio_num_t gpio_num_ = GPIO_NUM_12;
 #else
     gpio_num_t gpio_num_ = GPIO_NUM_18;
 #endif
-    bool power_ = false;
+    // 命令在协议线程中执行，属性在主循环中读取
+    std::atomic<bool> power_ = false;
 
     void InitializeGpio() {
         gpio_config_t config = {
@@ -31,28 +34,45 @@ private:
         gpio_set_level(gpio_num_, 0);
     }
 
-public:
-    Lamp() : Thing("Lamp", "一个测试用的灯"), power_(false) {
-        InitializeGpio();
-
-        // 定义设备的属性
-        properties_.AddBooleanProperty("power", "灯是否打开", [this]() -> bool {
-            return power_;
-        });
-
-        // 定义设备可以被远程执行的指令
-        methods_.AddMethod("TurnOn", "打开灯", ParameterList(), [this](const ParameterList& parameters) {
-            power_ = true;
-            gpio_set_level(gpio_num_, 1);
-        });
-
-        methods_.AddMethod("TurnOff", "关闭灯", ParameterList(), [this](const ParameterList& parameters) {
-            power_ = false;
-            gpio_set_level(gpio_num_, 0);
-        });
+    void SetPower(bool power) {
+        power_ = power;
+        gpio_set_level(gpio_num_, power ? 1 : 0);
+        NotifyPropertyChanged("power");
     }
+
+public:
+    Lamp();
+
+    static const PropertySchema<Lamp> kProperties[];
+    static const MethodSchema<Lamp> kMethods[];
+    static const ThingSchema<Lamp> kSchema;
 };
 
+// 定义设备的属性
+constexpr PropertySchema<Lamp> Lamp::kProperties[] = {
+    {"power", "灯是否打开", [](Lamp& lamp) -> bool {
+        return lamp.power_;
+    }, true},
+};
+
+// 定义设备可以被远程执行的指令
+constexpr MethodSchema<Lamp> Lamp::kMethods[] = {
+    {"TurnOn", "打开灯", [](Lamp& lamp, const ParameterList& parameters) {
+        lamp.SetPower(true);
+    }},
+    {"TurnOff", "关闭灯", [](Lamp& lamp, const ParameterList& parameters) {
+        lamp.SetPower(false);
+    }},
+};
+
+constexpr ThingSchema<Lamp> Lamp::kSchema = {"Lamp", "一个测试用的灯", kProperties, kMethods};
+
+Lamp::Lamp() : StaticThing(kSchema, ThingDescriptor<Lamp, kSchema>::kJson.data()) {
+    // 只是设置 GPIO，直接在收到命令的线程中执行
+    executor_ = kThingExecutorInline;
+    InitializeGpio();
+}
+
 } // namespace iot
 
 DECLARE_THING(Lamp);
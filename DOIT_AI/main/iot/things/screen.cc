@@ -1,4 +1,4 @@
-#include "iot/thing.h"
+#include "iot/thing_schema.h"
 #include "board.h"
 #include "display/lcd_display.h"
 #include "settings.h"
@@ -11,44 +11,62 @@
 namespace iot {
 
 // 这里仅定义 Screen 的属性和方法，不包含具体的实现
-class Screen : public Thing {
+class Screen : public StaticThing<Screen> {
 public:
-    Screen() : Thing("Screen", "这是一个屏幕，可设置主题和亮度") {
-        // 定义设备的属性
-        properties_.AddStringProperty("theme", "主题", [this]() -> std::string {
-            auto theme = Board::GetInstance().GetDisplay()->GetTheme();
-            return theme;
-        });
-
-        properties_.AddNumberProperty("brightness", "当前亮度百分比", [this]() -> int {
-            // 这里可以添加获取当前亮度的逻辑
-            auto backlight = Board::GetInstance().GetBacklight();
-            return backlight ? backlight->brightness() : 100;
-        });
-
-        // 定义设备可以被远程执行的指令
-        methods_.AddMethod("SetTheme", "设置屏幕主题", ParameterList({
-            Parameter("theme_name", "主题模式, light 或 dark", kValueTypeString, true)
-        }), [this](const ParameterList& parameters) {
-            std::string theme_name = static_cast<std::string>(parameters["theme_name"].string());
-            auto display = Board::GetInstance().GetDisplay();
-            if (display) {
-                display->SetTheme(theme_name);
-            }
-        });
-        
-        methods_.AddMethod("SetBrightness", "设置亮度", ParameterList({
-            Parameter("brightness", "0到100之间的整数", kValueTypeNumber, true)
-        }), [this](const ParameterList& parameters) {
-            uint8_t brightness = static_cast<uint8_t>(parameters["brightness"].number());
-            auto backlight = Board::GetInstance().GetBacklight();
-            if (backlight) {
-                backlight->SetBrightness(brightness, true);
-            }
-        });
-    }
+    Screen();
+
+    static const PropertySchema<Screen> kProperties[];
+    static const ParameterSchema kSetThemeParameters[];
+    static const ParameterSchema kSetBrightnessParameters[];
+    static const MethodSchema<Screen> kMethods[];
+    static const ThingSchema<Screen> kSchema;
+};
+
+// 定义设备的属性
+constexpr PropertySchema<Screen> Screen::kProperties[] = {
+    {"theme", "主题", [](Screen& screen) -> std::string {
+        auto theme = Board::GetInstance().GetDisplay()->GetTheme();
+        return theme;
+    }},
+    {"brightness", "当前亮度百分比", [](Screen& screen) -> int {
+        // 这里可以添加获取当前亮度的逻辑
+        auto backlight = Board::GetInstance().GetBacklight();
+        return backlight ? backlight->brightness() : 100;
+    }},
 };
 
+// 定义设备可以被远程执行的指令
+constexpr ParameterSchema Screen::kSetThemeParameters[] = {
+    {"theme_name", "主题模式, light 或 dark", kValueTypeString, true},
+};
+
+constexpr ParameterSchema Screen::kSetBrightnessParameters[] = {
+    {"brightness", "0到100之间的整数", kValueTypeNumber, true},
+};
+
+constexpr MethodSchema<Screen> Screen::kMethods[] = {
+    {"SetTheme", "设置屏幕主题", kSetThemeParameters, [](Screen& screen, const ParameterList& parameters) {
+        std::string theme_name = static_cast<std::string>(parameters["theme_name"].string());
+        auto display = Board::GetInstance().GetDisplay();
+        if (display) {
+            display->SetTheme(theme_name);
+        }
+    }, true},
+    {"SetBrightness", "设置亮度", kSetBrightnessParameters, [](Screen& screen, const ParameterList& parameters) {
+        uint8_t brightness = static_cast<uint8_t>(parameters["brightness"].number());
+        auto backlight = Board::GetInstance().GetBacklight();
+        if (backlight) {
+            backlight->SetBrightness(brightness, true);
+        }
+    }, true},
+};
+
+constexpr ThingSchema<Screen> Screen::kSchema = {"Screen", "这是一个屏幕，可设置主题和亮度", kProperties, kMethods};
+
+Screen::Screen() : StaticThing(kSchema, ThingDescriptor<Screen, kSchema>::kJson.data()) {
+    executor_ = kThingExecutorWorker;
+}
+
 } // namespace iot
 
-DECLARE_THING(Screen);
\ No newline at end of file
+DECLARE_THING(Screen);
@@ -1,4 +1,4 @@
-#include "iot/thing.h"
+#include "iot/thing_schema.h"
 #include "board.h"
 #include "audio_codec.h"
 
@@ -9,25 +9,42 @@
 namespace iot {
 
 // 这里仅定义 Speaker 的属性和方法，不包含具体的实现
-class Speaker : public Thing {
+class Speaker : public StaticThing<Speaker> {
 public:
-    Speaker() : Thing("Speaker", "扬声器") {
-        // 定义设备的属性
-        properties_.AddNumberProperty("volume", "当前音量值", [this]() -> int {
-            auto codec = Board::GetInstance().GetAudioCodec();
-            return codec->output_volume();
-        });
-
-        // 定义设备可以被远程执行的指令
-        methods_.AddMethod("SetVolume", "设置音量", ParameterList({
-            Parameter("volume", "0到100之间的整数", kValueTypeNumber, true)
-        }), [this](const ParameterList& parameters) {
-            auto codec = Board::GetInstance().GetAudioCodec();
-            codec->SetOutputVolume(static_cast<uint8_t>(parameters["volume"].number()));
-        });
-    }
+    Speaker();
+
+    static const PropertySchema<Speaker> kProperties[];
+    static const ParameterSchema kSetVolumeParameters[];
+    static const MethodSchema<Speaker> kMethods[];
+    static const ThingSchema<Speaker> kSchema;
+};
+
+// 定义设备的属性
+constexpr PropertySchema<Speaker> Speaker::kProperties[] = {
+    {"volume", "当前音量值", [](Speaker& speaker) -> int {
+        auto codec = Board::GetInstance().GetAudioCodec();
+        return codec->output_volume();
+    }},
+};
+
+// 定义设备可以被远程执行的指令
+constexpr ParameterSchema Speaker::kSetVolumeParameters[] = {
+    {"volume", "0到100之间的整数", kValueTypeNumber, true},
 };
 
+constexpr MethodSchema<Speaker> Speaker::kMethods[] = {
+    {"SetVolume", "设置音量", kSetVolumeParameters, [](Speaker& speaker, const ParameterList& parameters) {
+        auto codec = Board::GetInstance().GetAudioCodec();
+        codec->SetOutputVolume(static_cast<uint8_t>(parameters["volume"].number()));
+    }, true},
+};
+
+constexpr ThingSchema<Speaker> Speaker::kSchema = {"Speaker", "扬声器", kProperties, kMethods};
+
+Speaker::Speaker() : StaticThing(kSchema, ThingDescriptor<Speaker, kSchema>::kJson.data()) {
+    executor_ = kThingExecutorWorker;
+}
+
 } // namespace iot
 
 DECLARE_THING(Speaker);
@@ -1,4 +1,5 @@
 #include "ota.h"
+#include "delta_patch.h"
 #include "system_info.h"
 #include "settings.h"
 #include "assets/lang_config.h"
@@ -8,8 +9,15 @@
 #include <esp_partition.h>
 #include <esp_ota_ops.h>
 #include <esp_app_format.h>
+#include <esp_image_format.h>
 #include <esp_efuse.h>
 #include <esp_efuse_table.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <mbedtls/sha256.h>
 #ifdef SOC_HMAC_SUPPORTED
 #include <esp_hmac.h>
 #endif
@@ -18,9 +26,19 @@
 #include <vector>
 #include <sstream>
 #include <algorithm>
+#include <atomic>
+#include <memory>
 
 #define TAG "Ota"
 
+#define OTA_SECTOR_SIZE 4096
+// 缓冲区按扇区对齐，保存的断点因此总是扇区边界
+#define OTA_BUFFER_SIZE ((size_t)std::max(CONFIG_OTA_DOWNLOAD_BUFFER_SIZE / 4, 1) * OTA_SECTOR_SIZE)
+// 每写入这么多数据保存一次断点
+#define OTA_SAVE_INTERVAL (64 * 1024)
+// 缓存的版本检查响应的最大长度，NVS 字符串不能超过 4000 字节
+#define OTA_CONFIG_CACHE_MAX_SIZE 3072
+
 
 Ota::Ota() {
     {
@@ -86,6 +104,14 @@ bool Ota::CheckVersion() {
 
     auto http = SetupHttp();
 
+    // 上次的响应没有变化时服务器返回 304，直接使用缓存
+    Settings cache("ota_config", true);
+    std::string cached_body = cache.GetString("body");
+    std::string etag = cache.GetString("etag");
+    if (!cached_body.empty() && !etag.empty()) {
+        http->SetHeader("If-None-Match", etag);
+    }
+
     std::string data = board.GetJson();
     std::string method = data.length() > 0 ? "POST" : "GET";
     if (!http->Open(method, check_version_url_, data)) {
@@ -94,7 +120,14 @@ bool Ota::CheckVersion() {
         return false;
     }
 
-    data = http->GetBody();
+    bool not_modified = http->GetStatusCode() == 304 && !cached_body.empty();
+    if (not_modified) {
+        ESP_LOGI(TAG, "Config not modified, using cached response");
+        data = std::move(cached_body);
+    } else {
+        data = http->GetBody();
+        etag = http->GetResponseHeader("ETag");
+    }
     delete http;
 
     // Response: { "firmware": { "version": "1.0.0", "url": "http://" } }
@@ -107,6 +140,18 @@ bool Ota::CheckVersion() {
         return false;
     }
 
+    // 需要激活的响应不能用于离线启动
+    if (cJSON_GetObjectItem(root, "activation") != NULL || data.size() > OTA_CONFIG_CACHE_MAX_SIZE) {
+        cache.EraseAll();
+    } else if (!not_modified && (data != cached_body || etag != cache.GetString("etag"))) {
+        cache.SetString("body", data);
+        if (etag.empty()) {
+            cache.EraseKey("etag");
+        } else {
+            cache.SetString("etag", etag);
+        }
+    }
+
     has_activation_code_ = false;
     has_activation_challenge_ = false;
     cJSON *activation = cJSON_GetObjectItem(root, "activation");
@@ -167,7 +212,8 @@ bool Ota::CheckVersion() {
 
     has_server_time_ = false;
     cJSON *server_time = cJSON_GetObjectItem(root, "server_time");
-    if (server_time != NULL) {
+    // 缓存中的服务器时间已经过期
+    if (server_time != NULL && !not_modified) {
         cJSON *timestamp = cJSON_GetObjectItem(server_time, "timestamp");
         cJSON *timezone_offset = cJSON_GetObjectItem(server_time, "timezone_offset");
         
@@ -191,6 +237,7 @@ bool Ota::CheckVersion() {
     }
 
     has_new_version_ = false;
+    force_upgrade_ = false;
     cJSON *firmware = cJSON_GetObjectItem(root, "firmware");
     if (firmware != NULL) {
         cJSON *version = cJSON_GetObjectItem(firmware, "version");
@@ -201,6 +248,9 @@ bool Ota::CheckVersion() {
         if (url != NULL) {
             firmware_url_ = url->valuestring;
         }
+        // 相对当前运行固件的差分补丁，由 scripts/gen_delta.py 生成
+        cJSON *patch_url = cJSON_GetObjectItem(firmware, "patch_url");
+        patch_url_ = cJSON_IsString(patch_url) ? patch_url->valuestring : "";
 
         if (version != NULL && url != NULL) {
             // Check if the version is newer, for example, 0.1.0 is newer than 0.0.1
@@ -214,6 +264,7 @@ bool Ota::CheckVersion() {
             cJSON *force = cJSON_GetObjectItem(firmware, "force");
             if (force != NULL && force->valueint == 1) {
                 has_new_version_ = true;
+                force_upgrade_ = true;
             }
         }
     } else {
@@ -224,6 +275,30 @@ bool Ota::CheckVersion() {
     return true;
 }
 
+bool Ota::LoadCachedConfig() {
+    current_version_ = esp_app_get_description()->version;
+
+    Settings cache("ota_config");
+    std::string data = cache.GetString("body");
+    if (data.empty()) {
+        return false;
+    }
+    cJSON *root = cJSON_Parse(data.c_str());
+    if (root == NULL) {
+        return false;
+    }
+    // 协议配置在检查版本时已经保存到 NVS，这里只需要知道使用哪个协议
+    has_mqtt_config_ = cJSON_GetObjectItem(root, "mqtt") != NULL;
+    has_websocket_config_ = cJSON_GetObjectItem(root, "websocket") != NULL;
+    cJSON_Delete(root);
+    return has_mqtt_config_ || has_websocket_config_;
+}
+
+void Ota::ClearCachedConfig() {
+    Settings cache("ota_config", true);
+    cache.EraseAll();
+}
+
 void Ota::MarkCurrentVersionValid() {
     auto partition = esp_ota_get_running_partition();
     if (strcmp(partition->label, "factory") == 0) {
@@ -244,9 +319,251 @@ void Ota::MarkCurrentVersionValid() {
     }
 }
 
+static std::string DigestHex(const uint8_t* digest, size_t length) {
+    static const char hex_chars[] = "0123456789abcdef";
+    std::string hex(length * 2, '0');
+    for (size_t i = 0; i < length; i++) {
+        hex[i * 2] = hex_chars[digest[i] >> 4];
+        hex[i * 2 + 1] = hex_chars[digest[i] & 0x0f];
+    }
+    return hex;
+}
+
+static std::string Sha256Hex(const mbedtls_sha256_context& context) {
+    mbedtls_sha256_context copy;
+    mbedtls_sha256_init(&copy);
+    mbedtls_sha256_clone(&copy, &context);
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&copy, digest);
+    mbedtls_sha256_free(&copy);
+    return DigestHex(digest, sizeof(digest));
+}
+
+/*
+ * 固件写入任务
+ * 下载线程填满一块缓冲区后交给写入任务，写入 Flash 的同时继续下载下一块，两块缓冲区循环使用。
+ * 直接按扇区擦除和写入分区而不是使用 esp_ota_begin（它会先擦除整个分区，也不能从中间继续写入），
+ * 中断后可以从断点继续写入。因为绕过了 esp_ota_write 的检查，切换启动分区前要用 VerifyImage 校验整个镜像。
+ * 差分升级的输出不能从中间继续，resumable 为 false 时不保存断点。
+ */
+class OtaWriter {
+public:
+    // validator 是服务器返回的 ETag 或 Last-Modified，继续下载时通过 If-Range 确认固件没有变化
+    OtaWriter(const esp_partition_t* partition, const std::string& url, const std::string& validator,
+        size_t image_size, size_t offset, const mbedtls_sha256_context& sha256, bool resumable = true) :
+        partition_(partition), url_(url), validator_(validator), image_size_(image_size), offset_(offset),
+        resumable_(resumable) {
+        mbedtls_sha256_init(&sha256_);
+        mbedtls_sha256_clone(&sha256_, &sha256);
+    }
+
+    ~OtaWriter() {
+        for (auto buffer : buffers_) {
+            heap_caps_free(buffer);
+        }
+        if (free_queue_ != nullptr) {
+            vQueueDelete(free_queue_);
+        }
+        if (full_queue_ != nullptr) {
+            vQueueDelete(full_queue_);
+        }
+        if (done_ != nullptr) {
+            vSemaphoreDelete(done_);
+        }
+        mbedtls_sha256_free(&sha256_);
+    }
+
+    bool Start() {
+        free_queue_ = xQueueCreate(2, sizeof(char*));
+        full_queue_ = xQueueCreate(3, sizeof(Block));
+        done_ = xSemaphoreCreateBinary();
+        for (auto& buffer : buffers_) {
+            buffer = (char*)heap_caps_malloc(OTA_BUFFER_SIZE, MALLOC_CAP_SPIRAM);
+            if (buffer == nullptr) {
+                buffer = (char*)heap_caps_malloc(OTA_BUFFER_SIZE, MALLOC_CAP_8BIT);
+            }
+            if (buffer == nullptr) {
+                ESP_LOGE(TAG, "Failed to allocate download buffer");
+                return false;
+            }
+            xQueueSend(free_queue_, &buffer, 0);
+        }
+        return xTaskCreate([](void* arg) {
+            auto writer = (OtaWriter*)arg;
+            writer->WriteTask();
+            vTaskDelete(NULL);
+        }, "ota_write", 4096, this, 4, nullptr) == pdPASS;
+    }
+
+    // 取得一块空闲缓冲区，wait_us 为等待 Flash 写入的时间
+    char* AcquireBuffer(int64_t& wait_us) {
+        char* buffer = nullptr;
+        auto start_time = esp_timer_get_time();
+        xQueueReceive(free_queue_, &buffer, portMAX_DELAY);
+        wait_us = esp_timer_get_time() - start_time;
+        return buffer;
+    }
+
+    // length 为 0 时只归还缓冲区
+    void Submit(char* buffer, size_t length) {
+        Block block = {buffer, length};
+        xQueueSend(full_queue_, &block, portMAX_DELAY);
+    }
+
+    // 等待排队的数据块写完，返回是否全部写入成功
+    bool Finish() {
+        Block block = {nullptr, 0};
+        xQueueSend(full_queue_, &block, portMAX_DELAY);
+        xSemaphoreTake(done_, portMAX_DELAY);
+        return error_ == ESP_OK;
+    }
+
+    bool failed() const { return error_ != ESP_OK; }
+    size_t offset() const { return offset_; }
+    // 已写入数据的 SHA-256，Finish 之后调用
+    std::string sha256() const { return Sha256Hex(sha256_); }
+
+private:
+    struct Block {
+        char* data;
+        size_t length;
+    };
+
+    const esp_partition_t* partition_;
+    std::string url_;
+    std::string validator_;
+    size_t image_size_;
+    size_t offset_;
+    bool resumable_;
+    mbedtls_sha256_context sha256_;
+    char* buffers_[2] = {nullptr, nullptr};
+    QueueHandle_t free_queue_ = nullptr;
+    QueueHandle_t full_queue_ = nullptr;
+    SemaphoreHandle_t done_ = nullptr;
+    std::atomic<esp_err_t> error_ = ESP_OK;
+
+    void WriteTask() {
+        Block block;
+        size_t saved_offset = offset_;
+        while (xQueueReceive(full_queue_, &block, portMAX_DELAY) == pdTRUE && block.data != nullptr) {
+            if (block.length > 0 && error_ == ESP_OK) {
+                error_ = Write(block.data, block.length);
+                if (error_ == ESP_OK && resumable_ && offset_ - saved_offset >= OTA_SAVE_INTERVAL) {
+                    SaveProgress();
+                    saved_offset = offset_;
+                }
+            }
+            xQueueSend(free_queue_, &block.data, portMAX_DELAY);
+        }
+        // 最后一块不是整扇区，写完后不再需要断点
+        if (error_ == ESP_OK && resumable_ && offset_ % OTA_SECTOR_SIZE == 0 && offset_ != saved_offset) {
+            SaveProgress();
+        }
+        xSemaphoreGive(done_);
+    }
+
+    esp_err_t Write(char* data, size_t length) {
+        if (offset_ + length > image_size_) {
+            ESP_LOGE(TAG, "Image is larger than expected");
+            return ESP_ERR_INVALID_SIZE;
+        }
+        // 加密分区要求按 16 字节写入，最后一块用 0xFF 补齐
+        size_t padded_length = (length + 15) & ~15;
+        memset(data + length, 0xFF, padded_length - length);
+        size_t erase_length = (padded_length + OTA_SECTOR_SIZE - 1) & ~(OTA_SECTOR_SIZE - 1);
+        esp_err_t err = esp_partition_erase_range(partition_, offset_, erase_length);
+        if (err == ESP_OK) {
+            err = esp_partition_write(partition_, offset_, data, padded_length);
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to write OTA data: %s", esp_err_to_name(err));
+            return err;
+        }
+        mbedtls_sha256_update(&sha256_, (const uint8_t*)data, length);
+        offset_ += length;
+        return ESP_OK;
+    }
+
+    void SaveProgress() {
+        Settings settings("ota", true);
+        settings.SetString("url", url_);
+        settings.SetString("validator", validator_);
+        settings.SetString("partition", partition_->label);
+        settings.SetInt("size", image_size_);
+        settings.SetInt("offset", offset_);
+        settings.SetString("sha256", Sha256Hex(sha256_));
+        // 断点用于掉电后继续下载，不等待延迟提交
+        Settings::Flush();
+    }
+};
+
+// If-Range 只接受强 ETag，没有时使用 Last-Modified，都没有时不能安全地继续下载
+static std::string GetResponseValidator(Http* http) {
+    auto etag = http->GetResponseHeader("ETag");
+    if (!etag.empty() && etag.compare(0, 2, "W/") != 0) {
+        return etag;
+    }
+    return http->GetResponseHeader("Last-Modified");
+}
+
+// 读取上次中断的下载进度，重新计算已写入数据的哈希并与保存的值比较，返回可以继续下载的位置
+static size_t LoadOtaProgress(const std::string& url, const esp_partition_t* partition, size_t& image_size,
+    std::string& validator, mbedtls_sha256_context& sha256) {
+    Settings settings("ota");
+    if (settings.GetString("url") != url || settings.GetString("partition") != partition->label) {
+        return 0;
+    }
+    validator = settings.GetString("validator");
+    if (validator.empty()) {
+        return 0;
+    }
+    size_t offset = settings.GetInt("offset");
+    image_size = settings.GetInt("size");
+    if (offset == 0 || offset % OTA_SECTOR_SIZE != 0 || offset >= image_size || image_size > partition->size) {
+        return 0;
+    }
+
+    std::vector<uint8_t> buffer(OTA_SECTOR_SIZE);
+    for (size_t position = 0; position < offset; position += buffer.size()) {
+        if (esp_partition_read(partition, position, buffer.data(), buffer.size()) != ESP_OK) {
+            break;
+        }
+        mbedtls_sha256_update(&sha256, buffer.data(), buffer.size());
+    }
+    if (Sha256Hex(sha256) != settings.GetString("sha256")) {
+        ESP_LOGW(TAG, "Partial image hash mismatch, download from the beginning");
+        mbedtls_sha256_starts(&sha256, 0);
+        return 0;
+    }
+    return offset;
+}
+
+static void ClearOtaProgress() {
+    Settings settings("ota", true);
+    settings.EraseAll();
+}
+
+// 校验写入的镜像（段、校验和、SHA-256 以及启用时的安全启动签名），镜像不能超出下载的长度
+static bool VerifyImage(const esp_partition_t* partition, size_t image_size) {
+    esp_partition_pos_t position = {
+        .offset = partition->address,
+        .size = partition->size,
+    };
+    esp_image_metadata_t metadata = {};
+    esp_err_t err = esp_image_verify(ESP_IMAGE_VERIFY, &position, &metadata);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Image verification failed: %s", esp_err_to_name(err));
+        return false;
+    }
+    if (metadata.image_len > image_size) {
+        ESP_LOGE(TAG, "Image length %lu exceeds downloaded size %zu", metadata.image_len, image_size);
+        return false;
+    }
+    return true;
+}
+
 void Ota::Upgrade(const std::string& firmware_url) {
     ESP_LOGI(TAG, "Upgrading firmware from %s", firmware_url.c_str());
-    esp_ota_handle_t update_handle = 0;
     auto update_partition = esp_ota_get_next_update_partition(NULL);
     if (update_partition == NULL) {
         ESP_LOGE(TAG, "Failed to get update partition");
@@ -254,109 +571,338 @@ void Ota::Upgrade(const std::string& firmware_url) {
     }
 
     ESP_LOGI(TAG, "Writing to partition %s at offset 0x%lx", update_partition->label, update_partition->address);
-    bool image_header_checked = false;
-    std::string image_header;
 
-    auto http = Board::GetInstance().CreateHttp();
-    if (!http->Open("GET", firmware_url)) {
-        ESP_LOGE(TAG, "Failed to open HTTP connection");
-        delete http;
+    mbedtls_sha256_context sha256;
+    mbedtls_sha256_init(&sha256);
+    mbedtls_sha256_starts(&sha256, 0);
+    size_t image_size = 0;
+    std::string validator;
+    size_t offset = LoadOtaProgress(firmware_url, update_partition, image_size, validator, sha256);
+
+    // 固件变化时服务器忽略 If-Range 返回 200 和完整的新固件
+    auto open_http = [&firmware_url, &validator](size_t range_offset) -> Http* {
+        auto http = Board::GetInstance().CreateHttp();
+        if (range_offset > 0) {
+            http->SetHeader("Range", "bytes=" + std::to_string(range_offset) + "-");
+            http->SetHeader("If-Range", validator);
+        }
+        if (!http->Open("GET", firmware_url)) {
+            ESP_LOGE(TAG, "Failed to open HTTP connection");
+            delete http;
+            return nullptr;
+        }
+        return http;
+    };
+
+    auto http = open_http(offset);
+    if (http != nullptr && offset > 0) {
+        int status_code = http->GetStatusCode();
+        if (status_code == 206 && offset + http->GetBodyLength() == image_size) {
+            ESP_LOGI(TAG, "Resume download from %zu/%zu", offset, image_size);
+        } else {
+            // 服务器不支持 Range 或者固件已经变化，从头下载
+            ESP_LOGW(TAG, "Resume rejected (status %d), download from the beginning", status_code);
+            offset = 0;
+            mbedtls_sha256_starts(&sha256, 0);
+            if (status_code != 200) {
+                delete http;
+                http = open_http(0);
+            }
+        }
+    }
+    if (http == nullptr) {
+        mbedtls_sha256_free(&sha256);
         return;
     }
 
     size_t content_length = http->GetBodyLength();
     if (content_length == 0) {
         ESP_LOGE(TAG, "Failed to get content length");
+        mbedtls_sha256_free(&sha256);
+        delete http;
+        return;
+    }
+    if (offset == 0) {
+        image_size = content_length;
+        validator = GetResponseValidator(http);
+    }
+    if (image_size > update_partition->size) {
+        ESP_LOGE(TAG, "Image size %zu exceeds partition size %lu", image_size, update_partition->size);
+        mbedtls_sha256_free(&sha256);
         delete http;
         return;
     }
 
-    char buffer[512];
-    size_t total_read = 0, recent_read = 0;
-    auto last_calc_time = esp_timer_get_time();
-    while (true) {
-        int ret = http->Read(buffer, sizeof(buffer));
-        if (ret < 0) {
-            ESP_LOGE(TAG, "Failed to read HTTP data: %s", esp_err_to_name(ret));
-            delete http;
-            return;
-        }
+    OtaWriter writer(update_partition, firmware_url, validator, image_size, offset, sha256);
+    mbedtls_sha256_free(&sha256);
+    if (!writer.Start()) {
+        delete http;
+        return;
+    }
 
-        // Calculate speed and progress every second
-        recent_read += ret;
-        total_read += ret;
-        if (esp_timer_get_time() - last_calc_time >= 1000000 || ret == 0) {
-            size_t progress = total_read * 100 / content_length;
-            ESP_LOGI(TAG, "Progress: %zu%% (%zu/%zu), Speed: %zuB/s", progress, total_read, content_length, recent_read);
-            if (upgrade_callback_) {
-                upgrade_callback_(progress, recent_read);
+    bool image_header_checked = offset > 0;
+    bool completed = false;
+    size_t total_read = offset, recent_read = 0;
+    int64_t write_stall_us = 0;
+    auto last_calc_time = esp_timer_get_time();
+    while (!writer.failed()) {
+        int64_t wait_us;
+        char* buffer = writer.AcquireBuffer(wait_us);
+        write_stall_us += wait_us;
+
+        size_t length = 0;
+        int ret = 0;
+        while (length < OTA_BUFFER_SIZE) {
+            ret = http->Read(buffer + length, OTA_BUFFER_SIZE - length);
+            if (ret <= 0) {
+                break;
+            }
+            length += ret;
+            recent_read += ret;
+            total_read += ret;
+
+            // Calculate speed and progress every second
+            if (esp_timer_get_time() - last_calc_time >= 1000000) {
+                size_t progress = total_read * 100 / image_size;
+                uint32_t write_stall_ms = write_stall_us / 1000;
+                ESP_LOGI(TAG, "Progress: %zu%% (%zu/%zu), Speed: %zuB/s, Write stall: %lums", progress, total_read,
+                    image_size, recent_read, write_stall_ms);
+                if (upgrade_callback_) {
+                    upgrade_callback_(progress, recent_read, write_stall_ms);
+                }
+                last_calc_time = esp_timer_get_time();
+                recent_read = 0;
+                write_stall_us = 0;
             }
-            last_calc_time = esp_timer_get_time();
-            recent_read = 0;
         }
-
-        if (ret == 0) {
+        if (ret < 0) {
+            // 不完整的数据块丢弃，下次从上一个断点继续
+            ESP_LOGE(TAG, "Failed to read HTTP data: %s", esp_err_to_name(ret));
+            writer.Submit(buffer, 0);
             break;
         }
 
-        if (!image_header_checked) {
-            image_header.append(buffer, ret);
-            if (image_header.size() >= sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t) + sizeof(esp_app_desc_t)) {
+        if (!image_header_checked && length > 0) {
+            if (length >= sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t) + sizeof(esp_app_desc_t)) {
                 esp_app_desc_t new_app_info;
-                memcpy(&new_app_info, image_header.data() + sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t), sizeof(esp_app_desc_t));
+                memcpy(&new_app_info, buffer + sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t), sizeof(esp_app_desc_t));
                 ESP_LOGI(TAG, "New firmware version: %s", new_app_info.version);
 
                 auto current_version = esp_app_get_description()->version;
                 if (memcmp(new_app_info.version, current_version, sizeof(new_app_info.version)) == 0) {
                     ESP_LOGE(TAG, "Firmware version is the same, skipping upgrade");
-                    delete http;
-                    return;
+                    writer.Submit(buffer, 0);
+                    break;
                 }
-
-                if (esp_ota_begin(update_partition, OTA_WITH_SEQUENTIAL_WRITES, &update_handle)) {
-                    esp_ota_abort(update_handle);
-                    delete http;
-                    ESP_LOGE(TAG, "Failed to begin OTA");
-                    return;
-                }
-
-                image_header_checked = true;
-                std::string().swap(image_header);
             }
+            image_header_checked = true;
         }
-        auto err = esp_ota_write(update_handle, buffer, ret);
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to write OTA data: %s", esp_err_to_name(err));
-            esp_ota_abort(update_handle);
-            delete http;
-            return;
+
+        writer.Submit(buffer, length);
+        if (ret == 0) {
+            completed = total_read == image_size;
+            if (!completed) {
+                ESP_LOGE(TAG, "Connection closed at %zu/%zu", total_read, image_size);
+            }
+            break;
         }
     }
     delete http;
 
-    esp_err_t err = esp_ota_end(update_handle);
-    if (err != ESP_OK) {
-        if (err == ESP_ERR_OTA_VALIDATE_FAILED) {
-            ESP_LOGE(TAG, "Image validation failed, image is corrupted");
-        } else {
-            ESP_LOGE(TAG, "Failed to end OTA: %s", esp_err_to_name(err));
-        }
+    if (!writer.Finish() || !completed) {
+        ESP_LOGI(TAG, "Download stopped at %zu/%zu", writer.offset(), image_size);
         return;
     }
+    if (upgrade_callback_) {
+        upgrade_callback_(100, recent_read, write_stall_us / 1000);
+    }
 
-    err = esp_ota_set_boot_partition(update_partition);
+    // 镜像损坏时断点也不可信，下次从头下载
+    if (!VerifyImage(update_partition, image_size)) {
+        ClearOtaProgress();
+        return;
+    }
+    esp_err_t err = esp_ota_set_boot_partition(update_partition);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to set boot partition: %s", esp_err_to_name(err));
         return;
     }
+    ClearOtaProgress();
 
     ESP_LOGI(TAG, "Firmware upgrade successful, rebooting in 3 seconds...");
     vTaskDelay(pdMS_TO_TICKS(3000));
     esp_restart();
 }
 
-void Ota::StartUpgrade(std::function<void(int progress, size_t speed)> callback) {
+/*
+ * 差分升级：下载相对当前运行固件的补丁，读取运行分区作为源数据，重建的镜像经 OtaWriter 写入升级分区。
+ * 补丁和镜像都不会完整放在内存中。补丁不匹配或者下载失败时返回 false，由调用者改为下载完整固件。
+ */
+bool Ota::UpgradeFromPatch(const std::string& patch_url) {
+    ESP_LOGI(TAG, "Upgrading firmware from patch %s", patch_url.c_str());
+    auto running_partition = esp_ota_get_running_partition();
+    auto update_partition = esp_ota_get_next_update_partition(NULL);
+    if (running_partition == NULL || update_partition == NULL) {
+        ESP_LOGE(TAG, "Failed to get OTA partitions");
+        return false;
+    }
+
+    std::unique_ptr<Http> http(Board::GetInstance().CreateHttp());
+    if (!http->Open("GET", patch_url) || http->GetStatusCode() != 200) {
+        ESP_LOGE(TAG, "Failed to download patch");
+        return false;
+    }
+    size_t content_length = http->GetBodyLength();
+    if (content_length == 0) {
+        ESP_LOGE(TAG, "Failed to get content length");
+        return false;
+    }
+
+    std::unique_ptr<OtaWriter> writer;
+    std::string target_sha256;
+    auto on_header = [&](const DeltaPatchHeader& header) {
+        if (header.source_size > running_partition->size || header.target_size == 0 ||
+            header.target_size > update_partition->size) {
+            ESP_LOGE(TAG, "Invalid patch sizes: source %lu, target %lu", header.source_size, header.target_size);
+            return false;
+        }
+        if (memcmp(header.source_sha256, header.target_sha256, sizeof(header.source_sha256)) == 0) {
+            ESP_LOGE(TAG, "Firmware is the same, skipping upgrade");
+            return false;
+        }
+
+        // 补丁只适用于生成它的那个固件
+        mbedtls_sha256_context sha256;
+        mbedtls_sha256_init(&sha256);
+        mbedtls_sha256_starts(&sha256, 0);
+        std::vector<uint8_t> buffer(OTA_SECTOR_SIZE);
+        for (size_t position = 0; position < header.source_size; position += buffer.size()) {
+            size_t length = std::min(buffer.size(), (size_t)header.source_size - position);
+            if (esp_partition_read(running_partition, position, buffer.data(), length) != ESP_OK) {
+                break;
+            }
+            mbedtls_sha256_update(&sha256, buffer.data(), length);
+        }
+        bool matched = Sha256Hex(sha256) == DigestHex(header.source_sha256, sizeof(header.source_sha256));
+        if (!matched) {
+            ESP_LOGW(TAG, "Patch does not match the running firmware");
+            mbedtls_sha256_free(&sha256);
+            return false;
+        }
+
+        // 写入的镜像与之前保存的完整固件断点无关，断点作废
+        ClearOtaProgress();
+        mbedtls_sha256_starts(&sha256, 0);
+        writer = std::make_unique<OtaWriter>(update_partition, patch_url, "", header.target_size, 0, sha256, false);
+        mbedtls_sha256_free(&sha256);
+        target_sha256 = DigestHex(header.target_sha256, sizeof(header.target_sha256));
+        ESP_LOGI(TAG, "Patch %zu bytes, image %lu bytes", content_length, header.target_size);
+        if (!writer->Start()) {
+            writer.reset();
+            return false;
+        }
+        return true;
+    };
+
+    auto read_source = [running_partition](size_t offset, uint8_t* data, size_t length) {
+        return esp_partition_read(running_partition, offset, data, length) == ESP_OK;
+    };
+
+    char* buffer = nullptr;
+    size_t buffer_length = 0;
+    int64_t write_stall_us = 0;
+    auto write_target = [&](const uint8_t* data, size_t length) {
+        while (length > 0) {
+            if (writer->failed()) {
+                return false;
+            }
+            if (buffer == nullptr) {
+                int64_t wait_us;
+                buffer = writer->AcquireBuffer(wait_us);
+                write_stall_us += wait_us;
+                buffer_length = 0;
+            }
+            size_t n = std::min(length, OTA_BUFFER_SIZE - buffer_length);
+            memcpy(buffer + buffer_length, data, n);
+            buffer_length += n;
+            data += n;
+            length -= n;
+            if (buffer_length == OTA_BUFFER_SIZE) {
+                writer->Submit(buffer, buffer_length);
+                buffer = nullptr;
+            }
+        }
+        return true;
+    };
+
+    auto patch = std::make_unique<DeltaPatch>(read_source, on_header, write_target);
+    std::vector<char> data(OTA_SECTOR_SIZE);
+    size_t total_read = 0, recent_read = 0;
+    auto last_calc_time = esp_timer_get_time();
+    bool ok = true;
+    while (ok && !patch->done()) {
+        int ret = http->Read(data.data(), data.size());
+        if (ret <= 0) {
+            ESP_LOGE(TAG, "Patch download stopped at %zu/%zu", total_read, content_length);
+            ok = false;
+            break;
+        }
+        ok = patch->Feed((const uint8_t*)data.data(), ret);
+        recent_read += ret;
+        total_read += ret;
+
+        if (esp_timer_get_time() - last_calc_time >= 1000000) {
+            size_t progress = total_read * 100 / content_length;
+            uint32_t write_stall_ms = write_stall_us / 1000;
+            ESP_LOGI(TAG, "Progress: %zu%% (%zu/%zu), Speed: %zuB/s, Write stall: %lums", progress, total_read,
+                content_length, recent_read, write_stall_ms);
+            if (upgrade_callback_) {
+                upgrade_callback_(progress, recent_read, write_stall_ms);
+            }
+            last_calc_time = esp_timer_get_time();
+            recent_read = 0;
+            write_stall_us = 0;
+        }
+    }
+    http.reset();
+
+    if (writer == nullptr) {
+        return false;
+    }
+    if (buffer != nullptr) {
+        writer->Submit(buffer, ok ? buffer_length : 0);
+    }
+    if (!writer->Finish() || !ok || !patch->done()) {
+        return false;
+    }
+    if (writer->sha256() != target_sha256) {
+        ESP_LOGE(TAG, "Patched image hash mismatch");
+        return false;
+    }
+    if (upgrade_callback_) {
+        upgrade_callback_(100, recent_read, write_stall_us / 1000);
+    }
+
+    if (!VerifyImage(update_partition, writer->offset())) {
+        return false;
+    }
+    esp_err_t err = esp_ota_set_boot_partition(update_partition);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set boot partition: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Firmware upgrade successful, rebooting in 3 seconds...");
+    vTaskDelay(pdMS_TO_TICKS(3000));
+    esp_restart();
+    return true;
+}
+
+void Ota::StartUpgrade(std::function<void(int progress, size_t speed, uint32_t write_stall_ms)> callback) {
     upgrade_callback_ = callback;
+    if (!patch_url_.empty() && UpgradeFromPatch(patch_url_)) {
+        return;
+    }
     Upgrade(firmware_url_);
 }
 
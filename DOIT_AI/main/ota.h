@@ -15,14 +15,19 @@ public:
 
     void SetHeader(const std::string& key, const std::string& value);
     bool CheckVersion();
+    // 读取上次成功检查版本时缓存的配置，服务器不可用时也可以立即启动协议
+    bool LoadCachedConfig();
+    void ClearCachedConfig();
     esp_err_t Activate();
     bool HasActivationChallenge() { return has_activation_challenge_; }
     bool HasNewVersion() { return has_new_version_; }
+    bool IsUpgradeForced() { return force_upgrade_; }
     bool HasMqttConfig() { return has_mqtt_config_; }
     bool HasWebsocketConfig() { return has_websocket_config_; }
     bool HasActivationCode() { return has_activation_code_; }
     bool HasServerTime() { return has_server_time_; }
-    void StartUpgrade(std::function<void(int progress, size_t speed)> callback);
+    // speed 为最近一秒下载的字节数，write_stall_ms 为其中等待 Flash 写入的时间
+    void StartUpgrade(std::function<void(int progress, size_t speed, uint32_t write_stall_ms)> callback);
     void MarkCurrentVersionValid();
 
     const std::string& GetFirmwareVersion() const { return firmware_version_; }
@@ -36,6 +41,7 @@ private:
     std::string activation_message_;
     std::string activation_code_;
     bool has_new_version_ = false;
+    bool force_upgrade_ = false;
     bool has_mqtt_config_ = false;
     bool has_websocket_config_ = false;
     bool has_server_time_ = false;
@@ -45,13 +51,15 @@ private:
     std::string current_version_;
     std::string firmware_version_;
     std::string firmware_url_;
+    std::string patch_url_;
     std::string activation_challenge_;
     std::string serial_number_;
     int activation_timeout_ms_ = 30000;
     std::map<std::string, std::string> headers_;
 
     void Upgrade(const std::string& firmware_url);
-    std::function<void(int progress, size_t speed)> upgrade_callback_;
+    bool UpgradeFromPatch(const std::string& patch_url);
+    std::function<void(int progress, size_t speed, uint32_t write_stall_ms)> upgrade_callback_;
     std::vector<int> ParseVersion(const std::string& version);
     bool IsNewVersionAvailable(const std::string& currentVersion, const std::string& newVersion);
     std::string GetActivationPayload();
@@ -0,0 +1,338 @@
+#include "json_scanner.h"
+
+#include <cstring>
+
+static bool ParseHex4(const char* p, const char* end, uint32_t& value) {
+    if (end - p < 4) {
+        return false;
+    }
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+        char c = p[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= c - '0';
+        else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+        else return false;
+    }
+    return true;
+}
+
+JsonScanner::JsonScanner(const char* data, size_t length) : p_(data), end_(data + length) {
+}
+
+bool JsonScanner::Fail() {
+    error_ = true;
+    return false;
+}
+
+void JsonScanner::SkipWhitespace() {
+    while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) {
+        p_++;
+    }
+}
+
+bool JsonScanner::ScanString(std::string_view& raw, bool& escaped) {
+    // p_ 指向起始引号
+    const char* start = ++p_;
+    escaped = false;
+    while (p_ < end_) {
+        if (*p_ == '\\') {
+            escaped = true;
+            p_++;
+            // 反斜杠是最后一个字符时字符串没有结束，不能越过 end_
+            if (p_ >= end_) {
+                return false;
+            }
+            char c = *p_++;
+            if (c == 'u') {
+                // 和 cJSON 一样，代理项必须成对出现
+                uint32_t code_point, low;
+                if (!ParseHex4(p_, end_, code_point) || (code_point >= 0xDC00 && code_point <= 0xDFFF)) {
+                    return false;
+                }
+                p_ += 4;
+                if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+                    if (end_ - p_ < 6 || p_[0] != '\\' || p_[1] != 'u' || !ParseHex4(p_ + 2, end_, low) ||
+                        low < 0xDC00 || low > 0xDFFF) {
+                        return false;
+                    }
+                    p_ += 6;
+                }
+            } else if (c == '\0' || strchr("\"\\/bfnrt", c) == nullptr) {
+                return false;
+            }
+            continue;
+        }
+        if (*p_ == '"') {
+            raw = std::string_view(start, p_ - start);
+            p_++;
+            return true;
+        }
+        p_++;
+    }
+    return false;
+}
+
+// -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+bool JsonScanner::ScanNumber() {
+    auto digits = [this]() {
+        const char* start = p_;
+        while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+            p_++;
+        }
+        return p_ > start;
+    };
+    if (p_ < end_ && *p_ == '-') {
+        p_++;
+    }
+    if (p_ < end_ && *p_ == '0') {
+        p_++;
+    } else if (!digits()) {
+        return false;
+    }
+    if (p_ < end_ && *p_ == '.') {
+        p_++;
+        if (!digits()) {
+            return false;
+        }
+    }
+    if (p_ < end_ && (*p_ == 'e' || *p_ == 'E')) {
+        p_++;
+        if (p_ < end_ && (*p_ == '+' || *p_ == '-')) {
+            p_++;
+        }
+        if (!digits()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool JsonScanner::ScanLiteral(JsonValueType& type) {
+    std::string_view literal;
+    switch (*p_) {
+        case 't':
+            type = kJsonValueBoolean;
+            literal = "true";
+            break;
+        case 'f':
+            type = kJsonValueBoolean;
+            literal = "false";
+            break;
+        case 'n':
+            type = kJsonValueNull;
+            literal = "null";
+            break;
+        default:
+            type = kJsonValueNumber;
+            return ScanNumber();
+    }
+    if ((size_t)(end_ - p_) < literal.size() || memcmp(p_, literal.data(), literal.size()) != 0) {
+        return false;
+    }
+    p_ += literal.size();
+    return true;
+}
+
+bool JsonScanner::SkipNested() {
+    // 每层一位记录是对象还是数组，用来检查括号是否配对；超过 64 层时按格式错误处理，交给 cJSON
+    uint64_t objects = 0;
+    int depth = 0;
+    // 刚进入对象或数组，可以直接结束
+    bool opened = false;
+    enum { kValue, kKey, kAfterValue } expect = kValue;
+    while (true) {
+        SkipWhitespace();
+        if (p_ >= end_) {
+            return false;
+        }
+        char c = *p_;
+        bool in_object = objects & 1;
+        if (expect == kAfterValue || (opened && (c == '}' || c == ']'))) {
+            if (c == ',' && !opened) {
+                p_++;
+                expect = in_object ? kKey : kValue;
+                continue;
+            }
+            if (c != (in_object ? '}' : ']')) {
+                return false;
+            }
+            p_++;
+            objects >>= 1;
+            if (--depth == 0) {
+                return true;
+            }
+            opened = false;
+            expect = kAfterValue;
+            continue;
+        }
+        opened = false;
+
+        std::string_view raw;
+        bool escaped;
+        if (expect == kKey) {
+            if (c != '"' || !ScanString(raw, escaped)) {
+                return false;
+            }
+            SkipWhitespace();
+            if (p_ >= end_ || *p_ != ':') {
+                return false;
+            }
+            p_++;
+            expect = kValue;
+            continue;
+        }
+
+        if (c == '{' || c == '[') {
+            if (depth == 64) {
+                return false;
+            }
+            objects = (objects << 1) | (c == '{' ? 1 : 0);
+            depth++;
+            p_++;
+            opened = true;
+            expect = c == '{' ? kKey : kValue;
+            continue;
+        }
+        JsonValueType type;
+        if (c == '"' ? !ScanString(raw, escaped) : !ScanLiteral(type)) {
+            return false;
+        }
+        expect = kAfterValue;
+    }
+}
+
+bool JsonScanner::Next(std::string_view& key, JsonValue& value) {
+    if (error_) {
+        return false;
+    }
+
+    SkipWhitespace();
+    if (!started_) {
+        if (p_ >= end_ || *p_ != '{') {
+            return Fail();
+        }
+        p_++;
+        started_ = true;
+        SkipWhitespace();
+        if (p_ < end_ && *p_ == '}') {
+            p_++;
+            return false;
+        }
+    } else {
+        if (p_ >= end_) {
+            return Fail();
+        }
+        if (*p_ == '}') {
+            p_++;
+            return false;
+        }
+        if (*p_ != ',') {
+            return Fail();
+        }
+        p_++;
+        SkipWhitespace();
+    }
+
+    bool key_escaped;
+    if (p_ >= end_ || *p_ != '"' || !ScanString(key, key_escaped)) {
+        return Fail();
+    }
+    SkipWhitespace();
+    if (p_ >= end_ || *p_ != ':') {
+        return Fail();
+    }
+    p_++;
+    SkipWhitespace();
+    if (p_ >= end_) {
+        return Fail();
+    }
+
+    const char* start = p_;
+    value.escaped = false;
+    if (*p_ == '"') {
+        value.type = kJsonValueString;
+        if (!ScanString(value.raw, value.escaped)) {
+            return Fail();
+        }
+        return true;
+    }
+    if (*p_ == '{' || *p_ == '[') {
+        value.type = *p_ == '{' ? kJsonValueObject : kJsonValueArray;
+        if (!SkipNested()) {
+            return Fail();
+        }
+    } else if (!ScanLiteral(value.type)) {
+        return Fail();
+    }
+    value.raw = std::string_view(start, p_ - start);
+    return true;
+}
+
+static void AppendUtf8(std::string& output, uint32_t code_point) {
+    if (code_point < 0x80) {
+        output.push_back((char)code_point);
+    } else if (code_point < 0x800) {
+        output.push_back((char)(0xC0 | (code_point >> 6)));
+        output.push_back((char)(0x80 | (code_point & 0x3F)));
+    } else if (code_point < 0x10000) {
+        output.push_back((char)(0xE0 | (code_point >> 12)));
+        output.push_back((char)(0x80 | ((code_point >> 6) & 0x3F)));
+        output.push_back((char)(0x80 | (code_point & 0x3F)));
+    } else {
+        output.push_back((char)(0xF0 | (code_point >> 18)));
+        output.push_back((char)(0x80 | ((code_point >> 12) & 0x3F)));
+        output.push_back((char)(0x80 | ((code_point >> 6) & 0x3F)));
+        output.push_back((char)(0x80 | (code_point & 0x3F)));
+    }
+}
+
+void JsonScanner::Unescape(std::string_view raw, std::string& output) {
+    output.clear();
+    output.reserve(raw.size());
+    const char* p = raw.data();
+    const char* end = p + raw.size();
+    while (p < end) {
+        if (*p != '\\' || p + 1 >= end) {
+            output.push_back(*p++);
+            continue;
+        }
+        p++;
+        switch (*p++) {
+            case 'b': output.push_back('\b'); break;
+            case 'f': output.push_back('\f'); break;
+            case 'n': output.push_back('\n'); break;
+            case 'r': output.push_back('\r'); break;
+            case 't': output.push_back('\t'); break;
+            case 'u': {
+                uint32_t code_point;
+                if (!ParseHex4(p, end, code_point)) {
+                    break;
+                }
+                p += 4;
+                // UTF-16 代理对
+                uint32_t low;
+                if (code_point >= 0xD800 && code_point <= 0xDBFF && end - p >= 6 && p[0] == '\\' && p[1] == 'u' &&
+                    ParseHex4(p + 2, end, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                }
+                AppendUtf8(output, code_point);
+                break;
+            }
+            default:
+                // \" \\ \/
+                output.push_back(*(p - 1));
+                break;
+        }
+    }
+}
+
+std::string_view JsonScanner::GetString(const JsonValue& value, std::string& scratch) {
+    if (!value.escaped) {
+        return value.raw;
+    }
+    Unescape(value.raw, scratch);
+    return scratch;
+}
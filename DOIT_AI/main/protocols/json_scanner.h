@@ -0,0 +1,56 @@
+#ifndef JSON_SCANNER_H
+#define JSON_SCANNER_H
+
+#include <string>
+#include <string_view>
+
+enum JsonValueType {
+    kJsonValueInvalid,
+    kJsonValueString,
+    kJsonValueNumber,
+    kJsonValueBoolean,
+    kJsonValueNull,
+    kJsonValueObject,
+    kJsonValueArray
+};
+
+struct JsonValue {
+    JsonValueType type = kJsonValueInvalid;
+    // 字符串为引号内的原始内容（未反转义），其他类型为完整的原始文本
+    std::string_view raw;
+    bool escaped = false;
+};
+
+/*
+ * 单遍扫描顶层 JSON 对象的成员，不构建 DOM，不分配内存
+ * 键和值都以 string_view 的形式指向输入缓冲区，嵌套的对象和数组整体跳过，但仍然检查格式：
+ * 括号配对、true/false/null 完整拼写、数字语法、转义字符和 \u 代理对，格式错误时调用方改用 cJSON 解析
+ */
+class JsonScanner {
+public:
+    JsonScanner(const char* data, size_t length);
+
+    // 读取下一个成员，没有更多成员或者格式错误时返回 false，可以用 error() 区分
+    bool Next(std::string_view& key, JsonValue& value);
+    bool error() const { return error_; }
+
+    // 取得字符串值，只有包含转义字符时才会解码到 scratch 中
+    static std::string_view GetString(const JsonValue& value, std::string& scratch);
+    static void Unescape(std::string_view raw, std::string& output);
+
+private:
+    const char* p_;
+    const char* end_;
+    bool started_ = false;
+    bool error_ = false;
+
+    void SkipWhitespace();
+    bool ScanString(std::string_view& raw, bool& escaped);
+    bool ScanNumber();
+    // 数字、true、false 或 null
+    bool ScanLiteral(JsonValueType& type);
+    bool SkipNested();
+    bool Fail();
+};
+
+#endif // JSON_SCANNER_H
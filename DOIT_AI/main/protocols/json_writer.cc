@@ -0,0 +1,121 @@
+#include "json_writer.h"
+
+#include <cstdio>
+
+static const char hex_chars[] = "0123456789abcdef";
+
+JsonWriter::JsonWriter(std::string& buffer) : buffer_(buffer) {
+    buffer_.clear();
+}
+
+void JsonWriter::BeforeValue() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (depth_ > 0) {
+        uint32_t bit = 1u << (depth_ - 1);
+        if (has_element_ & bit) {
+            buffer_.push_back(',');
+        }
+        has_element_ |= bit;
+    }
+}
+
+JsonWriter& JsonWriter::BeginObject() {
+    BeforeValue();
+    buffer_.push_back('{');
+    depth_++;
+    has_element_ &= ~(1u << (depth_ - 1));
+    return *this;
+}
+
+JsonWriter& JsonWriter::EndObject() {
+    depth_--;
+    buffer_.push_back('}');
+    return *this;
+}
+
+JsonWriter& JsonWriter::BeginArray() {
+    BeforeValue();
+    buffer_.push_back('[');
+    depth_++;
+    has_element_ &= ~(1u << (depth_ - 1));
+    return *this;
+}
+
+JsonWriter& JsonWriter::EndArray() {
+    depth_--;
+    buffer_.push_back(']');
+    return *this;
+}
+
+JsonWriter& JsonWriter::Key(std::string_view key) {
+    BeforeValue();
+    buffer_.push_back('"');
+    AppendEscaped(key);
+    buffer_.append("\":", 2);
+    after_key_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::String(std::string_view value) {
+    BeforeValue();
+    buffer_.push_back('"');
+    AppendEscaped(value);
+    buffer_.push_back('"');
+    return *this;
+}
+
+JsonWriter& JsonWriter::Number(int64_t value) {
+    BeforeValue();
+    char number[24];
+    int length = snprintf(number, sizeof(number), "%lld", (long long)value);
+    buffer_.append(number, length);
+    return *this;
+}
+
+JsonWriter& JsonWriter::Bool(bool value) {
+    BeforeValue();
+    if (value) {
+        buffer_.append("true", 4);
+    } else {
+        buffer_.append("false", 5);
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::Raw(std::string_view json) {
+    BeforeValue();
+    buffer_.append(json);
+    return *this;
+}
+
+JsonWriter& JsonWriter::AppendEscaped(std::string_view text) {
+    // 连续的无需转义的字符批量追加
+    size_t start = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = text[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        buffer_.append(text.data() + start, i - start);
+        start = i + 1;
+        switch (c) {
+            case '"': buffer_.append("\\\"", 2); break;
+            case '\\': buffer_.append("\\\\", 2); break;
+            case '\b': buffer_.append("\\b", 2); break;
+            case '\f': buffer_.append("\\f", 2); break;
+            case '\n': buffer_.append("\\n", 2); break;
+            case '\r': buffer_.append("\\r", 2); break;
+            case '\t': buffer_.append("\\t", 2); break;
+            default: {
+                char escaped[6] = {'\\', 'u', '0', '0', hex_chars[c >> 4], hex_chars[c & 0x0f]};
+                buffer_.append(escaped, sizeof(escaped));
+                break;
+            }
+        }
+    }
+    buffer_.append(text.data() + start, text.size() - start);
+    return *this;
+}
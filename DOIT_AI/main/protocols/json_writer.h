@@ -0,0 +1,47 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+ * 轻量的 JSON 序列化器，直接写入调用方提供的缓冲区
+ * 缓冲区在多次消息之间复用，clear() 不会释放容量，因此热路径上不会反复分配内存
+ * 字符串值会按 RFC 8259 转义
+ */
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& buffer);
+
+    JsonWriter& BeginObject();
+    JsonWriter& EndObject();
+    JsonWriter& BeginArray();
+    JsonWriter& EndArray();
+    JsonWriter& Key(std::string_view key);
+    JsonWriter& String(std::string_view value);
+    JsonWriter& Number(int64_t value);
+    JsonWriter& Bool(bool value);
+    // 写入已经序列化好的 JSON 片段
+    JsonWriter& Raw(std::string_view json);
+
+    JsonWriter& Field(std::string_view key, std::string_view value) { return Key(key).String(value); }
+    JsonWriter& Field(std::string_view key, const char* value) { return Key(key).String(value); }
+
+    // 直接追加原始字符，不处理逗号，用于预先序列化的消息模板
+    JsonWriter& Append(std::string_view text) { buffer_.append(text); return *this; }
+    JsonWriter& AppendEscaped(std::string_view text);
+
+    const std::string& str() const { return buffer_; }
+
+private:
+    std::string& buffer_;
+    // 每一层嵌套一位，标记该层是否已经写过元素（需要逗号），最多支持 32 层
+    uint32_t has_element_ = 0;
+    int depth_ = 0;
+    bool after_key_ = false;
+
+    void BeforeValue();
+};
+
+#endif // JSON_WRITER_H
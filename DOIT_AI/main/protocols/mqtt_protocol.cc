@@ -2,28 +2,49 @@
 #include "board.h"
 #include "application.h"
 #include "settings.h"
+#include "json_writer.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <ml307_mqtt.h>
 #include <ml307_udp.h>
+#include <hex_codec.h>
 #include <cstring>
 #include <arpa/inet.h>
 #include "assets/lang_config.h"
 
 #define TAG "MQTT"
 
-MqttProtocol::MqttProtocol() {
+MqttProtocol::MqttProtocol()
+    : receive_stats_(CONFIG_AUDIO_REORDER_WINDOW), reorder_buffer_(CONFIG_AUDIO_REORDER_WINDOW) {
     event_group_handle_ = xEventGroupCreate();
+    mbedtls_aes_init(&aes_ctx_);
+    // 预分配 UDP 发送缓冲区（nonce 头 + payload 连续存放），避免每个音频包重新分配
+    udp_packet_.reserve(MQTT_UDP_PACKET_RESERVE_SIZE);
+
+    esp_timer_create_args_t reorder_timer_args = {
+        .callback = [](void* arg) {
+            static_cast<MqttProtocol*>(arg)->FlushReorderBuffer();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "audio_reorder",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&reorder_timer_args, &reorder_timer_));
 }
 
 MqttProtocol::~MqttProtocol() {
     ESP_LOGI(TAG, "MqttProtocol deinit");
+    esp_timer_stop(reorder_timer_);
+    esp_timer_delete(reorder_timer_);
     if (udp_ != nullptr) {
         delete udp_;
     }
     if (mqtt_ != nullptr) {
         delete mqtt_;
     }
+    mbedtls_aes_free(&aes_ctx_);
     vEventGroupDelete(event_group_handle_);
 }
 
@@ -60,6 +81,10 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
     });
 
     mqtt_->OnMessage([this](const std::string& topic, const std::string& payload) {
+        if (DispatchIncomingMessage(payload.data(), payload.size())) {
+            last_incoming_time_ = std::chrono::steady_clock::now();
+            return;
+        }
         cJSON* root = cJSON_Parse(payload.c_str());
         if (root == nullptr) {
             ESP_LOGE(TAG, "Failed to parse json message %s", payload.c_str());
@@ -127,25 +152,29 @@ void MqttProtocol::SendAudio(const AudioStreamPacket& packet) {
         return;
     }
 
-    std::string nonce(aes_nonce_);
-    *(uint16_t*)&nonce[2] = htons(packet.payload.size());
-    *(uint32_t*)&nonce[8] = htonl(packet.timestamp);
-    *(uint32_t*)&nonce[12] = htonl(++local_sequence_);
-
-    std::string encrypted;
-    encrypted.resize(aes_nonce_.size() + packet.payload.size());
-    memcpy(encrypted.data(), nonce.data(), nonce.size());
-
+    // 头部和 payload 写入同一个预分配的缓冲区，然后原地加密 payload
+    const size_t nonce_size = aes_nonce_.size();
+    udp_packet_.resize(nonce_size + packet.payload.size());
+    auto header = (uint8_t*)udp_packet_.data();
+    memcpy(header, aes_nonce_.data(), nonce_size);
+    *(uint16_t*)&header[2] = htons(packet.payload.size());
+    *(uint32_t*)&header[8] = htonl(packet.timestamp);
+    *(uint32_t*)&header[12] = htonl(++local_sequence_);
+    memcpy(header + nonce_size, packet.payload.data(), packet.payload.size());
+
+    // mbedtls 会修改计数器，使用栈上的副本，头部保持为原始 nonce
+    uint8_t nonce_counter[MQTT_AES_BLOCK_SIZE];
+    memcpy(nonce_counter, header, sizeof(nonce_counter));
     size_t nc_off = 0;
-    uint8_t stream_block[16] = {0};
-    if (mbedtls_aes_crypt_ctr(&aes_ctx_, packet.payload.size(), &nc_off, (uint8_t*)nonce.c_str(), stream_block,
-        (uint8_t*)packet.payload.data(), (uint8_t*)&encrypted[nonce.size()]) != 0) {
+    uint8_t stream_block[MQTT_AES_BLOCK_SIZE] = {0};
+    if (mbedtls_aes_crypt_ctr(&aes_ctx_, packet.payload.size(), &nc_off, nonce_counter, stream_block,
+        header + nonce_size, header + nonce_size) != 0) {
         ESP_LOGE(TAG, "Failed to encrypt audio data");
         return;
     }
 
     busy_sending_audio_ = true;
-    udp_->Send(encrypted);
+    udp_->Send(udp_packet_);
     busy_sending_audio_ = false;
 }
 
@@ -157,12 +186,29 @@ void MqttProtocol::CloseAudioChannel() {
             udp_ = nullptr;
         }
     }
+    {
+        std::lock_guard<std::mutex> lock(reorder_mutex_);
+        esp_timer_stop(reorder_timer_);
+        reorder_buffer_.Reset();
+    }
 
-    std::string message = "{";
-    message += "\"session_id\":\"" + session_id_ + "\",";
-    message += "\"type\":\"goodbye\"";
-    message += "}";
-    SendText(message);
+    std::string stats_json;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        if (receive_stats_.received() > 0) {
+            stats_json = receive_stats_.GetJson();
+        }
+    }
+    if (!stats_json.empty()) {
+        ESP_LOGI(TAG, "Audio receive stats: %s", stats_json.c_str());
+#if CONFIG_AUDIO_RECEIVE_STATS_INTERVAL > 0
+        SendText(GetReceiveStatsMessage());
+#endif
+    }
+
+    JsonWriter writer(message_buffer_);
+    writer.BeginObject().Field("session_id", session_id_).Field("type", "goodbye").EndObject();
+    SendText(message_buffer_);
 
     if (on_audio_channel_closed_ != nullptr) {
         on_audio_channel_closed_();
@@ -216,7 +262,7 @@ bool MqttProtocol::OpenAudioChannel() {
          * |type 1u|flags 1u|payload_len 2u|ssrc 4u|timestamp 4u|sequence 4u|
          * |payload payload_len|
          */
-        if (data.size() < sizeof(aes_nonce_)) {
+        if (data.size() < aes_nonce_.size()) {
             ESP_LOGE(TAG, "Invalid audio packet size: %zu", data.size());
             return;
         }
@@ -226,19 +272,43 @@ bool MqttProtocol::OpenAudioChannel() {
         }
         uint32_t timestamp = ntohl(*(uint32_t*)&data[8]);
         uint32_t sequence = ntohl(*(uint32_t*)&data[12]);
-        if (sequence < remote_sequence_) {
-            ESP_LOGW(TAG, "Received audio packet with old sequence: %lu, expected: %lu", sequence, remote_sequence_);
+        int64_t now_ms = esp_timer_get_time() / 1000;
+        bool accepted;
+        std::vector<uint32_t> missing;
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            accepted = receive_stats_.OnPacket(sequence, timestamp, now_ms);
+#if CONFIG_USE_AUDIO_NACK
+            missing = receive_stats_.TakeMissingSequences();
+#endif
+        }
+        if (!accepted) {
+            ESP_LOGW(TAG, "Received audio packet with old sequence: %lu, expected: %lu", sequence, remote_sequence_ + 1);
             return;
         }
         if (sequence != remote_sequence_ + 1) {
             ESP_LOGW(TAG, "Received audio packet with wrong sequence: %lu, expected: %lu", sequence, remote_sequence_ + 1);
+            if (!missing.empty()) {
+                SendNack(missing);
+            }
         }
+#if CONFIG_AUDIO_RECEIVE_STATS_INTERVAL > 0
+        if (now_ms - last_stats_report_ms_ >= CONFIG_AUDIO_RECEIVE_STATS_INTERVAL * 1000) {
+            last_stats_report_ms_ = now_ms;
+            Application::GetInstance().Schedule([this, message = GetReceiveStatsMessage()]() {
+                SendText(message);
+            });
+        }
+#endif
 
         size_t decrypted_size = data.size() - aes_nonce_.size();
         size_t nc_off = 0;
-        uint8_t stream_block[16] = {0};
-        auto nonce = (uint8_t*)data.data();
+        uint8_t stream_block[MQTT_AES_BLOCK_SIZE] = {0};
+        uint8_t nonce[MQTT_AES_BLOCK_SIZE];
+        memcpy(nonce, data.data(), sizeof(nonce));
         auto encrypted = (uint8_t*)data.data() + aes_nonce_.size();
+        // 接收端每个包解密到新的 payload：它随 packet 移交给乱序缓冲和 Application 的解码队列，
+        // 由后台解码任务释放，没有回到这里的路径可以复用
         AudioStreamPacket packet;
         packet.timestamp = timestamp;
         packet.payload.resize(decrypted_size);
@@ -247,10 +317,20 @@ bool MqttProtocol::OpenAudioChannel() {
             ESP_LOGE(TAG, "Failed to decrypt audio data, ret: %d", ret);
             return;
         }
-        if (on_incoming_audio_ != nullptr) {
-            on_incoming_audio_(std::move(packet));
+        {
+            std::lock_guard<std::mutex> lock(reorder_mutex_);
+            reorder_buffer_.Push(sequence, std::move(packet), [this](AudioStreamPacket&& packet) {
+                DeliverAudio(std::move(packet));
+            });
+            esp_timer_stop(reorder_timer_);
+            if (!reorder_buffer_.empty()) {
+                esp_timer_start_once(reorder_timer_, CONFIG_AUDIO_REORDER_WINDOW * server_frame_duration_ * 1000);
+            }
+        }
+        // 乱序到达的包不往回更新，remote_sequence_ 始终是收到的最新序号
+        if ((int32_t)(sequence - remote_sequence_) > 0) {
+            remote_sequence_ = sequence;
         }
-        remote_sequence_ = sequence;
         last_incoming_time_ = std::chrono::steady_clock::now();
     });
 
@@ -295,35 +375,83 @@ void MqttProtocol::ParseServerHello(const cJSON* root) {
     }
     udp_server_ = cJSON_GetObjectItem(udp, "server")->valuestring;
     udp_port_ = cJSON_GetObjectItem(udp, "port")->valueint;
-    auto key = cJSON_GetObjectItem(udp, "key")->valuestring;
-    auto nonce = cJSON_GetObjectItem(udp, "nonce")->valuestring;
+    auto key = cJSON_GetObjectItem(udp, "key");
+    auto nonce = cJSON_GetObjectItem(udp, "nonce");
+    if (!cJSON_IsString(key) || !cJSON_IsString(nonce)) {
+        ESP_LOGE(TAG, "UDP key or nonce is not specified");
+        return;
+    }
 
     // auto encryption = cJSON_GetObjectItem(udp, "encryption")->valuestring;
     // ESP_LOGI(TAG, "UDP server: %s, port: %d, encryption: %s", udp_server_.c_str(), udp_port_, encryption);
-    aes_nonce_ = DecodeHexString(nonce);
-    mbedtls_aes_init(&aes_ctx_);
-    mbedtls_aes_setkey_enc(&aes_ctx_, (const unsigned char*)DecodeHexString(key).c_str(), 128);
+    // 音频包头部就是 nonce，AES-128-CTR 的计数器和密钥都必须是 16 字节
+    auto aes_key = DecodeHexString(key->valuestring);
+    auto aes_nonce = DecodeHexString(nonce->valuestring);
+    if (aes_key.size() != MQTT_AES_BLOCK_SIZE || aes_nonce.size() != MQTT_AES_BLOCK_SIZE) {
+        ESP_LOGE(TAG, "Invalid UDP key or nonce size: %zu, %zu", aes_key.size(), aes_nonce.size());
+        return;
+    }
+    aes_nonce_ = std::move(aes_nonce);
+    mbedtls_aes_setkey_enc(&aes_ctx_, (const unsigned char*)aes_key.data(), 128);
     local_sequence_ = 0;
     remote_sequence_ = 0;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        receive_stats_.Reset();
+    }
+    {
+        std::lock_guard<std::mutex> lock(reorder_mutex_);
+        esp_timer_stop(reorder_timer_);
+        reorder_buffer_.Reset();
+    }
+    last_stats_report_ms_ = esp_timer_get_time() / 1000;
     xEventGroupSetBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT);
 }
 
-static const char hex_chars[] = "0123456789ABCDEF";
-// 辅助函数，将单个十六进制字符转换为对应的数值
-static inline uint8_t CharToHex(char c) {
-    if (c >= '0' && c <= '9') return c - '0';
-    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
-    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
-    return 0;  // 对于无效输入，返回0
+// 上报音频接收统计，供服务端监控网络质量
+std::string MqttProtocol::GetReceiveStatsMessage() {
+    std::string message;
+    JsonWriter writer(message);
+    writer.BeginObject().Field("session_id", session_id_).Field("type", "audio_stats");
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        writer.Key("receive").Raw(receive_stats_.GetJson());
+    }
+    writer.EndObject();
+    return message;
+}
+
+void MqttProtocol::DeliverAudio(AudioStreamPacket&& packet) {
+    if (on_incoming_audio_ != nullptr) {
+        on_incoming_audio_(std::move(packet));
+    }
+}
+
+void MqttProtocol::FlushReorderBuffer() {
+    std::lock_guard<std::mutex> lock(reorder_mutex_);
+    reorder_buffer_.Flush([this](AudioStreamPacket&& packet) {
+        DeliverAudio(std::move(packet));
+    });
+}
+
+// 请求服务端重传缺失的音频包（或切换到 FEC）
+void MqttProtocol::SendNack(const std::vector<uint32_t>& sequences) {
+    std::string message;
+    JsonWriter writer(message);
+    writer.BeginObject().Field("session_id", session_id_).Field("type", "nack");
+    writer.Key("sequences").BeginArray();
+    for (auto sequence : sequences) {
+        writer.Number(sequence);
+    }
+    writer.EndArray().EndObject();
+    Application::GetInstance().Schedule([this, message = std::move(message)]() {
+        SendText(message);
+    });
 }
 
 std::string MqttProtocol::DecodeHexString(const std::string& hex_string) {
     std::string decoded;
-    decoded.reserve(hex_string.size() / 2);
-    for (size_t i = 0; i < hex_string.size(); i += 2) {
-        char byte = (CharToHex(hex_string[i]) << 4) | CharToHex(hex_string[i + 1]);
-        decoded.push_back(byte);
-    }
+    HexDecodeAppend(decoded, hex_string.data(), hex_string.size());
     return decoded;
 }
 
@@ -3,12 +3,15 @@
 
 
 #include "protocol.h"
+#include "receive_stats.h"
+#include "reorder_buffer.h"
 #include <mqtt.h>
 #include <udp.h>
 #include <cJSON.h>
 #include <mbedtls/aes.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
+#include <esp_timer.h>
 
 #include <functional>
 #include <string>
@@ -17,6 +20,8 @@
 
 #define MQTT_PING_INTERVAL_SECONDS 90
 #define MQTT_RECONNECT_INTERVAL_MS 10000
+#define MQTT_UDP_PACKET_RESERVE_SIZE 1500
+#define MQTT_AES_BLOCK_SIZE 16
 
 #define MQTT_PROTOCOL_SERVER_HELLO_EVENT (1 << 0)
 
@@ -45,14 +50,29 @@ private:
     Udp* udp_ = nullptr;
     mbedtls_aes_context aes_ctx_;
     std::string aes_nonce_;
+    std::string udp_packet_;
     std::string udp_server_;
     int udp_port_;
     uint32_t local_sequence_;
     uint32_t remote_sequence_;
+    // 接收统计在 UDP 接收任务中更新，在主任务中读取和重置。
+    // 不用 channel_mutex_：关闭通道时持有它删除 udp_，而接收回调可能正等着同一把锁
+    std::mutex stats_mutex_;
+    ReceiveStats receive_stats_;
+    int64_t last_stats_report_ms_ = 0;
+    // 乱序缓冲在 UDP 接收任务和 reorder_timer_ 的回调中使用，持有锁时交出音频包，保证交出的顺序
+    std::mutex reorder_mutex_;
+    ReorderBuffer<AudioStreamPacket> reorder_buffer_;
+    // 暂存的包等待超过 AUDIO_REORDER_WINDOW 个包的时长后全部交出，避免一句话的结尾卡在缓冲中
+    esp_timer_handle_t reorder_timer_ = nullptr;
 
     bool StartMqttClient(bool report_error=false);
     void ParseServerHello(const cJSON* root);
     std::string DecodeHexString(const std::string& hex_string);
+    std::string GetReceiveStatsMessage();
+    void SendNack(const std::vector<uint32_t>& sequences);
+    void DeliverAudio(AudioStreamPacket&& packet);
+    void FlushReorderBuffer();
 
     bool SendText(const std::string& text) override;
 };
@@ -1,13 +1,39 @@
 #include "protocol.h"
+#include "json_writer.h"
+#include "json_scanner.h"
+#include "hash_name.h"
 
 #include <esp_log.h>
+#include <string_view>
 
 #define TAG "Protocol"
 
+// 固定结构消息的预序列化模板，只有 session_id 和文本字段需要在运行时填入
+static constexpr std::string_view kSessionIdPrefix = "{\"session_id\":\"";
+static constexpr std::string_view kAbortSuffix = "\",\"type\":\"abort\"}";
+static constexpr std::string_view kAbortWakeWordSuffix = "\",\"type\":\"abort\",\"reason\":\"wake_word_detected\"}";
+static constexpr std::string_view kWakeWordInfix = "\",\"type\":\"listen\",\"state\":\"detect\",\"text\":\"";
+static constexpr std::string_view kStringEndSuffix = "\"}";
+static constexpr std::string_view kStartListeningAutoSuffix = "\",\"type\":\"listen\",\"state\":\"start\",\"mode\":\"auto\"}";
+static constexpr std::string_view kStartListeningManualSuffix = "\",\"type\":\"listen\",\"state\":\"start\",\"mode\":\"manual\"}";
+static constexpr std::string_view kStartListeningRealtimeSuffix = "\",\"type\":\"listen\",\"state\":\"start\",\"mode\":\"realtime\"}";
+static constexpr std::string_view kStopListeningSuffix = "\",\"type\":\"listen\",\"state\":\"stop\"}";
+static constexpr std::string_view kIotDescriptorsHashInfix = "\",\"type\":\"iot\",\"update\":true,\"descriptors_hash\":\"";
+static constexpr std::string_view kIotDescriptorsInfix = "\",\"descriptors\":";
+static constexpr std::string_view kIotStatesInfix = "\",\"type\":\"iot\",\"update\":true,\"states\":";
+
+Protocol::Protocol() {
+    message_buffer_.reserve(PROTOCOL_MESSAGE_BUFFER_SIZE);
+}
+
 void Protocol::OnIncomingJson(std::function<void(const cJSON* root)> callback) {
     on_incoming_json_ = callback;
 }
 
+void Protocol::OnIncomingMessage(std::function<void(const IncomingMessage& message)> callback) {
+    on_incoming_message_ = callback;
+}
+
 void Protocol::OnIncomingAudio(std::function<void(AudioStreamPacket&& packet)> callback) {
     on_incoming_audio_ = callback;
 }
@@ -32,37 +58,36 @@ void Protocol::SetError(const std::string& message) {
 }
 
 void Protocol::SendAbortSpeaking(AbortReason reason) {
-    std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"abort\"";
-    if (reason == kAbortReasonWakeWordDetected) {
-        message += ",\"reason\":\"wake_word_detected\"";
-    }
-    message += "}";
-    SendText(message);
+    JsonWriter writer(message_buffer_);
+    writer.Append(kSessionIdPrefix).AppendEscaped(session_id_);
+    writer.Append(reason == kAbortReasonWakeWordDetected ? kAbortWakeWordSuffix : kAbortSuffix);
+    SendText(message_buffer_);
 }
 
 void Protocol::SendWakeWordDetected(const std::string& wake_word) {
-    std::string json = "{\"session_id\":\"" + session_id_ + 
-                      "\",\"type\":\"listen\",\"state\":\"detect\",\"text\":\"" + wake_word + "\"}";
-    SendText(json);
+    JsonWriter writer(message_buffer_);
+    writer.Append(kSessionIdPrefix).AppendEscaped(session_id_);
+    writer.Append(kWakeWordInfix).AppendEscaped(wake_word).Append(kStringEndSuffix);
+    SendText(message_buffer_);
 }
 
 void Protocol::SendStartListening(ListeningMode mode) {
-    std::string message = "{\"session_id\":\"" + session_id_ + "\"";
-    message += ",\"type\":\"listen\",\"state\":\"start\"";
+    JsonWriter writer(message_buffer_);
+    writer.Append(kSessionIdPrefix).AppendEscaped(session_id_);
     if (mode == kListeningModeRealtime) {
-        message += ",\"mode\":\"realtime\"";
+        writer.Append(kStartListeningRealtimeSuffix);
     } else if (mode == kListeningModeAutoStop) {
-        message += ",\"mode\":\"auto\"";
+        writer.Append(kStartListeningAutoSuffix);
     } else {
-        message += ",\"mode\":\"manual\"";
+        writer.Append(kStartListeningManualSuffix);
     }
-    message += "}";
-    SendText(message);
+    SendText(message_buffer_);
 }
 
 void Protocol::SendStopListening() {
-    std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"listen\",\"state\":\"stop\"}";
-    SendText(message);
+    JsonWriter writer(message_buffer_);
+    writer.Append(kSessionIdPrefix).AppendEscaped(session_id_).Append(kStopListeningSuffix);
+    SendText(message_buffer_);
 }
 
 void Protocol::SendIotDescriptors(const std::string& descriptors) {
@@ -110,11 +135,107 @@ void Protocol::SendIotDescriptors(const std::string& descriptors) {
     cJSON_Delete(root);
 }
 
-void Protocol::SendIotStates(const std::string& states) {
-    std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"iot\",\"update\":true,\"states\":" + states + "}";
+void Protocol::SendIotDescriptors(const std::string& descriptors, const std::string& hash, bool unchanged) {
+    // 描述可能有数 KB，不使用共享缓冲区，避免其容量常驻
+    std::string message;
+    JsonWriter writer(message);
+    if (!unchanged) {
+        message.reserve(descriptors.size() + 128);
+    }
+    writer.Append(kSessionIdPrefix).AppendEscaped(session_id_);
+    writer.Append(kIotDescriptorsHashInfix).AppendEscaped(hash);
+    if (unchanged) {
+        writer.Append(kStringEndSuffix);
+    } else {
+        writer.Append(kIotDescriptorsInfix).Append(descriptors).Append("}");
+    }
     SendText(message);
 }
 
+void Protocol::SendIotStates(const std::string& states) {
+    JsonWriter writer(message_buffer_);
+    writer.Append(kSessionIdPrefix).AppendEscaped(session_id_);
+    writer.Append(kIotStatesInfix).Append(states).Append("}");
+    SendText(message_buffer_);
+}
+
+static IncomingMessageKind GetIncomingMessageKind(std::string_view type, std::string_view state) {
+    // 先按哈希分派，再比较字符串确认，case 标签重复会在编译期报错，保证哈希没有冲突
+    switch (HashName(type)) {
+        case HashName("tts"):
+            if (type != "tts") {
+                break;
+            }
+            switch (HashName(state)) {
+                case HashName("start"):
+                    return state == "start" ? kIncomingMessageTtsStart : kIncomingMessageUnknown;
+                case HashName("stop"):
+                    return state == "stop" ? kIncomingMessageTtsStop : kIncomingMessageUnknown;
+                case HashName("sentence_start"):
+                    return state == "sentence_start" ? kIncomingMessageTtsSentenceStart : kIncomingMessageUnknown;
+                default:
+                    break;
+            }
+            break;
+        case HashName("stt"):
+            return type == "stt" ? kIncomingMessageStt : kIncomingMessageUnknown;
+        case HashName("llm"):
+            return type == "llm" ? kIncomingMessageLlm : kIncomingMessageUnknown;
+        default:
+            break;
+    }
+    return kIncomingMessageUnknown;
+}
+
+bool Protocol::DispatchIncomingMessage(const char* data, size_t length) {
+    if (on_incoming_message_ == nullptr) {
+        return false;
+    }
+
+    JsonScanner scanner(data, length);
+    std::string_view key;
+    JsonValue value, type, state, text, emotion;
+    // 重复的键取第一个，与 cJSON_GetObjectItem 的行为一致
+    while (scanner.Next(key, value)) {
+        switch (HashName(key)) {
+            case HashName("type"):
+                if (key == "type" && type.type == kJsonValueInvalid) type = value;
+                break;
+            case HashName("state"):
+                if (key == "state" && state.type == kJsonValueInvalid) state = value;
+                break;
+            case HashName("text"):
+                if (key == "text" && text.type == kJsonValueInvalid) text = value;
+                break;
+            case HashName("emotion"):
+                if (key == "emotion" && emotion.type == kJsonValueInvalid) emotion = value;
+                break;
+            default:
+                break;
+        }
+    }
+    if (scanner.error() || type.type != kJsonValueString || type.escaped) {
+        return false;
+    }
+
+    IncomingMessage message;
+    message.kind = GetIncomingMessageKind(type.raw, state.type == kJsonValueString ? state.raw : std::string_view());
+    if (message.kind == kIncomingMessageUnknown) {
+        return false;
+    }
+
+    // 只有包含转义字符的字段才需要解码到临时缓冲区
+    std::string text_scratch, emotion_scratch;
+    if (text.type == kJsonValueString) {
+        message.text = JsonScanner::GetString(text, text_scratch);
+    }
+    if (emotion.type == kJsonValueString) {
+        message.emotion = JsonScanner::GetString(emotion, emotion_scratch);
+    }
+    on_incoming_message_(message);
+    return true;
+}
+
 bool Protocol::IsTimeout() const {
     const int kTimeoutSeconds = 120;
     auto now = std::chrono::steady_clock::now();
@@ -3,6 +3,7 @@
 
 #include <cJSON.h>
 #include <string>
+#include <string_view>
 #include <functional>
 #include <chrono>
 #include <vector>
@@ -33,14 +34,34 @@ enum AbortReason {
     kAbortReasonWakeWordDetected
 };
 
+// 高频的服务器消息，走免 DOM 的快速解析路径
+enum IncomingMessageKind {
+    kIncomingMessageUnknown,
+    kIncomingMessageTtsStart,
+    kIncomingMessageTtsStop,
+    kIncomingMessageTtsSentenceStart,
+    kIncomingMessageStt,
+    kIncomingMessageLlm
+};
+
+// 字段指向接收缓冲区，只在回调期间有效
+struct IncomingMessage {
+    IncomingMessageKind kind = kIncomingMessageUnknown;
+    std::string_view text;
+    std::string_view emotion;
+};
+
 enum ListeningMode {
     kListeningModeAutoStop,
     kListeningModeManualStop,
     kListeningModeRealtime // 需要 AEC 支持
 };
 
+#define PROTOCOL_MESSAGE_BUFFER_SIZE 512
+
 class Protocol {
 public:
+    Protocol();
     virtual ~Protocol() = default;
 
     inline int server_sample_rate() const {
@@ -55,6 +76,7 @@ public:
 
     void OnIncomingAudio(std::function<void(AudioStreamPacket&& packet)> callback);
     void OnIncomingJson(std::function<void(const cJSON* root)> callback);
+    void OnIncomingMessage(std::function<void(const IncomingMessage& message)> callback);
     void OnAudioChannelOpened(std::function<void()> callback);
     void OnAudioChannelClosed(std::function<void()> callback);
     void OnNetworkError(std::function<void(const std::string& message)> callback);
@@ -70,10 +92,13 @@ public:
     virtual void SendStopListening();
     virtual void SendAbortSpeaking(AbortReason reason);
     virtual void SendIotDescriptors(const std::string& descriptors);
+    // 在一条消息中发送全部描述，unchanged 为 true 时只发送哈希，服务端使用缓存的描述
+    virtual void SendIotDescriptors(const std::string& descriptors, const std::string& hash, bool unchanged);
     virtual void SendIotStates(const std::string& states);
 
 protected:
     std::function<void(const cJSON* root)> on_incoming_json_;
+    std::function<void(const IncomingMessage& message)> on_incoming_message_;
     std::function<void(AudioStreamPacket&& packet)> on_incoming_audio_;
     std::function<void()> on_audio_channel_opened_;
     std::function<void()> on_audio_channel_closed_;
@@ -85,8 +110,12 @@ protected:
     bool busy_sending_audio_ = false;
     std::string session_id_;
     std::chrono::time_point<std::chrono::steady_clock> last_incoming_time_;
+    // 主循环发送控制消息时复用的缓冲区
+    std::string message_buffer_;
 
     virtual bool SendText(const std::string& text) = 0;
+    // 返回 false 表示不是快速路径支持的消息，调用方需要回退到 cJSON 解析
+    bool DispatchIncomingMessage(const char* data, size_t length);
     virtual void SetError(const std::string& message);
     virtual bool IsTimeout() const;
 };
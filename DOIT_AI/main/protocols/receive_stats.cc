@@ -0,0 +1,100 @@
+#include "receive_stats.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+// 序号按 32 位循环计数，用有符号差值比较先后（RFC 1982），回绕后仍然有序
+inline int32_t SequenceDiff(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b);
+}
+
+} // namespace
+
+void ReceiveStats::Reset() {
+    base_sequence_ = 0;
+    max_sequence_ = 0;
+    received_ = 0;
+    reordered_ = 0;
+    late_ = 0;
+    duplicated_ = 0;
+    last_transit_ = 0;
+    has_transit_ = false;
+    jitter_ = 0;
+    missing_.clear();
+    new_missing_.clear();
+}
+
+bool ReceiveStats::OnPacket(uint32_t sequence, uint32_t timestamp, int64_t arrival_ms) {
+    if (received_ > 0 && SequenceDiff(sequence, max_sequence_) <= 0) {
+        // missing_ 最多 RECEIVE_STATS_MAX_MISSING 个，回绕时数值不再有序，直接顺序查找
+        auto it = std::find(missing_.begin(), missing_.end(), sequence);
+        if (it == missing_.end()) {
+            duplicated_++;
+            return false;
+        }
+        // 乱序或重传的包计入已接收，乱序缓冲还在等它时可以播放，否则播放位置已经错过，丢弃
+        missing_.erase(it);
+        new_missing_.erase(std::remove(new_missing_.begin(), new_missing_.end(), sequence), new_missing_.end());
+        reordered_++;
+        received_++;
+        if (SequenceDiff(max_sequence_, sequence) >= (int32_t)reorder_window_) {
+            late_++;
+            return false;
+        }
+        return true;
+    }
+
+    if (received_ == 0) {
+        base_sequence_ = sequence;
+    } else {
+        // 只记录最近的 RECEIVE_STATS_MAX_MISSING 个缺失序号，更早的只计入丢包数
+        uint32_t first = max_sequence_ + 1;
+        if (sequence - first > RECEIVE_STATS_MAX_MISSING) {
+            first = sequence - RECEIVE_STATS_MAX_MISSING;
+        }
+        for (uint32_t s = first; s != sequence; ++s) {
+            if (missing_.size() >= RECEIVE_STATS_MAX_MISSING) {
+                missing_.erase(missing_.begin());
+            }
+            missing_.push_back(s);
+            if (new_missing_.size() < RECEIVE_STATS_MAX_MISSING) {
+                new_missing_.push_back(s);
+            }
+        }
+    }
+    max_sequence_ = sequence;
+    received_++;
+
+    // RFC 3550 A.8: J += (|D| - J) / 16
+    if (timestamp != 0) {
+        int64_t transit = arrival_ms - timestamp;
+        if (has_transit_) {
+            int64_t d = std::llabs(transit - last_transit_);
+            jitter_ += ((float)d - jitter_) / 16.0f;
+        }
+        last_transit_ = transit;
+        has_transit_ = true;
+    }
+    return true;
+}
+
+std::vector<uint32_t> ReceiveStats::TakeMissingSequences() {
+    std::vector<uint32_t> sequences;
+    sequences.swap(new_missing_);
+    return sequences;
+}
+
+std::string ReceiveStats::GetJson() const {
+    std::string json = "{";
+    json += "\"received\":" + std::to_string(received_) + ",";
+    json += "\"expected\":" + std::to_string(expected()) + ",";
+    json += "\"lost\":" + std::to_string(lost()) + ",";
+    json += "\"reordered\":" + std::to_string(reordered_) + ",";
+    json += "\"late\":" + std::to_string(late_) + ",";
+    json += "\"duplicated\":" + std::to_string(duplicated_) + ",";
+    json += "\"jitter\":" + std::to_string(jitter());
+    json += "}";
+    return json;
+}
@@ -0,0 +1,55 @@
+#ifndef RECEIVE_STATS_H
+#define RECEIVE_STATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define RECEIVE_STATS_MAX_MISSING 32
+
+/*
+ * 音频下行包的接收统计（每个会话一份）
+ * 丢包率按 RFC 3550 A.3 计算，抖动按 RFC 3550 A.8 计算（单位与时间戳一致，毫秒）
+ * 序号回绕后继续按循环顺序统计；不是线程安全的，调用方负责加锁
+ * reorder_window 是接收端乱序缓冲（ReorderBuffer）等待的包数，比最新的包旧不到这么多个的缺失包
+ * 迟到后仍然可以按顺序播放
+ */
+class ReceiveStats {
+public:
+    explicit ReceiveStats(uint32_t reorder_window = 0) : reorder_window_(reorder_window) {}
+
+    void Reset();
+
+    // 返回 false 表示该包是重复包或者已经错过播放位置，应当丢弃
+    bool OnPacket(uint32_t sequence, uint32_t timestamp, int64_t arrival_ms);
+
+    // 取出自上次调用以来新发现的缺失序号，用于 NACK
+    std::vector<uint32_t> TakeMissingSequences();
+    std::string GetJson() const;
+
+    uint32_t received() const { return received_; }
+    uint32_t expected() const { return received_ == 0 ? 0 : max_sequence_ - base_sequence_ + 1; }
+    uint32_t lost() const { return expected() > received_ ? expected() - received_ : 0; }
+    uint32_t reordered() const { return reordered_; }
+    uint32_t late() const { return late_; }
+    uint32_t duplicated() const { return duplicated_; }
+    uint32_t jitter() const { return (uint32_t)jitter_; }
+    float loss_rate() const { return expected() == 0 ? 0.0f : (float)lost() / expected(); }
+
+private:
+    uint32_t reorder_window_;
+    uint32_t base_sequence_ = 0;
+    uint32_t max_sequence_ = 0;
+    uint32_t received_ = 0;
+    uint32_t reordered_ = 0;
+    uint32_t late_ = 0;
+    uint32_t duplicated_ = 0;
+    int64_t last_transit_ = 0;
+    bool has_transit_ = false;
+    float jitter_ = 0;
+    // 尚未到达的序号，按到达顺序排列
+    std::vector<uint32_t> missing_;
+    std::vector<uint32_t> new_missing_;
+};
+
+#endif // RECEIVE_STATS_H
@@ -0,0 +1,89 @@
+#ifndef REORDER_BUFFER_H
+#define REORDER_BUFFER_H
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+/*
+ * 下行音频包的乱序缓冲，按序号顺序交出数据
+ * 出现缺口时最多暂存 window 个后续的包，等待缺失的包乱序到达或者被 NACK 重传；
+ * 缺失的包到达、最新的包比缺口新 window 个以上或者调用 Flush 时按顺序交出，仍然缺失的序号直接跳过。
+ * 和 ReceiveStats 使用相同的 window 时，ReceiveStats 接受的迟到包这里一定还没有跳过。
+ * window 为 0 时不等待；序号按 32 位循环计数；不是线程安全的，调用方负责加锁
+ */
+template <typename T>
+class ReorderBuffer {
+public:
+    explicit ReorderBuffer(uint32_t window) : window_(window) {}
+
+    void Reset() {
+        started_ = false;
+        slots_.clear();
+    }
+
+    // 返回 false 表示该序号已经交出或跳过，数据被丢弃
+    template <typename Output>
+    bool Push(uint32_t sequence, T&& item, Output&& output) {
+        if (!started_) {
+            started_ = true;
+            next_ = sequence;
+        }
+        if ((int32_t)(sequence - next_) < 0) {
+            return false;
+        }
+        // 序号跳得太远时先交出或跳过比它旧 window 个以上的槽位，最多保留 window + 1 个槽位
+        while ((int32_t)(sequence - next_) > (int32_t)window_) {
+            if (slots_.empty()) {
+                next_ = sequence - window_;
+                break;
+            }
+            PopFront(output);
+        }
+
+        size_t offset = sequence - next_;
+        if (offset >= slots_.size()) {
+            slots_.resize(offset + 1);
+        }
+        if (slots_[offset].has_value()) {
+            return false;
+        }
+        slots_[offset] = std::move(item);
+        Release(output, window_);
+        return true;
+    }
+
+    // 不再等待，交出所有暂存的包
+    template <typename Output>
+    void Flush(Output&& output) {
+        Release(output, 0);
+    }
+
+    bool empty() const { return slots_.empty(); }
+
+private:
+    uint32_t window_;
+    bool started_ = false;
+    // slots_[i] 对应序号 next_ + i
+    uint32_t next_ = 0;
+    std::deque<std::optional<T>> slots_;
+
+    template <typename Output>
+    void PopFront(Output& output) {
+        if (slots_.front().has_value()) {
+            output(std::move(*slots_.front()));
+        }
+        slots_.pop_front();
+        next_++;
+    }
+
+    // 交出开头连续到达的包，开头是缺口时最多保留 keep 个槽位等待
+    template <typename Output>
+    void Release(Output& output, size_t keep) {
+        while (!slots_.empty() && (slots_.front().has_value() || slots_.size() > keep)) {
+            PopFront(output);
+        }
+    }
+};
+
+#endif // REORDER_BUFFER_H
@@ -150,9 +150,9 @@ bool WebsocketProtocol::OpenAudioChannel() {
                     });
                 }
             }
-        } else {
+        } else if (!DispatchIncomingMessage(data, len)) {
             // Parse JSON data
-            auto root = cJSON_Parse(data);
+            auto root = cJSON_ParseWithLength(data, len);
             auto type = cJSON_GetObjectItem(root, "type");
             if (type != NULL) {
                 if (strcmp(type->valuestring, "hello") == 0) {
@@ -163,7 +163,7 @@ bool WebsocketProtocol::OpenAudioChannel() {
                     }
                 }
             } else {
-                ESP_LOGE(TAG, "Missing message type, data: %s", data);
+                ESP_LOGE(TAG, "Missing message type, data: %.*s", (int)len, data);
             }
             cJSON_Delete(root);
         }
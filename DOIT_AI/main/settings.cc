@@ -1,67 +1,341 @@
 #include "settings.h"
 
 #include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <nvs_flash.h>
 
+#include <algorithm>
+#include <map>
+#include <mutex>
+
 #define TAG "Settings"
 
-Settings::Settings(const std::string& ns, bool read_write) : ns_(ns), read_write_(read_write) {
-    nvs_open(ns.c_str(), read_write_ ? NVS_READWRITE : NVS_READONLY, &nvs_handle_);
-}
+// 最后一次写入后多久提交
+#define SETTINGS_COMMIT_DELAY_MS 2000
+// 连续写入时最多推迟多久提交
+#define SETTINGS_COMMIT_MAX_DELAY_MS 10000
+// 超过这个长度的字符串提交后不保留在缓存中，例如 OTA 配置
+#define SETTINGS_CACHE_MAX_STRING_LENGTH 256
+// 延迟提交在低优先级任务中执行，不占用 esp_timer 任务
+#define SETTINGS_COMMIT_TASK_STACK_SIZE 3072
+#define SETTINGS_COMMIT_TASK_PRIORITY 1
+
+namespace {
+
+enum ValueType {
+    kValueAbsent,
+    kValueString,
+    kValueInt,
+};
 
-Settings::~Settings() {
-    if (nvs_handle_ != 0) {
-        if (read_write_ && dirty_) {
-            ESP_ERROR_CHECK(nvs_commit(nvs_handle_));
+struct Value {
+    ValueType type = kValueAbsent;
+    std::string string_value;
+    int32_t int_value = 0;
+    // 修改后还没有提交到 NVS
+    bool dirty = false;
+    // 每次修改递增，提交期间又被修改的值提交后仍然是脏的
+    uint32_t version = 0;
+
+    bool Equals(const Value& other) const {
+        if (type != other.type) {
+            return false;
+        }
+        if (type == kValueString) {
+            return string_value == other.string_value;
         }
-        nvs_close(nvs_handle_);
+        return type != kValueInt || int_value == other.int_value;
     }
+
+    bool Cacheable() const {
+        return dirty || type != kValueString || string_value.size() <= SETTINGS_CACHE_MAX_STRING_LENGTH;
+    }
+};
+
+struct Namespace {
+    std::map<std::string, Value> values;
+    // EraseAll 之后还没有提交，缓存中没有的键都视为不存在
+    bool erase_all = false;
+    uint32_t erase_all_version = 0;
+    bool dirty = false;
+};
+
+class SettingsCache {
+public:
+    static SettingsCache& GetInstance() {
+        static SettingsCache instance;
+        return instance;
+    }
+
+    Value Get(const std::string& ns, const std::string& key);
+    void Set(const std::string& ns, const std::string& key, Value&& value);
+    void EraseAll(const std::string& ns);
+    void Flush();
+
+private:
+    // mutex_ 保护缓存，提交 NVS 时不持有；flush_mutex_ 保证提交按顺序进行
+    std::mutex mutex_;
+    std::mutex flush_mutex_;
+    std::map<std::string, Namespace> namespaces_;
+    esp_timer_handle_t commit_timer_ = nullptr;
+    TaskHandle_t commit_task_ = nullptr;
+    int64_t first_dirty_time_ = 0;
+    uint32_t version_ = 0;
+
+    SettingsCache();
+    bool Load(const std::string& ns, const std::string& key, Value& value);
+    bool Commit(const std::string& ns, const Namespace& changes);
+    void MarkCommitted(Namespace& space, const Namespace& changes);
+    void ScheduleCommit();
+};
+
+SettingsCache::SettingsCache() {
+    xTaskCreate([](void* arg) {
+        auto cache = (SettingsCache*)arg;
+        while (true) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            cache->Flush();
+        }
+    }, "settings_commit", SETTINGS_COMMIT_TASK_STACK_SIZE, this, SETTINGS_COMMIT_TASK_PRIORITY, &commit_task_);
+
+    esp_timer_create_args_t timer_args = {
+        .callback = [](void* arg) {
+            xTaskNotifyGive(((SettingsCache*)arg)->commit_task_);
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "settings_commit",
+        .skip_unhandled_events = true
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &commit_timer_));
+    esp_register_shutdown_handler([]() {
+        SettingsCache::GetInstance().Flush();
+    });
 }
 
-std::string Settings::GetString(const std::string& key, const std::string& default_value) {
-    if (nvs_handle_ == 0) {
-        return default_value;
+// 返回 false 表示读取失败，结果不能缓存
+bool SettingsCache::Load(const std::string& ns, const std::string& key, Value& value) {
+    value = Value();
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(ns.c_str(), NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        return err == ESP_ERR_NVS_NOT_FOUND;
     }
 
-    size_t length = 0;
-    if (nvs_get_str(nvs_handle_, key.c_str(), nullptr, &length) != ESP_OK) {
-        return default_value;
+    nvs_type_t type;
+    err = nvs_find_key(handle, key.c_str(), &type);
+    if (err == ESP_OK && type == NVS_TYPE_STR) {
+        size_t length = 0;
+        err = nvs_get_str(handle, key.c_str(), nullptr, &length);
+        if (err == ESP_OK) {
+            value.string_value.resize(length);
+            err = nvs_get_str(handle, key.c_str(), value.string_value.data(), &length);
+        }
+        while (!value.string_value.empty() && value.string_value.back() == '\0') {
+            value.string_value.pop_back();
+        }
+        value.type = kValueString;
+    } else if (err == ESP_OK && type == NVS_TYPE_I32) {
+        err = nvs_get_i32(handle, key.c_str(), &value.int_value);
+        value.type = kValueInt;
+    } else if (err == ESP_OK) {
+        ESP_LOGW(TAG, "Unsupported type %d of %s.%s", type, ns.c_str(), key.c_str());
+    }
+    nvs_close(handle);
+
+    if (err != ESP_OK) {
+        value = Value();
+        return err == ESP_ERR_NVS_NOT_FOUND;
     }
+    return true;
+}
 
-    std::string value;
-    value.resize(length);
-    ESP_ERROR_CHECK(nvs_get_str(nvs_handle_, key.c_str(), value.data(), &length));
-    while (!value.empty() && value.back() == '\0') {
-        value.pop_back();
+Value SettingsCache::Get(const std::string& ns, const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& space = namespaces_[ns];
+    auto it = space.values.find(key);
+    if (it != space.values.end()) {
+        return it->second;
+    }
+
+    Value value;
+    if (!space.erase_all && Load(ns, key, value) && value.Cacheable()) {
+        space.values[key] = value;
     }
     return value;
 }
 
+void SettingsCache::Set(const std::string& ns, const std::string& key, Value&& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& space = namespaces_[ns];
+    auto it = space.values.find(key);
+    Value current;
+    bool known = true;
+    if (it != space.values.end()) {
+        current = it->second;
+    } else if (!space.erase_all) {
+        known = Load(ns, key, current);
+    }
+    // 值没有变化时不写 flash，例如反复设置同一个音量
+    if (known && current.Equals(value)) {
+        return;
+    }
+
+    value.dirty = true;
+    value.version = ++version_;
+    space.values[key] = std::move(value);
+    space.dirty = true;
+    ScheduleCommit();
+}
+
+void SettingsCache::EraseAll(const std::string& ns) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& space = namespaces_[ns];
+    space.values.clear();
+    space.erase_all = true;
+    space.erase_all_version = ++version_;
+    space.dirty = true;
+    ScheduleCommit();
+}
+
+void SettingsCache::ScheduleCommit() {
+    int64_t now = esp_timer_get_time();
+    if (first_dirty_time_ == 0) {
+        first_dirty_time_ = now;
+    }
+    int64_t delay = std::min<int64_t>(SETTINGS_COMMIT_DELAY_MS * 1000LL,
+        first_dirty_time_ + SETTINGS_COMMIT_MAX_DELAY_MS * 1000LL - now);
+    esp_timer_stop(commit_timer_);
+    esp_timer_start_once(commit_timer_, std::max<int64_t>(delay, 1000));
+}
+
+// 一个命名空间的修改在一次 nvs_commit 中提交，changes 只包含脏数据，失败时缓存中的数据保持为脏，下次提交时重试
+bool SettingsCache::Commit(const std::string& ns, const Namespace& changes) {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(ns.c_str(), NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open namespace %s: %s", ns.c_str(), esp_err_to_name(err));
+        return false;
+    }
+
+    if (changes.erase_all) {
+        err = nvs_erase_all(handle);
+    }
+    for (auto it = changes.values.begin(); it != changes.values.end() && err == ESP_OK; ++it) {
+        auto& value = it->second;
+        if (value.type == kValueString) {
+            err = nvs_set_str(handle, it->first.c_str(), value.string_value.c_str());
+        } else if (value.type == kValueInt) {
+            err = nvs_set_i32(handle, it->first.c_str(), value.int_value);
+        } else {
+            err = nvs_erase_key(handle, it->first.c_str());
+            if (err == ESP_ERR_NVS_NOT_FOUND) {
+                err = ESP_OK;
+            }
+        }
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to commit namespace %s: %s", ns.c_str(), esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+// 提交期间没有再修改的值清除脏标记
+void SettingsCache::MarkCommitted(Namespace& space, const Namespace& changes) {
+    if (changes.erase_all && space.erase_all_version == changes.erase_all_version) {
+        space.erase_all = false;
+    }
+    for (auto& [key, committed] : changes.values) {
+        auto it = space.values.find(key);
+        if (it == space.values.end() || it->second.version != committed.version) {
+            continue;
+        }
+        it->second.dirty = false;
+        if (!it->second.Cacheable()) {
+            space.values.erase(it);
+        }
+    }
+    space.dirty = space.erase_all || std::any_of(space.values.begin(), space.values.end(),
+        [](const auto& item) { return item.second.dirty; });
+}
+
+// 在锁内复制脏数据，锁外写 NVS，提交期间其它任务仍然可以读写缓存
+void SettingsCache::Flush() {
+    std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+    std::map<std::string, Namespace> changes;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        esp_timer_stop(commit_timer_);
+        first_dirty_time_ = 0;
+        for (auto& [ns, space] : namespaces_) {
+            if (!space.dirty) {
+                continue;
+            }
+            auto& change = changes[ns];
+            change.erase_all = space.erase_all;
+            change.erase_all_version = space.erase_all_version;
+            for (auto& [key, value] : space.values) {
+                if (value.dirty) {
+                    change.values[key] = value;
+                }
+            }
+        }
+    }
+
+    for (auto& [ns, change] : changes) {
+        if (Commit(ns, change)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            MarkCommitted(namespaces_[ns], change);
+        }
+    }
+}
+
+} // namespace
+
+Settings::Settings(const std::string& ns, bool read_write) : ns_(ns), read_write_(read_write) {
+}
+
+std::string Settings::GetString(const std::string& key, const std::string& default_value) {
+    auto value = SettingsCache::GetInstance().Get(ns_, key);
+    if (value.type != kValueString) {
+        return default_value;
+    }
+    return value.string_value;
+}
+
 void Settings::SetString(const std::string& key, const std::string& value) {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_str(nvs_handle_, key.c_str(), value.c_str()));
-        dirty_ = true;
+        Value cached;
+        cached.type = kValueString;
+        cached.string_value = value;
+        SettingsCache::GetInstance().Set(ns_, key, std::move(cached));
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
 }
 
 int32_t Settings::GetInt(const std::string& key, int32_t default_value) {
-    if (nvs_handle_ == 0) {
-        return default_value;
-    }
-
-    int32_t value;
-    if (nvs_get_i32(nvs_handle_, key.c_str(), &value) != ESP_OK) {
+    auto value = SettingsCache::GetInstance().Get(ns_, key);
+    if (value.type != kValueInt) {
         return default_value;
     }
-    return value;
+    return value.int_value;
 }
 
 void Settings::SetInt(const std::string& key, int32_t value) {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_i32(nvs_handle_, key.c_str(), value));
-        dirty_ = true;
+        Value cached;
+        cached.type = kValueInt;
+        cached.int_value = value;
+        SettingsCache::GetInstance().Set(ns_, key, std::move(cached));
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
@@ -69,10 +343,7 @@ void Settings::SetInt(const std::string& key, int32_t value) {
 
 void Settings::EraseKey(const std::string& key) {
     if (read_write_) {
-        auto ret = nvs_erase_key(nvs_handle_, key.c_str());
-        if (ret != ESP_ERR_NVS_NOT_FOUND) {
-            ESP_ERROR_CHECK(ret);
-        }
+        SettingsCache::GetInstance().Set(ns_, key, Value());
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
@@ -80,8 +351,12 @@ void Settings::EraseKey(const std::string& key) {
 
 void Settings::EraseAll() {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_erase_all(nvs_handle_));
+        SettingsCache::GetInstance().EraseAll(ns_);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
 }
+
+void Settings::Flush() {
+    SettingsCache::GetInstance().Flush();
+}
@@ -4,10 +4,16 @@
 #include <string>
 #include <nvs_flash.h>
 
+/*
+ * NVS 设置的读写接口，所有实例共用一份内存缓存
+ * 读取时按键从 NVS 加载一次，写入只修改缓存，最后一次写入 SETTINGS_COMMIT_DELAY_MS 后由低优先级任务批量提交，
+ * 连续写入时最多推迟 SETTINGS_COMMIT_MAX_DELAY_MS，esp_restart 前也会提交。提交时不锁住缓存。
+ * 掉电或崩溃时会丢失还未提交的修改，NVS 不支持事务，正在提交的命名空间可能只写入了一部分（每个键是完整的）。
+ * 需要立即落盘的数据（例如 OTA 断点）写入后调用 Flush
+ */
 class Settings {
 public:
     Settings(const std::string& ns, bool read_write = false);
-    ~Settings();
 
     std::string GetString(const std::string& key, const std::string& default_value = "");
     void SetString(const std::string& key, const std::string& value);
@@ -16,11 +22,12 @@ public:
     void EraseKey(const std::string& key);
     void EraseAll();
 
+    // 立即提交所有命名空间中未提交的修改
+    static void Flush();
+
 private:
     std::string ns_;
-    nvs_handle_t nvs_handle_ = 0;
     bool read_write_ = false;
-    bool dirty_ = false;
 };
 
 #endif
@@ -0,0 +1,219 @@
+#! /usr/bin/env python3
+"""
+生成差分升级补丁，格式见 main/delta_patch.h
+
+用法:
+    gen_delta.py diff old.bin new.bin patch.bin     生成补丁，生成后会自动应用一次并校验结果
+    gen_delta.py apply old.bin patch.bin new.bin    在电脑上应用补丁，用于验证
+
+old.bin 必须是设备上正在运行的固件（build/xiaozhi.bin），设备会先比较运行分区的 SHA-256，
+服务器在 OTA 配置的 firmware 中下发 "patch_url" 即可，设备应用失败时会自动回退到完整固件 "url"
+"""
+import hashlib
+import struct
+import sys
+
+MAGIC = b"XZDELTA1"
+# 源镜像每隔 INDEX_STEP 字节建立一个长度为 KEY_SIZE 的索引
+KEY_SIZE = 16
+INDEX_STEP = 4
+# 近似匹配向前扩展时，连续这么多字节没有提高得分就停止
+EXTEND_LIMIT = 64
+# literal 中允许夹杂的最长 0 字节串，更长的 0 串单独编码为 zero_run
+MAX_ZERO_GAP = 2
+
+
+def write_varint(out, value):
+    while True:
+        byte = value & 0x7f
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return
+
+
+def zigzag(value):
+    return (value << 1) if value >= 0 else ((-value << 1) - 1)
+
+
+def build_index(old):
+    index = {}
+    for pos in range(0, len(old) - KEY_SIZE + 1, INDEX_STEP):
+        index.setdefault(old[pos:pos + KEY_SIZE], pos)
+    return index
+
+
+def extend_match(old, new, old_pos, new_pos):
+    """从完全匹配的位置开始向前近似扩展，返回得分最高的长度（2 * 相同字节数 - 长度）"""
+    best_length = 0
+    best_score = 0
+    score = 0
+    length = 0
+    limit = min(len(old) - old_pos, len(new) - new_pos)
+    while length < limit:
+        score += 1 if old[old_pos + length] == new[new_pos + length] else -1
+        length += 1
+        if score > best_score:
+            best_score = score
+            best_length = length
+        elif length - best_length > EXTEND_LIMIT:
+            break
+    return best_length
+
+
+def find_matches(old, new):
+    """贪心查找 (new_pos, old_pos, length)，优先沿用上一个匹配的偏移"""
+    index = build_index(old)
+    matches = []
+    new_pos = 0
+    last_delta = None
+    while new_pos + KEY_SIZE <= len(new):
+        old_pos = None
+        # 插入或删除少量代码后，后面的内容通常整体偏移，先尝试上一次的偏移
+        if last_delta is not None:
+            candidate = new_pos + last_delta
+            if 0 <= candidate <= len(old) - KEY_SIZE and old[candidate:candidate + KEY_SIZE] == new[new_pos:new_pos + KEY_SIZE]:
+                old_pos = candidate
+        if old_pos is None:
+            old_pos = index.get(new[new_pos:new_pos + KEY_SIZE])
+        if old_pos is None:
+            new_pos += 1
+            continue
+        length = extend_match(old, new, old_pos, new_pos)
+        matches.append((new_pos, old_pos, length))
+        last_delta = old_pos - new_pos
+        new_pos += length
+    return matches
+
+
+def encode_diff(out, old, new, old_pos, new_pos, length):
+    diff = bytes((new[new_pos + i] - old[old_pos + i]) & 0xff for i in range(length))
+    pos = 0
+    while pos < length:
+        zero_start = pos
+        while pos < length and diff[pos] == 0:
+            pos += 1
+        write_varint(out, pos - zero_start)
+        if pos == length:
+            return
+        literal_start = pos
+        zeros = 0
+        while pos < length and zeros <= MAX_ZERO_GAP:
+            zeros = zeros + 1 if diff[pos] == 0 else 0
+            pos += 1
+        # 末尾的 0 留给下一个 zero_run
+        pos -= zeros
+        write_varint(out, pos - literal_start)
+        out += diff[literal_start:pos]
+
+
+def make_patch(old, new):
+    out = bytearray(MAGIC)
+    out += struct.pack("<II", len(old), len(new))
+    out += hashlib.sha256(old).digest()
+    out += hashlib.sha256(new).digest()
+
+    if not new:
+        return bytes(out)
+    matches = find_matches(old, new)
+    # 第一条记录只有 extra，输出第一个匹配之前的数据
+    records = [(0, 0, 0)] + matches
+    old_cursor = 0
+    for i, (new_pos, old_pos, length) in enumerate(records):
+        next_new = records[i + 1][0] if i + 1 < len(records) else len(new)
+        next_old = records[i + 1][1] if i + 1 < len(records) else old_pos + length
+        extra = new[new_pos + length:next_new]
+        write_varint(out, length)
+        write_varint(out, len(extra))
+        if length > 0:
+            encode_diff(out, old, new, old_pos, new_pos, length)
+        out += extra
+        old_cursor = old_pos + length
+        write_varint(out, zigzag(next_old - old_cursor))
+    return bytes(out)
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def bytes(self, length):
+        value = self.data[self.pos:self.pos + length]
+        if len(value) != length:
+            raise ValueError("unexpected end of patch")
+        self.pos += length
+        return value
+
+    def varint(self):
+        value = 0
+        shift = 0
+        while True:
+            byte = self.bytes(1)[0]
+            value |= (byte & 0x7f) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+
+def apply_patch(old, patch):
+    reader = Reader(patch)
+    if reader.bytes(8) != MAGIC:
+        raise ValueError("bad magic")
+    source_size, target_size = struct.unpack("<II", reader.bytes(8))
+    source_sha256 = reader.bytes(32)
+    target_sha256 = reader.bytes(32)
+    if source_size != len(old) or hashlib.sha256(old).digest() != source_sha256:
+        raise ValueError("patch does not match the source image")
+
+    new = bytearray()
+    old_pos = 0
+    while len(new) < target_size:
+        diff_length = reader.varint()
+        extra_length = reader.varint()
+        remaining = diff_length
+        while remaining > 0:
+            zero_run = reader.varint()
+            new += old[old_pos:old_pos + zero_run]
+            old_pos += zero_run
+            remaining -= zero_run
+            if remaining == 0:
+                break
+            literal = reader.bytes(reader.varint())
+            new += bytes((old[old_pos + i] + b) & 0xff for i, b in enumerate(literal))
+            old_pos += len(literal)
+            remaining -= len(literal)
+        new += reader.bytes(extra_length)
+        seek = reader.varint()
+        old_pos += (seek >> 1) ^ -(seek & 1)
+    if reader.pos != len(patch) or hashlib.sha256(new).digest() != target_sha256:
+        raise ValueError("patched image does not match")
+    return bytes(new)
+
+
+def main():
+    if len(sys.argv) != 5 or sys.argv[1] not in ("diff", "apply"):
+        print(__doc__)
+        sys.exit(1)
+
+    with open(sys.argv[2], "rb") as f:
+        old = f.read()
+    with open(sys.argv[3], "rb") as f:
+        data = f.read()
+
+    if sys.argv[1] == "diff":
+        patch = make_patch(old, data)
+        if apply_patch(old, patch) != data:
+            raise SystemExit("patch verification failed")
+        with open(sys.argv[4], "wb") as f:
+            f.write(patch)
+        print(f"patch: {len(patch)} bytes ({len(patch) * 100 / max(len(data), 1):.1f}% of {len(data)} bytes)")
+    else:
+        with open(sys.argv[4], "wb") as f:
+            f.write(apply_patch(old, data))
+
+
+if __name__ == "__main__":
+    main()
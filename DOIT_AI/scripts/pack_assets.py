@@ -0,0 +1,112 @@
+#! /usr/bin/env python3
+"""
+打包 assets 分区，格式见 main/assets.h
+
+用法:
+    pack_assets.py pack <输出文件> <名称>=<文件> ...    打包，生成后会自动按设备上的方式读取一次并校验
+    pack_assets.py list <资源包>                        列出资源包中的文件并校验
+
+例如 sounds/success.p3=main/assets/common/success.p3，名称最长 MAX_NAME_LENGTH 字节，
+编译时由 main/CMakeLists.txt 调用，也可以单独生成后用 idf.py assets-flash 烧录
+"""
+import struct
+import sys
+import zlib
+
+MAGIC = b"XZAS"
+VERSION = 1
+# magic, 版本, 文件数量, 资源包总长度, 索引的 CRC32
+HEADER_FORMAT = "<4sHHII"
+# 名称, 偏移, 长度, 数据的 CRC32
+ENTRY_FORMAT = "<36sIII"
+MAX_NAME_LENGTH = 35
+DATA_ALIGN = 16
+
+
+def align(value):
+    return (value + DATA_ALIGN - 1) // DATA_ALIGN * DATA_ALIGN
+
+
+def pack(files):
+    """files 是 (名称, 数据) 列表，返回资源包，索引按名称排序，设备上二分查找"""
+    files = sorted(files, key=lambda item: item[0].encode())
+    names = [name for name, _ in files]
+    if len(set(names)) != len(names):
+        raise ValueError("Duplicate asset names")
+
+    header_size = struct.calcsize(HEADER_FORMAT)
+    offset = align(header_size + struct.calcsize(ENTRY_FORMAT) * len(files))
+    index = bytearray()
+    data = bytearray()
+    for name, content in files:
+        encoded = name.encode()
+        if len(encoded) > MAX_NAME_LENGTH:
+            raise ValueError(f"Asset name too long: {name}")
+        index += struct.pack(ENTRY_FORMAT, encoded, offset + len(data), len(content), zlib.crc32(content))
+        data += content
+        data += bytes(align(len(data)) - len(data))
+
+    total_size = offset + len(data)
+    header = struct.pack(HEADER_FORMAT, MAGIC, VERSION, len(files), total_size, zlib.crc32(index))
+    padding = bytes(offset - header_size - len(index))
+    return header + index + padding + data
+
+
+def read(image):
+    """和设备上的 Assets 一样读取并校验资源包，返回 {名称: 数据}"""
+    header_size = struct.calcsize(HEADER_FORMAT)
+    entry_size = struct.calcsize(ENTRY_FORMAT)
+    if len(image) < header_size:
+        raise ValueError("Assets image too small")
+    magic, version, count, total_size, index_crc = struct.unpack_from(HEADER_FORMAT, image)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("Not an assets image")
+    if total_size > len(image) or header_size + entry_size * count > total_size:
+        raise ValueError("Assets image truncated")
+    index = image[header_size:header_size + entry_size * count]
+    if zlib.crc32(index) != index_crc:
+        raise ValueError("Assets index checksum mismatch")
+
+    files = {}
+    previous = b""
+    for i in range(count):
+        name, offset, size, crc = struct.unpack_from(ENTRY_FORMAT, index, i * entry_size)
+        name = name.rstrip(b"\0")
+        if name <= previous:
+            raise ValueError("Assets index is not sorted")
+        previous = name
+        if offset % DATA_ALIGN or offset > total_size or size > total_size - offset:
+            raise ValueError(f"Invalid asset {name.decode()}")
+        content = bytes(image[offset:offset + size])
+        if zlib.crc32(content) != crc:
+            raise ValueError(f"Asset {name.decode()} checksum mismatch")
+        files[name.decode()] = content
+    return files
+
+
+def main():
+    if len(sys.argv) >= 3 and sys.argv[1] == "pack":
+        files = []
+        for arg in sys.argv[3:]:
+            name, _, path = arg.partition("=")
+            with open(path, "rb") as f:
+                files.append((name, f.read()))
+        image = pack(files)
+        if read(image) != dict(files):
+            raise ValueError("Assets verification failed")
+        with open(sys.argv[2], "wb") as f:
+            f.write(image)
+        print(f"Packed {len(files)} assets, {len(image)} bytes")
+    elif len(sys.argv) == 3 and sys.argv[1] == "list":
+        with open(sys.argv[2], "rb") as f:
+            files = read(f.read())
+        for name, content in files.items():
+            print(f"{len(content):>10}  {name}")
+        print(f"{len(files)} assets OK")
+    else:
+        print(__doc__)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,186 @@
+#! /usr/bin/env python3
+"""
+把表情图片打包成 LZ4 压缩的 LVGL 图片，写入 assets 分区，格式见 main/display/emoji_assets.h
+
+用法:
+    pack_emoji.py <emoji 源码目录> <输出文件>
+
+源码目录是 xiaozhi-fonts 组件的 src/emoji，每个 emoji_<unicode>_<尺寸>.c 是 LVGLImage.py 生成的 C 数组，
+打包后会自动解压一次并和原始数据比较
+"""
+import os
+import re
+import struct
+import sys
+
+MAGIC = b"XZEM"
+VERSION = 1
+HEADER_FORMAT = "<4sHH"
+# unicode, 尺寸, cf, 保留, w, h, stride, 保留, 偏移, 长度
+ENTRY_FORMAT = "<IHBBHHHHII"
+# lv_image_compressed_t 中的 method、compressed_size、decompressed_size
+COMPRESSED_HEADER_FORMAT = "<III"
+COMPRESS_METHOD_LZ4 = 2
+DATA_ALIGN = 4
+
+COLOR_FORMATS = {
+    "LV_COLOR_FORMAT_ARGB8888": 0x10,
+    "LV_COLOR_FORMAT_RGB565": 0x12,
+    "LV_COLOR_FORMAT_RGB565A8": 0x14,
+}
+
+# LZ4 块格式的限制：最短匹配 4 字节，最后 5 字节必须是 literal，最后一个匹配要在结尾 12 字节之前开始
+MIN_MATCH = 4
+LAST_LITERALS = 5
+MF_LIMIT = 12
+MAX_OFFSET = 65535
+
+
+def write_length(out, value):
+    while value >= 255:
+        out.append(255)
+        value -= 255
+    out.append(value)
+
+
+def write_sequence(out, literals, offset=0, match_length=0):
+    token = min(len(literals), 15) << 4
+    if offset:
+        token |= min(match_length - MIN_MATCH, 15)
+    out.append(token)
+    if len(literals) >= 15:
+        write_length(out, len(literals) - 15)
+    out += literals
+    if offset:
+        out += struct.pack("<H", offset)
+        if match_length - MIN_MATCH >= 15:
+            write_length(out, match_length - MIN_MATCH - 15)
+
+
+def lz4_compress(data):
+    """LZ4 块格式（不带帧头），设备上由 LVGL 的 LZ4_decompress_safe 解压"""
+    out = bytearray()
+    table = {}
+    anchor = 0
+    pos = 0
+    limit = len(data) - MF_LIMIT
+    while pos < limit:
+        key = data[pos:pos + MIN_MATCH]
+        ref = table.get(key)
+        table[key] = pos
+        if ref is None or pos - ref > MAX_OFFSET:
+            pos += 1
+            continue
+
+        length = MIN_MATCH
+        max_length = len(data) - LAST_LITERALS - pos
+        while length < max_length and data[ref + length] == data[pos + length]:
+            length += 1
+        while pos > anchor and ref > 0 and data[pos - 1] == data[ref - 1]:
+            pos -= 1
+            ref -= 1
+            length += 1
+
+        write_sequence(out, data[anchor:pos], pos - ref, length)
+        # 匹配内部的位置也加入索引，重复的行可以匹配到更近的数据
+        for i in range(pos + 1, min(pos + length, limit), 2):
+            table[data[i:i + MIN_MATCH]] = i
+        pos += length
+        anchor = pos
+    write_sequence(out, data[anchor:])
+    return bytes(out)
+
+
+def lz4_decompress(data, size):
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        token = data[pos]
+        pos += 1
+        length = token >> 4
+        if length == 15:
+            while True:
+                length += data[pos]
+                pos += 1
+                if data[pos - 1] != 255:
+                    break
+        out += data[pos:pos + length]
+        pos += length
+        if pos >= len(data):
+            break
+        offset = data[pos] | (data[pos + 1] << 8)
+        pos += 2
+        length = (token & 0x0f) + MIN_MATCH
+        if token & 0x0f == 15:
+            while True:
+                length += data[pos]
+                pos += 1
+                if data[pos - 1] != 255:
+                    break
+        for _ in range(length):
+            out.append(out[-offset])
+    if len(out) != size:
+        raise ValueError("LZ4 decompressed size mismatch")
+    return bytes(out)
+
+
+def parse_image(path):
+    """读取 LVGLImage.py 生成的 C 数组，返回 (cf, w, h, stride, 像素数据)"""
+    with open(path, "r", encoding="utf-8") as f:
+        source = f.read()
+
+    body = re.search(r"_map\[\]\s*=\s*\{(.*?)\};", source, re.S)
+    fields = dict(re.findall(r"\.header\.(\w+)\s*=\s*(\w+)", source))
+    if body is None or fields.get("cf") not in COLOR_FORMATS:
+        raise ValueError(f"Unsupported image source: {path}")
+
+    pixels = bytes(int(value, 16) for value in re.findall(r"0x[0-9a-fA-F]{2}", body.group(1)))
+    return COLOR_FORMATS[fields["cf"]], int(fields["w"]), int(fields["h"]), int(fields["stride"]), pixels
+
+
+def pack(source_dir, output_path):
+    images = []
+    for name in sorted(os.listdir(source_dir)):
+        match = re.fullmatch(r"emoji_([0-9a-f]+)_(\d+)\.c", name)
+        if match:
+            images.append((int(match.group(1), 16), int(match.group(2)), os.path.join(source_dir, name)))
+    if not images:
+        raise ValueError(f"No emoji images in {source_dir}")
+
+    entries = bytearray()
+    blobs = bytearray()
+    data_offset = struct.calcsize(HEADER_FORMAT) + struct.calcsize(ENTRY_FORMAT) * len(images)
+    raw_size = 0
+    for unicode, size, path in images:
+        cf, w, h, stride, pixels = parse_image(path)
+        compressed = lz4_compress(pixels)
+        if lz4_decompress(compressed, len(pixels)) != pixels:
+            raise ValueError(f"LZ4 verification failed: {path}")
+
+        while (data_offset + len(blobs)) % DATA_ALIGN:
+            blobs.append(0)
+        blob = struct.pack(COMPRESSED_HEADER_FORMAT, COMPRESS_METHOD_LZ4, len(compressed), len(pixels)) + compressed
+        entries += struct.pack(ENTRY_FORMAT, unicode, size, cf, 0, w, h, stride, 0,
+                               data_offset + len(blobs), len(blob))
+        blobs += blob
+        raw_size += len(pixels)
+
+    with open(output_path, "wb") as f:
+        f.write(struct.pack(HEADER_FORMAT, MAGIC, VERSION, len(images)))
+        f.write(entries)
+        f.write(blobs)
+
+    packed_size = data_offset + len(blobs)
+    print(f"Packed {len(images)} emoji images: {raw_size} bytes -> {packed_size} bytes "
+          f"({packed_size * 100 // raw_size}%)")
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(__doc__)
+        sys.exit(1)
+    pack(sys.argv[1], sys.argv[2])
+
+
+if __name__ == "__main__":
+    main()